@@ -0,0 +1,446 @@
+/* Band and tridiagonal linear systems
+ * Oct 18 2026 */
+
+#include "band.h"
+
+// the systems of one task of tridiagonal_solve_batch()
+struct tridiagonal_job
+{
+	unsigned int n, count, ld;
+	const float *a, *b, *c;
+	float *d;
+	int failed;
+};
+
+band zero_band(unsigned int n, unsigned int kl, unsigned int ku);
+void free_band(band B);
+float band_get(band B, unsigned int i, unsigned int j);
+int band_set(band B, unsigned int i, unsigned int j, float a);
+band band_from_matrix(matrix A, unsigned int kl, unsigned int ku);
+matrix band_to_matrix(band B);
+int band_gemv(float alpha, band B, const float *x, float beta, float *y);
+int band_lu_factor(band B);
+int band_lu_solve(band B, vector x, vector b);
+int tridiagonal_solve(unsigned int n, const float *a, const float *b,
+		const float *c, const float *d, float *x);
+int tridiagonal_solve_batch(unsigned int n, unsigned int count,
+		unsigned int ld, const float *a, const float *b, const float *c,
+		float *d);
+
+// where a_ij is stored, i and j must be inside the band
+static float * band_element(band B, unsigned int i, unsigned int j);
+// count systems with element i of system k at [i*ld + k], the solutions
+// overwrite d, cp holds n*count floats, returns 0 on success
+static int thomas(unsigned int n, unsigned int count, unsigned int ld,
+		const float *a, const float *b, const float *c, float *d, float *cp);
+// the systems of one task of tridiagonal_solve_batch()
+static void tridiagonal_task(void *arg, unsigned int t);
+
+// a zeroed band matrix with room for the fill of pivoting
+band zero_band(unsigned int n, unsigned int kl, unsigned int ku)
+{
+	band B;
+
+	if (n < 1 || kl >= n || ku >= n)
+	{
+		fprintf(stderr,"Error: a band matrix needs n >= 1 and kl, ku < n\n");
+		return NULL;
+	}
+	if ((B = malloc(sizeof(*B))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	B->n = n;
+	B->kl = kl;
+	B->ku = ku;
+	B->ld = 2*kl + ku + 1;
+	B->flags = 0;
+	B->ab = calloc((size_t)B->ld*n, sizeof(*B->ab));
+	B->pivot = malloc(sizeof(*B->pivot)*n);
+	if (B->ab == NULL || B->pivot == NULL)
+	{
+		perror("Error allocating memory");
+		free_band(B);
+		return NULL;
+	}
+	return B;
+}
+
+void free_band(band B)
+{
+	if (B == NULL)
+	{
+		return;
+	}
+	free(B->ab);
+	free(B->pivot);
+	free(B);
+}
+
+// column j holds rows j-ku-kl ... j+kl, the diagonal is row kl+ku
+static float * band_element(band B, unsigned int i, unsigned int j)
+{
+	return B->ab + (B->kl + B->ku + i - j) + (size_t)j*B->ld;
+}
+
+float band_get(band B, unsigned int i, unsigned int j)
+{
+	if (i >= B->n || j >= B->n || i + B->ku < j || i > j + B->kl)
+	{
+		return 0.;
+	}
+	return *band_element(B, i, j);
+}
+
+int band_set(band B, unsigned int i, unsigned int j, float a)
+{
+	if (i >= B->n || j >= B->n || i + B->ku < j || i > j + B->kl)
+	{
+		fprintf(stderr,"Error: (%u,%u) is outside the band\n",i,j);
+		return 1;
+	}
+	*band_element(B, i, j) = a;
+	return 0;
+}
+
+// copy the band of a dense matrix
+band band_from_matrix(matrix A, unsigned int kl, unsigned int ku)
+{
+	band B;
+	unsigned int i,j,first,last;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Error: a band matrix must be square\n");
+		return NULL;
+	}
+	if ((B = zero_band(A->n, kl, ku)) == NULL)
+	{
+		return NULL;
+	}
+	for (j=0; j < B->n; j++)
+	{
+		first = (j > ku) ? j - ku : 0;
+		last = (j + kl < B->n) ? j + kl : B->n - 1;
+		for (i=first; i <= last; i++)
+		{
+			*band_element(B, i, j) = (A->flags & MATRIX_TRANSPOSED)
+				? A->A[j][i] : A->A[i][j];
+		}
+	}
+	return B;
+}
+
+// a dense copy of an unfactored band matrix
+matrix band_to_matrix(band B)
+{
+	matrix A;
+	unsigned int i,j,first,last;
+
+	if (B->flags & BAND_FACTORED)
+	{
+		fprintf(stderr,"Error: band matrix has been factored\n");
+		return NULL;
+	}
+	if ((A = zero_matrix(B->n, B->n)) == NULL)
+	{
+		return NULL;
+	}
+	for (j=0; j < B->n; j++)
+	{
+		first = (j > B->ku) ? j - B->ku : 0;
+		last = (j + B->kl < B->n) ? j + B->kl : B->n - 1;
+		for (i=first; i <= last; i++)
+		{
+			A->A[i][j] = *band_element(B, i, j);
+		}
+	}
+	return A;
+}
+
+// y = alpha*A*x + beta*y a column at a time
+int band_gemv(float alpha, band B, const float *x, float beta, float *y)
+{
+	unsigned int i,j,first,last;
+
+	if (B->flags & BAND_FACTORED)
+	{
+		fprintf(stderr,"Error: band matrix has been factored\n");
+		return 1;
+	}
+	// y isn't read when beta is 0, so it may start out as anything
+	for (i=0; i < B->n; i++)
+	{
+		y[i] = (beta == 0.) ? 0. : beta*y[i];
+	}
+	for (j=0; j < B->n; j++)
+	{
+		first = (j > B->ku) ? j - B->ku : 0;
+		last = (j + B->kl < B->n) ? j + B->kl : B->n - 1;
+		mathlib_kernels->axpy(last - first + 1, alpha*x[j], band_element(B, first, j),
+				y + first);
+	}
+	return 0;
+}
+
+// the unblocked algorithm of LAPACK's gbtf2, rows are swapped across the
+// columns up to the last one U reaches so far, which grows by at most
+// ku+kl past the pivot row
+int band_lu_factor(band B)
+{
+	unsigned int n=B->n, kl=B->kl, kv=B->kl+B->ku, ld=B->ld;
+	unsigned int i,j,c,km,jp,ju=0;
+	float *col,*p,*q;
+	float big,t,u;
+
+	if (B->flags & BAND_FACTORED)
+	{
+		fprintf(stderr,"Error: band matrix has been factored\n");
+		return 1;
+	}
+	// the fill rows start out empty
+	for (j=0; j < n; j++)
+	{
+		memset(B->ab + (size_t)j*ld, 0, sizeof(*B->ab)*kl);
+	}
+	B->flags |= BAND_FACTORED;
+
+	for (j=0; j < n; j++)
+	{
+		// the largest of the km elements below the diagonal and itself
+		col = B->ab + kv + (size_t)j*ld;
+		km = (kl < n - 1 - j) ? kl : n - 1 - j;
+		jp = 0;
+		big = fabsf(col[0]);
+		for (i=1; i <= km; i++)
+		{
+			if (fabsf(col[i]) > big)
+			{
+				big = fabsf(col[i]);
+				jp = i;
+			}
+		}
+		B->pivot[j] = j + jp;
+		if (big == 0. || !isfinite(big))
+		{
+			fprintf(stderr,"No unique solution\n");
+			B->flags |= BAND_SINGULAR;
+			return 1;
+		}
+		if (j + B->ku + jp > ju)
+		{
+			ju = (j + B->ku + jp < n) ? j + B->ku + jp : n - 1;
+		}
+
+		// swap rows j and j+jp in columns j ... ju, consecutive elements
+		// of a row are ld-1 apart
+		if (jp != 0)
+		{
+			p = col;
+			q = col + jp;
+			for (c=j; c <= ju; c++)
+			{
+				t = *p;
+				*p = *q;
+				*q = t;
+				p += ld - 1;
+				q += ld - 1;
+			}
+		}
+
+		// the multipliers, then the update of the columns U reaches
+		if (km > 0)
+		{
+			mathlib_kernels->scal(km, 1./col[0], col + 1);
+			for (c=j+1; c <= ju; c++)
+			{
+				u = *band_element(B, j, c);
+				if (u != 0.)
+				{
+					mathlib_kernels->axpy(km, -u, col + 1, band_element(B, j+1, c));
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+// forward through the pivots and L a column at a time, then U
+int band_lu_solve(band B, vector x, vector b)
+{
+	unsigned int n=B->n, kv=B->kl+B->ku;
+	unsigned int j,lm,len;
+	float *col,t;
+
+	if (!(B->flags & BAND_FACTORED))
+	{
+		fprintf(stderr,"Error: band matrix has not been factored\n");
+		return 1;
+	}
+	if (B->flags & BAND_SINGULAR)
+	{
+		fprintf(stderr,"No unique solution\n");
+		return 1;
+	}
+	if (n != x->n || n != b->n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if (x->a != b->a)
+	{
+		memcpy(x->a, b->a, sizeof(*x->a)*n);
+	}
+
+	for (j=0; j+1 < n; j++)
+	{
+		lm = (B->kl < n - 1 - j) ? B->kl : n - 1 - j;
+		if (B->pivot[j] != j)
+		{
+			t = x->a[j];
+			x->a[j] = x->a[B->pivot[j]];
+			x->a[B->pivot[j]] = t;
+		}
+		col = B->ab + kv + (size_t)j*B->ld;
+		mathlib_kernels->axpy(lm, -x->a[j], col + 1, x->a + j + 1);
+	}
+
+	// U has kl+ku super diagonals once rows have been swapped
+	for (j=n; j-- > 0; )
+	{
+		col = B->ab + kv + (size_t)j*B->ld;
+		x->a[j] /= col[0];
+		len = (j < kv) ? j : kv;
+		mathlib_kernels->axpy(len, -x->a[j], col - len, x->a + j - len);
+	}
+	return 0;
+}
+
+// forward elimination with the normalized super diagonal in cp, then
+// back substitution, every step is a loop over the count systems
+static int thomas(unsigned int n, unsigned int count, unsigned int ld,
+		const float *a, const float *b, const float *c, float *d, float *cp)
+{
+	size_t i; // i*ld may pass 2^32 in a large batch
+	unsigned int k;
+	float den;
+
+	for (k=0; k < count; k++)
+	{
+		cp[k] = (n > 1) ? c[k]/b[k] : 0.;
+		d[k] /= b[k];
+	}
+	for (i=1; i < n; i++)
+	{
+		for (k=0; k < count; k++)
+		{
+			den = b[i*ld + k] - a[i*ld + k]*cp[(i-1)*count + k];
+			cp[i*count + k] = (i+1 < n) ? c[i*ld + k]/den : 0.;
+			d[i*ld + k] = (d[i*ld + k] - a[i*ld + k]*d[(i-1)*ld + k])/den;
+		}
+	}
+	for (i=n-1; i-- > 0; )
+	{
+		for (k=0; k < count; k++)
+		{
+			d[i*ld + k] -= cp[i*count + k]*d[(i+1)*ld + k];
+		}
+	}
+
+	// a zero pivot leaves inf or NaN behind in its system
+	for (i=0; i < n; i++)
+	{
+		for (k=0; k < count; k++)
+		{
+			if (!isfinite(d[i*ld + k]))
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+// one system
+int tridiagonal_solve(unsigned int n, const float *a, const float *b,
+		const float *c, const float *d, float *x)
+{
+	float *cp;
+	int status;
+
+	if (n < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return 1;
+	}
+	if ((cp = vector_allocate(n)) == NULL)
+	{
+		return 1;
+	}
+	if (x != d)
+	{
+		memcpy(x, d, sizeof(*x)*n);
+	}
+	if ((status = thomas(n, 1, 1, a, b, c, x, cp)) != 0)
+	{
+		fprintf(stderr,"Zero pivot in tridiagonal system\n");
+	}
+	free(cp);
+	return status;
+}
+
+// many systems, TRIDIAGONAL_BATCH per task
+int tridiagonal_solve_batch(unsigned int n, unsigned int count,
+		unsigned int ld, const float *a, const float *b, const float *c,
+		float *d)
+{
+	struct tridiagonal_job job;
+
+	if (n < 1 || ld < count)
+	{
+		fprintf(stderr,"Error: need n >= 1 and ld >= count\n");
+		return 1;
+	}
+	job.n = n;
+	job.count = count;
+	job.ld = ld;
+	job.a = a;
+	job.b = b;
+	job.c = c;
+	job.d = d;
+	job.failed = 0;
+	parallel_for((count + TRIDIAGONAL_BATCH - 1)/TRIDIAGONAL_BATCH,
+			&tridiagonal_task, &job);
+	if (job.failed)
+	{
+		fprintf(stderr,"Zero pivot in tridiagonal system\n");
+	}
+	return job.failed;
+}
+
+// systems t*TRIDIAGONAL_BATCH ...
+static void tridiagonal_task(void *arg, unsigned int t)
+{
+	struct tridiagonal_job *job = arg;
+	unsigned int first=t*TRIDIAGONAL_BATCH;
+	unsigned int count=TRIDIAGONAL_BATCH;
+	float *cp;
+
+	if (first + count > job->count)
+	{
+		count = job->count - first;
+	}
+	if ((cp = malloc(sizeof(*cp)*job->n*count)) == NULL)
+	{
+		perror("Error allocating memory");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	if (thomas(job->n, count, job->ld, job->a + first, job->b + first,
+			job->c + first, job->d + first, cp) != 0)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+	free(cp);
+}
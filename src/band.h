@@ -0,0 +1,71 @@
+/* Band and tridiagonal linear systems
+ * Oct 18 2026 */
+
+#ifndef BAND_H
+#define BAND_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// band flags
+#define BAND_FACTORED 1 // ab holds L and U, pivot the row interchanges
+#define BAND_SINGULAR 2 // band_lu_factor() stopped at a zero pivot
+
+// systems solved together by one task of tridiagonal_solve_batch()
+#define TRIDIAGONAL_BATCH 256
+
+// a square matrix with kl sub and ku super diagonals in the layout of
+// LAPACK's gbtrf, a_ij is ab[kl+ku+i-j + j*ld] for j-ku <= i <= j+kl,
+// the kl rows above are room for the fill of partial pivoting
+typedef struct
+{
+	unsigned int n; // order of matrix
+	unsigned int kl; // sub diagonals
+	unsigned int ku; // super diagonals
+	unsigned int ld; // 2*kl+ku+1, stored elements of a column
+	float *ab; // n columns of ld, column major
+	unsigned int *pivot; // row j was swapped with pivot[j] by band_lu_factor()
+	unsigned int flags;
+} *band;
+
+// a zeroed band matrix
+extern band zero_band(unsigned int n, unsigned int kl, unsigned int ku);
+extern void free_band(band B);
+// a_ij of an unfactored matrix, 0 outside the band
+extern float band_get(band B, unsigned int i, unsigned int j);
+// set a_ij, returns 1 if (i,j) is outside the band
+extern int band_set(band B, unsigned int i, unsigned int j, float a);
+// the band of a dense matrix, elements outside it are ignored
+extern band band_from_matrix(matrix A, unsigned int kl, unsigned int ku);
+extern matrix band_to_matrix(band B);
+// y = alpha*A*x + beta*y for an unfactored matrix, returns 0 on success
+extern int band_gemv(float alpha, band B, const float *x, float beta,
+		float *y);
+// PA=LU in place by partial pivoting in O(n*kl*(kl+ku)) operations
+// returns 0 on success, 1 if A is singular, which band_lu_solve() refuses
+extern int band_lu_factor(band B);
+// direct solution of LUx=Pb, x may be b, returns 0 on success
+extern int band_lu_solve(band B, vector x, vector b);
+
+// the Thomas algorithm for a tridiagonal system with sub diagonal
+// a[1..n-1], diagonal b and super diagonal c[0..n-2] in O(n), x may be d
+// there is no pivoting, so A should be diagonally dominant or SPD
+// returns 0 on success, 1 on a zero pivot
+extern int tridiagonal_solve(unsigned int n, const float *a, const float *b,
+		const float *c, const float *d, float *x);
+// count systems of order n at once, stored structure of arrays with
+// element i of system k at [i*ld + k] so a loop over k vectorizes,
+// the solutions overwrite d and the systems are split over the thread
+// pool, returns 0 on success, 1 if any system hit a zero pivot
+extern int tridiagonal_solve_batch(unsigned int n, unsigned int count,
+		unsigned int ld, const float *a, const float *b, const float *c,
+		float *d);
+
+#endif
@@ -0,0 +1,714 @@
+/* Backward differentiation formulas, implicit methods
+ * Oct 18 2026 */
+
+#include "bdf.h"
+
+// the solution is carried as backward differences D[0] = y_n,
+// D[k] = D[k-1] y_n - D[k-1] y_n-1 of equally spaced steps,
+// which makes changing the step size and the order cheap
+// after Shampine and Reichelt, The MATLAB ODE Suite
+
+// everything a step works with, n floats each unless noted
+struct bdf_work
+{
+	ode_rhs f;
+	ode_jacobian jac; // NULL for finite differences
+	void *userdata;
+	unsigned int n;
+	float threshold; // below this |y| atol sets the tolerance, not rtol
+	float *D; // differences, BDF_MAX_ORDER+3 rows of n
+	float *predict; // the solution extrapolated to the end of the step
+	float *psi; // the history part of the BDF formula
+	float *scale; // atol + rtol*|y| for the error norms
+	float *d; // correction from the prediction, D[order+1] of y_n+1
+	float *fy; // slope at the current Newton iterate
+	float *fj; // slope at a perturbed point for the Jacobian
+	float *yj; // the perturbed point
+	float *y; // [t y1 ... yn] at the end of the step
+	float *row; // [t y1 ... yn] of dense output
+	vector b, dy; // right hand side and solution of the Newton system
+	matrix J; // the Jacobian, kept until Newton has trouble
+	matrix M; // the iteration matrix I - c*J
+	lu_handle lu; // its factors, NULL when h or the order changed
+	struct ode_stats count;
+};
+
+matrix bdf(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order,
+		struct ode_stats *stats);
+int bdf_stream(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order, ode_stream out,
+		struct ode_stats *stats);
+int bdf_rhs(ode_rhs f, ode_jacobian jac, void *userdata, vector y0,
+		float tmin, float tmax, float rtol, float atol, float dt,
+		unsigned int order, ode_stream out, struct ode_stats *stats);
+
+// rows of dense output from tmin to tmax
+static unsigned int dense_rows(float tmin, float tmax, float dt);
+// root mean square of a/scale
+static double error_norm(unsigned int n, const float *a, const float *scale);
+// a first step for the tolerances
+static double initial_step(struct bdf_work *w, double t, double tmax,
+		float rtol, float atol);
+// rescale the differences from step h to factor*h
+static void change_differences(struct bdf_work *w, unsigned int order,
+		double factor);
+// the Jacobian at (t, y)
+static void jacobian(struct bdf_work *w, double t, const float *y);
+// factor I - c*J into w->lu, returns 0 on success
+static int iteration_matrix(struct bdf_work *w, double c);
+// solve the BDF formula for the end of the step, returns 0 if it converged
+static int newton(struct bdf_work *w, double t, double c, double tol,
+		unsigned int *iterations);
+// allocate and free the work of an integration
+static int work_allocate(struct bdf_work *w, unsigned int n);
+static void work_free(struct bdf_work *w);
+
+// rows of dense output from tmin to tmax, allowing for dt
+// not dividing the interval exactly in float
+static unsigned int dense_rows(float tmin, float tmax, float dt)
+{
+	return (unsigned int)floor(((double)tmax-tmin)/dt + 1e-3) + 1;
+}
+
+// root mean square of a/scale
+static double error_norm(unsigned int n, const float *a, const float *scale)
+{
+	double sum=0.;
+	unsigned int i;
+
+	for (i=0; i < n; i++)
+	{
+		sum += ((double)a[i]/scale[i])*((double)a[i]/scale[i]);
+	}
+	return sqrt(sum/n);
+}
+
+// a first step for the tolerances, after Hairer, Norsett and Wanner
+// a trial Euler step estimates the second derivative, expects
+// the slope at t in w->fy and the solution in D[0]
+static double initial_step(struct bdf_work *w, double t, double tmax,
+		float rtol, float atol)
+{
+	unsigned int n=w->n;
+	unsigned int i;
+	double d0,d1,d2,h0,h1;
+
+	for (i=0; i < n; i++)
+	{
+		w->scale[i] = atol + rtol*fabsf(w->D[i]);
+	}
+	d0 = error_norm(n, w->D, w->scale);
+	d1 = error_norm(n, w->fy, w->scale);
+	h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+	h0 = fmin(h0, tmax - t);
+
+	for (i=0; i < n; i++)
+	{
+		w->yj[i] = w->D[i] + h0*w->fy[i];
+	}
+	(*w->f)(t + h0, w->yj, w->fj, n, w->userdata);
+	w->count.evaluations++;
+	for (i=0; i < n; i++)
+	{
+		w->fj[i] -= w->fy[i];
+	}
+	d2 = error_norm(n, w->fj, w->scale)/h0;
+
+	if (fmax(d1, d2) <= 1e-15)
+	{
+		h1 = fmax(1e-6, h0*1e-3);
+	}
+	else
+	{
+		h1 = sqrt(0.01/fmax(d1, d2));
+	}
+	return fmin(fmin(100*h0, h1), tmax - t);
+}
+
+// rescale the differences of a step h to a step factor*h,
+// D <- (RU)^T D where R and U interpolate the old points and
+// evaluate at the new ones
+static void change_differences(struct bdf_work *w, unsigned int order,
+		double factor)
+{
+	double R[BDF_MAX_ORDER+1][BDF_MAX_ORDER+1];
+	double U[BDF_MAX_ORDER+1][BDF_MAX_ORDER+1];
+	double RU[BDF_MAX_ORDER+1][BDF_MAX_ORDER+1];
+	double old[BDF_MAX_ORDER+1];
+	double sum;
+	unsigned int n=w->n;
+	unsigned int i,j,k;
+
+	// R[i][j] = prod_{k=1..i} (k-1 - factor*j)/k and U the same with 1
+	for (j=0; j <= order; j++)
+	{
+		R[0][j] = 1.;
+		U[0][j] = 1.;
+		for (i=1; i <= order; i++)
+		{
+			R[i][j] = (j == 0) ? 0. : R[i-1][j]*(i-1 - factor*j)/i;
+			U[i][j] = (j == 0) ? 0. : U[i-1][j]*((double)i-1 - j)/i;
+		}
+	}
+	for (i=0; i <= order; i++)
+	{
+		for (j=0; j <= order; j++)
+		{
+			sum = 0.;
+			for (k=0; k <= order; k++)
+			{
+				sum += R[i][k]*U[k][j];
+			}
+			RU[i][j] = sum;
+		}
+	}
+
+	// one component at a time, so the differences are
+	// rewritten in place
+	for (k=0; k < n; k++)
+	{
+		for (i=0; i <= order; i++)
+		{
+			old[i] = w->D[i*n+k];
+		}
+		for (j=0; j <= order; j++)
+		{
+			sum = 0.;
+			for (i=0; i <= order; i++)
+			{
+				sum += RU[i][j]*old[i];
+			}
+			w->D[j*n+k] = sum;
+		}
+	}
+}
+
+// the Jacobian at (t, y), by forward differences if
+// there is no user Jacobian
+static void jacobian(struct bdf_work *w, double t, const float *y)
+{
+	unsigned int n=w->n;
+	unsigned int i,j;
+	float delta;
+
+	w->count.jacobians++;
+	if (w->jac != NULL)
+	{
+		(*w->jac)(t, y, w->J, n, w->userdata);
+		return;
+	}
+
+	(*w->f)(t, y, w->fy, n, w->userdata);
+	memcpy(w->yj, y, sizeof(*y)*n);
+	for (j=0; j < n; j++)
+	{
+		// a step of about sqrt(eps) relative to y, or to the
+		// size below which atol takes over from rtol
+		delta = sqrtf(FLT_EPSILON)*fmaxf(fabsf(y[j]), w->threshold);
+		if (!(delta > 0.))
+		{
+			delta = sqrtf(FLT_EPSILON);
+		}
+		w->yj[j] = y[j] + delta;
+		// the step actually taken after rounding
+		delta = w->yj[j] - y[j];
+		(*w->f)(t, w->yj, w->fj, n, w->userdata);
+		for (i=0; i < n; i++)
+		{
+			w->J->A[i][j] = (w->fj[i] - w->fy[i])/delta;
+		}
+		w->yj[j] = y[j];
+	}
+	w->count.evaluations += n+1;
+}
+
+// factor I - c*J into w->lu
+static int iteration_matrix(struct bdf_work *w, double c)
+{
+	unsigned int n=w->n;
+	unsigned int i,j;
+
+	for (i=0; i < n; i++)
+	{
+		for (j=0; j < n; j++)
+		{
+			w->M->A[i][j] = -c*w->J->A[i][j];
+		}
+		w->M->A[i][i] += 1.;
+	}
+
+	lu_handle_release(w->lu);
+	w->count.factorizations++;
+	if ((w->lu = lu_handle_factor(w->M, LU_PARTIAL_PIVOTING)) == NULL)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+// simplified Newton iteration for y = predict + d with
+// (I - c*J) dy = c*f(t, y) - psi - d, the iteration is given up as
+// soon as the rate of convergence says it won't reach tol in time
+static int newton(struct bdf_work *w, double t, double c, double tol,
+		unsigned int *iterations)
+{
+	unsigned int n=w->n;
+	unsigned int i,k;
+	double norm,norm_old,rate;
+	float *y=w->y+1;
+
+	memcpy(y, w->predict, sizeof(*y)*n);
+	memset(w->d, 0, sizeof(*w->d)*n);
+	norm_old = -1.;
+	rate = 0.;
+
+	for (k=0; k < BDF_NEWTON_MAXITER; k++)
+	{
+		*iterations = k+1;
+		(*w->f)(t, y, w->fy, n, w->userdata);
+		w->count.evaluations++;
+		for (i=0; i < n; i++)
+		{
+			if (!isfinite(w->fy[i]))
+			{
+				return 1;
+			}
+			w->b->a[i] = c*w->fy[i] - w->psi[i] - w->d[i];
+		}
+		if (lu_handle_solve(w->lu, w->dy, w->b) != 0)
+		{
+			return 1;
+		}
+		norm = error_norm(n, w->dy->a, w->scale);
+
+		if (norm_old >= 0.)
+		{
+			rate = norm/norm_old;
+			if (rate >= 1.
+					|| pow(rate, BDF_NEWTON_MAXITER - k)/(1 - rate)*norm > tol)
+			{
+				return 1;
+			}
+		}
+		for (i=0; i < n; i++)
+		{
+			y[i] += w->dy->a[i];
+			w->d[i] += w->dy->a[i];
+		}
+		if (norm == 0. || (norm_old >= 0. && rate/(1 - rate)*norm < tol))
+		{
+			return 0;
+		}
+		norm_old = norm;
+	}
+	return 1;
+}
+
+// allocate the work of an integration of n equations
+static int work_allocate(struct bdf_work *w, unsigned int n)
+{
+	float *a;
+
+	if ((a = vector_allocate((BDF_MAX_ORDER+3)*n + 7*n + 2*(n+1))) == NULL)
+	{
+		return 1;
+	}
+	w->n = n;
+	w->D = a;
+	w->predict = w->D + (BDF_MAX_ORDER+3)*n;
+	w->psi = w->predict + n;
+	w->scale = w->psi + n;
+	w->d = w->scale + n;
+	w->fy = w->d + n;
+	w->fj = w->fy + n;
+	w->yj = w->fj + n;
+	w->y = w->yj + n;
+	w->row = w->y + n+1;
+	w->lu = NULL;
+
+	if ((w->b = zero_vector(n)) == NULL
+			|| (w->dy = zero_vector(n)) == NULL
+			|| (w->J = zero_matrix(n, n)) == NULL
+			|| (w->M = zero_matrix(n, n)) == NULL)
+	{
+		work_free(w);
+		return 1;
+	}
+	return 0;
+}
+
+// free the work of an integration
+static void work_free(struct bdf_work *w)
+{
+	if (w->b != NULL)
+	{
+		free_vector(w->b);
+	}
+	if (w->dy != NULL)
+	{
+		free_vector(w->dy);
+	}
+	if (w->J != NULL)
+	{
+		free_matrix(w->J);
+	}
+	if (w->M != NULL)
+	{
+		free_matrix(w->M);
+	}
+	lu_handle_release(w->lu);
+	free(w->D);
+}
+
+// solution rows at t = tmin, tmin+dt, ... up to tmax
+matrix bdf(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order,
+		struct ode_stats *stats)
+{
+	matrix Y;
+	ode_stream out;
+
+	if (!(dt > 0.) || !(tmax > tmin))
+	{
+		fprintf(stderr,"Error: output interval must be positive\n");
+		return NULL;
+	}
+
+	if ((Y=zero_matrix(dense_rows(tmin, tmax, dt), f->n+1)) == NULL)
+	{
+		return NULL;
+	}
+	if ((out=ode_stream_into(Y, 1)) == NULL)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+	if (bdf_stream(f, y0, tmin, tmax, rtol, atol, dt, order, out, stats) != 0
+			|| ode_stream_close(out) != 0)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+
+	return Y;
+}
+
+// the same rows pushed to out, or one row per step when dt == 0
+int bdf_stream(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order, ode_stream out,
+		struct ode_stats *stats)
+{
+	struct vecfunc_adapter adapter;
+	int status;
+
+	if (f->n != y0->n)
+	{
+		fprintf(stderr,"System has inconsistent dimensions\n");
+		return 1;
+	}
+	if (vecfunc_adapter_init(&adapter, f) != 0)
+	{
+		return 1;
+	}
+	status = bdf_rhs(&vecfunc_rhs, NULL, &adapter, y0, tmin, tmax, rtol, atol,
+			dt, order, out, stats);
+	vecfunc_adapter_free(&adapter);
+
+	return status;
+}
+
+// the same for a right hand side computed a whole vector at a time
+int bdf_rhs(ode_rhs f, ode_jacobian jac, void *userdata, vector y0,
+		float tmin, float tmax, float rtol, float atol, float dt,
+		unsigned int order, ode_stream out, struct ode_stats *stats)
+{
+	struct bdf_work w;
+	unsigned int n=y0->n;
+	unsigned int i,j,k,q,rows,next_row,equal_steps,iterations;
+	float *D;
+	double gamma[BDF_MAX_ORDER+2],error_const[BDF_MAX_ORDER+2];
+	double t,t_new,t_out,h,c,x,p,sum,newton_tol,safety,factor,best;
+	double err,err_q[3];
+	int converged,current_jac,status;
+
+	if (!(tmax > tmin) || !(rtol >= 0.) || !(atol >= 0.) || rtol+atol <= 0.
+			|| !(dt >= 0.))
+	{
+		fprintf(stderr,"Error: invalid interval or tolerances\n");
+		return 1;
+	}
+	if (order < 1 || order > BDF_MAX_ORDER)
+	{
+		fprintf(stderr,"Error: BDF order must be 1 to %d\n",BDF_MAX_ORDER);
+		return 1;
+	}
+
+	memset(&w, 0, sizeof(w));
+	w.f = f;
+	w.jac = jac;
+	w.userdata = userdata;
+	// Newton can't converge much beyond float rounding
+	if (rtol < 10*FLT_EPSILON)
+	{
+		rtol = 10*FLT_EPSILON;
+	}
+	w.threshold = atol/rtol;
+	if (work_allocate(&w, n) != 0)
+	{
+		return 1;
+	}
+	D = w.D;
+
+	// gamma[k] = 1 + 1/2 + ... + 1/k, the leading coefficient of
+	// the order k formula, and the constants of its local error
+	gamma[0] = 0.;
+	error_const[0] = 1.;
+	for (k=1; k <= BDF_MAX_ORDER+1; k++)
+	{
+		gamma[k] = gamma[k-1] + 1./k;
+		error_const[k] = 1./(k+1);
+	}
+	// Newton needs to be more accurate than the error test,
+	// but not beyond what float can hold
+	newton_tol = fmax(10*FLT_EPSILON/rtol, fmin(0.03, sqrt(rtol)));
+
+	// initial conditions
+	t = tmin;
+	w.y[0] = tmin;
+	for (i=0; i < n; i++)
+	{
+		D[i] = y0->a[i];
+		w.y[i+1] = y0->a[i];
+		w.scale[i] = atol + rtol*fabsf(y0->a[i]);
+	}
+	rows = (dt > 0.) ? dense_rows(tmin, tmax, dt) : 0;
+	next_row = 1;
+	status = ode_stream_push(out, w.y);
+
+	(*f)(t, D, w.fy, n, userdata);
+	w.count.evaluations++;
+	h = initial_step(&w, t, tmax, rtol, atol);
+	for (i=0; i < n; i++)
+	{
+		D[n+i] = h*w.fy[i];
+	}
+	jacobian(&w, t, D);
+	current_jac = 1;
+	q = 1;
+	equal_steps = 0;
+
+	while (status == 0 && t < tmax)
+	{
+		// try the step until it is accepted
+		for (;;)
+		{
+			if (!(h > 10*DBL_EPSILON*fabs(t)) || !(h > DBL_MIN))
+			{
+				fprintf(stderr,"Error: step size too small at t = %g\n",t);
+				status = 1;
+				break;
+			}
+
+			// don't step past tmax
+			t_new = t + h;
+			if (t_new >= tmax)
+			{
+				t_new = tmax;
+				change_differences(&w, q, (t_new - t)/h);
+				equal_steps = 0;
+				lu_handle_release(w.lu);
+				w.lu = NULL;
+			}
+			h = t_new - t;
+
+			// predict y_n+1 by extrapolating the differences,
+			// psi is the rest of the formula that doesn't depend on it
+			for (i=0; i < n; i++)
+			{
+				sum = 0.;
+				for (k=0; k <= q; k++)
+				{
+					sum += D[k*n+i];
+				}
+				w.predict[i] = sum;
+				w.scale[i] = atol + rtol*fabs(sum);
+				sum = 0.;
+				for (k=1; k <= q; k++)
+				{
+					sum += gamma[k]*D[k*n+i];
+				}
+				w.psi[i] = sum/gamma[q];
+			}
+
+			// Newton with the factors we have, then with a fresh
+			// Jacobian if the old one doesn't do it any more
+			c = h/gamma[q];
+			converged = 0;
+			iterations = 0;
+			for (;;)
+			{
+				if (w.lu == NULL && iteration_matrix(&w, c) != 0)
+				{
+					break;
+				}
+				if (newton(&w, t_new, c, newton_tol, &iterations) == 0)
+				{
+					converged = 1;
+					break;
+				}
+				if (current_jac)
+				{
+					break;
+				}
+				jacobian(&w, t_new, w.predict);
+				current_jac = 1;
+				lu_handle_release(w.lu);
+				w.lu = NULL;
+			}
+			if (!converged)
+			{
+				w.count.rejected++;
+				h *= 0.5;
+				change_differences(&w, q, 0.5);
+				equal_steps = 0;
+				lu_handle_release(w.lu);
+				w.lu = NULL;
+				continue;
+			}
+
+			// the error test, a rejected step is retried smaller so
+			// I - c J has to be factored again for the new c
+			safety = 0.9*(2*BDF_NEWTON_MAXITER + 1)/(2*BDF_NEWTON_MAXITER
+					+ iterations);
+			for (i=0; i < n; i++)
+			{
+				w.scale[i] = atol + rtol*fabsf(w.y[i+1]);
+				w.fj[i] = error_const[q]*w.d[i];
+			}
+			err = error_norm(n, w.fj, w.scale);
+			if (err > 1.)
+			{
+				w.count.rejected++;
+				factor = fmax(BDF_FACMIN, safety*pow(err, -1./(q+1)));
+				h *= factor;
+				change_differences(&w, q, factor);
+				equal_steps = 0;
+				lu_handle_release(w.lu);
+				w.lu = NULL;
+				continue;
+			}
+			break;
+		}
+		if (status != 0)
+		{
+			break;
+		}
+
+		// accepted
+		w.count.steps++;
+		equal_steps++;
+		current_jac = 0;
+		w.y[0] = t_new;
+
+		// D[q+1] of y_n+1 is d, update the lower differences from it
+		for (i=0; i < n; i++)
+		{
+			D[(q+2)*n+i] = w.d[i] - D[(q+1)*n+i];
+			D[(q+1)*n+i] = w.d[i];
+		}
+		for (k=q+1; k >= 1; k--)
+		{
+			for (i=0; i < n; i++)
+			{
+				D[(k-1)*n+i] += D[k*n+i];
+			}
+		}
+
+		if (dt > 0.)
+		{
+			// the interpolating polynomial through the last q+1 points
+			// y(s) = D[0] + sum_j D[j] prod_{l<j} (s - t_new + l*h)/((l+1)*h)
+			while (next_row < rows && status == 0)
+			{
+				t_out = tmin + next_row*(double)dt;
+				if (t_new < tmax && t_out > t_new)
+				{
+					break;
+				}
+				w.row[0] = t_out;
+				for (i=0; i < n; i++)
+				{
+					sum = D[i];
+					p = 1.;
+					for (j=1; j <= q; j++)
+					{
+						x = (t_out - (t_new - (j-1)*h))/(j*h);
+						p *= x;
+						sum += D[j*n+i]*p;
+					}
+					w.row[i+1] = sum;
+				}
+				status = ode_stream_push(out, w.row);
+				next_row++;
+			}
+		}
+		else
+		{
+			status = ode_stream_push(out, w.y);
+		}
+		t = t_new;
+
+		// change the order and step after q+1 steps of the same size,
+		// to whichever of orders q-1, q and q+1 allows the longest step
+		if (equal_steps < q+1)
+		{
+			continue;
+		}
+		err_q[0] = HUGE_VAL;
+		err_q[1] = err;
+		err_q[2] = HUGE_VAL;
+		if (q > 1)
+		{
+			for (i=0; i < n; i++)
+			{
+				w.fj[i] = error_const[q-1]*D[q*n+i];
+			}
+			err_q[0] = error_norm(n, w.fj, w.scale);
+		}
+		if (q < order)
+		{
+			for (i=0; i < n; i++)
+			{
+				w.fj[i] = error_const[q+1]*D[(q+2)*n+i];
+			}
+			err_q[2] = error_norm(n, w.fj, w.scale);
+		}
+		best = -1.;
+		k = 0;
+		for (j=0; j < 3; j++)
+		{
+			factor = pow(err_q[j], -1./(q+j));
+			if (factor > best)
+			{
+				best = factor;
+				k = j;
+			}
+		}
+		q = q+k-1;
+
+		factor = fmin(BDF_FACMAX, safety*best);
+		h *= factor;
+		change_differences(&w, q, factor);
+		equal_steps = 0;
+		lu_handle_release(w.lu);
+		w.lu = NULL;
+	}
+
+	if (stats != NULL)
+	{
+		*stats = w.count;
+	}
+	work_free(&w);
+	return status;
+}
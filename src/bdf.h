@@ -0,0 +1,48 @@
+/* Backward differentiation formulas, implicit methods
+ * for stiff ODE's of form dy/dt = f(t,y), y(0) = y0
+ * Oct 18 2026 */
+
+#ifndef BDF_H
+#define BDF_H
+
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "vector_function.h"
+#include "linear_system.h"
+#include "ode_stream.h"
+
+// highest order used, order 1 is backward Euler
+#define BDF_MAX_ORDER 5
+// Newton iterations tried before the step is retried
+#define BDF_NEWTON_MAXITER 4
+// a step shrinks by at most this
+#define BDF_FACMIN 0.2
+// and grows by at most this
+#define BDF_FACMAX 10.
+
+// the Jacobian J[i][j] = df_i/dy_j at (t, y), J is n x n
+typedef void (*ode_jacobian)(double t, const float *y, matrix J, int n,
+		void *userdata);
+
+// solution rows [t y1 ... yn] at t = tmin, tmin+dt, ... up to tmax
+// by variable step BDF of order 1 up to order, each component is kept
+// within atol + rtol*|y| per step, rtol is at least 10*FLT_EPSILON,
+// the Jacobian is found by finite differences, stats may be NULL
+extern matrix bdf(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order,
+		struct ode_stats *stats);
+// the same rows pushed to out, or with dt == 0 one row for
+// every step taken, returns 0 on success
+extern int bdf_stream(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order, ode_stream out,
+		struct ode_stats *stats);
+// the same for a right hand side computed a whole vector at a time
+// jac may be NULL to use finite differences
+extern int bdf_rhs(ode_rhs f, ode_jacobian jac, void *userdata, vector y0,
+		float tmin, float tmax, float rtol, float atol, float dt,
+		unsigned int order, ode_stream out, struct ode_stats *stats);
+
+#endif
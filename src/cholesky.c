@@ -0,0 +1,805 @@
+/* Cholesky and LDL^T factorizations of symmetric matrices
+ * Oct 18 2026 */
+
+#include "cholesky.h"
+
+// the trailing triangle handed out CHOLESKY_BLOCK rows at a time
+// L(r0:n,r0:n) -= A(r0:n,ja:ja+kb) B(r0:n,jb:jb+kb)^T
+struct lower_job
+{
+	float **L;
+	unsigned int n;
+	unsigned int r0; // the first row, and column, being updated
+	unsigned int kb;
+	float **A, **B;
+	unsigned int ja, jb;
+	float **P; // if not NULL, a panel to copy to L(r0:n,k0:k0+kb) first
+	unsigned int k0;
+	int failed; // set by a task that ran out of memory
+};
+
+// the factorizations kept by symmetric_solve()
+struct cholesky_entry
+{
+	matrix A;
+	cholesky_handle h;
+	struct cholesky_entry *next;
+};
+static pthread_mutex_t cholesky_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct cholesky_entry *cholesky_entries;
+
+cholesky_handle cholesky_factor(matrix A);
+cholesky_handle ldlt_factor(matrix A);
+cholesky_handle cholesky_retain(cholesky_handle h);
+void cholesky_release(cholesky_handle h);
+int cholesky_solve(cholesky_handle h, vector x, vector b);
+int cholesky_solve_many(cholesky_handle h, matrix B, matrix X);
+size_t cholesky_bytes(cholesky_handle h);
+double cholesky_logdet(cholesky_handle h, int *sign);
+int symmetric_solve(matrix A, vector x, vector b);
+void free_symmetric(matrix A);
+void free_all_symmetric(void);
+
+// floats in rows 0..n-1 of the padded lower triangle
+static size_t triangle_size(unsigned int n);
+// a handle holding the lower triangle of A, not yet factored
+static cholesky_handle new_factorization(matrix A, int kind);
+// LL^T in place, returns 1 if A isn't positive definite, -1 if out
+// of memory
+static int cholesky_blocked(cholesky_handle h);
+// Bunch-Kaufman LDL^T in place, from LAPACK's lasyf
+// returns 1 if A is singular, -1 if out of memory
+static int ldlt_blocked(cholesky_handle h);
+// the trailing triangle takes the panel by blocks of rows,
+// returns 1 if out of memory
+static int update_lower(struct lower_job *job);
+static void update_task(void *arg, unsigned int t);
+
+cholesky_handle cholesky_factor(matrix A)
+{
+	cholesky_handle h;
+	int status;
+
+	if ((h = new_factorization(A, CHOLESKY_LLT)) == NULL)
+	{
+		return NULL;
+	}
+	if ((status = cholesky_blocked(h)) != 0)
+	{
+		if (status > 0)
+		{
+			fprintf(stderr,"Matrix is not positive definite\n");
+		}
+		cholesky_release(h);
+		return NULL;
+	}
+	return h;
+}
+
+cholesky_handle ldlt_factor(matrix A)
+{
+	cholesky_handle h;
+	int status;
+
+	if ((h = new_factorization(A, CHOLESKY_LDLT)) == NULL)
+	{
+		return NULL;
+	}
+	if ((status = ldlt_blocked(h)) != 0)
+	{
+		if (status > 0)
+		{
+			fprintf(stderr,"No unique solution\n");
+		}
+		cholesky_release(h);
+		return NULL;
+	}
+	return h;
+}
+
+// take another reference to a factorization
+cholesky_handle cholesky_retain(cholesky_handle h)
+{
+	__atomic_add_fetch(&h->refs, 1, __ATOMIC_RELAXED);
+	return h;
+}
+
+// drop a reference, the last one frees the factorization
+void cholesky_release(cholesky_handle h)
+{
+	if (h == NULL || __atomic_sub_fetch(&h->refs, 1, __ATOMIC_ACQ_REL) != 0)
+	{
+		return;
+	}
+	free(h->data);
+	free(h->L);
+	free(h->d);
+	free(h->e);
+	free(h->ipiv);
+	free(h);
+}
+
+// x = P^T L^-T D^-1 L^-1 P b
+int cholesky_solve(cholesky_handle h, vector x, vector b)
+{
+	float **L=h->L;
+	float *y,t;
+	float akm1k,akm1,ak,denom,bkm1,bk;
+	unsigned int n=h->n,i;
+
+	if (b->n != n || x->n != n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((y = malloc(sizeof(*y)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	memcpy(y, b->a, sizeof(*y)*n);
+
+	for (i=0; h->ipiv != NULL && i < n; i++)
+	{
+		t = y[i];
+		y[i] = y[h->ipiv[i]];
+		y[h->ipiv[i]] = t;
+	}
+	for (i=0; i < n; i++)
+	{
+		y[i] = (y[i] - mathlib_kernels->dot(i, L[i], y))/L[i][i];
+	}
+	for (i=0; h->d != NULL && i < n; i++)
+	{
+		if (h->e[i] == 0.)
+		{
+			y[i] /= h->d[i];
+			continue;
+		}
+		// a 2x2 block as in LAPACK's sytrs
+		akm1k = h->e[i];
+		akm1 = h->d[i]/akm1k;
+		ak = h->d[i+1]/akm1k;
+		denom = akm1*ak - 1.;
+		bkm1 = y[i]/akm1k;
+		bk = y[i+1]/akm1k;
+		y[i] = (ak*bkm1 - bk)/denom;
+		y[i+1] = (akm1*bk - bkm1)/denom;
+		i++;
+	}
+	// L^T a column of L^T, which is a row of L, at a time
+	for (i=n; i-- > 0; )
+	{
+		y[i] /= L[i][i];
+		mathlib_kernels->axpy(i, -y[i], L[i], y);
+	}
+	for (i=n; h->ipiv != NULL && i-- > 0; )
+	{
+		t = y[i];
+		y[i] = y[h->ipiv[i]];
+		y[h->ipiv[i]] = t;
+	}
+
+	memcpy(x->a, y, sizeof(*y)*n);
+	free(y);
+	return 0;
+}
+
+// the same with the off diagonal blocks of L applied by matrix products
+int cholesky_solve_many(cholesky_handle h, matrix B, matrix X)
+{
+	matrix C;
+	float **L=h->L,**Y;
+	float akm1k,akm1,ak,denom,bkm1,bk;
+	unsigned int n=h->n,s=B->m;
+	unsigned int ib,rb,i,j,q;
+
+	if (B->n != n || X->n != n || X->m != s)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((C = zero_matrix(n, s)) == NULL)
+	{
+		return 1;
+	}
+	matrix_set(C, B);
+	Y = C->A;
+
+	for (i=0; h->ipiv != NULL && i < n; i++)
+	{
+		row_swap(Y, i, h->ipiv[i]);
+	}
+
+	// L Y = C a block of rows at a time
+	for (ib=0; ib < n; ib += CHOLESKY_BLOCK)
+	{
+		rb = (n - ib < CHOLESKY_BLOCK) ? n - ib : CHOLESKY_BLOCK;
+		if (ib > 0 && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, rb, s, ib,
+					-1., L + ib, 0, Y, 0, 1., Y + ib, 0) != 0)
+		{
+			free_matrix(C);
+			return 1;
+		}
+		for (i=ib; i < ib+rb; i++)
+		{
+			for (j=ib; j < i; j++)
+			{
+				mathlib_kernels->axpy(s, -L[i][j], Y[j], Y[i]);
+			}
+			mathlib_kernels->scal(s, 1./L[i][i], Y[i]);
+		}
+	}
+
+	for (i=0; h->d != NULL && i < n; i++)
+	{
+		if (h->e[i] == 0.)
+		{
+			mathlib_kernels->scal(s, 1./h->d[i], Y[i]);
+			continue;
+		}
+		akm1k = h->e[i];
+		akm1 = h->d[i]/akm1k;
+		ak = h->d[i+1]/akm1k;
+		denom = akm1*ak - 1.;
+		for (q=0; q < s; q++)
+		{
+			bkm1 = Y[i][q]/akm1k;
+			bk = Y[i+1][q]/akm1k;
+			Y[i][q] = (ak*bkm1 - bk)/denom;
+			Y[i+1][q] = (akm1*bk - bkm1)/denom;
+		}
+		i++;
+	}
+
+	// L^T X = Y from the last block of rows up
+	for (ib=((n-1)/CHOLESKY_BLOCK)*CHOLESKY_BLOCK; ; ib -= CHOLESKY_BLOCK)
+	{
+		rb = (n - ib < CHOLESKY_BLOCK) ? n - ib : CHOLESKY_BLOCK;
+		for (i=ib+rb; i-- > ib; )
+		{
+			mathlib_kernels->scal(s, 1./L[i][i], Y[i]);
+			for (j=ib; j < i; j++)
+			{
+				mathlib_kernels->axpy(s, -L[i][j], Y[i], Y[j]);
+			}
+		}
+		if (ib == 0)
+		{
+			break;
+		}
+		if (gemm_blocked(MATRIX_TRANS, MATRIX_NOTRANS, ib, s, rb, -1.,
+				L + ib, 0, Y + ib, 0, 1., Y, 0) != 0)
+		{
+			free_matrix(C);
+			return 1;
+		}
+	}
+
+	for (i=n; h->ipiv != NULL && i-- > 0; )
+	{
+		row_swap(Y, i, h->ipiv[i]);
+	}
+	matrix_set(X, C);
+	free_matrix(C);
+	return 0;
+}
+
+size_t cholesky_bytes(cholesky_handle h)
+{
+	size_t bytes;
+
+	bytes = sizeof(*h) + sizeof(*h->data)*triangle_size(h->n)
+		+ sizeof(*h->L)*h->n;
+	if (h->kind == CHOLESKY_LDLT)
+	{
+		bytes += (sizeof(*h->d) + sizeof(*h->e) + sizeof(*h->ipiv))*h->n;
+	}
+	return bytes;
+}
+
+// log|det A|, twice the log of the product of the diagonal of L, or
+// the sum over the 1x1 and 2x2 blocks of D for LDL^T, whose symmetric
+// interchanges leave the sign alone
+double cholesky_logdet(cholesky_handle h, int *sign)
+{
+	double logdet=0.,det;
+	unsigned int k;
+	int s=1;
+
+	for (k=0; k < h->n; k++)
+	{
+		if (h->kind == CHOLESKY_LLT)
+		{
+			det = (double)h->L[k][k]*h->L[k][k];
+		}
+		else if (h->e[k] == 0.)
+		{
+			det = h->d[k];
+		}
+		else
+		{
+			det = (double)h->d[k]*h->d[k+1] - (double)h->e[k]*h->e[k];
+			k++;
+		}
+		if (det == 0.)
+		{
+			s = 0;
+			logdet = -INFINITY;
+			break;
+		}
+		if (det < 0.)
+		{
+			s = -s;
+		}
+		logdet += log(fabs(det));
+	}
+	if (sign != NULL)
+	{
+		*sign = s;
+	}
+	return logdet;
+}
+
+// solve the symmetric Ax=b with the kept factorization of A
+int symmetric_solve(matrix A, vector x, vector b)
+{
+	struct cholesky_entry *e;
+	cholesky_handle h=NULL,f;
+	int status;
+
+	pthread_mutex_lock(&cholesky_lock);
+	for (e=cholesky_entries; e != NULL; e=e->next)
+	{
+		if (e->A == A)
+		{
+			h = cholesky_retain(e->h);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cholesky_lock);
+
+	// if A has not been factored yet now is the time
+	if (h == NULL)
+	{
+		if ((f = new_factorization(A, CHOLESKY_LLT)) == NULL)
+		{
+			return 1;
+		}
+		// an indefinite A only costs the columns up to a bad pivot,
+		// and isn't an error here so cholesky_factor() isn't used
+		if ((status = cholesky_blocked(f)) != 0)
+		{
+			cholesky_release(f);
+			if (status < 0 || (f = ldlt_factor(A)) == NULL)
+			{
+				return 1;
+			}
+		}
+		if ((e = malloc(sizeof(*e))) == NULL)
+		{
+			perror("Error allocating memory");
+			cholesky_release(f);
+			return 1;
+		}
+		pthread_mutex_lock(&cholesky_lock);
+		// another thread may have factored A meanwhile
+		for (e->next=cholesky_entries; e->next != NULL; e->next=e->next->next)
+		{
+			if (e->next->A == A)
+			{
+				h = cholesky_retain(e->next->h);
+				break;
+			}
+		}
+		if (h == NULL)
+		{
+			e->A = A;
+			e->h = f;
+			e->next = cholesky_entries;
+			cholesky_entries = e;
+			h = cholesky_retain(f);
+			f = NULL;
+			e = NULL;
+		}
+		pthread_mutex_unlock(&cholesky_lock);
+		free(e);
+		cholesky_release(f);
+	}
+
+	status = cholesky_solve(h, x, b);
+	cholesky_release(h);
+	return status;
+}
+
+// forget the factorization of A
+void free_symmetric(matrix A)
+{
+	struct cholesky_entry **p,*e;
+
+	pthread_mutex_lock(&cholesky_lock);
+	for (p=&cholesky_entries; *p != NULL; p=&(*p)->next)
+	{
+		if ((*p)->A == A)
+		{
+			e = *p;
+			*p = e->next;
+			cholesky_release(e->h);
+			free(e);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cholesky_lock);
+}
+
+void free_all_symmetric(void)
+{
+	struct cholesky_entry *e,*next;
+
+	pthread_mutex_lock(&cholesky_lock);
+	for (e=cholesky_entries; e != NULL; e=next)
+	{
+		next = e->next;
+		cholesky_release(e->h);
+		free(e);
+	}
+	cholesky_entries = NULL;
+	pthread_mutex_unlock(&cholesky_lock);
+}
+
+// a row of a block of rows is as long as the last row of the block, so
+// the diagonal blocks can be updated whole, the part of them above the
+// diagonal is scratch
+static size_t triangle_size(unsigned int n)
+{
+	size_t blocks=(n + CHOLESKY_BLOCK - 1)/CHOLESKY_BLOCK;
+
+	return (size_t)CHOLESKY_BLOCK*CHOLESKY_BLOCK*blocks*(blocks + 1)/2;
+}
+
+static cholesky_handle new_factorization(matrix A, int kind)
+{
+	cholesky_handle h;
+	size_t offset;
+	unsigned int n=A->n,i,j;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Matrix is not square\n");
+		return NULL;
+	}
+	if (n == 0)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return NULL;
+	}
+
+	if ((h = calloc(1, sizeof(*h))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	h->n = n;
+	h->kind = kind;
+	h->refs = 1;
+	if ((errno = posix_memalign((void **)&h->data, MATRIX_ALIGN,
+			sizeof(*h->data)*triangle_size(n))) != 0)
+	{
+		perror("Error allocating memory");
+		free(h);
+		return NULL;
+	}
+	memset(h->data, 0, sizeof(*h->data)*triangle_size(n));
+	if ((h->L = malloc(sizeof(*h->L)*n)) == NULL
+			|| (kind == CHOLESKY_LDLT
+				&& ((h->d = calloc(n, sizeof(*h->d))) == NULL
+				|| (h->e = calloc(n, sizeof(*h->e))) == NULL
+				|| (h->ipiv = calloc(n, sizeof(*h->ipiv))) == NULL)))
+	{
+		perror("Error allocating memory");
+		cholesky_release(h);
+		return NULL;
+	}
+
+	// the lower triangle of A
+	offset = 0;
+	for (i=0; i < n; i++)
+	{
+		h->L[i] = h->data + offset;
+		offset += (i/CHOLESKY_BLOCK + 1)*CHOLESKY_BLOCK;
+		if (A->flags & MATRIX_TRANSPOSED)
+		{
+			for (j=0; j <= i; j++)
+			{
+				h->L[i][j] = A->A[j][i];
+			}
+		}
+		else
+		{
+			memcpy(h->L[i], A->A[i], sizeof(**h->L)*(i+1));
+		}
+	}
+	return h;
+}
+
+// right looking, the diagonal block is factored and inverted, the panel
+// below it is A21 L11^-T by one matrix product into P, where the rows
+// are close together for the products that update the trailing triangle
+static int cholesky_blocked(cholesky_handle h)
+{
+	struct lower_job job;
+	matrix P,Linv;
+	float **L=h->L,**V;
+	unsigned int n=h->n,k,kb,i,j,l;
+	float s;
+
+	if ((P = zero_matrix(n, CHOLESKY_BLOCK)) == NULL
+			|| (Linv = zero_matrix(CHOLESKY_BLOCK, CHOLESKY_BLOCK)) == NULL)
+	{
+		free_matrix(P);
+		return -1;
+	}
+	V = Linv->A;
+	job.L = L;
+	job.n = n;
+	job.A = P->A;
+	job.B = P->A;
+	job.ja = 0;
+	job.jb = 0;
+	job.P = P->A;
+	for (k=0; k < n; k += CHOLESKY_BLOCK)
+	{
+		kb = (n - k < CHOLESKY_BLOCK) ? n - k : CHOLESKY_BLOCK;
+		for (j=k; j < k+kb; j++)
+		{
+			s = L[j][j] - mathlib_kernels->dot(j-k, L[j]+k, L[j]+k);
+			// not positive catches a NaN too
+			if (!(s > 0.))
+			{
+				free_matrix(P);
+				free_matrix(Linv);
+				return 1;
+			}
+			L[j][j] = sqrtf(s);
+			for (i=j+1; i < k+kb; i++)
+			{
+				L[i][j] = (L[i][j] - mathlib_kernels->dot(j-k, L[i]+k, L[j]+k))/L[j][j];
+			}
+		}
+		if (k + kb == n)
+		{
+			break;
+		}
+
+		// L11^-1 a column at a time
+		for (j=0; j < kb; j++)
+		{
+			V[j][j] = 1./L[k+j][k+j];
+			for (i=j+1; i < kb; i++)
+			{
+				s = 0.;
+				for (l=j; l < i; l++)
+				{
+					s += L[k+i][k+l]*V[l][j];
+				}
+				V[i][j] = -s/L[k+i][k+i];
+			}
+		}
+		job.r0 = k + kb;
+		job.kb = kb;
+		job.k0 = k;
+		if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, n-job.r0, kb, kb, 1.,
+					L + job.r0, k, V, 0, 0., P->A + job.r0, 0) != 0
+				|| update_lower(&job) != 0)
+		{
+			free_matrix(P);
+			free_matrix(Linv);
+			return -1;
+		}
+	}
+	free_matrix(P);
+	free_matrix(Linv);
+	return 0;
+}
+
+// the columns of a panel are made one at a time in W from the original
+// columns and the panel so far, W = L D, choosing 1x1 or 2x2 pivots by
+// Bunch and Kaufman's test, the interchanges are applied to the whole
+// rows of L so that PAP^T = LDL^T with a single P, then the trailing
+// triangle takes L W^T once per panel
+static int ldlt_blocked(cholesky_handle h)
+{
+	struct lower_job job;
+	matrix Wm;
+	float **L=h->L,**W;
+	unsigned int n=h->n,k,k0,c,i,imax,kp,kk,kstep;
+	double absakk,colmax,rowmax;
+	float d11,d22,d21,t,r1;
+
+	if ((Wm = zero_matrix(n, CHOLESKY_BLOCK + 1)) == NULL)
+	{
+		return -1;
+	}
+	W = Wm->A;
+	job.L = L;
+	job.n = n;
+	job.A = L;
+	job.B = W;
+	job.jb = 0;
+	job.P = NULL;
+
+	for (k=0; k < n; )
+	{
+		k0 = k;
+		while (k < n && k - k0 < CHOLESKY_BLOCK)
+		{
+			c = k - k0;
+			for (i=k; i < n; i++)
+			{
+				W[i][c] = L[i][k] - mathlib_kernels->dot(c, L[i]+k0, W[k]);
+			}
+
+			kstep = 1;
+			absakk = fabs(W[k][c]);
+			imax = k;
+			colmax = 0.;
+			for (i=k+1; i < n; i++)
+			{
+				if (fabs(W[i][c]) > colmax)
+				{
+					colmax = fabs(W[i][c]);
+					imax = i;
+				}
+			}
+			if (absakk == 0. && colmax == 0.)
+			{
+				free_matrix(Wm);
+				return 1;
+			}
+
+			if (absakk >= LDLT_ALPHA*colmax)
+			{
+				kp = k;
+			}
+			else
+			{
+				// column imax brought up to date in W(:,c+1)
+				for (i=k; i < imax; i++)
+				{
+					W[i][c+1] = L[imax][i];
+				}
+				for (i=imax; i < n; i++)
+				{
+					W[i][c+1] = L[i][imax];
+				}
+				rowmax = 0.;
+				for (i=k; i < n; i++)
+				{
+					W[i][c+1] -= mathlib_kernels->dot(c, L[i]+k0, W[imax]);
+					if (i != imax && fabs(W[i][c+1]) > rowmax)
+					{
+						rowmax = fabs(W[i][c+1]);
+					}
+				}
+
+				if (absakk >= LDLT_ALPHA*colmax*(colmax/rowmax))
+				{
+					kp = k;
+				}
+				else if (fabs(W[imax][c+1]) >= LDLT_ALPHA*rowmax)
+				{
+					kp = imax;
+					for (i=k; i < n; i++)
+					{
+						W[i][c] = W[i][c+1];
+					}
+				}
+				else
+				{
+					kp = imax;
+					kstep = 2;
+				}
+			}
+
+			// the untouched column kk moves to kp, it is replaced by W
+			kk = k + kstep - 1;
+			if (kp != kk)
+			{
+				L[kp][kp] = L[kk][kk];
+				for (i=kk+1; i < kp; i++)
+				{
+					L[kp][i] = L[i][kk];
+				}
+				for (i=kp+1; i < n; i++)
+				{
+					L[i][kp] = L[i][kk];
+				}
+				mathlib_kernels->swap(kk, L[kk], L[kp]);
+				row_swap(W, kk, kp);
+			}
+
+			if (kstep == 1)
+			{
+				h->d[k] = W[k][c];
+				r1 = 1./W[k][c];
+				for (i=k+1; i < n; i++)
+				{
+					L[i][k] = W[i][c]*r1;
+				}
+				L[k][k] = 1.;
+				h->ipiv[k] = kp;
+			}
+			else
+			{
+				// L(:,k:k+1) = W(:,c:c+1) D^-1 as in LAPACK's lasyf
+				d21 = W[k+1][c];
+				d11 = W[k+1][c+1]/d21;
+				d22 = W[k][c]/d21;
+				t = 1./(d11*d22 - 1.);
+				d21 = t/d21;
+				for (i=k+2; i < n; i++)
+				{
+					L[i][k] = d21*(d11*W[i][c] - W[i][c+1]);
+					L[i][k+1] = d21*(d22*W[i][c+1] - W[i][c]);
+				}
+				h->d[k] = W[k][c];
+				h->e[k] = W[k+1][c];
+				h->d[k+1] = W[k+1][c+1];
+				L[k][k] = 1.;
+				L[k+1][k] = 0.;
+				L[k+1][k+1] = 1.;
+				h->ipiv[k] = k;
+				h->ipiv[k+1] = kp;
+			}
+			k += kstep;
+		}
+
+		if (k < n)
+		{
+			job.r0 = k;
+			job.ja = k0;
+			job.kb = k - k0;
+			if (update_lower(&job) != 0)
+			{
+				free_matrix(Wm);
+				return -1;
+			}
+		}
+	}
+
+	free_matrix(Wm);
+	return 0;
+}
+
+static int update_lower(struct lower_job *job)
+{
+	unsigned int blocks;
+
+	blocks = (job->n - 1)/CHOLESKY_BLOCK - job->r0/CHOLESKY_BLOCK + 1;
+	job->failed = 0;
+	parallel_for(blocks, update_task, job);
+	return job->failed;
+}
+
+// the rows of one block, from r0 to its diagonal, the longest blocks
+// are handed out first
+static void update_task(void *arg, unsigned int t)
+{
+	struct lower_job *job=arg;
+	unsigned int blocks,b,first,last,i;
+
+	blocks = (job->n - 1)/CHOLESKY_BLOCK - job->r0/CHOLESKY_BLOCK + 1;
+	b = job->r0/CHOLESKY_BLOCK + blocks - 1 - t;
+	first = (b*CHOLESKY_BLOCK > job->r0) ? b*CHOLESKY_BLOCK : job->r0;
+	last = ((b + 1)*CHOLESKY_BLOCK < job->n) ? (b + 1)*CHOLESKY_BLOCK : job->n;
+	for (i=first; job->P != NULL && i < last; i++)
+	{
+		memcpy(job->L[i] + job->k0, job->P[i], sizeof(**job->P)*job->kb);
+	}
+	if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, last-first, last-job->r0,
+				job->kb, -1., job->A + first, job->ja, job->B + job->r0, job->jb,
+				1., job->L + first, job->r0) != 0)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+}
@@ -0,0 +1,68 @@
+/* Cholesky and LDL^T factorizations of symmetric matrices
+ * Oct 18 2026 */
+
+#ifndef CHOLESKY_H
+#define CHOLESKY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "gemm.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// kinds of symmetric factorization
+#define CHOLESKY_LLT 0 // A=LL^T, A positive definite
+#define CHOLESKY_LDLT 1 // PAP^T=LDL^T, D with 1x1 and 2x2 blocks
+// columns per panel, the trailing triangle is updated once per panel
+// by matrix multiplication a block of this many rows per task
+#define CHOLESKY_BLOCK 64
+// Bunch-Kaufman's (1+sqrt(17))/8, the growth bound of LDL^T pivoting
+#define LDLT_ALPHA 0.6403882032022076
+
+// the lower triangle of a symmetric factorization, never modified once
+// factored, so any number of threads may solve with it at the same time
+struct cholesky_factorization
+{
+	unsigned int n;
+	int kind; // CHOLESKY_LLT or CHOLESKY_LDLT
+	unsigned int refs; // references held, the last release frees it
+	float *data; // row i of L has i+1 entries, padded to CHOLESKY_BLOCK
+	float **L; // unit diagonal for LDL^T
+	float *d, *e; // D for LDL^T, e[k] couples k and k+1 in a 2x2 block
+	unsigned int *ipiv; // row i was swapped with row ipiv[i] >= i
+};
+typedef struct cholesky_factorization *cholesky_handle;
+
+// factor a positive definite A, only the lower triangle is read
+// returns a handle holding one reference, NULL on failure
+extern cholesky_handle cholesky_factor(matrix A);
+// the same for a symmetric indefinite A with Bunch-Kaufman pivoting
+extern cholesky_handle ldlt_factor(matrix A);
+extern cholesky_handle cholesky_retain(cholesky_handle h);
+extern void cholesky_release(cholesky_handle h);
+// direct solution of Ax=b with the factors, returns 0 on success
+extern int cholesky_solve(cholesky_handle h, vector x, vector b);
+// the same for every column of B at once, X may be B
+extern int cholesky_solve_many(cholesky_handle h, matrix B, matrix X);
+// memory held by a factorization
+extern size_t cholesky_bytes(cholesky_handle h);
+// log|det A| in O(n) from the factors, det A = sign*exp(logdet),
+// sign may be NULL
+extern double cholesky_logdet(cholesky_handle h, int *sign);
+// solve the symmetric Ax=b, A is factored by Cholesky, or LDL^T if it
+// isn't positive definite, the first time it is seen and the factors
+// are kept for later calls
+// this only compares the pointer! if A changes call free_symmetric(A)
+extern int symmetric_solve(matrix A, vector x, vector b);
+// cleanup
+extern void free_symmetric(matrix A);
+extern void free_all_symmetric(void);
+
+#endif
@@ -0,0 +1,169 @@
+/* File format for matrices and vectors
+ * Oct 18 2026 */
+
+#include "datafile.h"
+
+int datafile_write_header(FILE *outfile, uint32_t dtype,
+		uint32_t rows, uint32_t cols, uint32_t ld);
+int datafile_read_header(FILE *infile, const char *filename,
+		struct datafile_header *header, int *swapped);
+void datafile_swap32(void *a, size_t n);
+void * datafile_map(const char *filename, struct datafile_header *header);
+void datafile_unmap(void *data, size_t bytes);
+
+static uint64_t swap64(uint64_t a);
+
+// write a header for rows x cols elements stored ld apart
+int datafile_write_header(FILE *outfile, uint32_t dtype,
+		uint32_t rows, uint32_t cols, uint32_t ld)
+{
+	struct datafile_header header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DATAFILE_MAGIC, sizeof(DATAFILE_MAGIC));
+	header.version = DATAFILE_VERSION;
+	header.dtype = dtype;
+	header.endian = DATAFILE_ENDIAN;
+	header.rows = rows;
+	header.cols = cols;
+	header.ld = ld;
+	header.offset = DATAFILE_HEADER;
+	header.bytes = (uint64_t)rows*ld*sizeof(float);
+
+	if (fwrite(&header, sizeof(header), 1, outfile) != 1)
+	{
+		perror("Error writing file");
+		return 1;
+	}
+	return 0;
+}
+
+// reverse the bytes of a 64 bit integer
+static uint64_t swap64(uint64_t a)
+{
+	uint32_t h[2],tmp;
+
+	memcpy(h, &a, sizeof(a));
+	datafile_swap32(h, 2);
+	tmp = h[0];
+	h[0] = h[1];
+	h[1] = tmp;
+	memcpy(&a, h, sizeof(a));
+	return a;
+}
+
+// reverse the bytes of n 32 bit elements
+void datafile_swap32(void *a, size_t n)
+{
+	uint32_t *u = a;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		u[i] = ((u[i] & 0xff) << 24) | ((u[i] & 0xff00) << 8)
+			| ((u[i] >> 8) & 0xff00) | (u[i] >> 24);
+	}
+}
+
+// read and check a header
+int datafile_read_header(FILE *infile, const char *filename,
+		struct datafile_header *header, int *swapped)
+{
+	struct stat if_stat;
+
+	if (fread(header, sizeof(*header), 1, infile) != 1
+			|| memcmp(header->magic, DATAFILE_MAGIC, sizeof(DATAFILE_MAGIC)) != 0)
+	{
+		// not one of ours, let the caller try the old format
+		rewind(infile);
+		return -1;
+	}
+
+	*swapped = 0;
+	if (header->endian != DATAFILE_ENDIAN)
+	{
+		datafile_swap32(&header->version, 6);
+		header->offset = swap64(header->offset);
+		header->bytes = swap64(header->bytes);
+		*swapped = 1;
+	}
+	if (header->endian != DATAFILE_ENDIAN || header->version != DATAFILE_VERSION)
+	{
+		fprintf(stderr,"Error: %s has an unknown format version\n",filename);
+		return 1;
+	}
+	if (header->dtype != DATAFILE_FLOAT32)
+	{
+		fprintf(stderr,"Error: %s has an unknown element type\n",filename);
+		return 1;
+	}
+
+	// the dimensions must describe exactly the data that follows,
+	// otherwise someone has modified the file and reading
+	// it could run off the end of our allocation
+	if (fstat(fileno(infile), &if_stat) != 0)
+	{
+		perror("Error reading file");
+		return 1;
+	}
+	if (header->rows < 1 || header->cols < 1 || header->ld < header->cols
+			|| header->offset < sizeof(*header)
+			|| header->bytes != (uint64_t)header->rows*header->ld*sizeof(float)
+			|| (uint64_t)if_stat.st_size != header->offset + header->bytes)
+	{
+		fprintf(stderr,"Error: %s has inconsistent dimensions\n",filename);
+		return 1;
+	}
+
+	return 0;
+}
+
+// map a file read only, returns its data or NULL
+void * datafile_map(const char *filename, struct datafile_header *header)
+{
+	FILE *infile;
+	void *base;
+	int status,swapped;
+
+	if ((infile = fopen(filename, "r")) == NULL)
+	{
+		perror("Error opening file");
+		return NULL;
+	}
+	if ((status = datafile_read_header(infile, filename, header, &swapped)) != 0)
+	{
+		if (status < 0)
+		{
+			fprintf(stderr,"Error: %s is in the old format, "
+					"it can only be loaded\n",filename);
+		}
+		fclose(infile);
+		return NULL;
+	}
+	// the data is used as it is on disk
+	if (swapped || header->offset != DATAFILE_HEADER)
+	{
+		fprintf(stderr,"Error: %s can't be mapped on this machine, "
+				"it can only be loaded\n",filename);
+		fclose(infile);
+		return NULL;
+	}
+
+	base = mmap(NULL, header->offset + header->bytes, PROT_READ, MAP_PRIVATE,
+			fileno(infile), 0);
+	// the mapping stays valid after the file is closed
+	fclose(infile);
+	if (base == MAP_FAILED)
+	{
+		perror("Error mapping file");
+		return NULL;
+	}
+
+	return (char *)base + header->offset;
+}
+
+// release a mapping made by datafile_map()
+void datafile_unmap(void *data, size_t bytes)
+{
+	munmap((char *)data - DATAFILE_HEADER, DATAFILE_HEADER + bytes);
+}
@@ -0,0 +1,63 @@
+/* File format for matrices and vectors
+ * Oct 18 2026 */
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+// a file is a fixed header followed by the elements row after row,
+// each row padded to ld elements so the data can be mapped and used
+// in place, vectors are stored as a single column
+#define DATAFILE_MAGIC "MATHLIB"
+#define DATAFILE_VERSION 1
+// bytes in the header, the data starts here in version 1
+// so mapped rows keep the alignment they were saved with
+#define DATAFILE_HEADER 64
+// written as a native integer to detect the byte order of the writer
+#define DATAFILE_ENDIAN 0x01020304
+
+// element types
+#define DATAFILE_FLOAT32 1
+
+struct datafile_header
+{
+	char magic[8]; // DATAFILE_MAGIC
+	uint32_t version;
+	uint32_t dtype;
+	uint32_t endian; // DATAFILE_ENDIAN in the byte order of the writer
+	uint32_t rows;
+	uint32_t cols;
+	uint32_t ld; // elements from the start of one row to the next
+	uint64_t offset; // bytes from the start of the file to the data
+	uint64_t bytes; // bytes of data
+	char pad[DATAFILE_HEADER - 48]; // zero
+};
+
+// write a header for rows x cols elements stored ld apart
+// the data follows immediately, returns 0 on success
+extern int datafile_write_header(FILE *outfile, uint32_t dtype,
+		uint32_t rows, uint32_t cols, uint32_t ld);
+// read and check a header, byte swapping it if the file came
+// from a machine of the other byte order, swapped is set if so
+// returns 0 for a valid file, -1 for a file that doesn't start
+// with the magic (the stream is rewound) and 1 for a bad file
+extern int datafile_read_header(FILE *infile, const char *filename,
+		struct datafile_header *header, int *swapped);
+// reverse the bytes of n 32 bit elements
+extern void datafile_swap32(void *a, size_t n);
+// map a file read only, returns its data or NULL
+// the header is filled in for the caller to build a view on
+extern void * datafile_map(const char *filename, struct datafile_header *header);
+// release a mapping made by datafile_map() with this many bytes of data
+extern void datafile_unmap(void *data, size_t bytes);
+
+#endif
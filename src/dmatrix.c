@@ -0,0 +1,622 @@
+/* Double precision matrices, LU and ODE solvers
+ * Oct 18 2026 */
+
+#include "dmatrix.h"
+
+dmatrix dzero_matrix(unsigned int n, unsigned int m);
+void dfree_matrix(dmatrix A);
+dvector dzero_vector(unsigned int n);
+void dfree_vector(dvector v);
+void dprint_matrix(dmatrix A);
+void dprint_vector(dvector v);
+dmatrix dmatrix_convert(matrix A);
+dvector dvector_convert(vector v);
+int dvector_store(dvector v, vector out);
+int dmatrix_gemv(double alpha, dmatrix A, const double *x,
+		double beta, double *y);
+dlu dlu_factor(dmatrix A);
+int dlu_solve(dlu f, dvector x, dvector b);
+void dlu_free(dlu f);
+dmatrix deuler_method(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+dmatrix drunge_kutta4(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+int mixed_solve(dmatrix A, dvector x, dvector b, unsigned int maxiter);
+int mixed_refine(lu_handle h, dmatrix A, dvector x, dvector b,
+		unsigned int maxiter);
+
+// elements per row of an m column matrix, rounded up to MATRIX_ALIGN bytes
+static unsigned int leading_dimension(unsigned int m);
+// one fixed step method for both solvers, rk4 picks the method
+static dmatrix fixed_step(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h, int rk4);
+// max |a_i|
+static double dmax_norm(unsigned int n, const double *a);
+
+// elements per row of an m column matrix, rounded up to MATRIX_ALIGN bytes
+static unsigned int leading_dimension(unsigned int m)
+{
+	unsigned int align = MATRIX_ALIGN/sizeof(double);
+
+	return (m + align - 1)/align*align;
+}
+
+// an n x m matrix of zeros
+dmatrix dzero_matrix(unsigned int n, unsigned int m)
+{
+	dmatrix A;
+	void *data;
+	unsigned int i;
+	size_t bytes;
+
+	if (n < 1 || m < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return NULL;
+	}
+	if ((A = malloc(sizeof(*A))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	A->n = n;
+	A->m = m;
+	A->ld = leading_dimension(m);
+	A->flags = MATRIX_OWNER;
+
+	bytes = sizeof(double)*(size_t)n*A->ld;
+	if ((errno = posix_memalign(&data, MATRIX_ALIGN, bytes)) != 0)
+	{
+		perror("Error allocating memory");
+		free(A);
+		return NULL;
+	}
+	memset(data, 0, bytes);
+	A->data = data;
+	if ((A->A = malloc(sizeof(*A->A)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		free(A->data);
+		free(A);
+		return NULL;
+	}
+	for (i=0; i < n; i++)
+	{
+		A->A[i] = A->data + (size_t)i*A->ld;
+	}
+	return A;
+}
+
+void dfree_matrix(dmatrix A)
+{
+	if (A == NULL)
+	{
+		return;
+	}
+	free(A->A);
+	if (A->flags & MATRIX_OWNER)
+	{
+		free(A->data);
+	}
+	free(A);
+}
+
+// a vector of n zeros
+dvector dzero_vector(unsigned int n)
+{
+	dvector v;
+
+	if (n < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return NULL;
+	}
+	if ((v = malloc(sizeof(*v))) == NULL
+			|| (v->a = calloc(n, sizeof(*v->a))) == NULL)
+	{
+		perror("Error allocating memory");
+		free(v);
+		return NULL;
+	}
+	v->n = n;
+	return v;
+}
+
+void dfree_vector(dvector v)
+{
+	if (v == NULL)
+	{
+		return;
+	}
+	free(v->a);
+	free(v);
+}
+
+void dprint_matrix(dmatrix A)
+{
+	unsigned int i,j;
+
+	for (i=0; i < A->n; i++)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			printf("%.16E\t",A->A[i][j]);
+		}
+		printf("\n");
+	}
+}
+
+void dprint_vector(dvector v)
+{
+	unsigned int i;
+
+	for (i=0; i < v->n; i++)
+	{
+		printf("%.16E\n",v->a[i]);
+	}
+}
+
+// a copy of a single precision matrix or view
+dmatrix dmatrix_convert(matrix A)
+{
+	dmatrix B;
+	unsigned int i,j;
+
+	if ((B = dzero_matrix(A->n, A->m)) == NULL)
+	{
+		return NULL;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			B->A[i][j] = (A->flags & MATRIX_TRANSPOSED) ? A->A[j][i] : A->A[i][j];
+		}
+	}
+	return B;
+}
+
+// a copy of a single precision vector
+dvector dvector_convert(vector v)
+{
+	dvector w;
+	unsigned int i;
+
+	if ((w = dzero_vector(v->n)) == NULL)
+	{
+		return NULL;
+	}
+	for (i=0; i < v->n; i++)
+	{
+		w->a[i] = v->a[i];
+	}
+	return w;
+}
+
+// v rounded into out
+int dvector_store(dvector v, vector out)
+{
+	unsigned int i;
+
+	if (v->n != out->n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	for (i=0; i < v->n; i++)
+	{
+		out->a[i] = v->a[i];
+	}
+	return 0;
+}
+
+// y = alpha*A*x + beta*y, a row at a time so the inner loop is contiguous
+int dmatrix_gemv(double alpha, dmatrix A, const double *x,
+		double beta, double *y)
+{
+	unsigned int i,j;
+	double sum;
+
+	for (i=0; i < A->n; i++)
+	{
+		sum = 0.;
+		for (j=0; j < A->m; j++)
+		{
+			sum += A->A[i][j]*x[j];
+		}
+		y[i] = alpha*sum + ((beta != 0.) ? beta*y[i] : 0.);
+	}
+	return 0;
+}
+
+// right looking elimination on a copy of A, rows are exchanged by
+// swapping row pointers and each update runs along a contiguous row
+dlu dlu_factor(dmatrix A)
+{
+	dlu f;
+	double **LU,*row,l,big;
+	unsigned int n=A->n;
+	unsigned int i,j,k,p,t;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return NULL;
+	}
+	if ((f = malloc(sizeof(*f))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	if ((f->perm = malloc(sizeof(*f->perm)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		free(f);
+		return NULL;
+	}
+	if ((f->LU = dzero_matrix(n, n)) == NULL)
+	{
+		free(f->perm);
+		free(f);
+		return NULL;
+	}
+	LU = f->LU->A;
+	for (i=0; i < n; i++)
+	{
+		memcpy(LU[i], A->A[i], sizeof(**LU)*n);
+		f->perm[i] = i;
+	}
+
+	for (k=0; k < n; k++)
+	{
+		// partial pivoting on the largest element of column k
+		p = k;
+		big = fabs(LU[k][k]);
+		for (i=k+1; i < n; i++)
+		{
+			if (fabs(LU[i][k]) > big)
+			{
+				big = fabs(LU[i][k]);
+				p = i;
+			}
+		}
+		if (big == 0. || !isfinite(big))
+		{
+			fprintf(stderr,"No unique solution\n");
+			dlu_free(f);
+			return NULL;
+		}
+		if (p != k)
+		{
+			row = LU[p];
+			LU[p] = LU[k];
+			LU[k] = row;
+			t = f->perm[p];
+			f->perm[p] = f->perm[k];
+			f->perm[k] = t;
+		}
+
+		for (i=k+1; i < n; i++)
+		{
+			l = (LU[i][k] /= LU[k][k]);
+			for (j=k+1; j < n; j++)
+			{
+				LU[i][j] -= l*LU[k][j];
+			}
+		}
+	}
+	return f;
+}
+
+// direct solution of LUx=Pb
+int dlu_solve(dlu f, dvector x, dvector b)
+{
+	double **LU = f->LU->A;
+	double *z;
+	unsigned int n=f->LU->n;
+	unsigned int i,j;
+	double sum;
+
+	if (x->n != n || b->n != n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+
+	// the permutation needs scratch space when x is b
+	z = x->a;
+	if (x->a == b->a && (z = malloc(sizeof(*z)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+
+	// Lz = Pb
+	for (i=0; i < n; i++)
+	{
+		sum = b->a[f->perm[i]];
+		for (j=0; j < i; j++)
+		{
+			sum -= LU[i][j]*z[j];
+		}
+		z[i] = sum;
+	}
+	// Uz = z
+	for (i=n; i >= 1; i--)
+	{
+		sum = z[i-1];
+		for (j=i; j < n; j++)
+		{
+			sum -= LU[i-1][j]*z[j];
+		}
+		z[i-1] = sum/LU[i-1][i-1];
+	}
+
+	if (z != x->a)
+	{
+		memcpy(x->a, z, sizeof(*z)*n);
+		free(z);
+	}
+	return 0;
+}
+
+void dlu_free(dlu f)
+{
+	if (f == NULL)
+	{
+		return;
+	}
+	dfree_matrix(f->LU);
+	free(f->perm);
+	free(f);
+}
+
+// Euler's method
+dmatrix deuler_method(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h)
+{
+	return fixed_step(f, userdata, y0, tmin, tmax, h, 0);
+}
+
+// the classical fourth order Runge-Kutta method
+dmatrix drunge_kutta4(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h)
+{
+	return fixed_step(f, userdata, y0, tmin, tmax, h, 1);
+}
+
+// rows [t y] of the solution
+static dmatrix fixed_step(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h, int rk4)
+{
+	dmatrix Y;
+	double *work,*k1,*k2,*k3,*k4,*stage,*y,*next;
+	unsigned int n=(int)((tmax-tmin)/h);
+	unsigned int d=y0->n;
+	unsigned int i,j;
+	double t;
+
+	if ((int)((tmax-tmin)/h) < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return NULL;
+	}
+	if ((Y = dzero_matrix(n, d+1)) == NULL)
+	{
+		return NULL;
+	}
+	if ((work = malloc(sizeof(*work)*5*d)) == NULL)
+	{
+		perror("Error allocating memory");
+		dfree_matrix(Y);
+		return NULL;
+	}
+	k1 = work;
+	k2 = k1+d;
+	k3 = k2+d;
+	k4 = k3+d;
+	stage = k4+d;
+
+	Y->A[0][0] = tmin;
+	memcpy(Y->A[0]+1, y0->a, sizeof(*y0->a)*d);
+	for (i=0; i+1 < n; i++)
+	{
+		t = tmin + i*h;
+		y = Y->A[i]+1;
+		next = Y->A[i+1]+1;
+		Y->A[i+1][0] = tmin + (i+1)*h;
+
+		(*f)(t, y, k1, d, userdata);
+		if (!rk4)
+		{
+			for (j=0; j < d; j++)
+			{
+				next[j] = y[j] + h*k1[j];
+			}
+			continue;
+		}
+
+		for (j=0; j < d; j++)
+		{
+			stage[j] = y[j] + h/2*k1[j];
+		}
+		(*f)(t+h/2, stage, k2, d, userdata);
+		for (j=0; j < d; j++)
+		{
+			stage[j] = y[j] + h/2*k2[j];
+		}
+		(*f)(t+h/2, stage, k3, d, userdata);
+		for (j=0; j < d; j++)
+		{
+			stage[j] = y[j] + h*k3[j];
+		}
+		(*f)(t+h, stage, k4, d, userdata);
+		for (j=0; j < d; j++)
+		{
+			next[j] = y[j] + h/6*(k1[j] + 2*k2[j] + 2*k3[j] + k4[j]);
+		}
+	}
+
+	free(work);
+	return Y;
+}
+
+// max |a_i|
+static double dmax_norm(unsigned int n, const double *a)
+{
+	unsigned int i;
+	double norm=0.;
+
+	for (i=0; i < n; i++)
+	{
+		norm = fmax(norm, fabs(a[i]));
+	}
+	return norm;
+}
+
+// factor in single precision, refine in double
+int mixed_solve(dmatrix A, dvector x, dvector b, unsigned int maxiter)
+{
+	matrix S;
+	lu_handle h=NULL;
+	dlu f;
+	unsigned int i,j;
+	int status=1,finite=1;
+
+	if (A->n != A->m || A->n != x->n || A->n != b->n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+
+	// A rounded to single precision, a matrix too large for
+	// float doesn't get a factorization and goes straight to double
+	if ((S = zero_matrix(A->n, A->m)) == NULL)
+	{
+		return 1;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			S->A[i][j] = A->A[i][j];
+			finite &= isfinite(S->A[i][j]);
+		}
+	}
+	if (finite)
+	{
+		h = lu_handle_factor(S, LU_PARTIAL_PIVOTING);
+	}
+	free_matrix(S);
+
+	if (h != NULL)
+	{
+		memset(x->a, 0, sizeof(*x->a)*x->n);
+		status = mixed_refine(h, A, x, b, maxiter);
+		lu_handle_release(h);
+	}
+	if (status == 0)
+	{
+		return 0;
+	}
+
+	// too ill conditioned for single precision
+	if ((f = dlu_factor(A)) == NULL)
+	{
+		return 1;
+	}
+	status = dlu_solve(f, x, b);
+	dlu_free(f);
+	return status;
+}
+
+// x += LU\(b - Ax) until the residual is at double roundoff
+// the residual is scaled before it is rounded to single
+// precision so it neither underflows nor overflows
+int mixed_refine(lu_handle h, dmatrix A, dvector x, dvector b,
+		unsigned int maxiter)
+{
+	vector r;
+	double *res,scale,norm,bound,last=INFINITY;
+	unsigned int n=A->n;
+	unsigned int i,j,k;
+	int status=1;
+
+	if (A->n != A->m || A->n != x->n || A->n != b->n
+			|| lu_handle_factors(h)->factors == NULL
+			|| lu_handle_factors(h)->factors->n != n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if (maxiter == 0)
+	{
+		maxiter = MIXED_MAXITER;
+	}
+	if ((r = zero_vector(n)) == NULL)
+	{
+		return 1;
+	}
+	if ((res = malloc(sizeof(*res)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		free_vector(r);
+		return 1;
+	}
+
+	// the residual of x rounded to double is about this big,
+	// the test LAPACK's dsgesv uses
+	bound = 0.;
+	for (i=0; i < n; i++)
+	{
+		for (j=0; j < n; j++)
+		{
+			bound = fmax(bound, fabs(A->A[i][j]));
+		}
+	}
+	bound *= sqrt(n)*DBL_EPSILON;
+
+	for (k=0; k < maxiter; k++)
+	{
+		// res = b - Ax in double
+		memcpy(res, b->a, sizeof(*res)*n);
+		dmatrix_gemv(-1., A, x->a, 1., res);
+		scale = dmax_norm(n, res);
+		if (scale <= bound*dmax_norm(n, x->a))
+		{
+			status = 0;
+			break;
+		}
+		if (!isfinite(scale))
+		{
+			break;
+		}
+
+		// the correction from the single precision factors
+		for (i=0; i < n; i++)
+		{
+			r->a[i] = res[i]/scale;
+		}
+		if (lu_handle_solve(h, r, r) != 0)
+		{
+			break;
+		}
+		norm = 0.;
+		for (i=0; i < n; i++)
+		{
+			x->a[i] += scale*r->a[i];
+			norm = fmax(norm, fabs(scale*r->a[i]));
+		}
+
+		// stalled when the correction stops shrinking by at least half
+		if (!(norm <= 0.5*last))
+		{
+			break;
+		}
+		last = norm;
+	}
+
+	free(res);
+	free_vector(r);
+	return status;
+}
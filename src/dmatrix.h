@@ -0,0 +1,89 @@
+/* Double precision matrices, LU and ODE solvers
+ * Oct 18 2026 */
+
+#ifndef DMATRIX_H
+#define DMATRIX_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "linear_system.h"
+
+// refinement steps allowed by mixed_solve() when 0 is given
+#define MIXED_MAXITER 30
+
+// a matrix of double, rows are ld elements apart
+typedef struct
+{
+	unsigned int n; // number of rows (height) of matrix
+	unsigned int m; // number of columns (width) of matrix
+	double **A; // row pointers into data
+	double *data; // first element
+	unsigned int ld; // leading dimension of data
+	unsigned int flags;
+} *dmatrix;
+
+// a vector of double
+typedef struct
+{
+	unsigned int n;
+	double *a;
+} *dvector;
+
+// PA=LU, L has a unit diagonal and is stored below the diagonal of U
+struct dlu_factors
+{
+	dmatrix LU;
+	unsigned int *perm; // row i of LU is row perm[i] of A
+};
+typedef struct dlu_factors *dlu;
+
+// right hand side of dy/dt = f(t,y) for all n components at once
+typedef void (*dode_rhs)(double t, const double *y, double *dydt, int n,
+		void *userdata);
+
+// allocation, matrices are zeroed and their rows aligned like a matrix's
+extern dmatrix dzero_matrix(unsigned int n, unsigned int m);
+extern void dfree_matrix(dmatrix A);
+extern dvector dzero_vector(unsigned int n);
+extern void dfree_vector(dvector v);
+extern void dprint_matrix(dmatrix A);
+extern void dprint_vector(dvector v);
+// copies of single precision matrices and vectors
+extern dmatrix dmatrix_convert(matrix A);
+extern dvector dvector_convert(vector v);
+// v rounded into the single precision vector out, returns 0 on success
+extern int dvector_store(dvector v, vector out);
+// y = alpha*A*x + beta*y with the sums accumulated in double
+extern int dmatrix_gemv(double alpha, dmatrix A, const double *x,
+		double beta, double *y);
+// factor a copy of A by partial pivoting, NULL if A is singular
+extern dlu dlu_factor(dmatrix A);
+// direct solution of LUx=b, x may be b, returns 0 on success
+extern int dlu_solve(dlu f, dvector x, dvector b);
+extern void dlu_free(dlu f);
+// fixed step solutions with rows [t y1 ... yn] as euler_method()
+// and runge_kutta4() give, but with t and y carried in double
+extern dmatrix deuler_method(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+extern dmatrix drunge_kutta4(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+
+// Ax=b to double precision, A is factored in single precision and the
+// solution refined with residuals computed in double, if refinement
+// stalls because A is too ill conditioned for that it falls back to
+// a double precision factorization, returns 0 on success
+extern int mixed_solve(dmatrix A, dvector x, dvector b, unsigned int maxiter);
+// the refinement alone, h is a single precision factorization of A
+// and x holds a starting guess, returns 0 once the residual is at
+// double precision roundoff and 1 if the corrections stalled first
+extern int mixed_refine(lu_handle h, dmatrix A, dvector x, dvector b,
+		unsigned int maxiter);
+
+#endif
@@ -0,0 +1,359 @@
+/* Dormand-Prince 5(4) adaptive Runge-Kutta method
+ * Oct 18 2026 */
+
+#include "dormand_prince.h"
+
+// the Butcher tableau, c are the nodes, a the stage weights
+// and b the 5th order weights, which are also the last stage
+// so the slope at the end of a step starts the next one
+static const float c2=1./5, c3=3./10, c4=4./5, c5=8./9;
+static const float a21=1./5;
+static const float a31=3./40, a32=9./40;
+static const float a41=44./45, a42=-56./15, a43=32./9;
+static const float a51=19372./6561, a52=-25360./2187, a53=64448./6561,
+	a54=-212./729;
+static const float a61=9017./3168, a62=-355./33, a63=46732./5247,
+	a64=49./176, a65=-5103./18656;
+static const float a71=35./384, a73=500./1113, a74=125./192,
+	a75=-2187./6784, a76=11./84;
+// 5th order minus 4th order weights, the local error estimate
+static const float e1=71./57600, e3=-71./16695, e4=71./1920,
+	e5=-17253./339200, e6=22./525, e7=-1./40;
+// continuous extension for dense output
+static const float d1=-12715105075./11282082432, d3=87487479700./32700410799,
+	d4=-10690763975./1880347072, d5=701980252875./199316789632,
+	d6=-1453857185./822651844, d7=69997945./29380423;
+
+matrix dormand_prince(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, struct ode_stats *stats);
+int dormand_prince_stream(vector_function f, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+int dormand_prince_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+
+// rows of dense output from tmin to tmax
+static unsigned int dense_rows(float tmin, float tmax, float dt);
+// weighted root mean square of a/(atol + rtol*|y|)
+static double error_norm(unsigned int n, const float *a, const float *y,
+		const float *z, float rtol, float atol);
+// a first step for the tolerances
+static float initial_step(ode_rhs f, void *userdata, unsigned int n,
+		float *ty, const float *k1, float *stage, float *k2, float tmax,
+		float rtol, float atol);
+
+// rows of dense output from tmin to tmax, allowing for dt
+// not dividing the interval exactly in float
+static unsigned int dense_rows(float tmin, float tmax, float dt)
+{
+	return (unsigned int)floor(((double)tmax-tmin)/dt + 1e-3) + 1;
+}
+
+// weighted root mean square of a/(atol + rtol*max(|y|,|z|))
+static double error_norm(unsigned int n, const float *a, const float *y,
+		const float *z, float rtol, float atol)
+{
+	double sum=0.,sk;
+	unsigned int i;
+
+	for (i=0; i < n; i++)
+	{
+		sk = atol + rtol*fmax(fabsf(y[i]), fabsf(z[i]));
+		sum += (a[i]/sk)*(a[i]/sk);
+	}
+	return sqrt(sum/n);
+}
+
+// a first step for the tolerances, after Hairer, Norsett and Wanner
+// a trial Euler step estimates the second derivative
+static float initial_step(ode_rhs f, void *userdata, unsigned int n,
+		float *ty, const float *k1, float *stage, float *k2, float tmax,
+		float rtol, float atol)
+{
+	unsigned int i;
+	double d0,d1,d2,h0,h1;
+
+	d0 = error_norm(n, ty+1, ty+1, ty+1, rtol, atol);
+	d1 = error_norm(n, k1, ty+1, ty+1, rtol, atol);
+	h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+	h0 = fmin(h0, (double)tmax - ty[0]);
+
+	stage[0] = ty[0] + h0;
+	for (i=0; i < n; i++)
+	{
+		stage[i+1] = ty[i+1] + h0*k1[i];
+	}
+	(*f)(stage[0], stage+1, k2, n, userdata);
+	for (i=0; i < n; i++)
+	{
+		k2[i] -= k1[i];
+	}
+	d2 = error_norm(n, k2, ty+1, ty+1, rtol, atol)/h0;
+
+	if (fmax(d1, d2) <= 1e-15)
+	{
+		h1 = fmax(1e-6, h0*1e-3);
+	}
+	else
+	{
+		h1 = pow(0.01/fmax(d1, d2), 1./5);
+	}
+	return fmin(fmin(100*h0, h1), (double)tmax - ty[0]);
+}
+
+// solution rows at t = tmin, tmin+dt, ... up to tmax
+matrix dormand_prince(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, struct ode_stats *stats)
+{
+	matrix Y;
+	ode_stream out;
+
+	if (!(dt > 0.) || !(tmax > tmin))
+	{
+		fprintf(stderr,"Error: output interval must be positive\n");
+		return NULL;
+	}
+
+	if ((Y=zero_matrix(dense_rows(tmin, tmax, dt), f->n+1)) == NULL)
+	{
+		return NULL;
+	}
+	if ((out=ode_stream_into(Y, 1)) == NULL)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+	if (dormand_prince_stream(f, y0, tmin, tmax, rtol, atol, dt, out, stats) != 0
+			|| ode_stream_close(out) != 0)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+
+	return Y;
+}
+
+// the same rows pushed to out, or one row per step when dt == 0
+int dormand_prince_stream(vector_function f, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats)
+{
+	struct vecfunc_adapter adapter;
+	int status;
+
+	if (f->n != y0->n)
+	{
+		fprintf(stderr,"System has inconsistent dimensions\n");
+		return 1;
+	}
+	if (vecfunc_adapter_init(&adapter, f) != 0)
+	{
+		return 1;
+	}
+	status = dormand_prince_rhs(&vecfunc_rhs, &adapter, y0, tmin, tmax,
+			rtol, atol, dt, out, stats);
+	vecfunc_adapter_free(&adapter);
+
+	return status;
+}
+
+// the same for a right hand side computed a whole vector at a time
+int dormand_prince_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats)
+{
+	unsigned int n=y0->n;
+	unsigned int m=n+1;
+	unsigned int i,rows,next_row;
+	float *work,*y,*z,*stage,*row,*k1,*k2,*k3,*k4,*k5,*k6,*k7,*tmp;
+	float *r1,*r2,*r3,*r4,*r5; // dense output polynomial of the last step
+	float h,theta,t_out;
+	double err,err_old,fac,facmax;
+	int last,status;
+	struct ode_stats count = { 0, 0, 0, 0, 0 };
+
+	if (!(tmax > tmin) || !(rtol >= 0.) || !(atol >= 0.) || rtol+atol <= 0.
+			|| !(dt >= 0.))
+	{
+		fprintf(stderr,"Error: invalid interval or tolerances\n");
+		return 1;
+	}
+
+	// rows [t y] for the solution at both ends of a step, the stages
+	// and dense output, then the seven slopes and the interpolant
+	if ((work=vector_allocate(4*m+12*n)) == NULL)
+	{
+		return 1;
+	}
+	y = work;
+	z = y+m;
+	stage = z+m;
+	row = stage+m;
+	k1 = row+m;
+	k2 = k1+n;
+	k3 = k2+n;
+	k4 = k3+n;
+	k5 = k4+n;
+	k6 = k5+n;
+	k7 = k6+n;
+	r1 = k7+n;
+	r2 = r1+n;
+	r3 = r2+n;
+	r4 = r3+n;
+	r5 = r4+n;
+
+	// initial conditions
+	y[0] = tmin;
+	for (i=0; i < n; i++)
+	{
+		y[i+1] = y0->a[i];
+	}
+	rows = (dt > 0.) ? dense_rows(tmin, tmax, dt) : 0;
+	next_row = 1;
+	status = ode_stream_push(out, y);
+
+	(*f)(y[0], y+1, k1, n, userdata);
+	h = initial_step(f, userdata, n, y, k1, stage, k2, tmax, rtol, atol);
+	count.evaluations += 2;
+	err_old = 1e-4;
+	facmax = DP_FACMAX;
+	last = 0;
+
+	while (status == 0 && !last)
+	{
+		// don't step past tmax, or leave a sliver before it
+		if (y[0] + 1.01*h >= tmax)
+		{
+			h = tmax - y[0];
+			last = 1;
+		}
+		if (h <= 10*FLT_EPSILON*fmax(fabsf(y[0]), 1.))
+		{
+			fprintf(stderr,"Error: step size too small at t = %g\n",y[0]);
+			status = 1;
+			break;
+		}
+
+		// stages, stage holds [t y] for each evaluation
+		stage[0] = y[0] + c2*h;
+		for (i=0; i < n; i++)
+		{
+			stage[i+1] = y[i+1] + h*a21*k1[i];
+		}
+		(*f)(stage[0], stage+1, k2, n, userdata);
+		stage[0] = y[0] + c3*h;
+		for (i=0; i < n; i++)
+		{
+			stage[i+1] = y[i+1] + h*(a31*k1[i] + a32*k2[i]);
+		}
+		(*f)(stage[0], stage+1, k3, n, userdata);
+		stage[0] = y[0] + c4*h;
+		for (i=0; i < n; i++)
+		{
+			stage[i+1] = y[i+1] + h*(a41*k1[i] + a42*k2[i] + a43*k3[i]);
+		}
+		(*f)(stage[0], stage+1, k4, n, userdata);
+		stage[0] = y[0] + c5*h;
+		for (i=0; i < n; i++)
+		{
+			stage[i+1] = y[i+1] + h*(a51*k1[i] + a52*k2[i] + a53*k3[i]
+					+ a54*k4[i]);
+		}
+		(*f)(stage[0], stage+1, k5, n, userdata);
+		stage[0] = y[0] + h;
+		for (i=0; i < n; i++)
+		{
+			stage[i+1] = y[i+1] + h*(a61*k1[i] + a62*k2[i] + a63*k3[i]
+					+ a64*k4[i] + a65*k5[i]);
+		}
+		(*f)(stage[0], stage+1, k6, n, userdata);
+		z[0] = last ? tmax : y[0] + h;
+		for (i=0; i < n; i++)
+		{
+			z[i+1] = y[i+1] + h*(a71*k1[i] + a73*k3[i] + a74*k4[i]
+					+ a75*k5[i] + a76*k6[i]);
+		}
+		(*f)(z[0], z+1, k7, n, userdata);
+		count.evaluations += 6;
+
+		// local error estimate, stored in k2 which isn't needed again
+		for (i=0; i < n; i++)
+		{
+			k2[i] = h*(e1*k1[i] + e3*k3[i] + e4*k4[i] + e5*k5[i]
+					+ e6*k6[i] + e7*k7[i]);
+		}
+		err = error_norm(n, k2, y+1, z+1, rtol, atol);
+
+		if (!(err <= 1.))
+		{
+			// rejected, try again with a smaller step
+			count.rejected++;
+			fac = (err == err) ? fmax(DP_FACMIN, DP_SAFETY*pow(err, -0.2)) : DP_FACMIN;
+			h *= fac;
+			facmax = 1.;
+			last = 0;
+			continue;
+		}
+
+		// accepted
+		count.steps++;
+		if (dt > 0.)
+		{
+			// the interpolant on [y[0], z[0]]
+			for (i=0; i < n; i++)
+			{
+				r1[i] = y[i+1];
+				r2[i] = z[i+1] - y[i+1];
+				r3[i] = h*k1[i] - r2[i];
+				r4[i] = r2[i] - h*k7[i] - r3[i];
+				r5[i] = h*(d1*k1[i] + d3*k3[i] + d4*k4[i] + d5*k5[i]
+						+ d6*k6[i] + d7*k7[i]);
+			}
+			// output times passed during this step, all of them after the last
+			while (next_row < rows && status == 0)
+			{
+				t_out = tmin + next_row*dt;
+				if (!last && t_out > z[0])
+				{
+					break;
+				}
+				theta = (t_out - y[0])/h;
+				row[0] = t_out;
+				for (i=0; i < n; i++)
+				{
+					row[i+1] = r1[i] + theta*(r2[i] + (1-theta)*(r3[i]
+								+ theta*(r4[i] + (1-theta)*r5[i])));
+				}
+				status = ode_stream_push(out, row);
+				next_row++;
+			}
+		}
+		else
+		{
+			status = ode_stream_push(out, z);
+		}
+
+		// PI step size control
+		fac = DP_SAFETY*pow(err > 1e-10 ? err : 1e-10, -(0.2 - 0.75*DP_BETA))
+			*pow(err_old, DP_BETA);
+		h *= fmin(facmax, fmax(DP_FACMIN, fac));
+		err_old = fmax(err, 1e-4);
+		facmax = DP_FACMAX;
+
+		// the last slope of this step is the first of the next
+		tmp = y;
+		y = z;
+		z = tmp;
+		tmp = k1;
+		k1 = k7;
+		k7 = tmp;
+	}
+
+	if (stats != NULL)
+	{
+		*stats = count;
+	}
+	free(work);
+	return status;
+}
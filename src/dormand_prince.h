@@ -0,0 +1,38 @@
+/* Dormand-Prince 5(4) adaptive Runge-Kutta method
+ * for ODE's of form dy/dt = f(t,y), y(0) = y0
+ * Oct 18 2026 */
+
+#ifndef DORMAND_PRINCE_H
+#define DORMAND_PRINCE_H
+
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "vector_function.h"
+#include "ode_stream.h"
+
+// step size control
+#define DP_SAFETY 0.9 // fraction of the optimal step actually taken
+#define DP_FACMIN 0.2 // a step shrinks by at most this
+#define DP_FACMAX 10. // and grows by at most this
+#define DP_BETA 0.04 // weight of the previous error in the PI controller
+
+// solution rows [t y1 ... yn] at t = tmin, tmin+dt, ... up to tmax
+// interpolated from the adaptive steps, each component is kept within
+// atol + rtol*|y| per step, rtol much below 1e-6 is lost in float
+// rounding, stats may be NULL
+extern matrix dormand_prince(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, struct ode_stats *stats);
+// the same rows pushed to out, or with dt == 0 one row for
+// every step taken, returns 0 on success
+extern int dormand_prince_stream(vector_function f, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+// the same for a right hand side computed a whole vector at a time
+extern int dormand_prince_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+
+#endif
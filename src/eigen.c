@@ -0,0 +1,1646 @@
+/* Eigenvalues and eigenvectors of symmetric matrices
+ * Oct 18 2026 */
+
+#include "eigen.h"
+
+// rows of the trailing matrix below which symv stays on one thread
+#define SYMV_PARALLEL_MIN 512
+// roots of a secular equation, or rows of its vectors, per task
+#define SECULAR_BLOCK 64
+// eigenvalues found by one task of bisection
+#define BISECTION_BLOCK 16
+
+// A reduced to T = Q^T A Q, Q the product of the reflectors
+// H_i = I - tau_i v_i v_i^T where v_i is 1 in row i+1 and is
+// column i of H below that
+struct tridiagonal
+{
+	unsigned int n;
+	matrix H;
+	float *tau;
+	double *d, *e; // diagonal and off diagonal of T, e[n-1] is 0
+};
+
+// y = A x for the lower triangle of a trailing block of A
+struct symv_job
+{
+	float **A; // row r of the block starts at A[r] + col
+	unsigned int col, n;
+	const float *x;
+	float *y; // n partial sums per task
+	unsigned int tasks;
+};
+
+// an eigenvalue, its column of Q and its part of a rank one update
+struct eigen_entry
+{
+	double value;
+	double z;
+	unsigned int col;
+};
+
+// a node of the divide and conquer tree, rows and columns start to
+// start+size-1 of Q, its children split it at start+size/2
+struct dc_node
+{
+	unsigned int start, size, depth;
+};
+
+// the tree and what its nodes share
+struct dc_job
+{
+	unsigned int n;
+	double *d; // diagonal with the rank one tears subtracted
+	const double *e;
+	double *w; // eigenvalues of a node in the order of its columns of Q
+	float **Q;
+	struct dc_node *nodes;
+	unsigned int *level; // the nodes being solved
+	int failed;
+};
+
+// the secular equation 1 + sum zz_i/(d_i - lambda) = 0 of one merge
+// and the eigenvectors of its rank one update
+struct secular_job
+{
+	unsigned int k;
+	double rho;
+	const double *d, *z, *zz; // sorted poles, z and rho*z_i^2
+	double *tau; // root j is d[origin[j]] + tau[j]
+	unsigned int *origin;
+	double *zhat; // z recomputed from the roots
+	const unsigned int *group; // the order of the columns of U
+	float **U; // row j is the eigenvector of root j
+};
+
+// eigenvalues il.. of T by bisection
+struct bisection_job
+{
+	unsigned int n, il, k;
+	const double *d, *e2;
+	double pivmin, gl, gu, tnorm;
+	double *w;
+};
+
+// eigenvectors of T by inverse iteration, one cluster per task
+struct inverse_job
+{
+	unsigned int n;
+	const double *d, *e, *w;
+	const unsigned int *cluster; // cluster c is w[cluster[c]..cluster[c+1]-1]
+	double tnorm;
+	float **Z;
+	int failed;
+};
+
+int symmetric_eigen(matrix A, vector w, matrix Z);
+int symmetric_eigen_range(matrix A, unsigned int il, unsigned int iu,
+		vector w, matrix Z);
+int tridiagonal_eigen(unsigned int n, const float *d, const float *e,
+		float *w, matrix Z);
+
+// Householder reduction of the lower triangle of A to tridiagonal form
+static struct tridiagonal * tridiagonal_reduce(matrix A);
+static void free_tridiagonal(struct tridiagonal *t);
+// reduce one panel of columns, X and Y collect the update of the rest
+static void tridiagonal_panel(struct tridiagonal *t, unsigned int k0,
+		unsigned int nb, float **X, float **Y, float *v, float *y,
+		float *work, unsigned int tasks);
+// y = A x for the lower triangle of the trailing n x n block at col
+static void symv(float **A, unsigned int col, unsigned int n, const float *x,
+		float *y, float *work, unsigned int tasks);
+// the rows of one task of symv()
+static void symv_task(void *arg, unsigned int t);
+// Z = Q Z for the k columns of Z, returns 0 on success
+static int back_transform(struct tridiagonal *t, float **Z, unsigned int k);
+// implicit QL with Wilkinson shifts, e is destroyed, if z isn't NULL the
+// rotations are accumulated into its columns, returns 0 on success
+static int tridiagonal_ql(unsigned int n, double *d, double *e, double *z,
+		unsigned int ldz);
+// sorted eigenvalues of T alone
+static int tridiagonal_values(unsigned int n, const double *d,
+		const double *e, double *w);
+// sorted eigenvalues and vectors of T by divide and conquer
+static int tridiagonal_dc(unsigned int n, const double *d, const double *e,
+		double *w, float **Z);
+// add a node and its children to the tree, returns the deepest level
+static unsigned int dc_split(struct dc_job *job, unsigned int *count,
+		unsigned int start, unsigned int size, unsigned int depth);
+// solve node level[t]
+static void dc_task(void *arg, unsigned int t);
+// a leaf by implicit QL
+static int dc_leaf(struct dc_job *job, struct dc_node *node);
+// combine the solutions of the children of a node
+static int dc_merge(struct dc_job *job, struct dc_node *node);
+// the roots of one task of a secular equation
+static void secular_task(void *arg, unsigned int t);
+// zhat from the roots by Lowner's formula
+static void zhat_task(void *arg, unsigned int t);
+// the eigenvectors of one task of the rank one update
+static void vector_task(void *arg, unsigned int t);
+// the root of a secular equation between d[j] and d[j+1], or above d[k-1]
+static double secular_root(unsigned int k, const double *d, const double *zz,
+		unsigned int j, unsigned int *origin);
+// order eigen entries by value
+static int entry_compare(const void *a, const void *b);
+static int double_compare(const void *a, const void *b);
+// bounds on the eigenvalues of T from Gershgorin's circles
+static void gershgorin(unsigned int n, const double *d, const double *e,
+		double *gl, double *gu);
+// eigenvalues of T less than x
+static unsigned int sturm_count(unsigned int n, const double *d,
+		const double *e2, double x, double pivmin);
+// eigenvalues il to il+k-1 of T by bisection
+static int tridiagonal_bisect(unsigned int n, const double *d,
+		const double *e, unsigned int il, unsigned int k, double *w);
+static void bisection_task(void *arg, unsigned int t);
+// eigenvectors of T for the sorted eigenvalues w[0..k) into Z
+static int tridiagonal_inverse(unsigned int n, const double *d,
+		const double *e, unsigned int k, const double *w, float **Z);
+static void inverse_task(void *arg, unsigned int t);
+
+// eigenvalues by divide and conquer, or QL when no vectors are wanted
+int symmetric_eigen(matrix A, vector w, matrix Z)
+{
+	struct tridiagonal *t;
+	matrix V;
+	double *wd;
+	unsigned int i,n=A->n;
+	int status;
+
+	if (A->n != A->m || n < 1)
+	{
+		fprintf(stderr,"Error: eigenvalues need a square matrix\n");
+		return 1;
+	}
+	if (w->n != n || (Z != NULL && (Z->n != n || Z->m != n)))
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((wd = malloc(sizeof(*wd)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	if ((t = tridiagonal_reduce(A)) == NULL)
+	{
+		free(wd);
+		return 1;
+	}
+
+	if (Z == NULL)
+	{
+		status = tridiagonal_values(n, t->d, t->e, wd);
+	}
+	else
+	{
+		// the vectors are formed along rows, so a transposed
+		// view is computed in ordinary storage
+		V = (Z->flags & MATRIX_TRANSPOSED) ? zero_matrix(n, n) : Z;
+		status = (V == NULL);
+		if (status == 0)
+		{
+			status = tridiagonal_dc(n, t->d, t->e, wd, V->A);
+		}
+		if (status == 0)
+		{
+			status = back_transform(t, V->A, n);
+		}
+		if (V != Z && V != NULL)
+		{
+			if (status == 0)
+			{
+				matrix_set(Z, V);
+			}
+			free_matrix(V);
+		}
+	}
+	for (i=0; status == 0 && i < n; i++)
+	{
+		w->a[i] = wd[i];
+	}
+
+	free_tridiagonal(t);
+	free(wd);
+	return status;
+}
+
+// eigenvalues by bisection, vectors by inverse iteration
+int symmetric_eigen_range(matrix A, unsigned int il, unsigned int iu,
+		vector w, matrix Z)
+{
+	struct tridiagonal *t;
+	matrix V;
+	double *wd;
+	unsigned int i,k,n=A->n;
+	int status;
+
+	if (A->n != A->m || n < 1)
+	{
+		fprintf(stderr,"Error: eigenvalues need a square matrix\n");
+		return 1;
+	}
+	if (il > iu || iu >= n)
+	{
+		fprintf(stderr,"Error: eigenvalue range %u to %u of %u\n", il, iu, n);
+		return 1;
+	}
+	k = iu - il + 1;
+	if (w->n != k || (Z != NULL && (Z->n != n || Z->m != k)))
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((wd = malloc(sizeof(*wd)*k)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	if ((t = tridiagonal_reduce(A)) == NULL)
+	{
+		free(wd);
+		return 1;
+	}
+
+	status = tridiagonal_bisect(n, t->d, t->e, il, k, wd);
+	if (status == 0 && Z != NULL)
+	{
+		V = (Z->flags & MATRIX_TRANSPOSED) ? zero_matrix(n, k) : Z;
+		status = (V == NULL);
+		if (status == 0)
+		{
+			status = tridiagonal_inverse(n, t->d, t->e, k, wd, V->A);
+		}
+		if (status == 0)
+		{
+			status = back_transform(t, V->A, k);
+		}
+		if (V != Z && V != NULL)
+		{
+			if (status == 0)
+			{
+				matrix_set(Z, V);
+			}
+			free_matrix(V);
+		}
+	}
+	for (i=0; status == 0 && i < k; i++)
+	{
+		w->a[i] = wd[i];
+	}
+
+	free_tridiagonal(t);
+	free(wd);
+	return status;
+}
+
+// the tridiagonal part alone, in double
+int tridiagonal_eigen(unsigned int n, const float *d, const float *e,
+		float *w, matrix Z)
+{
+	matrix V=NULL;
+	double *dd,*ee,*wd;
+	unsigned int i;
+	int status;
+
+	if (n < 1 || (Z != NULL && (Z->n != n || Z->m != n)))
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((dd = malloc(sizeof(*dd)*3*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	ee = dd + n;
+	wd = ee + n;
+	for (i=0; i < n; i++)
+	{
+		dd[i] = d[i];
+		ee[i] = (i + 1 < n) ? e[i] : 0.;
+	}
+
+	if (Z == NULL)
+	{
+		status = tridiagonal_values(n, dd, ee, wd);
+	}
+	else
+	{
+		V = (Z->flags & MATRIX_TRANSPOSED) ? zero_matrix(n, n) : Z;
+		status = (V == NULL);
+		if (status == 0)
+		{
+			status = tridiagonal_dc(n, dd, ee, wd, V->A);
+		}
+		if (V != Z && V != NULL)
+		{
+			if (status == 0)
+			{
+				matrix_set(Z, V);
+			}
+			free_matrix(V);
+		}
+	}
+	for (i=0; status == 0 && i < n; i++)
+	{
+		w[i] = wd[i];
+	}
+
+	free(dd);
+	return status;
+}
+
+// a panel of EIGEN_PANEL columns at a time is reduced with matrix-vector
+// products, then the trailing matrix takes the panel's reflectors in one
+// rank 2*EIGEN_PANEL update, as LAPACK's sytrd does
+static struct tridiagonal * tridiagonal_reduce(matrix A)
+{
+	struct tridiagonal *t;
+	matrix X=NULL,Y=NULL;
+	float **H;
+	float *v=NULL,*work=NULL;
+	unsigned int n=A->n;
+	unsigned int i,j,k0,nb,c,cols,tasks;
+
+	if ((t = malloc(sizeof(*t))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	t->n = n;
+	t->tau = NULL;
+	t->d = NULL;
+	if ((t->H = zero_matrix(n, n)) == NULL)
+	{
+		free(t);
+		return NULL;
+	}
+	tasks = mathlib_get_threads();
+	if ((t->tau = malloc(sizeof(*t->tau)*n)) == NULL
+			|| (t->d = malloc(sizeof(*t->d)*2*n)) == NULL
+			|| (v = malloc(sizeof(*v)*2*n)) == NULL
+			|| (work = malloc(sizeof(*work)*(size_t)tasks*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		free(v);
+		free_tridiagonal(t);
+		return NULL;
+	}
+	t->e = t->d + n;
+	t->e[n-1] = 0.;
+	t->tau[n-1] = 0.;
+	if ((X = zero_matrix(n, 2*EIGEN_PANEL)) == NULL
+			|| (Y = zero_matrix(n, 2*EIGEN_PANEL)) == NULL)
+	{
+		free_matrix(X);
+		free(v);
+		free(work);
+		free_tridiagonal(t);
+		return NULL;
+	}
+
+	// the lower triangle is all that is read or kept up to date
+	H = t->H->A;
+	for (i=0; i < n; i++)
+	{
+		for (j=0; j <= i; j++)
+		{
+			H[i][j] = (A->flags & MATRIX_TRANSPOSED) ? A->A[j][i] : A->A[i][j];
+		}
+	}
+
+	for (k0=0; k0 < n; k0 += EIGEN_PANEL)
+	{
+		nb = (n - k0 < EIGEN_PANEL) ? n - k0 : EIGEN_PANEL;
+		tridiagonal_panel(t, k0, nb, X->A, Y->A, v, v + n, work, tasks);
+		if (k0 + nb == n)
+		{
+			break;
+		}
+
+		// A -= X Y^T below the panel, a block of columns
+		// at a time so the upper triangle is mostly skipped
+		for (c=k0+nb; c < n; c += EIGEN_UPDATE_COLS)
+		{
+			cols = (n - c < EIGEN_UPDATE_COLS) ? n - c : EIGEN_UPDATE_COLS;
+			if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, n - c, cols,
+					2*EIGEN_PANEL, -1., X->A + c, 0, Y->A + c, 0, 1., H + c, c) != 0)
+			{
+				free_matrix(X);
+				free_matrix(Y);
+				free(v);
+				free(work);
+				free_tridiagonal(t);
+				return NULL;
+			}
+		}
+	}
+
+	free_matrix(X);
+	free_matrix(Y);
+	free(v);
+	free(work);
+	return t;
+}
+
+static void free_tridiagonal(struct tridiagonal *t)
+{
+	if (t == NULL)
+	{
+		return;
+	}
+	free_matrix(t->H);
+	free(t->tau);
+	free(t->d);
+	free(t);
+}
+
+// row r of X is [V(r,:) W(r,:)] and of Y [W(r,:) V(r,:)], each half
+// EIGEN_PANEL wide, so A - X Y^T = A - V W^T - W V^T, column i = k0+j is
+// brought up to date with the reflectors of the panel before it, then
+// reflected, W(:,j) is tau (A v - V W^T v - W V^T v) less a multiple of v,
+// with A the trailing matrix as it was before the panel
+static void tridiagonal_panel(struct tridiagonal *t, unsigned int k0,
+		unsigned int nb, float **X, float **Y, float *v, float *y,
+		float *work, unsigned int tasks)
+{
+	float **A=t->H->A;
+	unsigned int n=t->n;
+	unsigned int i,j,r,m;
+	double alpha,beta,xnorm,tau;
+	float scale,s;
+	float p[2*EIGEN_PANEL];
+
+	for (r=k0; r < n; r++)
+	{
+		memset(X[r], 0, sizeof(**X)*2*EIGEN_PANEL);
+		memset(Y[r], 0, sizeof(**Y)*2*EIGEN_PANEL);
+	}
+	for (j=0; j < nb; j++)
+	{
+		i = k0 + j;
+		for (r=i; j > 0 && r < n; r++)
+		{
+			A[r][i] -= mathlib_kernels->dot(2*EIGEN_PANEL, X[r], Y[i]);
+		}
+		t->d[i] = A[i][i];
+		if (i + 1 == n)
+		{
+			break;
+		}
+
+		// the reflector taking A(i+1:n,i) to beta e_1
+		m = n - i - 1;
+		alpha = A[i+1][i];
+		xnorm = 0.;
+		for (r=i+2; r < n; r++)
+		{
+			xnorm += (double)A[r][i]*A[r][i];
+		}
+		if (xnorm == 0.)
+		{
+			tau = 0.;
+			beta = alpha;
+		}
+		else
+		{
+			beta = -copysign(sqrt(alpha*alpha + xnorm), alpha);
+			tau = (beta - alpha)/beta;
+			scale = 1./(alpha - beta);
+			for (r=i+2; r < n; r++)
+			{
+				A[r][i] *= scale;
+			}
+		}
+		t->e[i] = beta;
+		t->tau[i] = tau;
+		A[i+1][i] = 1.;
+		if (tau == 0.)
+		{
+			continue;
+		}
+
+		for (r=i+1; r < n; r++)
+		{
+			v[r-i-1] = A[r][i];
+		}
+		symv(A + i + 1, i + 1, m, v, y, work, tasks);
+
+		// the part of the panel not yet applied to the trailing matrix
+		if (j > 0)
+		{
+			memset(p, 0, sizeof(p));
+			for (r=i+1; r < n; r++)
+			{
+				mathlib_kernels->axpy(2*EIGEN_PANEL, v[r-i-1], X[r], p);
+			}
+			for (r=i+1; r < n; r++)
+			{
+				y[r-i-1] -= mathlib_kernels->dot(2*EIGEN_PANEL, Y[r], p);
+			}
+		}
+
+		mathlib_kernels->scal(m, tau, y);
+		s = -0.5*tau*mathlib_kernels->dot(m, y, v);
+		mathlib_kernels->axpy(m, s, v, y);
+		for (r=i+1; r < n; r++)
+		{
+			X[r][j] = Y[r][EIGEN_PANEL+j] = v[r-i-1];
+			X[r][EIGEN_PANEL+j] = Y[r][j] = y[r-i-1];
+		}
+	}
+}
+
+// the rows are cut so each task has about the same share of the
+// triangle, each task sums into its own vector of work
+static void symv(float **A, unsigned int col, unsigned int n, const float *x,
+		float *y, float *work, unsigned int tasks)
+{
+	struct symv_job job;
+	unsigned int i,t;
+
+	job.A = A;
+	job.col = col;
+	job.n = n;
+	job.x = x;
+	if (n < SYMV_PARALLEL_MIN || tasks < 2)
+	{
+		job.y = y;
+		job.tasks = 1;
+		symv_task(&job, 0);
+		return;
+	}
+
+	job.y = work;
+	job.tasks = tasks;
+	parallel_for(tasks, &symv_task, &job);
+	memcpy(y, work, sizeof(*y)*n);
+	for (t=1; t < tasks; t++)
+	{
+		for (i=0; i < n; i++)
+		{
+			y[i] += work[(size_t)t*n + i];
+		}
+	}
+}
+
+// row r of the lower triangle adds to y_r by a dot product and to y_0..y_r-1
+// by an axpy, so the triangle is read once
+static void symv_task(void *arg, unsigned int t)
+{
+	struct symv_job *job = arg;
+	unsigned int first,last,r;
+	float *y=job->y + (size_t)t*job->n;
+	float *row;
+
+	first = job->n*sqrt((double)t/job->tasks);
+	last = (t + 1 == job->tasks) ? job->n
+		: job->n*sqrt((double)(t + 1)/job->tasks);
+	memset(y, 0, sizeof(*y)*job->n);
+	for (r=first; r < last; r++)
+	{
+		row = job->A[r] + job->col;
+		y[r] += mathlib_kernels->dot(r, row, job->x) + row[r]*job->x[r];
+		mathlib_kernels->axpy(r, job->x[r], row, y);
+	}
+}
+
+// the reflectors are applied in blocks from the last, a block being
+// I - V T V^T with T upper triangular as from LAPACK's larft
+static int back_transform(struct tridiagonal *t, float **Z, unsigned int k)
+{
+	matrix V=NULL,T=NULL,S=NULL,M1=NULL,M2=NULL;
+	float **H=t->H->A;
+	unsigned int n=t->n;
+	unsigned int k0,nb,rows,r,p,q,l,g;
+	float sum;
+	int status=0;
+
+	if (n < 2 || k == 0)
+	{
+		return 0;
+	}
+	if ((V = zero_matrix(n, EIGEN_PANEL)) == NULL
+			|| (T = zero_matrix(EIGEN_PANEL, EIGEN_PANEL)) == NULL
+			|| (S = zero_matrix(EIGEN_PANEL, EIGEN_PANEL)) == NULL
+			|| (M1 = zero_matrix(EIGEN_PANEL, k)) == NULL
+			|| (M2 = zero_matrix(EIGEN_PANEL, k)) == NULL)
+	{
+		free_matrix(V);
+		free_matrix(T);
+		free_matrix(S);
+		free_matrix(M1);
+		return 1;
+	}
+
+	for (k0=((n-2)/EIGEN_PANEL)*EIGEN_PANEL; ; k0 -= EIGEN_PANEL)
+	{
+		// reflectors k0..k0+nb-1 touch rows k0+1..n-1
+		nb = (n - 1 - k0 < EIGEN_PANEL) ? n - 1 - k0 : EIGEN_PANEL;
+		rows = n - k0 - 1;
+		for (r=0; r < rows; r++)
+		{
+			g = k0 + 1 + r;
+			for (p=0; p < nb; p++)
+			{
+				V->A[r][p] = (g < k0 + p + 1) ? 0. : (g == k0 + p + 1) ? 1.
+					: H[g][k0+p];
+			}
+		}
+
+		// T(0:p,p) = -tau_p T(0:p,0:p) V(:,0:p)^T v_p
+		if (gemm_blocked(MATRIX_TRANS, MATRIX_NOTRANS, nb, nb, rows, 1.,
+				V->A, 0, V->A, 0, 0., S->A, 0) != 0)
+		{
+			status = 1;
+			break;
+		}
+		for (p=0; p < nb; p++)
+		{
+			for (q=0; q < p; q++)
+			{
+				sum = 0.;
+				for (l=q; l < p; l++)
+				{
+					sum += T->A[q][l]*S->A[l][p];
+				}
+				T->A[q][p] = -t->tau[k0+p]*sum;
+			}
+			T->A[p][p] = t->tau[k0+p];
+			for (q=p+1; q < nb; q++)
+			{
+				T->A[q][p] = 0.;
+			}
+		}
+
+		// Z -= V (T (V^T Z))
+		if (gemm_blocked(MATRIX_TRANS, MATRIX_NOTRANS, nb, k, rows, 1.,
+					V->A, 0, Z + k0 + 1, 0, 0., M1->A, 0) != 0
+				|| gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, nb, k, nb, 1.,
+					T->A, 0, M1->A, 0, 0., M2->A, 0) != 0
+				|| gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, rows, k, nb, -1.,
+					V->A, 0, M2->A, 0, 1., Z + k0 + 1, 0) != 0)
+		{
+			status = 1;
+			break;
+		}
+		if (k0 == 0)
+		{
+			break;
+		}
+	}
+
+	free_matrix(V);
+	free_matrix(T);
+	free_matrix(S);
+	free_matrix(M1);
+	free_matrix(M2);
+	return status;
+}
+
+// e[i] couples i and i+1, the QL sweeps chase the bulge up from the
+// bottom of each unreduced block, see Numerical Recipes' tqli
+static int tridiagonal_ql(unsigned int n, double *d, double *e, double *z,
+		unsigned int ldz)
+{
+	unsigned int l,m,i,r,iter;
+	double s,c,p,g,f,b,h,dd;
+	int split;
+
+	e[n-1] = 0.;
+	for (l=0; l < n; l++)
+	{
+		iter = 0;
+		for (;;)
+		{
+			for (m=l; m + 1 < n; m++)
+			{
+				dd = fabs(d[m]) + fabs(d[m+1]);
+				if (fabs(e[m]) <= DBL_EPSILON*dd)
+				{
+					break;
+				}
+			}
+			if (m == l)
+			{
+				break;
+			}
+			if (iter++ == EIGEN_MAXITER)
+			{
+				fprintf(stderr,"Error: QL iteration did not converge\n");
+				return 1;
+			}
+
+			// Wilkinson's shift from the leading 2x2 block
+			g = (d[l+1] - d[l])/(2.*e[l]);
+			h = hypot(g, 1.);
+			g = d[m] - d[l] + e[l]/(g + copysign(h, g));
+			s = c = 1.;
+			p = 0.;
+			split = 0;
+			for (i=m; i-- > l; )
+			{
+				f = s*e[i];
+				b = c*e[i];
+				e[i+1] = h = hypot(f, g);
+				if (h == 0.)
+				{
+					// an underflow split the matrix, start again
+					d[i+1] -= p;
+					e[m] = 0.;
+					split = 1;
+					break;
+				}
+				s = f/h;
+				c = g/h;
+				g = d[i+1] - p;
+				h = (d[i] - g)*s + 2.*c*b;
+				p = s*h;
+				d[i+1] = g + p;
+				g = c*h - b;
+				for (r=0; z != NULL && r < n; r++)
+				{
+					f = z[r*ldz + i+1];
+					z[r*ldz + i+1] = s*z[r*ldz + i] + c*f;
+					z[r*ldz + i] = c*z[r*ldz + i] - s*f;
+				}
+			}
+			if (split)
+			{
+				continue;
+			}
+			d[l] -= p;
+			e[l] = g;
+			e[m] = 0.;
+		}
+	}
+	return 0;
+}
+
+static int tridiagonal_values(unsigned int n, const double *d,
+		const double *e, double *w)
+{
+	double *ee;
+	int status;
+
+	if ((ee = malloc(sizeof(*ee)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	memcpy(w, d, sizeof(*w)*n);
+	memcpy(ee, e, sizeof(*ee)*n);
+	if ((status = tridiagonal_ql(n, w, ee, NULL, 0)) == 0)
+	{
+		qsort(w, n, sizeof(*w), &double_compare);
+	}
+	free(ee);
+	return status;
+}
+
+// T is torn into two halves by rank one updates down to leaves solved by
+// QL, then the tree is merged up a level at a time, a level with enough
+// nodes spreads them over the threads, one with few merges one node at a
+// time and lets the merge spread its own work
+static int tridiagonal_dc(unsigned int n, const double *d, const double *e,
+		double *w, float **Z)
+{
+	struct dc_job job;
+	struct eigen_entry *sorted=NULL;
+	unsigned int i,j,count=0,depth,cnt,threads;
+	float *row=NULL;
+
+	job.n = n;
+	job.e = e;
+	job.w = w;
+	job.Q = Z;
+	job.failed = 0;
+	job.nodes = NULL;
+	job.level = NULL;
+	if ((job.d = malloc(sizeof(*job.d)*n)) == NULL
+			|| (job.nodes = malloc(sizeof(*job.nodes)*2*n)) == NULL
+			|| (job.level = malloc(sizeof(*job.level)*2*n)) == NULL
+			|| (sorted = malloc(sizeof(*sorted)*n)) == NULL
+			|| (row = malloc(sizeof(*row)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		free(job.d);
+		free(job.nodes);
+		free(job.level);
+		free(sorted);
+		return 1;
+	}
+	memcpy(job.d, d, sizeof(*job.d)*n);
+	for (i=0; i < n; i++)
+	{
+		memset(Z[i], 0, sizeof(**Z)*n);
+	}
+
+	depth = dc_split(&job, &count, 0, n, 0);
+	threads = mathlib_get_threads();
+	for (depth++; depth-- > 0 && !job.failed; )
+	{
+		cnt = 0;
+		for (i=0; i < count; i++)
+		{
+			if (job.nodes[i].depth == depth)
+			{
+				job.level[cnt++] = i;
+			}
+		}
+		if (threads > 1 && cnt >= threads)
+		{
+			parallel_for(cnt, &dc_task, &job);
+		}
+		else
+		{
+			for (j=0; j < cnt; j++)
+			{
+				dc_task(&job, j);
+			}
+		}
+	}
+
+	// the root's columns in ascending order
+	if (!job.failed)
+	{
+		for (i=0; i < n; i++)
+		{
+			sorted[i].value = w[i];
+			sorted[i].col = i;
+		}
+		qsort(sorted, n, sizeof(*sorted), &entry_compare);
+		for (i=0; i < n; i++)
+		{
+			w[i] = sorted[i].value;
+		}
+		for (i=0; i < n; i++)
+		{
+			for (j=0; j < n; j++)
+			{
+				row[j] = Z[i][sorted[j].col];
+			}
+			memcpy(Z[i], row, sizeof(*row)*n);
+		}
+	}
+
+	free(job.d);
+	free(job.nodes);
+	free(job.level);
+	free(sorted);
+	free(row);
+	return job.failed;
+}
+
+// T = diag(T1, T2) + |e| u u^T where u is 1 in the last row of T1 and
+// sign(e) in the first of T2, so |e| comes off the diagonal either side
+static unsigned int dc_split(struct dc_job *job, unsigned int *count,
+		unsigned int start, unsigned int size, unsigned int depth)
+{
+	struct dc_node *node=&job->nodes[(*count)++];
+	unsigned int m=size/2;
+	unsigned int a,b;
+	double rho;
+
+	node->start = start;
+	node->size = size;
+	node->depth = depth;
+	if (size <= EIGEN_LEAF)
+	{
+		return depth;
+	}
+	rho = fabs(job->e[start+m-1]);
+	job->d[start+m-1] -= rho;
+	job->d[start+m] -= rho;
+	a = dc_split(job, count, start, m, depth + 1);
+	b = dc_split(job, count, start + m, size - m, depth + 1);
+	return (a > b) ? a : b;
+}
+
+static void dc_task(void *arg, unsigned int t)
+{
+	struct dc_job *job = arg;
+	struct dc_node *node=&job->nodes[job->level[t]];
+	int status;
+
+	status = (node->size <= EIGEN_LEAF) ? dc_leaf(job, node)
+		: dc_merge(job, node);
+	if (status)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static int dc_leaf(struct dc_job *job, struct dc_node *node)
+{
+	unsigned int s=node->size, o=node->start;
+	unsigned int i,j;
+	double *z,*dd,*ee;
+	int status;
+
+	if ((z = calloc((size_t)s*s + 2*s, sizeof(*z))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	dd = z + (size_t)s*s;
+	ee = dd + s;
+	for (i=0; i < s; i++)
+	{
+		z[i*s + i] = 1.;
+		dd[i] = job->d[o+i];
+		ee[i] = (i + 1 < s) ? job->e[o+i] : 0.;
+	}
+	if ((status = tridiagonal_ql(s, dd, ee, z, s)) == 0)
+	{
+		for (i=0; i < s; i++)
+		{
+			job->w[o+i] = dd[i];
+			for (j=0; j < s; j++)
+			{
+				job->Q[o+i][o+j] = z[i*s + j];
+			}
+		}
+	}
+	free(z);
+	return status;
+}
+
+// diag(Q1, Q2)^T T diag(Q1, Q2) = D + rho z z^T with rho = 2|e| and
+// z the last row of Q1 and sign(e) times the first row of Q2 over sqrt 2,
+// small parts of z and close pairs of D are deflated as in LAPACK's laed2,
+// the other eigenvalues are the roots of the secular equation and their
+// vectors diag(Q1, Q2) U are two products that skip the zero blocks
+// the node's columns come out as the roots in order, then the deflated
+static int dc_merge(struct dc_job *job, struct dc_node *node)
+{
+	unsigned int s=node->size, m=s/2, o=node->start;
+	float **Q=job->Q;
+	struct eigen_entry *ent,*df;
+	struct secular_job sj;
+	matrix G=NULL,U=NULL;
+	double *dk,*zk,*zz,*tau,*zhat;
+	unsigned int *type,*group,*origin,*col;
+	double rho,sign,tol,dmax,zmax,c,sn,h,t;
+	unsigned int i,j,q,k=0,ndf=0,pj=0,n1=0,n2=0,ty,tasks,row,a,b;
+	int have=0;
+	float x,y;
+
+	ent = malloc(sizeof(*ent)*2*s);
+	dk = malloc(sizeof(*dk)*5*s);
+	type = malloc(sizeof(*type)*4*s);
+	if (ent == NULL || dk == NULL || type == NULL)
+	{
+		perror("Error allocating memory");
+		free(ent);
+		free(dk);
+		free(type);
+		return 1;
+	}
+	df = ent + s;
+	zk = dk + s;
+	zz = zk + s;
+	tau = zz + s;
+	zhat = tau + s;
+	group = type + s;
+	origin = group + s;
+	col = origin + s;
+
+	rho = job->e[o+m-1];
+	sign = (rho < 0.) ? -1. : 1.;
+	rho = 2.*fabs(rho);
+	dmax = zmax = 0.;
+	for (j=0; j < s; j++)
+	{
+		ent[j].value = job->w[o+j];
+		ent[j].z = ((j < m) ? Q[o+m-1][o+j] : sign*Q[o+m][o+j])/M_SQRT2;
+		ent[j].col = j;
+		type[j] = (j < m) ? 1 : 3;
+		dmax = fmax(dmax, fabs(ent[j].value));
+		zmax = fmax(zmax, fabs(ent[j].z));
+	}
+	qsort(ent, s, sizeof(*ent), &entry_compare);
+	tol = 8.*FLT_EPSILON*fmax(dmax, rho*zmax);
+
+	// type 1 columns are zero below row m, type 3 above it, a rotation
+	// between the halves leaves both columns full, type 2
+	for (i=0; i < s; i++)
+	{
+		if (rho*fabs(ent[i].z) <= tol)
+		{
+			df[ndf++] = ent[i];
+			continue;
+		}
+		if (!have)
+		{
+			pj = i;
+			have = 1;
+			continue;
+		}
+		c = ent[i].z;
+		sn = ent[pj].z;
+		h = hypot(c, sn);
+		t = ent[i].value - ent[pj].value;
+		c /= h;
+		sn = -sn/h;
+		if (fabs(t*c*sn) <= tol)
+		{
+			// rotate the z of pj into i and deflate pj
+			ent[i].z = h;
+			ent[pj].z = 0.;
+			a = ent[pj].col;
+			b = ent[i].col;
+			for (row=0; row < s; row++)
+			{
+				x = Q[o+row][o+a];
+				y = Q[o+row][o+b];
+				Q[o+row][o+a] = c*x + sn*y;
+				Q[o+row][o+b] = c*y - sn*x;
+			}
+			if (type[a] != type[b])
+			{
+				type[a] = type[b] = 2;
+			}
+			t = ent[pj].value*c*c + ent[i].value*sn*sn;
+			ent[i].value = ent[pj].value*sn*sn + ent[i].value*c*c;
+			ent[pj].value = t;
+			df[ndf++] = ent[pj];
+		}
+		else
+		{
+			dk[k] = ent[pj].value;
+			zk[k] = ent[pj].z;
+			col[k++] = ent[pj].col;
+		}
+		pj = i;
+	}
+	if (have)
+	{
+		dk[k] = ent[pj].value;
+		zk[k] = ent[pj].z;
+		col[k++] = ent[pj].col;
+	}
+	qsort(df, ndf, sizeof(*df), &entry_compare);
+
+	// gather the columns, those that take part in the products grouped
+	// by type, and put the deflated ones back after them
+	for (ty=1, q=0; ty <= 3; ty++)
+	{
+		for (i=0; i < k; i++)
+		{
+			if (type[col[i]] == ty)
+			{
+				group[q++] = i;
+			}
+		}
+		n1 = (ty == 1) ? q : n1;
+		n2 = (ty == 2) ? q - n1 : n2;
+	}
+	if ((G = zero_matrix(s, s)) == NULL
+			|| (k > 0 && (U = zero_matrix(k, k)) == NULL))
+	{
+		free_matrix(G);
+		free(ent);
+		free(dk);
+		free(type);
+		return 1;
+	}
+	for (row=0; row < s; row++)
+	{
+		for (q=0; q < k; q++)
+		{
+			G->A[row][q] = Q[o+row][o+col[group[q]]];
+		}
+		for (q=0; q < ndf; q++)
+		{
+			G->A[row][k+q] = Q[o+row][o+df[q].col];
+		}
+		memcpy(Q[o+row] + o + k, G->A[row] + k, sizeof(**Q)*ndf);
+	}
+	for (q=0; q < ndf; q++)
+	{
+		job->w[o+k+q] = df[q].value;
+	}
+
+	if (k > 0)
+	{
+		for (i=0; i < k; i++)
+		{
+			zz[i] = rho*zk[i]*zk[i];
+		}
+		sj.k = k;
+		sj.rho = rho;
+		sj.d = dk;
+		sj.z = zk;
+		sj.zz = zz;
+		sj.tau = tau;
+		sj.origin = origin;
+		sj.zhat = zhat;
+		sj.group = group;
+		sj.U = U->A;
+		tasks = (k + SECULAR_BLOCK - 1)/SECULAR_BLOCK;
+		parallel_for(tasks, &secular_task, &sj);
+		parallel_for(tasks, &zhat_task, &sj);
+		parallel_for(tasks, &vector_task, &sj);
+
+		if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, m, k, n1 + n2, 1.,
+					G->A, 0, U->A, 0, 0., Q + o, o) != 0
+				|| gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, s - m, k, k - n1,
+					1., G->A + m, n1, U->A, n1, 0., Q + o + m, o) != 0)
+		{
+			free_matrix(G);
+			free_matrix(U);
+			free(ent);
+			free(dk);
+			free(type);
+			return 1;
+		}
+		for (j=0; j < k; j++)
+		{
+			job->w[o+j] = dk[origin[j]] + tau[j];
+		}
+	}
+
+	free_matrix(G);
+	free_matrix(U);
+	free(ent);
+	free(dk);
+	free(type);
+	return 0;
+}
+
+static void secular_task(void *arg, unsigned int t)
+{
+	struct secular_job *job = arg;
+	unsigned int j,last;
+
+	last = (t + 1)*SECULAR_BLOCK;
+	last = (last < job->k) ? last : job->k;
+	for (j=t*SECULAR_BLOCK; j < last; j++)
+	{
+		job->tau[j] = secular_root(job->k, job->d, job->zz, j,
+				&job->origin[j]);
+	}
+}
+
+// rho zhat_i^2 = prod_j (lambda_j - d_i) / prod_j!=i (d_j - d_i), so the
+// vectors below are orthogonal to working precision however close the
+// roots, each factor is a ratio near 1 by interlacing
+static void zhat_task(void *arg, unsigned int t)
+{
+	struct secular_job *job = arg;
+	const double *d=job->d;
+	unsigned int i,j,last;
+	double p;
+
+	last = (t + 1)*SECULAR_BLOCK;
+	last = (last < job->k) ? last : job->k;
+	for (i=t*SECULAR_BLOCK; i < last; i++)
+	{
+		p = (job->tau[i] - (d[i] - d[job->origin[i]]))/job->rho;
+		for (j=0; j < job->k; j++)
+		{
+			if (j != i)
+			{
+				p *= (job->tau[j] - (d[i] - d[job->origin[j]]))/(d[j] - d[i]);
+			}
+		}
+		job->zhat[i] = copysign(sqrt(fabs(p)), job->z[i]);
+	}
+}
+
+// u_i = zhat_i/(d_i - lambda_j) normalized, d_i - lambda_j is taken from
+// the nearer pole the root was found from so it keeps its accuracy
+static void vector_task(void *arg, unsigned int t)
+{
+	struct secular_job *job = arg;
+	const double *d=job->d;
+	unsigned int i,j,q,last;
+	double norm,u,base;
+
+	last = (t + 1)*SECULAR_BLOCK;
+	last = (last < job->k) ? last : job->k;
+	for (j=t*SECULAR_BLOCK; j < last; j++)
+	{
+		base = d[job->origin[j]];
+		norm = 0.;
+		for (q=0; q < job->k; q++)
+		{
+			i = job->group[q];
+			u = job->zhat[i]/((d[i] - base) - job->tau[j]);
+			norm += u*u;
+		}
+		norm = 1./sqrt(norm);
+		for (q=0; q < job->k; q++)
+		{
+			i = job->group[q];
+			job->U[j][q] = norm*job->zhat[i]/((d[i] - base) - job->tau[j]);
+		}
+	}
+}
+
+// the root is tau past the pole it is nearer, which the midpoint decides,
+// each step solves a model with the two poles either side of the root
+// whose terms match the sums on each side in value and slope, falling
+// back to bisection of the bracket, as in the middle way of LAPACK's laed4
+static double secular_root(unsigned int k, const double *d, const double *zz,
+		unsigned int j, unsigned int *origin)
+{
+	unsigned int i,it,o;
+	double lo,hi,tau,next,f,psi,phi,dpsi,dphi,delta,q,a,b,s,t,c,eta;
+	double bb,cc,disc;
+
+	if (j + 1 == k)
+	{
+		// above the largest pole, by at most the sum of zz
+		o = j;
+		lo = 0.;
+		hi = 0.;
+		for (i=0; i < k; i++)
+		{
+			hi += zz[i];
+		}
+	}
+	else
+	{
+		delta = (d[j+1] - d[j])/2.;
+		f = 1.;
+		for (i=0; i < k; i++)
+		{
+			f += zz[i]/((d[i] - d[j]) - delta);
+		}
+		if (f > 0.)
+		{
+			o = j;
+			lo = 0.;
+			hi = delta;
+		}
+		else
+		{
+			o = j + 1;
+			lo = -delta;
+			hi = 0.;
+		}
+	}
+	*origin = o;
+	tau = (lo + hi)/2.;
+
+	for (it=0; it < 100; it++)
+	{
+		psi = phi = dpsi = dphi = 0.;
+		for (i=0; i < k; i++)
+		{
+			delta = (d[i] - d[o]) - tau;
+			q = zz[i]/delta;
+			if (i <= j)
+			{
+				psi += q;
+				dpsi += q/delta;
+			}
+			else
+			{
+				phi += q;
+				dphi += q/delta;
+			}
+		}
+		f = 1. + psi + phi;
+		if (f > 0.)
+		{
+			hi = tau;
+		}
+		else
+		{
+			lo = tau;
+		}
+		if (fabs(f) <= 8.*k*DBL_EPSILON*(1. + fabs(psi) + fabs(phi)))
+		{
+			break;
+		}
+
+		// c + s/(a - eta) + t/(b - eta) = 0 for the step eta
+		a = (d[j] - d[o]) - tau;
+		s = a*a*dpsi;
+		if (j + 1 == k)
+		{
+			c = f - s/a;
+			eta = a + s/c;
+		}
+		else
+		{
+			b = (d[j+1] - d[o]) - tau;
+			t = b*b*dphi;
+			c = f - s/a - t/b;
+			bb = c*(a + b) + s + t;
+			cc = c*a*b + s*b + t*a;
+			disc = sqrt(fmax(bb*bb - 4.*c*cc, 0.));
+			q = (bb + copysign(disc, bb))/2.;
+			eta = (q != 0.) ? cc/q : 0.;
+			if (!(eta > a && eta < b) && c != 0.)
+			{
+				eta = q/c;
+			}
+		}
+		next = tau + eta;
+		if (!(next > lo && next < hi))
+		{
+			next = (lo + hi)/2.;
+		}
+		if (next == tau || fabs(next - tau) <= 2.*DBL_EPSILON*fabs(next))
+		{
+			tau = next;
+			break;
+		}
+		tau = next;
+	}
+	return tau;
+}
+
+static int entry_compare(const void *a, const void *b)
+{
+	double x=((const struct eigen_entry *)a)->value;
+	double y=((const struct eigen_entry *)b)->value;
+
+	return (x > y) - (x < y);
+}
+
+static int double_compare(const void *a, const void *b)
+{
+	double x=*(const double *)a;
+	double y=*(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void gershgorin(unsigned int n, const double *d, const double *e,
+		double *gl, double *gu)
+{
+	unsigned int i;
+	double r;
+
+	*gl = *gu = d[0];
+	for (i=0; i < n; i++)
+	{
+		r = ((i > 0) ? fabs(e[i-1]) : 0.) + ((i + 1 < n) ? fabs(e[i]) : 0.);
+		*gl = fmin(*gl, d[i] - r);
+		*gu = fmax(*gu, d[i] + r);
+	}
+}
+
+// the negative pivots of the LDL^T factorization of T - xI, tiny pivots
+// are replaced by -pivmin as in LAPACK's laebz
+static unsigned int sturm_count(unsigned int n, const double *d,
+		const double *e2, double x, double pivmin)
+{
+	unsigned int i,count;
+	double q;
+
+	q = d[0] - x;
+	q = (fabs(q) < pivmin) ? -pivmin : q;
+	count = (q <= 0.);
+	for (i=1; i < n; i++)
+	{
+		q = d[i] - e2[i-1]/q - x;
+		q = (fabs(q) < pivmin) ? -pivmin : q;
+		count += (q <= 0.);
+	}
+	return count;
+}
+
+static int tridiagonal_bisect(unsigned int n, const double *d,
+		const double *e, unsigned int il, unsigned int k, double *w)
+{
+	struct bisection_job job;
+	double *e2;
+	double emax=1.;
+	unsigned int i;
+
+	if ((e2 = malloc(sizeof(*e2)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	for (i=0; i < n; i++)
+	{
+		e2[i] = e[i]*e[i];
+		emax = fmax(emax, e2[i]);
+	}
+	job.n = n;
+	job.il = il;
+	job.k = k;
+	job.d = d;
+	job.e2 = e2;
+	job.w = w;
+	job.pivmin = DBL_MIN*emax;
+	gershgorin(n, d, e, &job.gl, &job.gu);
+	job.tnorm = fmax(fabs(job.gl), fabs(job.gu));
+	job.gl -= 2.*DBL_EPSILON*job.tnorm*n + 2.*job.pivmin;
+	job.gu += 2.*DBL_EPSILON*job.tnorm*n + 2.*job.pivmin;
+	parallel_for((k + BISECTION_BLOCK - 1)/BISECTION_BLOCK, &bisection_task,
+			&job);
+	free(e2);
+	return 0;
+}
+
+// lambda_i is the x at which the count passes i
+static void bisection_task(void *arg, unsigned int t)
+{
+	struct bisection_job *job = arg;
+	unsigned int j,last;
+	double lo,hi,mid;
+
+	last = (t + 1)*BISECTION_BLOCK;
+	last = (last < job->k) ? last : job->k;
+	for (j=t*BISECTION_BLOCK; j < last; j++)
+	{
+		lo = job->gl;
+		hi = job->gu;
+		for (;;)
+		{
+			mid = (lo + hi)/2.;
+			if (mid <= lo || mid >= hi
+					|| hi - lo <= 2.*DBL_EPSILON*job->tnorm)
+			{
+				break;
+			}
+			if (sturm_count(job->n, job->d, job->e2, mid, job->pivmin)
+					> job->il + j)
+			{
+				hi = mid;
+			}
+			else
+			{
+				lo = mid;
+			}
+		}
+		job->w[j] = (lo + hi)/2.;
+	}
+}
+
+// eigenvalues within EIGEN_CLUSTER |T| of each other form a cluster
+// whose vectors are orthogonalized against each other, clusters are
+// independent and go to separate tasks
+static int tridiagonal_inverse(unsigned int n, const double *d,
+		const double *e, unsigned int k, const double *w, float **Z)
+{
+	struct inverse_job job;
+	unsigned int *cluster;
+	unsigned int j,count=0;
+	double gl,gu;
+
+	if ((cluster = malloc(sizeof(*cluster)*(k + 1))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	gershgorin(n, d, e, &gl, &gu);
+	job.tnorm = fmax(fabs(gl), fabs(gu));
+	job.tnorm = (job.tnorm > 0.) ? job.tnorm : 1.;
+	for (j=0; j < k; j++)
+	{
+		if (j == 0 || w[j] - w[j-1] > EIGEN_CLUSTER*job.tnorm)
+		{
+			cluster[count++] = j;
+		}
+	}
+	cluster[count] = k;
+
+	job.n = n;
+	job.d = d;
+	job.e = e;
+	job.w = w;
+	job.cluster = cluster;
+	job.Z = Z;
+	job.failed = 0;
+	parallel_for(count, &inverse_task, &job);
+	free(cluster);
+	return job.failed;
+}
+
+// (T - lambda I) x = b by Gaussian elimination with partial pivoting, which
+// leaves U with two super diagonals, a few times from a pseudo random start,
+// pivots and eigenvalues of a cluster closer than 10 eps |T| are moved
+// that far apart so the solves stay finite
+static void inverse_task(void *arg, unsigned int t)
+{
+	struct inverse_job *job = arg;
+	const double *d=job->d, *e=job->e;
+	unsigned int n=job->n;
+	unsigned int j,i,p,step,seed;
+	double *u0,*u1,*u2,*l,*x;
+	unsigned char *swap;
+	double lambda,prev=0.,pert,u,v,a,b,sub,dot,norm;
+	float **Z=job->Z;
+
+	if ((u0 = malloc(sizeof(*u0)*5*n + n)) == NULL)
+	{
+		perror("Error allocating memory");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	u1 = u0 + n;
+	u2 = u1 + n;
+	l = u2 + n;
+	x = l + n;
+	swap = (unsigned char *)(x + n);
+	pert = 10.*DBL_EPSILON*job->tnorm;
+
+	for (j=job->cluster[t]; j < job->cluster[t+1]; j++)
+	{
+		lambda = job->w[j];
+		if (j > job->cluster[t] && lambda - prev < pert)
+		{
+			lambda = prev + pert;
+		}
+		prev = lambda;
+
+		// factor
+		u = d[0] - lambda;
+		v = (n > 1) ? e[0] : 0.;
+		for (i=0; i + 1 < n; i++)
+		{
+			sub = e[i];
+			a = d[i+1] - lambda;
+			b = (i + 2 < n) ? e[i+1] : 0.;
+			if (fabs(u) >= fabs(sub))
+			{
+				u = (fabs(u) < pert) ? copysign(pert, u) : u;
+				l[i] = sub/u;
+				swap[i] = 0;
+				u0[i] = u;
+				u1[i] = v;
+				u2[i] = 0.;
+				u = a - l[i]*v;
+				v = b;
+			}
+			else
+			{
+				l[i] = u/sub;
+				swap[i] = 1;
+				u0[i] = sub;
+				u1[i] = a;
+				u2[i] = b;
+				u = v - l[i]*a;
+				v = -l[i]*b;
+			}
+		}
+		u0[n-1] = (fabs(u) < pert) ? copysign(pert, u) : u;
+
+		seed = 2463534242u + 977u*j;
+		for (i=0; i < n; i++)
+		{
+			seed = seed*1103515245u + 12345u;
+			x[i] = ((seed >> 16) & 0x7fff)/16384. - 1.;
+		}
+		for (step=0; step < EIGEN_INVERSE_STEPS; step++)
+		{
+			for (i=0; i + 1 < n; i++)
+			{
+				if (swap[i])
+				{
+					a = x[i];
+					x[i] = x[i+1];
+					x[i+1] = a;
+				}
+				x[i+1] -= l[i]*x[i];
+			}
+			for (i=n; i-- > 0; )
+			{
+				a = x[i];
+				a -= (i + 1 < n) ? u1[i]*x[i+1] : 0.;
+				a -= (i + 2 < n) ? u2[i]*x[i+2] : 0.;
+				x[i] = a/u0[i];
+			}
+
+			// against the vectors of the cluster found so far
+			for (p=job->cluster[t]; p < j; p++)
+			{
+				dot = 0.;
+				for (i=0; i < n; i++)
+				{
+					dot += x[i]*Z[i][p];
+				}
+				for (i=0; i < n; i++)
+				{
+					x[i] -= dot*Z[i][p];
+				}
+			}
+			norm = 0.;
+			for (i=0; i < n; i++)
+			{
+				norm += x[i]*x[i];
+			}
+			norm = (norm > 0.) ? 1./sqrt(norm) : 0.;
+			for (i=0; i < n; i++)
+			{
+				x[i] *= norm;
+			}
+		}
+		for (i=0; i < n; i++)
+		{
+			Z[i][j] = x[i];
+		}
+	}
+	free(u0);
+}
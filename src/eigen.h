@@ -0,0 +1,51 @@
+/* Eigenvalues and eigenvectors of symmetric matrices
+ * Oct 18 2026 */
+
+#ifndef EIGEN_H
+#define EIGEN_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "gemm.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// columns reduced per panel of the tridiagonalization, the rest of the
+// matrix is updated once per panel by matrix multiplication
+#define EIGEN_PANEL 32
+// columns of the trailing matrix updated by one call of gemm_blocked()
+#define EIGEN_UPDATE_COLS 256
+// divide and conquer stops splitting below this order
+#define EIGEN_LEAF 32
+// sweeps of implicit QL allowed per eigenvalue of a tridiagonal matrix
+#define EIGEN_MAXITER 30
+// steps of inverse iteration for each eigenvector of an index range
+#define EIGEN_INVERSE_STEPS 3
+// eigenvalues closer than this times |T| have their vectors
+// orthogonalized against each other by inverse iteration
+#define EIGEN_CLUSTER 1e-3
+
+// all eigenvalues w[0] <= ... <= w[n-1] of a symmetric A and, if Z isn't
+// NULL, the orthonormal eigenvectors as the columns of the n x n Z
+// only the lower triangle of A is read and A is left alone, A is reduced
+// to tridiagonal form and the vectors come from divide and conquer
+// returns 0 on success
+extern int symmetric_eigen(matrix A, vector w, matrix Z);
+// eigenvalues il to iu of the same sorted list, 0 based and inclusive,
+// into w[0..iu-il] and their vectors into the n x (iu-il+1) Z, by bisection
+// and inverse iteration so the work on the tridiagonal matrix and the
+// back transformation are in proportion to the number of eigenpairs
+extern int symmetric_eigen_range(matrix A, unsigned int il, unsigned int iu,
+		vector w, matrix Z);
+// the same for a symmetric tridiagonal matrix with diagonal d[0..n-1] and
+// off diagonal e[0..n-2], Z may be NULL for the eigenvalues alone
+extern int tridiagonal_eigen(unsigned int n, const float *d, const float *e,
+		float *w, matrix Z);
+
+#endif
@@ -1,13 +1,17 @@
 #include "euler_method.h"
 
 matrix euler_method(vector_function f, vector y0, float tmin, float tmax, float h);
+int euler_method_stream(vector_function f, vector y0, float tmin, float tmax,
+		float h, ode_stream out);
+int euler_method_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float h, ode_stream out);
 
 matrix euler_method(vector_function f, vector y0,
 		float tmin, float tmax, float h)
 {
 	matrix Y;
+	ode_stream out;
 	unsigned int n=(int)((tmax-tmin)/h);
-	unsigned int i,j;
 
 	if (f->n != y0->n)
 	{
@@ -21,27 +25,98 @@ matrix euler_method(vector_function f, vector y0,
 		return NULL;
 	}
 
-	// time slices
-	Y->A[0][0] = tmin;
-	for (i=1; i < Y->n; i++)
+	// solution matrix
+	if ((out=ode_stream_into(Y, 1)) == NULL)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+	if (euler_method_stream(f, y0, tmin, tmax, h, out) != 0
+			|| ode_stream_close(out) != 0)
+	{
+		free_matrix(Y);
+		return NULL;
+	}
+
+	return Y;
+}
+
+// the rows [t y1 ... yn] of the solution are pushed to out as they are
+// computed, returns 0 on success, out is left open for the caller to close
+int euler_method_stream(vector_function f, vector y0,
+		float tmin, float tmax, float h, ode_stream out)
+{
+	struct vecfunc_adapter adapter;
+	int status;
+
+	if (f->n != y0->n)
+	{
+		fprintf(stderr,"System has inconsistent dimensions\n");
+		return 1;
+	}
+	if (vecfunc_adapter_init(&adapter, f) != 0)
+	{
+		return 1;
+	}
+	status = euler_method_rhs(&vecfunc_rhs, &adapter, y0, tmin, tmax, h, out);
+	vecfunc_adapter_free(&adapter);
+
+	return status;
+}
+
+// the same for a right hand side computed a whole vector at a time
+// only the current and next rows are kept in memory
+int euler_method_rhs(ode_rhs f, void *userdata, vector y0,
+		float tmin, float tmax, float h, ode_stream out)
+{
+	unsigned int n=(int)((tmax-tmin)/h);
+	unsigned int d=y0->n;
+	unsigned int m=d+1;
+	unsigned int i,j;
+	float *work,*y,*next,*k,*tmp;
+
+	if (n < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return 1;
+	}
+
+	// rows [t y] for the current and next steps, then the slope
+	if ((work=vector_allocate(2*m+d)) == NULL)
 	{
-		Y->A[i][0] = Y->A[i-1][0]+h;
+		return 1;
 	}
+	y = work;
+	next = y+m;
+	k = next+m;
 
 	// initial conditions
-	for (j=1; j < Y->m; j++)
+	y[0] = tmin;
+	for (j=1; j < m; j++)
 	{
-		Y->A[0][j] = y0->a[j-1];
+		y[j] = y0->a[j-1];
 	}
 
-	// solution matrix
-	for (i=0; i < n-1; i++)
+	// time steps
+	for (i=0; ode_stream_push(out, y) == 0; i++)
 	{
-		for(j=1; j < Y->m; j++)
+		if (i == n-1)
+		{
+			free(work);
+			return 0;
+		}
+		(*f)(y[0], y+1, k, d, userdata);
+		next[0] = tmin + (i+1)*h;
+		for (j=0; j < d; j++)
 		{
-			Y->A[i+1][j] = Y->A[i][j] + h*(*f->f[j-1])(Y->A[i], Y->m);
+			next[j+1] = y[j+1] + h*k[j];
 		}
+		tmp = y;
+		y = next;
+		next = tmp;
 	}
 
-	return Y;
+	// the stream refused a row
+	free(work);
+	return 1;
 }
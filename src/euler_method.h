@@ -9,7 +9,17 @@
 #include "matrix.h"
 #include "vector.h"
 #include "vector_function.h"
+#include "ode_stream.h"
 
+// solution rows [t y1 ... yn], row i at t = tmin + i*h, computed from i
+// rather than accumulated so rounding doesn't drift over many steps,
+// the other fixed step solvers give their rows the same way
 extern matrix euler_method(vector_function f, vector y0, float tmin, float tmax, float h);
+// the same rows pushed to out one at a time, returns 0 on success
+extern int euler_method_stream(vector_function f, vector y0, float tmin, float tmax,
+		float h, ode_stream out);
+// the same for a right hand side computed a whole vector at a time
+extern int euler_method_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float h, ode_stream out);
 
 #endif
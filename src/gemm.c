@@ -0,0 +1,434 @@
+/* Cache blocked matrix multiplication
+ * Oct 18 2026 */
+
+#include "gemm.h"
+
+// C = alpha*op(A)*op(B) + beta*C
+int gemm_blocked(int transa, int transb,
+		unsigned int n, unsigned int m, unsigned int k,
+		float alpha, float **A, unsigned int ja,
+		float **B, unsigned int jb,
+		float beta, float **C, unsigned int jc);
+
+// pack a block of op(A) into panels of tile_mr rows
+static void pack_a(int trans, unsigned int mc, unsigned int kc, unsigned int tile_mr,
+		float **A, unsigned int i0, unsigned int p0, float *buf);
+// pack a panel of op(B) into slivers of tile_nr columns
+static void pack_b(int trans, unsigned int kc, unsigned int nc, unsigned int tile_nr,
+		float **B, unsigned int p0, unsigned int j0, float *buf);
+// C = beta*C for the degenerate products
+static void scale_block(unsigned int n, unsigned int m,
+		float beta, float **C, unsigned int jc);
+// the micro-kernel over an mc x nc block of C from packed A and B
+static void gemm_macro(unsigned int mc, unsigned int nc, unsigned int kc,
+		float alpha, float beta, const float *apack, const float *bpack,
+		float **C, unsigned int jc);
+// single threaded product
+static int gemm_serial(int transa, int transb,
+		unsigned int n, unsigned int m, unsigned int k,
+		float alpha, float **A, unsigned int ja,
+		float **B, unsigned int jb,
+		float beta, float **C, unsigned int jc);
+// parallel_for task packing GEMM_TILE_MIN_COLS columns of the panel of B
+// or MC rows of the slice of A
+static void gemm_pack_task(void *arg, unsigned int t);
+// parallel_for task computing one tile of C against the packed panel
+static void gemm_tile(void *arg, unsigned int t);
+
+// a product split into tiles of C for the thread pool, every panel
+// of B and slice of A is packed once and shared by all the tiles
+struct gemm_job
+{
+	int transa;
+	int transb;
+	unsigned int n,m,k;
+	float alpha;
+	float **A,**B,**C;
+	unsigned int ja,jb,jc;
+	float *apack; // the n x kc slice of op(A) at (0,pc)
+	float *bpack; // the kc x nc panel of op(B) at (pc,jcol)
+	unsigned int pc,kc; // the current slice of the inner dimension
+	unsigned int jcol,nc; // the current panel of columns
+	float beta_k; // beta for this slice
+	unsigned int tile_cols; // columns of the panel per tile
+	unsigned int col_tiles; // tiles across the panel
+	unsigned int b_tasks; // packing tasks for the panel of B
+};
+
+// Pack an mc x kc block of op(A) starting at op(A)[i0][p0]
+// each panel of tile_mr rows is stored column after column so the
+// micro-kernel streams through it, short panels are padded with zeros
+static void pack_a(int trans, unsigned int mc, unsigned int kc, unsigned int tile_mr,
+		float **A, unsigned int i0, unsigned int p0, float *buf)
+{
+	unsigned int i,p,r,mr;
+	const float *row;
+
+	for (i = 0; i < mc; i += tile_mr)
+	{
+		mr = (mc - i < tile_mr) ? mc - i : tile_mr;
+
+		if (trans == MATRIX_NOTRANS)
+		{
+			// op(A)[i][p] = A[i][p], walk each row of the panel
+			for (r = 0; r < mr; r++)
+			{
+				row = A[i0+i+r] + p0;
+				for (p = 0; p < kc; p++)
+				{
+					buf[p*tile_mr + r] = row[p];
+				}
+			}
+		}
+		else
+		{
+			// op(A)[i][p] = A[p][i], a panel column is a piece of a row
+			for (p = 0; p < kc; p++)
+			{
+				row = A[p0+p] + i0 + i;
+				for (r = 0; r < mr; r++)
+				{
+					buf[p*tile_mr + r] = row[r];
+				}
+			}
+		}
+
+		// zero padding for the last panel
+		for (r = mr; r < tile_mr; r++)
+		{
+			for (p = 0; p < kc; p++)
+			{
+				buf[p*tile_mr + r] = 0.;
+			}
+		}
+
+		buf += tile_mr*kc;
+	}
+}
+
+// Pack a kc x nc panel of op(B) starting at op(B)[p0][j0]
+// each sliver of tile_nr columns is stored row after row,
+// short slivers are padded with zeros
+static void pack_b(int trans, unsigned int kc, unsigned int nc, unsigned int tile_nr,
+		float **B, unsigned int p0, unsigned int j0, float *buf)
+{
+	unsigned int j,p,c,nr;
+	const float *row;
+
+	for (j = 0; j < nc; j += tile_nr)
+	{
+		nr = (nc - j < tile_nr) ? nc - j : tile_nr;
+
+		if (trans == MATRIX_NOTRANS)
+		{
+			// op(B)[p][j] = B[p][j], a sliver row is a piece of a row
+			for (p = 0; p < kc; p++)
+			{
+				row = B[p0+p] + j0 + j;
+				for (c = 0; c < nr; c++)
+				{
+					buf[p*tile_nr + c] = row[c];
+				}
+				for (c = nr; c < tile_nr; c++)
+				{
+					buf[p*tile_nr + c] = 0.;
+				}
+			}
+		}
+		else
+		{
+			// op(B)[p][j] = B[j][p], walk each row of B
+			for (c = 0; c < nr; c++)
+			{
+				row = B[j0+j+c] + p0;
+				for (p = 0; p < kc; p++)
+				{
+					buf[p*tile_nr + c] = row[p];
+				}
+			}
+			for (c = nr; c < tile_nr; c++)
+			{
+				for (p = 0; p < kc; p++)
+				{
+					buf[p*tile_nr + c] = 0.;
+				}
+			}
+		}
+
+		buf += tile_nr*kc;
+	}
+}
+
+// C = beta*C
+static void scale_block(unsigned int n, unsigned int m,
+		float beta, float **C, unsigned int jc)
+{
+	unsigned int i,j;
+
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < m; j++)
+		{
+			if (beta == 0.)
+			{
+				C[i][jc+j] = 0.;
+			}
+			else
+			{
+				C[i][jc+j] *= beta;
+			}
+		}
+	}
+}
+
+// C = alpha*op(A)*op(B) + beta*C on one thread
+// the loops around the micro-kernel follow the usual layering:
+// NC columns of C at a time, KC deep slices of the inner dimension
+// packed once per panel of B, and MC rows of A packed once per block
+static int gemm_serial(int transa, int transb,
+		unsigned int n, unsigned int m, unsigned int k,
+		float alpha, float **A, unsigned int ja,
+		float **B, unsigned int jb,
+		float beta, float **C, unsigned int jc)
+{
+	unsigned int ic,jcol,pc;
+	unsigned int mc,nc,kc;
+	unsigned int a_rows,b_cols;
+	unsigned int tile_mr=mathlib_kernels->mr; // register tile
+	unsigned int tile_nr=mathlib_kernels->nr;
+	float beta_k; // beta for this slice of the inner dimension
+	float *apack,*bpack;
+
+	// only allocate as much packing space as this product needs
+	a_rows = (n < GEMM_MC) ? n : GEMM_MC;
+	a_rows = ((a_rows + tile_mr - 1)/tile_mr)*tile_mr;
+	b_cols = (m < GEMM_NC) ? m : GEMM_NC;
+	b_cols = ((b_cols + tile_nr - 1)/tile_nr)*tile_nr;
+	kc = (k < GEMM_KC) ? k : GEMM_KC;
+
+	if (posix_memalign((void **)&apack, 64, sizeof(*apack)*a_rows*kc) != 0)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	if (posix_memalign((void **)&bpack, 64, sizeof(*bpack)*b_cols*kc) != 0)
+	{
+		perror("Error allocating memory");
+		free(apack);
+		return 1;
+	}
+
+	for (jcol = 0; jcol < m; jcol += GEMM_NC)
+	{
+		nc = (m - jcol < GEMM_NC) ? m - jcol : GEMM_NC;
+
+		for (pc = 0; pc < k; pc += GEMM_KC)
+		{
+			kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+
+			// the first slice applies beta, later ones accumulate
+			beta_k = (pc == 0) ? beta : 1.;
+
+			if (transb == MATRIX_NOTRANS)
+			{
+				pack_b(transb, kc, nc, tile_nr, B, pc, jb + jcol, bpack);
+			}
+			else
+			{
+				pack_b(transb, kc, nc, tile_nr, B + jcol, jb + pc, 0, bpack);
+			}
+
+			for (ic = 0; ic < n; ic += GEMM_MC)
+			{
+				mc = (n - ic < GEMM_MC) ? n - ic : GEMM_MC;
+
+				if (transa == MATRIX_NOTRANS)
+				{
+					pack_a(transa, mc, kc, tile_mr, A + ic, 0, ja + pc, apack);
+				}
+				else
+				{
+					pack_a(transa, mc, kc, tile_mr, A + pc, ja + ic, 0, apack);
+				}
+
+				gemm_macro(mc, nc, kc, alpha, beta_k, apack, bpack,
+						C + ic, jc + jcol);
+			}
+		}
+	}
+
+	free(apack);
+	free(bpack);
+	return 0;
+}
+
+// C[0..mc][jc..jc+nc] from a packed block of A and panel of B
+static void gemm_macro(unsigned int mc, unsigned int nc, unsigned int kc,
+		float alpha, float beta, const float *apack, const float *bpack,
+		float **C, unsigned int jc)
+{
+	unsigned int ir,jr,mr,nr;
+	unsigned int tile_mr=mathlib_kernels->mr;
+	unsigned int tile_nr=mathlib_kernels->nr;
+
+	for (jr = 0; jr < nc; jr += tile_nr)
+	{
+		nr = (nc - jr < tile_nr) ? nc - jr : tile_nr;
+		for (ir = 0; ir < mc; ir += tile_mr)
+		{
+			mr = (mc - ir < tile_mr) ? mc - ir : tile_mr;
+			mathlib_kernels->gemm_micro(kc, apack + ir*kc, bpack + jr*kc,
+					alpha, beta, C + ir, jc + jr, mr, nr);
+		}
+	}
+}
+
+// columns t*GEMM_TILE_MIN_COLS.. of the current panel, a whole number
+// of slivers so each task writes its own part of bpack, the tasks after
+// b_tasks pack the rows of A the same way, MC at a time
+static void gemm_pack_task(void *arg, unsigned int t)
+{
+	struct gemm_job *job = arg;
+	unsigned int i,j,mc,nc;
+
+	if (t >= job->b_tasks)
+	{
+		i = (t - job->b_tasks)*GEMM_MC;
+		mc = (job->n - i < GEMM_MC) ? job->n - i : GEMM_MC;
+		if (job->transa == MATRIX_NOTRANS)
+		{
+			pack_a(job->transa, mc, job->kc, mathlib_kernels->mr, job->A + i, 0,
+					job->ja + job->pc, job->apack + i*job->kc);
+		}
+		else
+		{
+			pack_a(job->transa, mc, job->kc, mathlib_kernels->mr, job->A + job->pc,
+					job->ja + i, 0, job->apack + i*job->kc);
+		}
+		return;
+	}
+
+	j = t*GEMM_TILE_MIN_COLS;
+	nc = (job->nc - j < GEMM_TILE_MIN_COLS) ? job->nc - j : GEMM_TILE_MIN_COLS;
+	if (job->transb == MATRIX_NOTRANS)
+	{
+		pack_b(job->transb, job->kc, nc, mathlib_kernels->nr, job->B, job->pc,
+				job->jb + job->jcol + j, job->bpack + j*job->kc);
+	}
+	else
+	{
+		pack_b(job->transb, job->kc, nc, mathlib_kernels->nr, job->B + job->jcol + j,
+				job->jb + job->pc, 0, job->bpack + j*job->kc);
+	}
+}
+
+// tile t of the current panel, tiles are numbered across the rows of C
+// the packed A and B are only read
+static void gemm_tile(void *arg, unsigned int t)
+{
+	struct gemm_job *job = arg;
+	unsigned int i,j,mc,nc;
+
+	i = (t/job->col_tiles)*GEMM_MC;
+	j = (t%job->col_tiles)*job->tile_cols;
+	mc = (job->n - i < GEMM_MC) ? job->n - i : GEMM_MC;
+	nc = (job->nc - j < job->tile_cols) ? job->nc - j : job->tile_cols;
+
+	gemm_macro(mc, nc, job->kc, job->alpha, job->beta_k, job->apack + i*job->kc,
+			job->bpack + j*job->kc, job->C + i, job->jc + job->jcol + j);
+}
+
+// C = alpha*op(A)*op(B) + beta*C
+// large products are cut into independent tiles of C, each a multiple
+// of the cache blocks, and spread over the thread pool one packed
+// panel of B at a time, the packing buffers are allocated up front so
+// the tasks themselves can't fail
+int gemm_blocked(int transa, int transb,
+		unsigned int n, unsigned int m, unsigned int k,
+		float alpha, float **A, unsigned int ja,
+		float **B, unsigned int jb,
+		float beta, float **C, unsigned int jc)
+{
+	struct gemm_job job;
+	unsigned int threads,row_tiles,col_tiles,cols,a_rows,b_cols,kc;
+
+	if (n == 0 || m == 0)
+	{
+		return 0;
+	}
+	if (k == 0 || alpha == 0.)
+	{
+		scale_block(n, m, beta, C, jc);
+		return 0;
+	}
+
+	// not worth waking the pool for
+	if ((double)n*m*k < GEMM_PARALLEL_MIN || (threads = mathlib_get_threads()) < 2)
+	{
+		return gemm_serial(transa, transb, n, m, k, alpha, A, ja, B, jb,
+				beta, C, jc);
+	}
+
+	// MC is a multiple of MR so only the last block of A is padded
+	a_rows = ((n + mathlib_kernels->mr - 1)/mathlib_kernels->mr)*mathlib_kernels->mr;
+	b_cols = (m < GEMM_NC) ? m : GEMM_NC;
+	b_cols = ((b_cols + mathlib_kernels->nr - 1)/mathlib_kernels->nr)*mathlib_kernels->nr;
+	kc = (k < GEMM_KC) ? k : GEMM_KC;
+	if (posix_memalign((void **)&job.apack, 64, sizeof(*job.apack)*a_rows*kc) != 0)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	if (posix_memalign((void **)&job.bpack, 64, sizeof(*job.bpack)*b_cols*kc) != 0)
+	{
+		perror("Error allocating memory");
+		free(job.apack);
+		return 1;
+	}
+
+	job.transa = transa;
+	job.transb = transb;
+	job.n = n;
+	job.m = m;
+	job.k = k;
+	job.alpha = alpha;
+	job.A = A;
+	job.B = B;
+	job.C = C;
+	job.ja = ja;
+	job.jb = jb;
+	job.jc = jc;
+	row_tiles = (n + GEMM_MC - 1)/GEMM_MC;
+
+	// the loops of gemm_serial with the packing of each panel of B
+	// and slice of A, and the tiles of C, spread over the pool
+	for (job.jcol = 0; job.jcol < m; job.jcol += GEMM_NC)
+	{
+		job.nc = (m - job.jcol < GEMM_NC) ? m - job.jcol : GEMM_NC;
+
+		// rows of C are cut at MC, columns are cut so there are about
+		// twice as many tiles as threads to even out the load
+		col_tiles = (2*threads + row_tiles - 1)/row_tiles;
+		cols = (job.nc + col_tiles - 1)/col_tiles;
+		cols = ((cols + mathlib_kernels->nr - 1)/mathlib_kernels->nr)*mathlib_kernels->nr;
+		if (cols < GEMM_TILE_MIN_COLS)
+		{
+			cols = GEMM_TILE_MIN_COLS;
+		}
+		job.tile_cols = cols;
+		job.col_tiles = (job.nc + cols - 1)/cols;
+		job.b_tasks = (job.nc + GEMM_TILE_MIN_COLS - 1)/GEMM_TILE_MIN_COLS;
+
+		for (job.pc = 0; job.pc < k; job.pc += GEMM_KC)
+		{
+			job.kc = (k - job.pc < GEMM_KC) ? k - job.pc : GEMM_KC;
+			job.beta_k = (job.pc == 0) ? beta : 1.;
+			parallel_for(job.b_tasks + row_tiles, &gemm_pack_task, &job);
+			parallel_for(row_tiles*job.col_tiles, &gemm_tile, &job);
+		}
+	}
+
+	free(job.apack);
+	free(job.bpack);
+	return 0;
+}
@@ -0,0 +1,41 @@
+/* Cache blocked matrix multiplication
+ * Oct 18 2026 */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// cache blocking, a KC x NR sliver of B stays in L1,
+// an MC x KC block of A stays in L2 and a KC x NC panel of B in L3
+// the MR x NR register tile comes from the micro-kernel in use,
+// MC and NC are multiples of every MR and NR
+#define GEMM_MC 144
+#define GEMM_KC 256
+#define GEMM_NC 4096
+
+// products with fewer multiply-adds than this stay on one thread
+#define GEMM_PARALLEL_MIN (128.*128.*128.)
+// narrowest tile of C handed to a thread, and the columns of B
+// packed by one task, a multiple of every NR
+#define GEMM_TILE_MIN_COLS 128
+
+// C = alpha*op(A)*op(B) + beta*C working directly on row pointers
+// C is n x m, op(A) is n x k and op(B) is k x m
+// ja, jb and jc are the first column used in each row of A, B and C
+// so a block of a larger matrix can be passed as (A+i, j)
+// large products are computed on the thread pool
+// returns 0 on success, 1 if out of memory, when C is left undefined
+extern int gemm_blocked(int transa, int transb,
+		unsigned int n, unsigned int m, unsigned int k,
+		float alpha, float **A, unsigned int ja,
+		float **B, unsigned int jb,
+		float beta, float **C, unsigned int jc);
+
+#endif
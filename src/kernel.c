@@ -0,0 +1,170 @@
+/* Runtime dispatched vector kernels
+ * Oct 18 2026 */
+
+#include "kernel.h"
+
+const struct kernel_ops *mathlib_kernels = &kernel_scalar;
+
+// pick kernels from CPUID and MATHLIB_ISA
+void kernel_init(void);
+// name of the kernels in use
+const char * mathlib_isa(void);
+// write back an accumulated tile
+void kernel_tile_store(const float *ab, unsigned int ldab,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+void kernel_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol);
+void kernel_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp);
+
+// run kernel_init() when the library is loaded
+static void kernel_constructor(void) __attribute__((constructor));
+
+static void kernel_constructor(void)
+{
+	kernel_init();
+}
+
+// choose the widest instruction set this cpu supports
+void kernel_init(void)
+{
+	const struct kernel_ops *best = &kernel_scalar;
+	const struct kernel_ops *isa[4];
+	const char *force;
+	unsigned int i;
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (kernel_sse2 != NULL && __builtin_cpu_supports("sse2"))
+	{
+		best = kernel_sse2;
+	}
+	if (kernel_avx2 != NULL && __builtin_cpu_supports("avx2")
+			&& __builtin_cpu_supports("fma"))
+	{
+		best = kernel_avx2;
+	}
+	if (kernel_avx512 != NULL && __builtin_cpu_supports("avx512f"))
+	{
+		best = kernel_avx512;
+	}
+#endif
+	mathlib_kernels = best;
+
+	// for benchmarking a narrower set can be forced, never a wider one
+	if ((force = getenv("MATHLIB_ISA")) == NULL || force[0] == '\0')
+	{
+		return;
+	}
+
+	isa[0] = &kernel_scalar;
+	isa[1] = kernel_sse2;
+	isa[2] = kernel_avx2;
+	isa[3] = kernel_avx512;
+	for (i = 0; i < 4 && isa[i] != NULL; i++)
+	{
+		if (strcmp(force, isa[i]->name) == 0)
+		{
+			mathlib_kernels = isa[i];
+			return;
+		}
+		if (isa[i] == best)
+		{
+			break;
+		}
+	}
+	fprintf(stderr, "MATHLIB_ISA=%s is not available, using %s\n",
+			force, best->name);
+}
+
+// name of the kernels in use
+const char * mathlib_isa(void)
+{
+	return mathlib_kernels->name;
+}
+
+// C[0..mr][j..j+nr] = alpha*ab + beta*C
+// beta == 0 must not read C
+void kernel_tile_store(const float *ab, unsigned int ldab,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr)
+{
+	unsigned int r,s;
+	float *c;
+
+	for (r = 0; r < mr; r++)
+	{
+		c = C[r] + j;
+		if (beta == 0.)
+		{
+			for (s = 0; s < nr; s++)
+			{
+				c[s] = alpha*ab[r*ldab + s];
+			}
+		}
+		else
+		{
+			for (s = 0; s < nr; s++)
+			{
+				c[s] = beta*c[s] + alpha*ab[r*ldab + s];
+			}
+		}
+	}
+}
+
+// safeguarded Newton steps one problem at a time, the comparisons
+// are false for NaN so a NaN step falls back to bisection
+void kernel_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol)
+{
+	float f,xk,l,u,lower,upper,next;
+	int small,close;
+	unsigned int k;
+
+	for (k = 0; k < n; k++)
+	{
+		f = fx[k];
+		xk = x[k];
+		l = (f < 0.f) ? xk : lo[k];
+		u = (f > 0.f) ? xk : hi[k];
+		lower = (l < u) ? l : u;
+		upper = (l < u) ? u : l;
+
+		next = xk - f/dfx[k];
+		if (!(next > lower && next < upper))
+		{
+			next = 0.5f*(l + u);
+		}
+
+		small = fabsf(f) <= ftol;
+		close = fabsf(next - xk) <= xtol + 4*FLT_EPSILON*fabsf(next);
+		lo[k] = l;
+		hi[k] = u;
+		x[k] = small ? xk : next;
+		dfx[k] = (small || close) ? 1.f : 0.f;
+	}
+}
+
+// p and p' together, p' picks up each partial sum of p before it is
+// multiplied by x again
+void kernel_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp)
+{
+	unsigned int j,k;
+	float xk,pk,dk;
+
+	for (k = 0; k < n; k++)
+	{
+		xk = x[k];
+		pk = c[degree];
+		dk = 0.f;
+		for (j = degree; j-- > 0; )
+		{
+			dk = dk*xk + pk;
+			pk = pk*xk + c[j];
+		}
+		p[k] = pk;
+		dp[k] = dk;
+	}
+}
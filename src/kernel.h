@@ -0,0 +1,84 @@
+/* Runtime dispatched vector kernels
+ * Oct 18 2026 */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+// largest register tile of any micro-kernel, used to size scratch tiles
+#define KERNEL_MAX_MR 12
+#define KERNEL_MAX_NR 32
+
+// one set of inner loops for a particular instruction set
+// every routine that does O(n) work on contiguous floats goes through here
+struct kernel_ops
+{
+	const char *name; // value accepted by MATHLIB_ISA
+	// register tile of the gemm micro-kernel
+	unsigned int mr;
+	unsigned int nr;
+	// x.y, also the inner loop of the triangular solves
+	float (*dot)(unsigned int n, const float *x, const float *y);
+	// y = a*x + y
+	void (*axpy)(unsigned int n, float a, const float *x, float *y);
+	// x = a*x
+	void (*scal)(unsigned int n, float a, float *x);
+	// x <-> y, used for row swaps
+	void (*swap)(unsigned int n, float *x, float *y);
+	// C[0..mr][j..j+nr] = alpha*a*b + beta*C for packed panels a and b
+	// a holds kc columns of mr rows, b holds kc rows of nr columns
+	void (*gemm_micro)(unsigned int kc, const float *a, const float *b,
+			float alpha, float beta, float **C, unsigned int j,
+			unsigned int mr, unsigned int nr);
+	// safeguarded Newton steps for n independent scalar problems,
+	// see kernel_newton_step()
+	void (*newton_step)(unsigned int n, float *lo, float *hi, float *x,
+			const float *fx, float *dfx, float xtol, float ftol);
+	// sum of a[k]*x[index[k]], a row of a sparse matrix times x
+	float (*gather_dot)(unsigned int n, const float *a,
+			const unsigned int *index, const float *x);
+	// p(x[k]) and p'(x[k]) for n points, see kernel_horner()
+	void (*horner)(unsigned int n, unsigned int degree, const float *c,
+			const float *x, float *p, float *dp);
+};
+
+// the kernels in use, chosen once when the library is loaded
+extern const struct kernel_ops *mathlib_kernels;
+
+// the implementations, those that the compiler can't
+// build for this architecture are NULL
+extern const struct kernel_ops kernel_scalar;
+extern const struct kernel_ops *kernel_sse2;
+extern const struct kernel_ops *kernel_avx2;
+extern const struct kernel_ops *kernel_avx512;
+
+// pick kernels from CPUID, the MATHLIB_ISA environment variable
+// may force a specific set (scalar, sse2, avx2 or avx512)
+extern void kernel_init(void);
+// name of the kernels in use
+extern const char * mathlib_isa(void);
+
+// write back the valid mr x nr corner of an accumulated tile ab
+// with leading dimension ldab, shared by the micro-kernels for edge tiles
+extern void kernel_tile_store(const float *ab, unsigned int ldab,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+// shrink each bracket [lo,hi] with fx = f(x), then step x to the Newton
+// iterate x - fx/dfx or, where that leaves the bracket, to its midpoint
+// on return dfx is 1 where |fx| <= ftol or the step was below
+// xtol + 4*FLT_EPSILON*|x|, 0 elsewhere, the scalar version of
+// the newton_step kernels, which use it for the lanes left over
+extern void kernel_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol);
+// the polynomial c[0] + c[1]*x + ... + c[degree]*x^degree and its
+// derivative by Horner's rule at each of n points, the scalar version
+// of the horner kernels, which use it for the points left over
+extern void kernel_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp);
+
+#endif
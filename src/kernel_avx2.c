@@ -0,0 +1,335 @@
+/* AVX2 kernels
+ * Oct 18 2026 */
+
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define AVX2_MR 6
+#define AVX2_NR 16
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+static float avx2_dot(unsigned int n, const float *x, const float *y);
+static void avx2_axpy(unsigned int n, float a, const float *x, float *y);
+static void avx2_scal(unsigned int n, float a, float *x);
+static void avx2_swap(unsigned int n, float *x, float *y);
+static void avx2_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+static void avx2_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol);
+static float avx2_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x);
+static void avx2_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp);
+
+static const struct kernel_ops avx2_ops =
+{
+	"avx2",
+	AVX2_MR,
+	AVX2_NR,
+	&avx2_dot,
+	&avx2_axpy,
+	&avx2_scal,
+	&avx2_swap,
+	&avx2_gemm_micro,
+	&avx2_newton_step,
+	&avx2_gather_dot,
+	&avx2_horner
+};
+
+const struct kernel_ops *kernel_avx2 = &avx2_ops;
+
+// x.y with four independent partial sums
+AVX2_TARGET static float avx2_dot(unsigned int n, const float *x, const float *y)
+{
+	__m256 s0,s1,s2,s3;
+	__m128 h;
+	float sum;
+	unsigned int i=0;
+
+	s0 = s1 = s2 = s3 = _mm256_setzero_ps();
+	for (; i + 32 <= n; i += 32)
+	{
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i), _mm256_loadu_ps(y+i), s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i+8), _mm256_loadu_ps(y+i+8), s1);
+		s2 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i+16), _mm256_loadu_ps(y+i+16), s2);
+		s3 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i+24), _mm256_loadu_ps(y+i+24), s3);
+	}
+	for (; i + 8 <= n; i += 8)
+	{
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i), _mm256_loadu_ps(y+i), s0);
+	}
+	s0 = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+
+	// horizontal sum of the eight lanes
+	h = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+	h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+	sum = _mm_cvtss_f32(h);
+
+	for (; i < n; i++)
+	{
+		sum += x[i]*y[i];
+	}
+	return sum;
+}
+
+// y = a*x + y
+AVX2_TARGET static void avx2_axpy(unsigned int n, float a, const float *x, float *y)
+{
+	__m256 va = _mm256_set1_ps(a);
+	unsigned int i=0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm256_storeu_ps(y+i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x+i),
+					_mm256_loadu_ps(y+i)));
+		_mm256_storeu_ps(y+i+8, _mm256_fmadd_ps(va, _mm256_loadu_ps(x+i+8),
+					_mm256_loadu_ps(y+i+8)));
+	}
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(y+i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x+i),
+					_mm256_loadu_ps(y+i)));
+	}
+	for (; i < n; i++)
+	{
+		y[i] += a*x[i];
+	}
+}
+
+// x = a*x
+AVX2_TARGET static void avx2_scal(unsigned int n, float a, float *x)
+{
+	__m256 va = _mm256_set1_ps(a);
+	unsigned int i=0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(x+i, _mm256_mul_ps(va, _mm256_loadu_ps(x+i)));
+	}
+	for (; i < n; i++)
+	{
+		x[i] *= a;
+	}
+}
+
+// x <-> y
+AVX2_TARGET static void avx2_swap(unsigned int n, float *x, float *y)
+{
+	__m256 vx,vy;
+	unsigned int i=0;
+	float tmp;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		vx = _mm256_loadu_ps(x+i);
+		vy = _mm256_loadu_ps(y+i);
+		_mm256_storeu_ps(x+i, vy);
+		_mm256_storeu_ps(y+i, vx);
+	}
+	for (; i < n; i++)
+	{
+		tmp = x[i];
+		x[i] = y[i];
+		y[i] = tmp;
+	}
+}
+
+// one row of the tile is two registers
+#define AVX2_ROW(r) \
+	av = _mm256_broadcast_ss(a + r); \
+	c##r##0 = _mm256_fmadd_ps(av, b0, c##r##0); \
+	c##r##1 = _mm256_fmadd_ps(av, b1, c##r##1);
+
+#define AVX2_SAVE(r) \
+	_mm256_storeu_ps(ab + r*AVX2_NR, c##r##0); \
+	_mm256_storeu_ps(ab + r*AVX2_NR + 8, c##r##1);
+
+#define AVX2_STORE(r) \
+	c = C[r] + j; \
+	if (beta == 0.) \
+	{ \
+		_mm256_storeu_ps(c, _mm256_mul_ps(va, c##r##0)); \
+		_mm256_storeu_ps(c+8, _mm256_mul_ps(va, c##r##1)); \
+	} \
+	else \
+	{ \
+		_mm256_storeu_ps(c, _mm256_fmadd_ps(vb, _mm256_loadu_ps(c), \
+					_mm256_mul_ps(va, c##r##0))); \
+		_mm256_storeu_ps(c+8, _mm256_fmadd_ps(vb, _mm256_loadu_ps(c+8), \
+					_mm256_mul_ps(va, c##r##1))); \
+	}
+
+// 6x16 tile held in 12 registers
+AVX2_TARGET static void avx2_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr)
+{
+	__m256 c00,c01,c10,c11,c20,c21,c30,c31,c40,c41,c50,c51;
+	__m256 av,b0,b1,va,vb;
+	float ab[AVX2_MR*AVX2_NR];
+	float *c;
+	unsigned int p;
+
+	c00 = c01 = c10 = c11 = c20 = c21 = _mm256_setzero_ps();
+	c30 = c31 = c40 = c41 = c50 = c51 = _mm256_setzero_ps();
+
+	for (p = 0; p < kc; p++)
+	{
+		b0 = _mm256_loadu_ps(b);
+		b1 = _mm256_loadu_ps(b+8);
+		AVX2_ROW(0)
+		AVX2_ROW(1)
+		AVX2_ROW(2)
+		AVX2_ROW(3)
+		AVX2_ROW(4)
+		AVX2_ROW(5)
+		a += AVX2_MR;
+		b += AVX2_NR;
+	}
+
+	// full tiles go straight to C
+	if (mr == AVX2_MR && nr == AVX2_NR)
+	{
+		va = _mm256_set1_ps(alpha);
+		vb = _mm256_set1_ps(beta);
+		AVX2_STORE(0)
+		AVX2_STORE(1)
+		AVX2_STORE(2)
+		AVX2_STORE(3)
+		AVX2_STORE(4)
+		AVX2_STORE(5)
+		return;
+	}
+
+	AVX2_SAVE(0)
+	AVX2_SAVE(1)
+	AVX2_SAVE(2)
+	AVX2_SAVE(3)
+	AVX2_SAVE(4)
+	AVX2_SAVE(5)
+	kernel_tile_store(ab, AVX2_NR, alpha, beta, C, j, mr, nr);
+}
+
+// eight problems at a time, the comparisons are ordered
+// so NaN steps fall back to bisection as in the scalar version
+AVX2_TARGET static void avx2_newton_step(unsigned int n, float *lo, float *hi,
+		float *x, const float *fx, float *dfx, float xtol, float ftol)
+{
+	__m256 zero,half,one,sign,eps,vxtol,vftol;
+	__m256 f,xk,l,u,lower,upper,next,small,close,mask;
+	unsigned int i=0;
+
+	zero = _mm256_setzero_ps();
+	half = _mm256_set1_ps(0.5f);
+	one = _mm256_set1_ps(1.f);
+	sign = _mm256_set1_ps(-0.f);
+	eps = _mm256_set1_ps(4*FLT_EPSILON);
+	vxtol = _mm256_set1_ps(xtol);
+	vftol = _mm256_set1_ps(ftol);
+	for (; i + 8 <= n; i += 8)
+	{
+		f = _mm256_loadu_ps(fx+i);
+		xk = _mm256_loadu_ps(x+i);
+		l = _mm256_blendv_ps(_mm256_loadu_ps(lo+i), xk,
+				_mm256_cmp_ps(f, zero, _CMP_LT_OQ));
+		u = _mm256_blendv_ps(_mm256_loadu_ps(hi+i), xk,
+				_mm256_cmp_ps(f, zero, _CMP_GT_OQ));
+		mask = _mm256_cmp_ps(l, u, _CMP_LT_OQ);
+		lower = _mm256_blendv_ps(u, l, mask);
+		upper = _mm256_blendv_ps(l, u, mask);
+
+		next = _mm256_sub_ps(xk, _mm256_div_ps(f, _mm256_loadu_ps(dfx+i)));
+		mask = _mm256_and_ps(_mm256_cmp_ps(next, lower, _CMP_GT_OQ),
+				_mm256_cmp_ps(next, upper, _CMP_LT_OQ));
+		next = _mm256_blendv_ps(_mm256_mul_ps(half, _mm256_add_ps(l, u)),
+				next, mask);
+
+		small = _mm256_cmp_ps(_mm256_andnot_ps(sign, f), vftol, _CMP_LE_OQ);
+		close = _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(next, xk)),
+				_mm256_add_ps(vxtol, _mm256_mul_ps(eps,
+						_mm256_andnot_ps(sign, next))), _CMP_LE_OQ);
+		_mm256_storeu_ps(lo+i, l);
+		_mm256_storeu_ps(hi+i, u);
+		_mm256_storeu_ps(x+i, _mm256_blendv_ps(next, xk, small));
+		_mm256_storeu_ps(dfx+i, _mm256_and_ps(_mm256_or_ps(small, close), one));
+	}
+	kernel_newton_step(n-i, lo+i, hi+i, x+i, fx+i, dfx+i, xtol, ftol);
+}
+
+// sum of a[k]*x[index[k]] with two independent partial sums
+AVX2_TARGET static float avx2_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x)
+{
+	__m256 s0,s1;
+	__m128 h;
+	float sum;
+	unsigned int k=0;
+
+	s0 = s1 = _mm256_setzero_ps();
+	for (; k + 16 <= n; k += 16)
+	{
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+k), _mm256_i32gather_ps(x,
+					_mm256_loadu_si256((const __m256i *)(index+k)), 4), s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a+k+8), _mm256_i32gather_ps(x,
+					_mm256_loadu_si256((const __m256i *)(index+k+8)), 4), s1);
+	}
+	for (; k + 8 <= n; k += 8)
+	{
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+k), _mm256_i32gather_ps(x,
+					_mm256_loadu_si256((const __m256i *)(index+k)), 4), s0);
+	}
+	s0 = _mm256_add_ps(s0, s1);
+
+	// horizontal sum of the eight lanes
+	h = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+	h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+	sum = _mm_cvtss_f32(h);
+
+	for (; k < n; k++)
+	{
+		sum += a[k]*x[index[k]];
+	}
+	return sum;
+}
+
+// eight points at a time, two vectors in flight to hide the latency
+// of the dependent fused multiply-adds
+AVX2_TARGET static void avx2_horner(unsigned int n, unsigned int degree,
+		const float *c, const float *x, float *p, float *dp)
+{
+	__m256 x0,x1,p0,p1,d0,d1,cj;
+	unsigned int i=0,j;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		x0 = _mm256_loadu_ps(x+i);
+		x1 = _mm256_loadu_ps(x+i+8);
+		p0 = p1 = _mm256_set1_ps(c[degree]);
+		d0 = d1 = _mm256_setzero_ps();
+		for (j = degree; j-- > 0; )
+		{
+			cj = _mm256_set1_ps(c[j]);
+			d0 = _mm256_fmadd_ps(d0, x0, p0);
+			d1 = _mm256_fmadd_ps(d1, x1, p1);
+			p0 = _mm256_fmadd_ps(p0, x0, cj);
+			p1 = _mm256_fmadd_ps(p1, x1, cj);
+		}
+		_mm256_storeu_ps(p+i, p0);
+		_mm256_storeu_ps(p+i+8, p1);
+		_mm256_storeu_ps(dp+i, d0);
+		_mm256_storeu_ps(dp+i+8, d1);
+	}
+	kernel_horner(n-i, degree, c, x+i, p+i, dp+i);
+}
+
+#else
+
+const struct kernel_ops *kernel_avx2 = NULL;
+
+#endif
@@ -0,0 +1,342 @@
+/* AVX-512 kernels
+ * Oct 18 2026 */
+
+#include "kernel.h"
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define AVX512_MR 12
+#define AVX512_NR 32
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+static float avx512_dot(unsigned int n, const float *x, const float *y);
+static void avx512_axpy(unsigned int n, float a, const float *x, float *y);
+static void avx512_scal(unsigned int n, float a, float *x);
+static void avx512_swap(unsigned int n, float *x, float *y);
+static void avx512_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+static void avx512_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol);
+static float avx512_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x);
+static void avx512_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp);
+
+static const struct kernel_ops avx512_ops =
+{
+	"avx512",
+	AVX512_MR,
+	AVX512_NR,
+	&avx512_dot,
+	&avx512_axpy,
+	&avx512_scal,
+	&avx512_swap,
+	&avx512_gemm_micro,
+	&avx512_newton_step,
+	&avx512_gather_dot,
+	&avx512_horner
+};
+
+const struct kernel_ops *kernel_avx512 = &avx512_ops;
+
+// mask covering the first n < 16 lanes
+#define AVX512_TAIL(n) ((__mmask16)((1u << (n)) - 1))
+
+// x.y with four independent partial sums, the tail is masked
+AVX512_TARGET static float avx512_dot(unsigned int n, const float *x, const float *y)
+{
+	__m512 s0,s1,s2,s3;
+	__mmask16 k;
+	unsigned int i=0;
+
+	s0 = s1 = s2 = s3 = _mm512_setzero_ps();
+	for (; i + 64 <= n; i += 64)
+	{
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x+i), _mm512_loadu_ps(y+i), s0);
+		s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x+i+16), _mm512_loadu_ps(y+i+16), s1);
+		s2 = _mm512_fmadd_ps(_mm512_loadu_ps(x+i+32), _mm512_loadu_ps(y+i+32), s2);
+		s3 = _mm512_fmadd_ps(_mm512_loadu_ps(x+i+48), _mm512_loadu_ps(y+i+48), s3);
+	}
+	for (; i + 16 <= n; i += 16)
+	{
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x+i), _mm512_loadu_ps(y+i), s0);
+	}
+	if (i < n)
+	{
+		k = AVX512_TAIL(n - i);
+		s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(k, x+i),
+				_mm512_maskz_loadu_ps(k, y+i), s1);
+	}
+	s0 = _mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3));
+	return _mm512_reduce_add_ps(s0);
+}
+
+// y = a*x + y
+AVX512_TARGET static void avx512_axpy(unsigned int n, float a, const float *x, float *y)
+{
+	__m512 va = _mm512_set1_ps(a);
+	__mmask16 k;
+	unsigned int i=0;
+
+	for (; i + 32 <= n; i += 32)
+	{
+		_mm512_storeu_ps(y+i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x+i),
+					_mm512_loadu_ps(y+i)));
+		_mm512_storeu_ps(y+i+16, _mm512_fmadd_ps(va, _mm512_loadu_ps(x+i+16),
+					_mm512_loadu_ps(y+i+16)));
+	}
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_ps(y+i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x+i),
+					_mm512_loadu_ps(y+i)));
+	}
+	if (i < n)
+	{
+		k = AVX512_TAIL(n - i);
+		_mm512_mask_storeu_ps(y+i, k, _mm512_fmadd_ps(va,
+					_mm512_maskz_loadu_ps(k, x+i),
+					_mm512_maskz_loadu_ps(k, y+i)));
+	}
+}
+
+// x = a*x
+AVX512_TARGET static void avx512_scal(unsigned int n, float a, float *x)
+{
+	__m512 va = _mm512_set1_ps(a);
+	__mmask16 k;
+	unsigned int i=0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_ps(x+i, _mm512_mul_ps(va, _mm512_loadu_ps(x+i)));
+	}
+	if (i < n)
+	{
+		k = AVX512_TAIL(n - i);
+		_mm512_mask_storeu_ps(x+i, k, _mm512_mul_ps(va,
+					_mm512_maskz_loadu_ps(k, x+i)));
+	}
+}
+
+// x <-> y
+AVX512_TARGET static void avx512_swap(unsigned int n, float *x, float *y)
+{
+	__m512 vx,vy;
+	__mmask16 k;
+	unsigned int i=0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		vx = _mm512_loadu_ps(x+i);
+		vy = _mm512_loadu_ps(y+i);
+		_mm512_storeu_ps(x+i, vy);
+		_mm512_storeu_ps(y+i, vx);
+	}
+	if (i < n)
+	{
+		k = AVX512_TAIL(n - i);
+		vx = _mm512_maskz_loadu_ps(k, x+i);
+		vy = _mm512_maskz_loadu_ps(k, y+i);
+		_mm512_mask_storeu_ps(x+i, k, vy);
+		_mm512_mask_storeu_ps(y+i, k, vx);
+	}
+}
+
+// 12x32 tile held in 24 of the 32 registers
+// the tile is kept in an array indexed by constants only,
+// so the compiler assigns every element its own register
+AVX512_TARGET static void avx512_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr)
+{
+	__m512 c0[AVX512_MR],c1[AVX512_MR];
+	__m512 av,b0,b1,va,vb;
+	float ab[AVX512_MR*AVX512_NR];
+	float *c;
+	unsigned int p,r;
+
+	for (r = 0; r < AVX512_MR; r++)
+	{
+		c0[r] = _mm512_setzero_ps();
+		c1[r] = _mm512_setzero_ps();
+	}
+
+	for (p = 0; p < kc; p++)
+	{
+		b0 = _mm512_loadu_ps(b);
+		b1 = _mm512_loadu_ps(b+16);
+#pragma GCC unroll 12
+		for (r = 0; r < AVX512_MR; r++)
+		{
+			av = _mm512_set1_ps(a[r]);
+			c0[r] = _mm512_fmadd_ps(av, b0, c0[r]);
+			c1[r] = _mm512_fmadd_ps(av, b1, c1[r]);
+		}
+		a += AVX512_MR;
+		b += AVX512_NR;
+	}
+
+	// full tiles go straight to C
+	if (mr == AVX512_MR && nr == AVX512_NR)
+	{
+		va = _mm512_set1_ps(alpha);
+		vb = _mm512_set1_ps(beta);
+#pragma GCC unroll 12
+		for (r = 0; r < AVX512_MR; r++)
+		{
+			c = C[r] + j;
+			if (beta == 0.)
+			{
+				_mm512_storeu_ps(c, _mm512_mul_ps(va, c0[r]));
+				_mm512_storeu_ps(c+16, _mm512_mul_ps(va, c1[r]));
+			}
+			else
+			{
+				_mm512_storeu_ps(c, _mm512_fmadd_ps(vb, _mm512_loadu_ps(c),
+							_mm512_mul_ps(va, c0[r])));
+				_mm512_storeu_ps(c+16, _mm512_fmadd_ps(vb, _mm512_loadu_ps(c+16),
+							_mm512_mul_ps(va, c1[r])));
+			}
+		}
+		return;
+	}
+
+#pragma GCC unroll 12
+	for (r = 0; r < AVX512_MR; r++)
+	{
+		_mm512_storeu_ps(ab + r*AVX512_NR, c0[r]);
+		_mm512_storeu_ps(ab + r*AVX512_NR + 16, c1[r]);
+	}
+	kernel_tile_store(ab, AVX512_NR, alpha, beta, C, j, mr, nr);
+}
+
+// sixteen problems at a time, the tail is masked, the comparisons
+// are ordered so NaN steps fall back to bisection as in the scalar version
+AVX512_TARGET static void avx512_newton_step(unsigned int n, float *lo,
+		float *hi, float *x, const float *fx, float *dfx, float xtol, float ftol)
+{
+	__m512 zero,half,one,eps,vxtol,vftol;
+	__m512 f,xk,l,u,lower,upper,next;
+	__mmask16 k,lt,inside,small,close;
+	unsigned int i;
+
+	zero = _mm512_setzero_ps();
+	half = _mm512_set1_ps(0.5f);
+	one = _mm512_set1_ps(1.f);
+	eps = _mm512_set1_ps(4*FLT_EPSILON);
+	vxtol = _mm512_set1_ps(xtol);
+	vftol = _mm512_set1_ps(ftol);
+	for (i = 0; i < n; i += 16)
+	{
+		k = (n - i >= 16) ? (__mmask16)0xffff : AVX512_TAIL(n - i);
+		// the masked off lanes of the tail divide 0 by 1
+		f = _mm512_maskz_loadu_ps(k, fx+i);
+		xk = _mm512_maskz_loadu_ps(k, x+i);
+		l = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(f, zero, _CMP_LT_OQ),
+				_mm512_maskz_loadu_ps(k, lo+i), xk);
+		u = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(f, zero, _CMP_GT_OQ),
+				_mm512_maskz_loadu_ps(k, hi+i), xk);
+		lt = _mm512_cmp_ps_mask(l, u, _CMP_LT_OQ);
+		lower = _mm512_mask_blend_ps(lt, u, l);
+		upper = _mm512_mask_blend_ps(lt, l, u);
+
+		next = _mm512_sub_ps(xk, _mm512_div_ps(f,
+					_mm512_mask_loadu_ps(one, k, dfx+i)));
+		inside = _mm512_cmp_ps_mask(next, lower, _CMP_GT_OQ)
+			& _mm512_cmp_ps_mask(next, upper, _CMP_LT_OQ);
+		next = _mm512_mask_blend_ps(inside,
+				_mm512_mul_ps(half, _mm512_add_ps(l, u)), next);
+
+		small = _mm512_cmp_ps_mask(_mm512_abs_ps(f), vftol, _CMP_LE_OQ);
+		close = _mm512_cmp_ps_mask(_mm512_abs_ps(_mm512_sub_ps(next, xk)),
+				_mm512_add_ps(vxtol, _mm512_mul_ps(eps, _mm512_abs_ps(next))),
+				_CMP_LE_OQ);
+		_mm512_mask_storeu_ps(lo+i, k, l);
+		_mm512_mask_storeu_ps(hi+i, k, u);
+		_mm512_mask_storeu_ps(x+i, k, _mm512_mask_blend_ps(small, next, xk));
+		_mm512_mask_storeu_ps(dfx+i, k, _mm512_maskz_mov_ps(small | close, one));
+	}
+}
+
+// sum of a[k]*x[index[k]], the tail is a masked gather
+AVX512_TARGET static float avx512_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x)
+{
+	__m512 s0,s1;
+	__mmask16 m;
+	unsigned int k=0;
+
+	s0 = s1 = _mm512_setzero_ps();
+	for (; k + 32 <= n; k += 32)
+	{
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a+k), _mm512_i32gather_ps(
+					_mm512_loadu_si512(index+k), x, 4), s0);
+		s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a+k+16), _mm512_i32gather_ps(
+					_mm512_loadu_si512(index+k+16), x, 4), s1);
+	}
+	for (; k + 16 <= n; k += 16)
+	{
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a+k), _mm512_i32gather_ps(
+					_mm512_loadu_si512(index+k), x, 4), s0);
+	}
+	if (k < n)
+	{
+		m = AVX512_TAIL(n - k);
+		s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a+k),
+				_mm512_mask_i32gather_ps(_mm512_setzero_ps(), m,
+					_mm512_maskz_loadu_epi32(m, index+k), x, 4), s1);
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+}
+
+// sixteen points at a time with two vectors in flight, the tail is masked
+AVX512_TARGET static void avx512_horner(unsigned int n, unsigned int degree,
+		const float *c, const float *x, float *p, float *dp)
+{
+	__m512 x0,x1,p0,p1,d0,d1,cj;
+	__mmask16 m;
+	unsigned int i=0,j;
+
+	for (; i + 32 <= n; i += 32)
+	{
+		x0 = _mm512_loadu_ps(x+i);
+		x1 = _mm512_loadu_ps(x+i+16);
+		p0 = p1 = _mm512_set1_ps(c[degree]);
+		d0 = d1 = _mm512_setzero_ps();
+		for (j = degree; j-- > 0; )
+		{
+			cj = _mm512_set1_ps(c[j]);
+			d0 = _mm512_fmadd_ps(d0, x0, p0);
+			d1 = _mm512_fmadd_ps(d1, x1, p1);
+			p0 = _mm512_fmadd_ps(p0, x0, cj);
+			p1 = _mm512_fmadd_ps(p1, x1, cj);
+		}
+		_mm512_storeu_ps(p+i, p0);
+		_mm512_storeu_ps(p+i+16, p1);
+		_mm512_storeu_ps(dp+i, d0);
+		_mm512_storeu_ps(dp+i+16, d1);
+	}
+	for (; i < n; i += 16)
+	{
+		m = (n - i >= 16) ? (__mmask16)0xffff : AVX512_TAIL(n - i);
+		x0 = _mm512_maskz_loadu_ps(m, x+i);
+		p0 = _mm512_set1_ps(c[degree]);
+		d0 = _mm512_setzero_ps();
+		for (j = degree; j-- > 0; )
+		{
+			d0 = _mm512_fmadd_ps(d0, x0, p0);
+			p0 = _mm512_fmadd_ps(p0, x0, _mm512_set1_ps(c[j]));
+		}
+		_mm512_mask_storeu_ps(p+i, m, p0);
+		_mm512_mask_storeu_ps(dp+i, m, d0);
+	}
+}
+
+#else
+
+const struct kernel_ops *kernel_avx512 = NULL;
+
+#endif
@@ -0,0 +1,122 @@
+/* Portable kernels
+ * Oct 18 2026 */
+
+#include "kernel.h"
+
+#define SCALAR_MR 6
+#define SCALAR_NR 16
+
+static float scalar_dot(unsigned int n, const float *x, const float *y);
+static void scalar_axpy(unsigned int n, float a, const float *x, float *y);
+static void scalar_scal(unsigned int n, float a, float *x);
+static void scalar_swap(unsigned int n, float *x, float *y);
+static void scalar_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+static float scalar_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x);
+
+const struct kernel_ops kernel_scalar =
+{
+	"scalar",
+	SCALAR_MR,
+	SCALAR_NR,
+	&scalar_dot,
+	&scalar_axpy,
+	&scalar_scal,
+	&scalar_swap,
+	&scalar_gemm_micro,
+	&kernel_newton_step,
+	&scalar_gather_dot,
+	&kernel_horner
+};
+
+// x.y
+static float scalar_dot(unsigned int n, const float *x, const float *y)
+{
+	unsigned int i;
+	float sum=0.;
+
+	for (i = 0; i < n; i++)
+	{
+		sum += x[i]*y[i];
+	}
+	return sum;
+}
+
+// y = a*x + y
+static void scalar_axpy(unsigned int n, float a, const float *x, float *y)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+	{
+		y[i] += a*x[i];
+	}
+}
+
+// x = a*x
+static void scalar_scal(unsigned int n, float a, float *x)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+	{
+		x[i] *= a;
+	}
+}
+
+// x <-> y
+static void scalar_swap(unsigned int n, float *x, float *y)
+{
+	unsigned int i;
+	float tmp;
+
+	for (i = 0; i < n; i++)
+	{
+		tmp = x[i];
+		x[i] = y[i];
+		y[i] = tmp;
+	}
+}
+
+// accumulate the tile in a local array the compiler can keep in registers
+static void scalar_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr)
+{
+	float ab[SCALAR_MR*SCALAR_NR];
+	unsigned int p,r,s;
+
+	memset(ab, 0, sizeof(ab));
+
+	// rank-1 update of the tile for each column of the panels
+	for (p = 0; p < kc; p++)
+	{
+		for (r = 0; r < SCALAR_MR; r++)
+		{
+			for (s = 0; s < SCALAR_NR; s++)
+			{
+				ab[r*SCALAR_NR + s] += a[r]*b[s];
+			}
+		}
+		a += SCALAR_MR;
+		b += SCALAR_NR;
+	}
+
+	kernel_tile_store(ab, SCALAR_NR, alpha, beta, C, j, mr, nr);
+}
+
+// sum of a[k]*x[index[k]]
+static float scalar_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x)
+{
+	unsigned int k;
+	float sum=0.;
+
+	for (k = 0; k < n; k++)
+	{
+		sum += a[k]*x[index[k]];
+	}
+	return sum;
+}
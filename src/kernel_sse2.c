@@ -0,0 +1,286 @@
+/* SSE2 kernels
+ * Oct 18 2026 */
+
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+
+#define SSE2_MR 6
+#define SSE2_NR 8
+#define SSE2_TARGET __attribute__((target("sse2")))
+
+static float sse2_dot(unsigned int n, const float *x, const float *y);
+static void sse2_axpy(unsigned int n, float a, const float *x, float *y);
+static void sse2_scal(unsigned int n, float a, float *x);
+static void sse2_swap(unsigned int n, float *x, float *y);
+static void sse2_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr);
+static void sse2_newton_step(unsigned int n, float *lo, float *hi, float *x,
+		const float *fx, float *dfx, float xtol, float ftol);
+static float sse2_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x);
+static void sse2_horner(unsigned int n, unsigned int degree, const float *c,
+		const float *x, float *p, float *dp);
+
+static const struct kernel_ops sse2_ops =
+{
+	"sse2",
+	SSE2_MR,
+	SSE2_NR,
+	&sse2_dot,
+	&sse2_axpy,
+	&sse2_scal,
+	&sse2_swap,
+	&sse2_gemm_micro,
+	&sse2_newton_step,
+	&sse2_gather_dot,
+	&sse2_horner
+};
+
+const struct kernel_ops *kernel_sse2 = &sse2_ops;
+
+// x.y with four independent partial sums
+SSE2_TARGET static float sse2_dot(unsigned int n, const float *x, const float *y)
+{
+	__m128 s0,s1,s2,s3;
+	float part[4];
+	float sum;
+	unsigned int i=0;
+
+	s0 = s1 = s2 = s3 = _mm_setzero_ps();
+	for (; i + 16 <= n; i += 16)
+	{
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x+i), _mm_loadu_ps(y+i)));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(x+i+4), _mm_loadu_ps(y+i+4)));
+		s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(x+i+8), _mm_loadu_ps(y+i+8)));
+		s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(x+i+12), _mm_loadu_ps(y+i+12)));
+	}
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x+i), _mm_loadu_ps(y+i)));
+	}
+	s0 = _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3));
+	_mm_storeu_ps(part, s0);
+	sum = (part[0] + part[1]) + (part[2] + part[3]);
+	for (; i < n; i++)
+	{
+		sum += x[i]*y[i];
+	}
+	return sum;
+}
+
+// y = a*x + y
+SSE2_TARGET static void sse2_axpy(unsigned int n, float a, const float *x, float *y)
+{
+	__m128 va = _mm_set1_ps(a);
+	unsigned int i=0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm_storeu_ps(y+i, _mm_add_ps(_mm_loadu_ps(y+i),
+					_mm_mul_ps(va, _mm_loadu_ps(x+i))));
+		_mm_storeu_ps(y+i+4, _mm_add_ps(_mm_loadu_ps(y+i+4),
+					_mm_mul_ps(va, _mm_loadu_ps(x+i+4))));
+	}
+	for (; i < n; i++)
+	{
+		y[i] += a*x[i];
+	}
+}
+
+// x = a*x
+SSE2_TARGET static void sse2_scal(unsigned int n, float a, float *x)
+{
+	__m128 va = _mm_set1_ps(a);
+	unsigned int i=0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(x+i, _mm_mul_ps(va, _mm_loadu_ps(x+i)));
+	}
+	for (; i < n; i++)
+	{
+		x[i] *= a;
+	}
+}
+
+// x <-> y
+SSE2_TARGET static void sse2_swap(unsigned int n, float *x, float *y)
+{
+	__m128 vx,vy;
+	unsigned int i=0;
+	float tmp;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		vx = _mm_loadu_ps(x+i);
+		vy = _mm_loadu_ps(y+i);
+		_mm_storeu_ps(x+i, vy);
+		_mm_storeu_ps(y+i, vx);
+	}
+	for (; i < n; i++)
+	{
+		tmp = x[i];
+		x[i] = y[i];
+		y[i] = tmp;
+	}
+}
+
+// one row of the tile is two registers
+#define SSE2_ROW(r) \
+	av = _mm_set1_ps(a[r]); \
+	c##r##0 = _mm_add_ps(c##r##0, _mm_mul_ps(av, b0)); \
+	c##r##1 = _mm_add_ps(c##r##1, _mm_mul_ps(av, b1));
+
+#define SSE2_SAVE(r) \
+	_mm_storeu_ps(ab + r*SSE2_NR, c##r##0); \
+	_mm_storeu_ps(ab + r*SSE2_NR + 4, c##r##1);
+
+// 6x8 tile held in 12 registers
+SSE2_TARGET static void sse2_gemm_micro(unsigned int kc, const float *a, const float *b,
+		float alpha, float beta, float **C, unsigned int j,
+		unsigned int mr, unsigned int nr)
+{
+	__m128 c00,c01,c10,c11,c20,c21,c30,c31,c40,c41,c50,c51;
+	__m128 av,b0,b1;
+	float ab[SSE2_MR*SSE2_NR];
+	unsigned int p;
+
+	c00 = c01 = c10 = c11 = c20 = c21 = _mm_setzero_ps();
+	c30 = c31 = c40 = c41 = c50 = c51 = _mm_setzero_ps();
+
+	for (p = 0; p < kc; p++)
+	{
+		b0 = _mm_loadu_ps(b);
+		b1 = _mm_loadu_ps(b+4);
+		SSE2_ROW(0)
+		SSE2_ROW(1)
+		SSE2_ROW(2)
+		SSE2_ROW(3)
+		SSE2_ROW(4)
+		SSE2_ROW(5)
+		a += SSE2_MR;
+		b += SSE2_NR;
+	}
+
+	SSE2_SAVE(0)
+	SSE2_SAVE(1)
+	SSE2_SAVE(2)
+	SSE2_SAVE(3)
+	SSE2_SAVE(4)
+	SSE2_SAVE(5)
+	kernel_tile_store(ab, SSE2_NR, alpha, beta, C, j, mr, nr);
+}
+
+// mask ? a : b
+#define SSE2_SELECT(mask, a, b) \
+	_mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+// four problems at a time, the comparisons are ordered
+// so NaN steps fall back to bisection as in the scalar version
+SSE2_TARGET static void sse2_newton_step(unsigned int n, float *lo, float *hi,
+		float *x, const float *fx, float *dfx, float xtol, float ftol)
+{
+	__m128 zero,half,one,sign,eps,vxtol,vftol;
+	__m128 f,xk,l,u,lower,upper,next,small,close,mask;
+	unsigned int i=0;
+
+	zero = _mm_setzero_ps();
+	half = _mm_set1_ps(0.5f);
+	one = _mm_set1_ps(1.f);
+	sign = _mm_set1_ps(-0.f);
+	eps = _mm_set1_ps(4*FLT_EPSILON);
+	vxtol = _mm_set1_ps(xtol);
+	vftol = _mm_set1_ps(ftol);
+	for (; i + 4 <= n; i += 4)
+	{
+		f = _mm_loadu_ps(fx+i);
+		xk = _mm_loadu_ps(x+i);
+		l = SSE2_SELECT(_mm_cmplt_ps(f, zero), xk, _mm_loadu_ps(lo+i));
+		u = SSE2_SELECT(_mm_cmpgt_ps(f, zero), xk, _mm_loadu_ps(hi+i));
+		mask = _mm_cmplt_ps(l, u);
+		lower = SSE2_SELECT(mask, l, u);
+		upper = SSE2_SELECT(mask, u, l);
+
+		next = _mm_sub_ps(xk, _mm_div_ps(f, _mm_loadu_ps(dfx+i)));
+		mask = _mm_and_ps(_mm_cmpgt_ps(next, lower), _mm_cmplt_ps(next, upper));
+		next = SSE2_SELECT(mask, next, _mm_mul_ps(half, _mm_add_ps(l, u)));
+
+		small = _mm_cmple_ps(_mm_andnot_ps(sign, f), vftol);
+		close = _mm_cmple_ps(_mm_andnot_ps(sign, _mm_sub_ps(next, xk)),
+				_mm_add_ps(vxtol, _mm_mul_ps(eps, _mm_andnot_ps(sign, next))));
+		_mm_storeu_ps(lo+i, l);
+		_mm_storeu_ps(hi+i, u);
+		_mm_storeu_ps(x+i, SSE2_SELECT(small, xk, next));
+		_mm_storeu_ps(dfx+i, _mm_and_ps(_mm_or_ps(small, close), one));
+	}
+	kernel_newton_step(n-i, lo+i, hi+i, x+i, fx+i, dfx+i, xtol, ftol);
+}
+
+// sum of a[k]*x[index[k]], SSE2 has no gather so the lanes are
+// loaded one at a time and only the arithmetic is vectorized
+SSE2_TARGET static float sse2_gather_dot(unsigned int n, const float *a,
+		const unsigned int *index, const float *x)
+{
+	__m128 s0,s1;
+	float part[4];
+	float sum;
+	unsigned int k=0;
+
+	s0 = s1 = _mm_setzero_ps();
+	for (; k + 8 <= n; k += 8)
+	{
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a+k),
+					_mm_set_ps(x[index[k+3]], x[index[k+2]],
+						x[index[k+1]], x[index[k]])));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a+k+4),
+					_mm_set_ps(x[index[k+7]], x[index[k+6]],
+						x[index[k+5]], x[index[k+4]])));
+	}
+	_mm_storeu_ps(part, _mm_add_ps(s0, s1));
+	sum = (part[0] + part[1]) + (part[2] + part[3]);
+	for (; k < n; k++)
+	{
+		sum += a[k]*x[index[k]];
+	}
+	return sum;
+}
+
+// four points at a time, two vectors in flight to hide the latency
+// of the dependent multiply-adds
+SSE2_TARGET static void sse2_horner(unsigned int n, unsigned int degree,
+		const float *c, const float *x, float *p, float *dp)
+{
+	__m128 x0,x1,p0,p1,d0,d1,cj;
+	unsigned int i=0,j;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		x0 = _mm_loadu_ps(x+i);
+		x1 = _mm_loadu_ps(x+i+4);
+		p0 = p1 = _mm_set1_ps(c[degree]);
+		d0 = d1 = _mm_setzero_ps();
+		for (j = degree; j-- > 0; )
+		{
+			cj = _mm_set1_ps(c[j]);
+			d0 = _mm_add_ps(_mm_mul_ps(d0, x0), p0);
+			d1 = _mm_add_ps(_mm_mul_ps(d1, x1), p1);
+			p0 = _mm_add_ps(_mm_mul_ps(p0, x0), cj);
+			p1 = _mm_add_ps(_mm_mul_ps(p1, x1), cj);
+		}
+		_mm_storeu_ps(p+i, p0);
+		_mm_storeu_ps(p+i+4, p1);
+		_mm_storeu_ps(dp+i, d0);
+		_mm_storeu_ps(dp+i+4, d1);
+	}
+	kernel_horner(n-i, degree, c, x+i, p+i, dp+i);
+}
+
+#else
+
+const struct kernel_ops *kernel_sse2 = NULL;
+
+#endif
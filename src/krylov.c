@@ -0,0 +1,919 @@
+/* Krylov subspace solvers for large linear systems Ax=b
+ * Oct 18 2026 */
+
+#include "krylov.h"
+
+// marks a column with no entry in the row being factored by ILU(0)
+#define ILU_NONE UINT_MAX
+
+// a preconditioner and whatever it owns
+struct krylov_preconditioner
+{
+	linear_preconditioner apply;
+	void *userdata; // passed to apply, the preconditioner itself if built in
+	unsigned int n; // rows of A, 0 if not known
+	float *inverse; // 1/a_ii for Jacobi
+	sparse ilu; // L below the diagonal with a unit diagonal, U on and above
+	unsigned int *diagonal; // position of a_ii in each row of ilu
+	lu_handle lu;
+	int f; // index of lu_factor(), if lu is NULL
+};
+
+// the rows of one task of matrix_operator()
+struct operator_job
+{
+	matrix A;
+	const float *x;
+	float *y;
+};
+
+// one solve, shared by a method and the restarts around it
+struct krylov_run
+{
+	linear_operator A;
+	void *userdata;
+	preconditioner M;
+	unsigned int n;
+	float *x;
+	const float *b;
+	float *r; // b - Ax, the true residual whenever a method starts
+	double rnorm; // |r|_2
+	double bnorm; // |b|_2, or 1 if b = 0
+	double target; // tol*bnorm
+	unsigned int maxiter;
+	unsigned int restart; // basis size of GMRES
+	float *work; // the vectors of the method
+	double *H; // Hessenberg matrix and rotations of GMRES
+	struct krylov_stats count;
+};
+
+// iterations of a method from the true residual in run->r until the
+// residual it tracks reaches the target, returns a status
+typedef int (*krylov_method)(struct krylov_run *run);
+
+void matrix_operator(const float *x, float *y, unsigned int n, void *userdata);
+void sparse_operator(const float *x, float *y, unsigned int n, void *userdata);
+preconditioner precond_jacobi(matrix A);
+preconditioner precond_jacobi_sparse(sparse A);
+preconditioner precond_ilu0(sparse A);
+preconditioner precond_lu(lu_handle h);
+preconditioner precond_lu_index(int f, unsigned int n);
+preconditioner precond_custom(linear_preconditioner apply, void *userdata);
+int precond_apply(preconditioner M, const float *r, float *z, unsigned int n);
+void free_preconditioner(preconditioner M);
+int krylov_cg(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+int krylov_gmres(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int restart,
+		unsigned int maxiter, struct krylov_stats *stats);
+int krylov_bicgstab(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+
+// the rows of one task of matrix_operator()
+static void operator_task(void *arg, unsigned int t);
+// an empty preconditioner that applies with apply
+static preconditioner precond_new(linear_preconditioner apply, unsigned int n);
+// the built in preconditioners
+static int jacobi_apply(const float *r, float *z, unsigned int n,
+		void *userdata);
+static int ilu_apply(const float *r, float *z, unsigned int n, void *userdata);
+static int lu_apply(const float *r, float *z, unsigned int n, void *userdata);
+// ILU(0) in place on a CSR copy, returns 0 on success
+static int ilu_factor(sparse LU, unsigned int *diagonal);
+// the 2-norm of a vector in float, via the dot kernel
+static double norm(unsigned int n, const float *a);
+// run->r = b - Ax and its norm
+static double residual(struct krylov_run *run);
+// append to the history, if there is one and it has room
+static void record(struct krylov_stats *stats, double relative);
+// checks, defaults and room for r and vectors more, returns 0 on success
+static int krylov_start(struct krylov_run *run, linear_operator A,
+		void *userdata, preconditioner M, vector x, vector b, float tol,
+		unsigned int maxiter, struct krylov_stats *stats, size_t vectors);
+// the method restarted from the true residual until that converges or
+// stops improving, frees the run and returns a status
+static int krylov_solve(struct krylov_run *run, krylov_method method,
+		struct krylov_stats *stats);
+// the methods
+static int cg_method(struct krylov_run *run);
+static int gmres_method(struct krylov_run *run);
+static int bicgstab_method(struct krylov_run *run);
+
+// y = Ax for a dense matrix, its rows split over the thread pool
+void matrix_operator(const float *x, float *y, unsigned int n, void *userdata)
+{
+	struct operator_job job;
+	matrix A = userdata;
+
+	(void)n;
+	job.A = A;
+	job.x = x;
+	job.y = y;
+	parallel_for((A->n + KRYLOV_OPERATOR_ROWS - 1)/KRYLOV_OPERATOR_ROWS,
+			&operator_task, &job);
+}
+
+// rows t*KRYLOV_OPERATOR_ROWS ... of y = Ax
+static void operator_task(void *arg, unsigned int t)
+{
+	struct operator_job *job = arg;
+	matrix A = job->A;
+	unsigned int first=t*KRYLOV_OPERATOR_ROWS;
+	unsigned int last=first+KRYLOV_OPERATOR_ROWS;
+	unsigned int i,j;
+
+	if (last > A->n)
+	{
+		last = A->n;
+	}
+	if (A->flags & MATRIX_TRANSPOSED)
+	{
+		// the rows of y are contiguous in each stored row
+		memset(job->y + first, 0, sizeof(float)*(last - first));
+		for (j=0; j < A->m; j++)
+		{
+			mathlib_kernels->axpy(last - first, job->x[j], A->A[j] + first,
+					job->y + first);
+		}
+		return;
+	}
+	for (i=first; i < last; i++)
+	{
+		job->y[i] = mathlib_kernels->dot(A->m, A->A[i], job->x);
+	}
+}
+
+// y = Ax for a sparse matrix
+void sparse_operator(const float *x, float *y, unsigned int n, void *userdata)
+{
+	(void)n;
+	sparse_spmv(1., userdata, x, 0., y);
+}
+
+// an empty preconditioner
+static preconditioner precond_new(linear_preconditioner apply, unsigned int n)
+{
+	preconditioner M;
+
+	if ((M = calloc(1, sizeof(*M))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	M->apply = apply;
+	M->userdata = M;
+	M->n = n;
+	return M;
+}
+
+// M = diag(A) of a dense matrix
+preconditioner precond_jacobi(matrix A)
+{
+	preconditioner M;
+	unsigned int i;
+	float d;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Error: a preconditioner needs a square matrix\n");
+		return NULL;
+	}
+	if ((M = precond_new(&jacobi_apply, A->n)) == NULL)
+	{
+		return NULL;
+	}
+	if ((M->inverse = vector_allocate(A->n)) == NULL)
+	{
+		free_preconditioner(M);
+		return NULL;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		// the diagonal reads the same either way round
+		d = A->A[i][i];
+		if (d == 0. || !isfinite(d))
+		{
+			fprintf(stderr,"Error: zero on the diagonal of row %u\n",i);
+			free_preconditioner(M);
+			return NULL;
+		}
+		M->inverse[i] = 1./d;
+	}
+	return M;
+}
+
+// M = diag(A) of a sparse matrix, duplicates have been summed already
+preconditioner precond_jacobi_sparse(sparse A)
+{
+	preconditioner M;
+	unsigned int i,p,j;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Error: a preconditioner needs a square matrix\n");
+		return NULL;
+	}
+	if ((M = precond_new(&jacobi_apply, A->n)) == NULL)
+	{
+		return NULL;
+	}
+	if ((M->inverse = vector_allocate(A->n)) == NULL)
+	{
+		free_preconditioner(M);
+		return NULL;
+	}
+	// rows of CSR and columns of CSC both find a_ii the same way
+	for (j=0; j < A->n; j++)
+	{
+		for (p=A->ptr[j]; p < A->ptr[j+1]; p++)
+		{
+			if (A->index[p] == j)
+			{
+				M->inverse[j] = A->value[p];
+			}
+		}
+	}
+	for (i=0; i < A->n; i++)
+	{
+		if (M->inverse[i] == 0. || !isfinite(M->inverse[i]))
+		{
+			fprintf(stderr,"Error: zero on the diagonal of row %u\n",i);
+			free_preconditioner(M);
+			return NULL;
+		}
+		M->inverse[i] = 1./M->inverse[i];
+	}
+	return M;
+}
+
+// z = D^-1 r
+static int jacobi_apply(const float *r, float *z, unsigned int n,
+		void *userdata)
+{
+	preconditioner M = userdata;
+	unsigned int i;
+
+	for (i=0; i < n; i++)
+	{
+		z[i] = M->inverse[i]*r[i];
+	}
+	return 0;
+}
+
+// incomplete LU, fill outside the pattern of A is dropped
+preconditioner precond_ilu0(sparse A)
+{
+	preconditioner M;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Error: a preconditioner needs a square matrix\n");
+		return NULL;
+	}
+	if ((M = precond_new(&ilu_apply, A->n)) == NULL)
+	{
+		return NULL;
+	}
+	M->ilu = sparse_convert(A, SPARSE_CSR);
+	M->diagonal = malloc(sizeof(*M->diagonal)*A->n);
+	if (M->ilu == NULL || M->diagonal == NULL)
+	{
+		if (M->diagonal == NULL)
+		{
+			perror("Error allocating memory");
+		}
+		free_preconditioner(M);
+		return NULL;
+	}
+	if (ilu_factor(M->ilu, M->diagonal) != 0)
+	{
+		free_preconditioner(M);
+		return NULL;
+	}
+	return M;
+}
+
+// ILU(0) by rows, row i subtracts multiples of the rows k < i it has
+// an entry in, touching only entries row i already has
+static int ilu_factor(sparse LU, unsigned int *diagonal)
+{
+	unsigned int *where; // position of each column in row i
+	unsigned int n=LU->n;
+	unsigned int i,k,p,q;
+	float lik;
+
+	if ((where = malloc(sizeof(*where)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	for (i=0; i < n; i++)
+	{
+		where[i] = ILU_NONE;
+	}
+
+	for (i=0; i < n; i++)
+	{
+		diagonal[i] = ILU_NONE;
+		for (p=LU->ptr[i]; p < LU->ptr[i+1]; p++)
+		{
+			where[LU->index[p]] = p;
+			if (LU->index[p] == i)
+			{
+				diagonal[i] = p;
+			}
+		}
+		if (diagonal[i] == ILU_NONE)
+		{
+			fprintf(stderr,"Error: ILU(0) needs a_ii stored, row %u has none\n",i);
+			free(where);
+			return 1;
+		}
+
+		// the columns of a row are in increasing order, so the multipliers
+		// come before the diagonal
+		for (p=LU->ptr[i]; p < diagonal[i]; p++)
+		{
+			k = LU->index[p];
+			lik = LU->value[p] /= LU->value[diagonal[k]];
+			for (q=diagonal[k]+1; q < LU->ptr[k+1]; q++)
+			{
+				if (where[LU->index[q]] != ILU_NONE)
+				{
+					LU->value[where[LU->index[q]]] -= lik*LU->value[q];
+				}
+			}
+		}
+
+		if (LU->value[diagonal[i]] == 0. || !isfinite(LU->value[diagonal[i]]))
+		{
+			fprintf(stderr,"Error: ILU(0) broke down at row %u\n",i);
+			free(where);
+			return 1;
+		}
+		for (p=LU->ptr[i]; p < LU->ptr[i+1]; p++)
+		{
+			where[LU->index[p]] = ILU_NONE;
+		}
+	}
+
+	free(where);
+	return 0;
+}
+
+// z = U^-1 L^-1 r, z may be r
+static int ilu_apply(const float *r, float *z, unsigned int n, void *userdata)
+{
+	preconditioner M = userdata;
+	sparse LU = M->ilu;
+	unsigned int *d = M->diagonal;
+	unsigned int i;
+
+	for (i=0; i < n; i++)
+	{
+		z[i] = r[i] - mathlib_kernels->gather_dot(d[i] - LU->ptr[i],
+				LU->value + LU->ptr[i], LU->index + LU->ptr[i], z);
+	}
+	for (i=n; i-- > 0; )
+	{
+		z[i] = (z[i] - mathlib_kernels->gather_dot(LU->ptr[i+1] - d[i] - 1,
+				LU->value + d[i] + 1, LU->index + d[i] + 1, z))
+			/LU->value[d[i]];
+	}
+	return 0;
+}
+
+// an existing factorization of A or of something close to it
+preconditioner precond_lu(lu_handle h)
+{
+	preconditioner M;
+
+	if ((M = precond_new(&lu_apply, 0)) == NULL)
+	{
+		return NULL;
+	}
+	M->lu = lu_handle_retain(h);
+	return M;
+}
+
+// the same by its index in the factorization table
+preconditioner precond_lu_index(int f, unsigned int n)
+{
+	preconditioner M;
+
+	if ((M = precond_new(&lu_apply, n)) == NULL)
+	{
+		return NULL;
+	}
+	M->f = f;
+	return M;
+}
+
+// z = (LU)^-1 r
+static int lu_apply(const float *r, float *z, unsigned int n, void *userdata)
+{
+	preconditioner M = userdata;
+	// r and z wrapped for the solvers, r isn't written
+	__typeof__(*(vector)NULL) rv = {n, 1, (float *)r, 0}, zv = {n, 1, z, 0};
+
+	if (M->lu != NULL)
+	{
+		return lu_handle_solve(M->lu, &zv, &rv);
+	}
+	// lu_solve() reports a missing index but can't return it
+	memcpy(z, r, sizeof(*z)*n);
+	lu_solve(M->f, &zv, &rv);
+	return 0;
+}
+
+// a preconditioner the caller computes
+preconditioner precond_custom(linear_preconditioner apply, void *userdata)
+{
+	preconditioner M;
+
+	if ((M = precond_new(apply, 0)) == NULL)
+	{
+		return NULL;
+	}
+	M->userdata = userdata;
+	return M;
+}
+
+// z = M^-1 r
+int precond_apply(preconditioner M, const float *r, float *z, unsigned int n)
+{
+	if (M == NULL)
+	{
+		if (z != r)
+		{
+			memcpy(z, r, sizeof(*z)*n);
+		}
+		return 0;
+	}
+	if (M->n != 0 && M->n != n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	return M->apply(r, z, n, M->userdata);
+}
+
+// free the preconditioner and what it owns
+void free_preconditioner(preconditioner M)
+{
+	if (M == NULL)
+	{
+		return;
+	}
+	free(M->inverse);
+	free_sparse(M->ilu);
+	free(M->diagonal);
+	if (M->lu != NULL)
+	{
+		lu_handle_release(M->lu);
+	}
+	free(M);
+}
+
+// |a|_2
+static double norm(unsigned int n, const float *a)
+{
+	return sqrt(mathlib_kernels->dot(n, a, a));
+}
+
+// r = b - Ax
+static double residual(struct krylov_run *run)
+{
+	unsigned int i;
+
+	run->A(run->x, run->r, run->n, run->userdata);
+	run->count.products++;
+	for (i=0; i < run->n; i++)
+	{
+		run->r[i] = run->b[i] - run->r[i];
+	}
+	return norm(run->n, run->r);
+}
+
+// one more entry of the convergence history
+static void record(struct krylov_stats *stats, double relative)
+{
+	if (stats->history != NULL && stats->history_count < stats->history_size)
+	{
+		stats->history[stats->history_count++] = relative;
+	}
+}
+
+// everything a solve needs before the method starts
+static int krylov_start(struct krylov_run *run, linear_operator A,
+		void *userdata, preconditioner M, vector x, vector b, float tol,
+		unsigned int maxiter, struct krylov_stats *stats, size_t vectors)
+{
+	if (x->n != b->n || (M != NULL && M->n != 0 && M->n != x->n))
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+
+	memset(run, 0, sizeof(*run));
+	run->A = A;
+	run->userdata = userdata;
+	run->M = M;
+	run->n = x->n;
+	run->x = x->a;
+	run->b = b->a;
+	run->maxiter = (maxiter == 0) ? KRYLOV_DEFAULT_MAXITER : maxiter;
+	run->count.residual = INFINITY;
+	if (stats != NULL)
+	{
+		run->count.history = stats->history;
+		run->count.history_size = stats->history_size;
+	}
+
+	// r first, then the vectors of the method, all zeroed
+	if ((run->r = vector_allocate((vectors + 1)*run->n)) == NULL)
+	{
+		return 1;
+	}
+	run->work = run->r + run->n;
+
+	// b = 0 is solved by x = 0 exactly
+	if ((run->bnorm = norm(run->n, run->b)) == 0.)
+	{
+		memset(run->x, 0, sizeof(*run->x)*run->n);
+		run->bnorm = 1.;
+	}
+	run->target = tol*run->bnorm;
+	return 0;
+}
+
+// a method in float loses track of the true residual as rounding errors
+// build up, so each time it claims convergence or breaks down it is
+// restarted from b - Ax, for as long as that keeps improving
+static int krylov_solve(struct krylov_run *run, krylov_method method,
+		struct krylov_stats *stats)
+{
+	double last=INFINITY;
+	int status=KRYLOV_OK;
+
+	run->rnorm = residual(run);
+	record(&run->count, run->rnorm/run->bnorm);
+	while (run->rnorm > run->target && isfinite(run->rnorm))
+	{
+		if (run->count.iterations >= run->maxiter)
+		{
+			status = KRYLOV_NO_CONVERGENCE;
+			break;
+		}
+		if ((status = method(run)) == KRYLOV_ERROR)
+		{
+			break;
+		}
+		run->rnorm = residual(run);
+		if (run->rnorm <= run->target)
+		{
+			status = KRYLOV_OK;
+			break;
+		}
+		if (status == KRYLOV_NO_CONVERGENCE)
+		{
+			// a cycle of GMRES has to make some progress
+			if (run->count.iterations < run->maxiter && !(run->rnorm < last))
+			{
+				status = KRYLOV_STAGNATION;
+				break;
+			}
+		}
+		else if (!(run->rnorm <= KRYLOV_STALL*last))
+		{
+			// the true residual is at the roundoff of float, or the
+			// method broke down again without getting anywhere
+			status = (status == KRYLOV_BREAKDOWN) ? KRYLOV_BREAKDOWN
+				: KRYLOV_STAGNATION;
+			break;
+		}
+		last = run->rnorm;
+	}
+	if (!isfinite(run->rnorm) && status != KRYLOV_ERROR)
+	{
+		status = KRYLOV_BREAKDOWN;
+	}
+
+	run->count.residual = run->rnorm/run->bnorm;
+	if (stats != NULL)
+	{
+		*stats = run->count;
+	}
+	free(run->r);
+	free(run->H);
+	return status;
+}
+
+// preconditioned conjugate gradients
+int krylov_cg(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats)
+{
+	struct krylov_run run;
+
+	if (krylov_start(&run, A, userdata, M, x, b, tol, maxiter, stats, 3) != 0)
+	{
+		return KRYLOV_ERROR;
+	}
+	return krylov_solve(&run, &cg_method, stats);
+}
+
+// CG from the residual in run->r
+static int cg_method(struct krylov_run *run)
+{
+	unsigned int n=run->n;
+	unsigned int i;
+	float *r=run->r;
+	float *z=run->work;
+	float *p=z+n;
+	float *q=p+n;
+	double rnorm,rz,rz_next,pq,alpha,beta;
+
+	if (precond_apply(run->M, r, z, n) != 0)
+	{
+		return KRYLOV_ERROR;
+	}
+	run->count.preconditions++;
+	memcpy(p, z, sizeof(*p)*n);
+	rz = mathlib_kernels->dot(n, r, z);
+
+	while (run->count.iterations < run->maxiter)
+	{
+		run->A(p, q, n, run->userdata);
+		run->count.products++;
+		pq = mathlib_kernels->dot(n, p, q);
+		if (pq <= 0. || !isfinite(pq))
+		{
+			return KRYLOV_BREAKDOWN;
+		}
+		alpha = rz/pq;
+		mathlib_kernels->axpy(n, alpha, p, run->x);
+		mathlib_kernels->axpy(n, -alpha, q, r);
+		rnorm = norm(n, r);
+		run->count.iterations++;
+		record(&run->count, rnorm/run->bnorm);
+		if (rnorm <= run->target)
+		{
+			return KRYLOV_OK;
+		}
+
+		if (precond_apply(run->M, r, z, n) != 0)
+		{
+			return KRYLOV_ERROR;
+		}
+		run->count.preconditions++;
+		rz_next = mathlib_kernels->dot(n, r, z);
+		if (rz_next == 0. || !isfinite(rz_next))
+		{
+			return KRYLOV_BREAKDOWN;
+		}
+		beta = rz_next/rz;
+		rz = rz_next;
+		for (i=0; i < n; i++)
+		{
+			p[i] = z[i] + beta*p[i];
+		}
+	}
+	return KRYLOV_NO_CONVERGENCE;
+}
+
+// restarted GMRES with M applied on the right, AM^-1 u = b - Ax_0
+// and x = x_0 + M^-1 u, so the residual is that of Ax=b
+int krylov_gmres(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int restart,
+		unsigned int maxiter, struct krylov_stats *stats)
+{
+	struct krylov_run run;
+	unsigned int m;
+
+	// a basis can't grow past the dimension of the space
+	m = (restart == 0) ? KRYLOV_RESTART : restart;
+	if (m > x->n)
+	{
+		m = x->n;
+	}
+	// the basis of m+1 vectors and M^-1 of one of them
+	if (krylov_start(&run, A, userdata, M, x, b, tol, maxiter, stats,
+			(size_t)m+2) != 0)
+	{
+		return KRYLOV_ERROR;
+	}
+	run.restart = m;
+	// H has m columns of m+1, then the rotations c and s and g
+	if ((run.H = malloc(sizeof(*run.H)*((size_t)(m+1)*m + 3*m + 1))) == NULL)
+	{
+		perror("Error allocating memory");
+		free(run.r);
+		return KRYLOV_ERROR;
+	}
+	return krylov_solve(&run, &gmres_method, stats);
+}
+
+// one cycle of up to restart steps of Arnoldi from the residual, then
+// the least squares update of x
+static int gmres_method(struct krylov_run *run)
+{
+	unsigned int n=run->n, m=run->restart;
+	unsigned int i,j,k=0;
+	double *c=run->H + (size_t)(m+1)*m;
+	double *s=c+m;
+	double *g=s+m;
+	double h,t,*Hj;
+	float *V=run->work;
+	float *z=V + (size_t)(m+1)*n;
+	float *v;
+	int status=KRYLOV_NO_CONVERGENCE;
+
+	for (i=0; i < n; i++)
+	{
+		V[i] = run->r[i]/run->rnorm;
+	}
+	g[0] = run->rnorm;
+
+	for (j=0; j < m && run->count.iterations < run->maxiter; j++)
+	{
+		// the next direction A M^-1 v_j, orthogonalized against the basis
+		// by modified Gram-Schmidt
+		v = V + (size_t)(j+1)*n;
+		if (precond_apply(run->M, V + (size_t)j*n, z, n) != 0)
+		{
+			return KRYLOV_ERROR;
+		}
+		run->count.preconditions++;
+		run->A(z, v, n, run->userdata);
+		run->count.products++;
+		Hj = run->H + (size_t)j*(m+1);
+		for (i=0; i <= j; i++)
+		{
+			Hj[i] = mathlib_kernels->dot(n, V + (size_t)i*n, v);
+			mathlib_kernels->axpy(n, -Hj[i], V + (size_t)i*n, v);
+		}
+		Hj[j+1] = norm(n, v);
+		if (!isfinite(Hj[j+1]))
+		{
+			return KRYLOV_BREAKDOWN;
+		}
+		// a zero norm means the solution lies in the basis already
+		if (Hj[j+1] > 0.)
+		{
+			mathlib_kernels->scal(n, 1./Hj[j+1], v);
+		}
+
+		// the rotations so far, then one more to zero H[j+1][j]
+		for (i=0; i < j; i++)
+		{
+			t = c[i]*Hj[i] + s[i]*Hj[i+1];
+			Hj[i+1] = -s[i]*Hj[i] + c[i]*Hj[i+1];
+			Hj[i] = t;
+		}
+		if ((h = hypot(Hj[j], Hj[j+1])) == 0.)
+		{
+			// A M^-1 v_j is in the span of the others, A is singular
+			status = KRYLOV_BREAKDOWN;
+			break;
+		}
+		c[j] = Hj[j]/h;
+		s[j] = Hj[j+1]/h;
+		Hj[j] = h;
+		Hj[j+1] = 0.;
+		g[j+1] = -s[j]*g[j];
+		g[j] *= c[j];
+
+		run->count.iterations++;
+		k = j+1;
+		record(&run->count, fabs(g[j+1])/run->bnorm);
+		if (fabs(g[j+1]) <= run->target)
+		{
+			status = KRYLOV_OK;
+			break;
+		}
+	}
+
+	// H y = g by back substitution, y overwrites g
+	for (i=k; i-- > 0; )
+	{
+		t = g[i];
+		for (j=i+1; j < k; j++)
+		{
+			t -= run->H[(size_t)j*(m+1) + i]*g[j];
+		}
+		g[i] = t/run->H[(size_t)i*(m+1) + i];
+	}
+
+	// x += M^-1 V y, the sum is built in r which krylov_solve() recomputes
+	memset(run->r, 0, sizeof(*run->r)*n);
+	for (i=0; i < k; i++)
+	{
+		mathlib_kernels->axpy(n, g[i], V + (size_t)i*n, run->r);
+	}
+	if (precond_apply(run->M, run->r, z, n) != 0)
+	{
+		return KRYLOV_ERROR;
+	}
+	run->count.preconditions++;
+	mathlib_kernels->axpy(n, 1., z, run->x);
+	return status;
+}
+
+// van der Vorst's BiCGSTAB with M applied on the right
+int krylov_bicgstab(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats)
+{
+	struct krylov_run run;
+
+	if (krylov_start(&run, A, userdata, M, x, b, tol, maxiter, stats, 6) != 0)
+	{
+		return KRYLOV_ERROR;
+	}
+	return krylov_solve(&run, &bicgstab_method, stats);
+}
+
+// BiCGSTAB from the residual in run->r, which is also the shadow residual
+static int bicgstab_method(struct krylov_run *run)
+{
+	unsigned int n=run->n;
+	unsigned int i;
+	float *r=run->r;
+	float *r0=run->work;
+	float *p=r0+n;
+	float *v=p+n;
+	float *ph=v+n;
+	float *sh=ph+n;
+	float *t=sh+n;
+	double rnorm,rho=1.,rho_next,alpha=1.,omega=1.,beta,tt;
+
+	memcpy(r0, r, sizeof(*r0)*n);
+	memset(p, 0, sizeof(*p)*n);
+	memset(v, 0, sizeof(*v)*n);
+
+	while (run->count.iterations < run->maxiter)
+	{
+		rho_next = mathlib_kernels->dot(n, r0, r);
+		beta = (rho_next/rho)*(alpha/omega);
+		if (rho_next == 0. || !isfinite(beta))
+		{
+			return KRYLOV_BREAKDOWN;
+		}
+		rho = rho_next;
+		for (i=0; i < n; i++)
+		{
+			p[i] = r[i] + beta*(p[i] - omega*v[i]);
+		}
+
+		if (precond_apply(run->M, p, ph, n) != 0)
+		{
+			return KRYLOV_ERROR;
+		}
+		run->count.preconditions++;
+		run->A(ph, v, n, run->userdata);
+		run->count.products++;
+		tt = mathlib_kernels->dot(n, r0, v);
+		if (tt == 0. || !isfinite(tt))
+		{
+			return KRYLOV_BREAKDOWN;
+		}
+		alpha = rho/tt;
+
+		// s = r - alpha v is kept in r
+		mathlib_kernels->axpy(n, -alpha, v, r);
+		mathlib_kernels->axpy(n, alpha, ph, run->x);
+		run->count.iterations++;
+		if ((rnorm = norm(n, r)) <= run->target)
+		{
+			record(&run->count, rnorm/run->bnorm);
+			return KRYLOV_OK;
+		}
+
+		if (precond_apply(run->M, r, sh, n) != 0)
+		{
+			return KRYLOV_ERROR;
+		}
+		run->count.preconditions++;
+		run->A(sh, t, n, run->userdata);
+		run->count.products++;
+		tt = mathlib_kernels->dot(n, t, t);
+		omega = (tt > 0.) ? mathlib_kernels->dot(n, t, r)/tt : 0.;
+		if (omega == 0. || !isfinite(omega))
+		{
+			record(&run->count, rnorm/run->bnorm);
+			return KRYLOV_BREAKDOWN;
+		}
+		mathlib_kernels->axpy(n, omega, sh, run->x);
+		mathlib_kernels->axpy(n, -omega, t, r);
+		rnorm = norm(n, r);
+		record(&run->count, rnorm/run->bnorm);
+		if (rnorm <= run->target)
+		{
+			return KRYLOV_OK;
+		}
+	}
+	return KRYLOV_NO_CONVERGENCE;
+}
@@ -0,0 +1,106 @@
+/* Krylov subspace solvers for large linear systems Ax=b
+ * Oct 18 2026 */
+
+#ifndef KRYLOV_H
+#define KRYLOV_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "linear_system.h"
+#include "sparse.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// status of a Krylov solver
+#define KRYLOV_OK 0 // converged
+#define KRYLOV_NO_CONVERGENCE 1 // the iteration limit was reached
+#define KRYLOV_BREAKDOWN 2 // a denominator vanished, e.g. A isn't SPD for CG
+#define KRYLOV_ERROR 3 // bad arguments, allocation or preconditioner failure
+#define KRYLOV_STAGNATION 4 // restarts stopped reducing |b-Ax|, usually at float roundoff
+
+// iterations allowed when 0 is given
+#define KRYLOV_DEFAULT_MAXITER 1000
+// basis size of GMRES when a restart of 0 is given
+#define KRYLOV_RESTART 30
+// after a method claims convergence or breaks down it is restarted
+// from the true residual while that shrinks by at least this factor
+#define KRYLOV_STALL 0.5
+// rows of a dense matrix multiplied by one task of matrix_operator()
+#define KRYLOV_OPERATOR_ROWS 64
+
+// y = Ax for n unknowns, A needn't be stored at all
+typedef void (*linear_operator)(const float *x, float *y, unsigned int n,
+		void *userdata);
+// z = M^-1 r for a preconditioner M that approximates A
+typedef int (*linear_preconditioner)(const float *r, float *z, unsigned int n,
+		void *userdata);
+
+// a preconditioner and whatever it owns
+typedef struct krylov_preconditioner *preconditioner;
+
+// work done by a Krylov solver
+struct krylov_stats
+{
+	unsigned long iterations;
+	unsigned long products; // of A, including the final residual
+	unsigned long preconditions; // applications of M^-1
+	float residual; // |b-Ax|_2/|b|_2 at the returned x
+	// if history isn't NULL, the relative residual the iteration tracks
+	// is stored after each step, history[0] being that of the first guess
+	float *history;
+	unsigned int history_size; // room in history
+	unsigned int history_count; // entries written
+};
+
+// operators for stored matrices, userdata is the matrix or sparse
+// the rows of a dense matrix are split over the thread pool
+extern void matrix_operator(const float *x, float *y, unsigned int n,
+		void *userdata);
+extern void sparse_operator(const float *x, float *y, unsigned int n,
+		void *userdata);
+
+// M = diag(A)
+extern preconditioner precond_jacobi(matrix A);
+extern preconditioner precond_jacobi_sparse(sparse A);
+// incomplete LU with the sparsity pattern of A, which must have
+// its diagonal stored, A is copied
+extern preconditioner precond_ilu0(sparse A);
+// an existing factorization, e.g. of a nearby or older system,
+// the handle is retained until the preconditioner is freed
+extern preconditioner precond_lu(lu_handle h);
+// the same, for an index returned by lu_factor()
+extern preconditioner precond_lu_index(int f, unsigned int n);
+// any other M^-1, it must return 0 on success
+extern preconditioner precond_custom(linear_preconditioner apply,
+		void *userdata);
+// z = M^-1 r, z = r if M is NULL, returns 0 on success
+extern int precond_apply(preconditioner M, const float *r, float *z,
+		unsigned int n);
+extern void free_preconditioner(preconditioner M);
+
+// solve Ax=b starting from the guess in x, where the solution is left,
+// converged when the true |b-Ax|_2 <= tol*|b|_2, M may be NULL and stats
+// too, maxiter of 0 allows KRYLOV_DEFAULT_MAXITER, returns a status
+// a float solve of an ill conditioned system can't get below about
+// FLT_EPSILON*cond(A), asking for less ends in KRYLOV_STAGNATION
+// conjugate gradients, A and M must be symmetric positive definite
+extern int krylov_cg(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+// GMRES restarted every restart iterations, preconditioned on the
+// right so the residual it tracks is that of the original system
+extern int krylov_gmres(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int restart,
+		unsigned int maxiter, struct krylov_stats *stats);
+// stabilized biconjugate gradients, preconditioned on the right
+extern int krylov_bicgstab(linear_operator A, void *userdata,
+		preconditioner M, vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+
+#endif
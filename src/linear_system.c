@@ -3,37 +3,140 @@
  * April 21 2010 */
 
 #include "linear_system.h"
+#include "kernel.h"
+#include "gemm.h"
+#include "thread_pool.h"
+#include "sparse_lu.h"
 
-struct factored_system *factorizations;
-unsigned int n_factorizations; // maximum number of factorizations
-unsigned int i_factorizations; // current number of factorizations
+// columns of U12 solved for by one task
+#define LU_TRSM_COLS 256
+// solve pairs allowed in a condition estimate, as in LAPACK
+#define LU_CONDEST_STEPS 5
+// right hand sides solved for by one task
+#define LU_SOLVE_COLS 256
+// columns of L taken at once by lu_handle_inverse(), wide enough that
+// packing the inverse for the multiplication costs little
+#define LU_INVERSE_COLS (4*LU_BLOCK)
 
-// for creating a permutation vector of indices 1<=a<=n
-float index_element(int a, int b);
+// a triangular solve L11 U12 = A12 split over column ranges
+struct trsm_job
+{
+	matrix LU;
+	unsigned int j; // first row and column of the panel
+	unsigned int jb; // width of the panel
+	unsigned int first; // first column of U12
+	unsigned int cols; // columns per task
+};
+
+// a block column of U^-1 or of A^-1 split over blocks of LU_BLOCK rows
+struct inverse_job
+{
+	float **X; // the inverse, overwriting a copy of the factors
+	float **W; // n x LU_INVERSE_COLS work space
+	unsigned int n;
+	unsigned int j; // first column of the block
+	unsigned int jb; // width of the block
+	unsigned int jw; // column of W holding column j of L
+	float alpha; // the diagonal of L
+	int failed; // set by a task that ran out of memory
+};
+
+// LUX=B split over ranges of right hand sides
+struct solve_job
+{
+	struct factored_system *fs;
+	matrix X;
+	unsigned int cols; // columns per task
+	int failed; // set by a task that ran out of memory
+};
+
+// the factorizations handed out by index through lu_factor()
+// freed indices are reused, the table doubles when it is full
+static pthread_mutex_t factor_lock = PTHREAD_MUTEX_INITIALIZER;
+static lu_handle *factor_slots; // index -> factorization, NULL if unused
+static unsigned int n_slots; // allocated slots
+static unsigned int top_slot; // slots that have ever been used
+
+// matrix -> index lookup for the table above
+struct factor_index
+{
+	matrix A;
+	unsigned int slot;
+	struct factor_index *next; // next in this bucket
+};
+static struct factor_index **index_buckets;
+static unsigned int n_buckets; // a power of 2
+static unsigned int n_indexed;
+
+// for creating a permutation vector of indices 0<=a<n
+unsigned int index_element(int a, int b);
 // directly solve lower triangular system Lx=b
 void forward_substitution(matrix L, vector x, vector b);
 // directly solve upper triangular system Ux=b
 void backward_substitution(matrix U, vector x, vector b);
 // direct solution of LUx=b with factorizations index f
 void lu_solve(int f, vector x, vector b);
+// factorization handles
+lu_handle lu_handle_factor(matrix A, int pivoting);
+lu_handle lu_handle_retain(lu_handle h);
+void lu_handle_release(lu_handle h);
+int lu_handle_solve(lu_handle h, vector x, vector b);
+int lu_solve_many(lu_handle h, matrix B, matrix X);
+static void lu_solve_task(void *arg, unsigned int t);
+static int permute_rows(matrix X, uvector p, int gather);
+static int sparse_solve_many(lu_handle h, matrix B, matrix X);
+size_t lu_handle_bytes(lu_handle h);
+struct factored_system * lu_handle_factors(lu_handle h);
 // generate an LU factorization, return factorizations index
 int lu_factor(matrix A);
+int lu_factor_pivot(matrix A, int pivoting);
+// in place factorizations of a square matrix
+int lu_factor_blocked(matrix LU, uvector bi);
+int lu_factor_total(matrix LU, uvector xi, uvector bi);
+static void lu_trsm_task(void *arg, unsigned int t);
+static int lu_factor_transposed(matrix LU, uvector xi, uvector bi, int pivoting);
 // general method to solve a linear system Ax=b
 void linear_solve(matrix A, vector x, vector b);
+int linear_solve_refined(matrix A, vector x, vector b, unsigned int steps,
+		float *rcond);
+static lu_handle solve_handle(matrix A);
+// accuracy of a solution and of the factors
+int lu_handle_refine(lu_handle h, vector x, vector b, unsigned int steps);
+float lu_handle_rcond(lu_handle h);
+static void residual(matrix A, vector x, vector b, vector r);
+static void lu_solve_transposed(struct factored_system *fs, float *z);
+static int transposed_solve(lu_handle h, float *z, float *work);
+static unsigned int handle_order(lu_handle h);
+static double inverse_norm(lu_handle h, vector v, float *w);
+// determinants and the inverse from the factors
+float lu_handle_det(lu_handle h);
+double lu_handle_logdet(lu_handle h, int *sign);
+int lu_handle_inverse(lu_handle h, matrix X);
+int permutation_sign(unsigned int n, const unsigned int *p);
+static int invert_upper(struct inverse_job *job);
+static void upper_task(void *arg, unsigned int t);
+static void lower_task(void *arg, unsigned int t);
+static int unpermute(struct factored_system *fs, float **X, unsigned int n);
 // cleanup
 void free_factor(int factor);
+void free_all_factors(void);
+// bookkeeping for the factorization table, called with factor_lock held
+static int index_find(matrix A);
+static int index_insert(matrix A, unsigned int slot);
+static void index_remove(matrix A);
+static int slot_alloc(void);
 
-float index_element(int a, int b)
+unsigned int index_element(int a, int b)
 {
 	(void)b;
 
-	return a;
+	return a-1;
 }
 
 // direct solution of lower triangular system Lx=b
 void forward_substitution(matrix L, vector x, vector b)
 {
-	unsigned int i,k;
+	unsigned int i;
 	float sum;
 
 	if (L->n != x->n || L->n != b->n)
@@ -42,13 +145,22 @@ void forward_substitution(matrix L, vector x, vector b)
 		return;
 	}
 
-	for (i=1; i <= x->n; i++)
+	// the columns of a transposed view are contiguous,
+	// so eliminate a column at a time
+	if (L->flags & MATRIX_TRANSPOSED)
 	{
-		sum=0.;
-		for(k=1; k <= i-1; k++)
+		memmove(x->a, b->a, sizeof(*x->a)*x->n);
+		for (i=0; i < x->n; i++)
 		{
-			sum += L->A[i-1][k-1]*x->a[k-1];
+			x->a[i] /= L->A[i][i];
+			mathlib_kernels->axpy(x->n-i-1, -x->a[i], L->A[i]+i+1, x->a+i+1);
 		}
+		return;
+	}
+
+	for (i=1; i <= x->n; i++)
+	{
+		sum = mathlib_kernels->dot(i-1, L->A[i-1], x->a);
 		x->a[i-1] = (b->a[i-1] - sum)/L->A[i-1][i-1];
 	}
 }
@@ -56,7 +168,7 @@ void forward_substitution(matrix L, vector x, vector b)
 // direct solution of upper triangular system Ux=b
 void backward_substitution(matrix U, vector x, vector b)
 {
-	unsigned int i,k;
+	unsigned int i;
 	float sum;
 
 	if (U->n != x->n || U->n != b->n)
@@ -65,13 +177,22 @@ void backward_substitution(matrix U, vector x, vector b)
 		return;
 	}
 
-	for (i=x->n; i >= 1; i--)
+	// the columns of a transposed view are contiguous,
+	// so eliminate a column at a time
+	if (U->flags & MATRIX_TRANSPOSED)
 	{
-		sum=0.;
-		for (k=i+1; k <= x->n; k++)
+		memmove(x->a, b->a, sizeof(*x->a)*x->n);
+		for (i=x->n; i >= 1; i--)
 		{
-			sum += U->A[i-1][k-1]*x->a[k-1];
+			x->a[i-1] /= U->A[i-1][i-1];
+			mathlib_kernels->axpy(i-1, -x->a[i-1], U->A[i-1], x->a);
 		}
+		return;
+	}
+
+	for (i=x->n; i >= 1; i--)
+	{
+		sum = mathlib_kernels->dot(x->n-i, U->A[i-1]+i, x->a+i);
 		x->a[i-1] = (b->a[i-1]-sum)/U->A[i-1][i-1];
 	}
 }
@@ -80,353 +201,1609 @@ void backward_substitution(matrix U, vector x, vector b)
 // f is the number of the factor in the factor list
 void lu_solve(int f, vector x, vector b)
 {
-	unsigned int i,k;
-	float sum;
-	int bp,xp; // b and x index permutation
-	vector z; // intermediate solution
+	lu_handle h=NULL;
 
-	if (factorizations[f].factors->n != x->n || factorizations[f].factors->n != b->n)
+	pthread_mutex_lock(&factor_lock);
+	if (f >= 0 && (unsigned int)f < top_slot && factor_slots[f] != NULL)
 	{
-		fprintf(stderr,"System is dimensionally inconsistent\n");
-		return;
+		h = lu_handle_retain(factor_slots[f]);
 	}
+	pthread_mutex_unlock(&factor_lock);
 
-	// initialize intermediate solution vector
-	if ((z = zero_vector(b->n)) == NULL)
+	if (h == NULL)
 	{
+		fprintf(stderr,"No factorization with index %d\n",f);
 		return;
 	}
 
-	// forward substitution of lower triangular portion Lz=b
-	for (i=1; i <= x->n; i++)
+	lu_handle_solve(h,x,b);
+	lu_handle_release(h);
+}
+
+// direct solution of decomposed system LUx=b
+// returns 0 on success
+int lu_handle_solve(lu_handle h, vector x, vector b)
+{
+	unsigned int i,n;
+	float sum;
+	float *z; // intermediate solution
+	struct factored_system *fs = &h->fs;
+	float **LU;
+
+	if (h->sparse != NULL)
 	{
-		sum=0.;
-		for (k=1; k <= i-1; k++)
+		n = sparse_factors_system(h->sparse)->n;
+		if (n != x->n || n != b->n)
 		{
-			sum += factorizations[f].factors->A[i-1][k-1]*z->a[k-1];
+			fprintf(stderr,"System is dimensionally inconsistent\n");
+			return 1;
 		}
-		bp = (int)(factorizations[f].b_permutation->a[i-1])-1;
-		z->a[i-1] = (b->a[bp] - sum)/factorizations[f].alpha;
+		return sparse_factors_solve(h->sparse, b->a, x->a);
 	}
 
-	// backward substitution of upper triangular portion Ux=z
-	for (i=x->n; i >= 1; i--)
+	LU = fs->factors->A;
+	n = fs->factors->n;
+	if (n != x->n || n != b->n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+
+	// with row pivoting only, the solution is built in x itself,
+	// scratch space is needed to undo column pivoting or if x is b
+	z = x->a;
+	if (h->pivoting == LU_TOTAL_PIVOTING || x->a == b->a)
 	{
-		sum=0.;
-		for (k=i+1; k <= x->n; k++)
+		if ((z = vector_allocate(n)) == NULL)
 		{
-			xp=(int)(factorizations[f].x_permutation->a[k-1])-1;
-			sum += factorizations[f].factors->A[i-1][k-1]*x->a[xp];
+			return 1;
 		}
-		xp=(int)(factorizations[f].x_permutation->a[i-1])-1;
-		x->a[xp] = (z->a[i-1]-sum)/factorizations[f].factors->A[i-1][i-1];
 	}
 
-	free_vector(z);
-}
-
-// factor matrix A into lower and upper triangular parts LU
-// if a factorization of A has already been done, it will be re-factored in place
-int lu_factor(matrix A)
-{
-	unsigned int i,j,k; // iterators
-	int factor=-1; // if this is positive we are refactoring
-	float r,sum,sum2; // temporary sums
-	float alpha=1.; // diag(L)
-	float beta; // diag(U)
-	matrix LU; // an LU factorization
-	vector xi; // x permutations
-	vector bi; // b permutations
-	vector max; // row maximums
+	// forward substitution of lower triangular portion Lz=Pb
+	for (i=0; i < n; i++)
+	{
+		sum = mathlib_kernels->dot(i, LU[i], z);
+		z[i] = (b->a[fs->b_permutation->a[i]] - sum)/fs->alpha;
+	}
 
-	// initialize the list of factorizations
-	if (factorizations == NULL)
+	// backward substitution of upper triangular portion Uz=z
+	// done in place so the inner loop is contiguous
+	for (i=n; i >= 1; i--)
 	{
-		n_factorizations=10;
-		i_factorizations=0;
-		if ((factorizations = malloc(sizeof(*factorizations)*n_factorizations)) == NULL)
-		{
-			fprintf(stderr,"Couldn't initialize factorizations list\n");
-			return -1;
-		}
+		sum = mathlib_kernels->dot(n-i, LU[i-1]+i, z+i);
+		z[i-1] = (z[i-1]-sum)/LU[i-1][i-1];
 	}
-	else
+
+	// undo the column pivoting x = Qz
+	if (z != x->a)
 	{
-		// search for an existing factorization of this matrix
-		for (i=0; i < i_factorizations; i++)
+		for (i=0; i < n; i++)
 		{
-			if (factorizations[i].system == A)
-			{
-				factor = i;
-				break;
-			}
+			x->a[fs->x_permutation->a[i]] = z[i];
 		}
+		free(z);
 	}
+	return 0;
+}
+
+// direct solution of LUX=B for every column of B at once
+// the columns are cut into ranges solved in parallel, within a range
+// the triangular solves are blocked so most of the work is GEMM and
+// each block of the factors passes through cache once per range
+// X may be B, returns 0 on success
+int lu_solve_many(lu_handle h, matrix B, matrix X)
+{
+	unsigned int i,n;
+	int status;
+	matrix T;
+	struct factored_system *fs = &h->fs;
+	struct solve_job job;
 
-	if (factor >= 0)
+	if (h->sparse != NULL)
 	{
-		// set up pointers so to re-factor system
-		LU = factorizations[factor].factors;
-		xi = factorizations[factor].x_permutation;
-		bi = factorizations[factor].b_permutation;
-		alpha = factorizations[factor].alpha;
+		return sparse_solve_many(h, B, X);
+	}
 
-		// reset things back to their original state
-		for (i=0; i < LU->n; i++)
-		{
-			for (j=0; j < LU->m; j++)
-			{
-				LU->A[i][j]=0.;
-			}
-			xi->a[i] = (float)(i+1);
-			bi->a[i] = (float)(i+1);
-		}
-			
+	n = fs->factors->n;
+	if (B->n != n || X->n != n || B->m != X->m)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
 	}
-	else
+
+	// the solves run along rows of X, so transposed
+	// views are solved in ordinary storage
+	if ((B->flags | X->flags) & MATRIX_TRANSPOSED)
 	{
-		// initialize a new factors matrix
-		// to save space, we save both L and U in the same matrix
-		// except for the diagonal the nonzero entries are disjoint sets
-		// so we keep the diagonal of U in LU and alpha in the factorizations list
-		if ((LU = zero_matrix(A->n,A->n)) == NULL)
+		if ((T = zero_matrix(n, X->m)) == NULL)
 		{
-			return -1;
-		}
-		if ((xi = new_vector(&index_element, A->n, 1)) == NULL)
-		{
-			free_matrix(LU);
-			return -1;
+			return 1;
 		}
-		if ((bi = new_vector(&index_element, A->n, 1)) == NULL)
+		matrix_set(T, B);
+		if ((status = lu_solve_many(h, T, T)) == 0)
 		{
-			free_matrix(LU);
-			free_vector(xi);
-			return -1;
+			matrix_set(X, T);
 		}
+		free_matrix(T);
+		return status;
 	}
 
-	// initialize vector for row maximums
-	if ((max = zero_vector(A->n)) == NULL)
+	// rows of X = PB
+	if (X == B)
 	{
-		if (factor < 0)
+		if (permute_rows(X, fs->b_permutation, 1) != 0)
 		{
-			free_matrix(LU);
-			free_vector(xi);
-			free_vector(bi);
+			return 1;
 		}
-		else
+	}
+	else
+	{
+		for (i=0; i < n; i++)
 		{
-			free_factor(factor);
+			memcpy(X->A[i], B->A[fs->b_permutation->a[i]], sizeof(**X->A)*X->m);
 		}
-		return -1;
 	}
-	
-	// find the maximums of each row of A
-	for (i=0; i < A->n; i++)
+
+	job.fs = fs;
+	job.X = X;
+	job.cols = LU_SOLVE_COLS;
+	job.failed = 0;
+	parallel_for((X->m + job.cols - 1)/job.cols, &lu_solve_task, &job);
+	if (job.failed)
 	{
-		for (j=0; j < A->n; j++)
+		return 1;
+	}
+
+	// rows of X = QX
+	if (h->pivoting == LU_TOTAL_PIVOTING)
+	{
+		return permute_rows(X, fs->x_permutation, 0);
+	}
+	return 0;
+}
+
+// sparse factors solve one column of B at a time
+static int sparse_solve_many(lu_handle h, matrix B, matrix X)
+{
+	unsigned int i,j,n;
+	float *b;
+
+	n = sparse_factors_system(h->sparse)->n;
+	if (B->n != n || X->n != n || B->m != X->m)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((b = vector_allocate(n)) == NULL)
+	{
+		return 1;
+	}
+	for (j=0; j < B->m; j++)
+	{
+		for (i=0; i < n; i++)
 		{
-			if (A->A[i][j] > max->a[i])
-			{
-				max->a[i] = A->A[i][j];
-			}
+			b[i] = (B->flags & MATRIX_TRANSPOSED) ? B->A[j][i] : B->A[i][j];
 		}
-		if (max->a[i] == 0.)
+		if (sparse_factors_solve(h->sparse, b, b) != 0)
 		{
-			// we need least squares method
-			fprintf(stderr,"No unique solution\n");
-			if (factor < 0)
+			free(b);
+			return 1;
+		}
+		for (i=0; i < n; i++)
+		{
+			if (X->flags & MATRIX_TRANSPOSED)
 			{
-				free_matrix(LU);
-				free_vector(xi);
-				free_vector(bi);
-				free_vector(max);
+				X->A[j][i] = b[i];
 			}
 			else
 			{
-				free_factor(factor);
+				X->A[i][j] = b[i];
 			}
-			return -1;
 		}
 	}
+	free(b);
+	return 0;
+}
+
+// solve LUX=X in place for one range of columns of X
+static void lu_solve_task(void *arg, unsigned int t)
+{
+	struct solve_job *job = arg;
+	float **LU = job->fs->factors->A;
+	float **X = job->X->A;
+	unsigned int n,i0,ib,r,c,first,cols;
+
+	n = job->fs->factors->n;
+	first = t*job->cols;
+	cols = (job->X->m - first < job->cols) ? job->X->m - first : job->cols;
 
-	/* iteration for total scaled pivoting and LU factorization */
-	for (i=1; i <= A->n; i++)
+	// LZ = X, one block row at a time
+	for (i0=0; i0 < n; i0 += LU_BLOCK)
 	{
-		r=0.;
-		// find scaled maximum of ith column
-		for (j=0; j < A->n; j++)
+		ib = (n - i0 < LU_BLOCK) ? n - i0 : LU_BLOCK;
+
+		// X_i = X_i - L[i][0..i0] Z[0..i0]
+		if (i0 > 0 && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, ib, cols, i0,
+					-1., LU+i0, 0, X, first, 1., X+i0, first) != 0)
 		{
-			if (r < A->A[j][i-1]/max->a[j])
-			{
-				r = A->A[j][i-1]/max->a[j];
-			}
+			__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+			return;
 		}
-		
-		// total scaled pivoting scheme
-		for (j=i; j < A->n+1; j++)
+		// then the unit lower triangle of the diagonal block
+		for (r=i0; r < i0+ib; r++)
 		{
-			for (k=i; k < A->n+1; k++)
+			for (c=i0; c < r; c++)
 			{
-				if (float_cmp(A->A[j-1][k-1]/max->a[j-1],r,1))
-				{
-					if (i < j)
-					{
-						row_swap_partial(A, i, j, i, A->n);
-						component_swap(bi, i, j);
-						row_swap_partial(LU, i, j, 1, i-1);
-						component_swap(max, i, j);
-					}
-					if (i < k)
-					{
-						col_swap_partial(A, i, k, i, A->n);
-						component_swap(xi, i, k);
-						col_swap_partial(LU, i, k, 1, i-1);
-					}
-				}
+				mathlib_kernels->axpy(cols, -LU[r][c], X[c]+first, X[r]+first);
+			}
+			if (job->fs->alpha != 1.)
+			{
+				mathlib_kernels->scal(cols, 1./job->fs->alpha, X[r]+first);
 			}
 		}
+	}
+
+	// UX = Z, from the bottom block row up
+	for (i0=((n-1)/LU_BLOCK)*LU_BLOCK; ; i0 -= LU_BLOCK)
+	{
+		ib = (n - i0 < LU_BLOCK) ? n - i0 : LU_BLOCK;
 
-		// Find diagonal LU[i][i] = beta
-		sum=0.;
-		for (j=1; j <= i-1; j++)
+		// Z_i = Z_i - U[i][i0+ib..n] X[i0+ib..n]
+		if (i0+ib < n && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, ib, cols,
+					n-i0-ib, -1., LU+i0, i0+ib, X+i0+ib, first, 1., X+i0, first) != 0)
 		{
-			sum+=LU->A[i-1][j-1]*LU->A[j-1][i-1];
+			__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+			return;
 		}
-		beta = A->A[i-1][i-1] - sum;
-
-		// matrix A is singular if this is true
-		if (float_cmp(A->A[i-1][i-1],sum,i))
+		// then the upper triangle of the diagonal block
+		for (r=i0+ib; r-- > i0; )
 		{
-			// need least squares
-			fprintf(stderr,"No unique solution\n");
-			if (factor < 0)
-			{
-				free_matrix(LU);
-				free_vector(xi);
-				free_vector(bi);
-				free_vector(max);
-			}
-			else
+			for (c=r+1; c < i0+ib; c++)
 			{
-				free_factor(factor);
+				mathlib_kernels->axpy(cols, -LU[r][c], X[c]+first, X[r]+first);
 			}
-			return -1;
+			mathlib_kernels->scal(cols, 1./LU[r][r], X[r]+first);
+		}
+
+		if (i0 == 0)
+		{
+			break;
 		}
+	}
+}
 
-		// set diagonal components
-		LU->A[i-1][i-1] = beta;
+// permute the rows of X in place by swapping along the cycles of p
+// gather moves row p[i] to row i, otherwise row i moves to row p[i]
+// returns 0 on success
+static int permute_rows(matrix X, uvector p, int gather)
+{
+	unsigned int i,j,tmp;
+	unsigned int *dest; // where the row currently at i belongs
 
-		// find off diagonal components of L and U
-		if (i < A->n)
+	if ((dest = uvector_allocate(X->n)) == NULL)
+	{
+		return 1;
+	}
+	for (i=0; i < X->n; i++)
+	{
+		if (gather)
 		{
-			for (j=i+1; j <= A->n; j++)
-			{
-				sum=0.;
-				sum2=0.;
-				for (k=1; k <= i-1; k++)
-				{
-					sum += LU->A[j-1][k-1]*LU->A[k-1][i-1];
-					sum2 += LU->A[i-1][k-1]*LU->A[k-1][j-1];
-				}
-				
-				LU->A[j-1][i-1] = (A->A[j-1][i-1] - sum)/LU->A[i-1][i-1];
-				LU->A[i-1][j-1] = (A->A[i-1][j-1] - sum2)/alpha;
-			}
+			dest[p->a[i]] = i;
+		}
+		else
+		{
+			dest[i] = p->a[i];
 		}
 	}
-	free_vector(max);
 
-	// new factorization
-	if (factor < 0)
+	for (i=0; i < X->n; i++)
 	{
-		// save these pointers in the factorizations list
-		factorizations[i_factorizations].system = A;
-		factorizations[i_factorizations].factors = LU;
-		factorizations[i_factorizations].x_permutation = xi;
-		factorizations[i_factorizations].b_permutation = bi;
-		factorizations[i_factorizations].alpha = alpha;
-		i_factorizations++;
+		while (dest[i] != i)
+		{
+			j = dest[i];
+			mathlib_kernels->swap(X->m, X->A[i], X->A[j]);
+			tmp = dest[j];
+			dest[j] = j;
+			dest[i] = tmp;
+		}
 	}
 
-	// return the factorizations index we just set
-	return i_factorizations-1;
+	free(dest);
+	return 0;
 }
 
-// solve linear system Ax=b
-void linear_solve(matrix A, vector x, vector b)
+// factor A into a new handle holding one reference
+// returns NULL if A is singular
+lu_handle lu_handle_factor(matrix A, int pivoting)
 {
-	unsigned int i;
-	int factor;
-	
+	lu_handle h;
+	int status;
+
 	if (A->n != A->m)
 	{
 		fprintf(stderr,"Matrix is not square\n");
-		return;
+		return NULL;
 	}
 
-	// this means we have not found a factor yet
-	factor=-1;
+	if ((h = calloc(1, sizeof(*h))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	h->pivoting = pivoting;
+	h->refs = 1;
+	h->fs.system = A;
+	h->fs.alpha = 1.;
 
-	// search for an existing factorization of matrix A
-	// this only compares the pointer! if A has changed
-	// since the last factorization, it must be refactored
-	// by calling lu_factor(A) manually
-	if (factorizations != NULL)
+	// to save space, we save both L and U in the same matrix
+	// except for the diagonal the nonzero entries are disjoint sets
+	// so we keep the diagonal of U in LU and alpha in the handle
+	if ((h->fs.factors = zero_matrix(A->n,A->n)) == NULL
+			|| (h->fs.x_permutation = new_uvector(&index_element, A->n, 1)) == NULL
+			|| (h->fs.b_permutation = new_uvector(&index_element, A->n, 1)) == NULL)
 	{
-		for (i=0; i < n_factorizations; i++)
-		{
-			if (factorizations[i].system == A)
-			{
-				factor=i;
-				break;
-			}
-		}
+		lu_handle_release(h);
+		return NULL;
 	}
 
-	// if A has not been factored yet now is the time
-	if (factor < 0)
+	// the factorization is computed in place on a copy of A
+	matrix_set(h->fs.factors, A);
+	if (pivoting == LU_TOTAL_PIVOTING)
+	{
+		status = lu_factor_total(h->fs.factors, h->fs.x_permutation,
+				h->fs.b_permutation);
+	}
+	else
+	{
+		status = lu_factor_blocked(h->fs.factors, h->fs.b_permutation);
+	}
+
+	if (status != 0)
 	{
-		if ((factor = lu_factor(A)) < 0)
+		// singular systems go to least_squares_solve() instead
+		if (status > 0)
 		{
-			return;
+			fprintf(stderr,"No unique solution\n");
 		}
+		lu_handle_release(h);
+		return NULL;
 	}
 
-	// find the solution of LUx=b
-	lu_solve(factor,x,b);
+	return h;
 }
 
-// free a factor from the factor list
-void free_factor(int factor)
+// take another reference to a factorization
+lu_handle lu_handle_retain(lu_handle h)
+{
+	__atomic_add_fetch(&h->refs, 1, __ATOMIC_RELAXED);
+	return h;
+}
+
+// drop a reference, the last one frees the factorization
+void lu_handle_release(lu_handle h)
 {
-	if (factorizations[factor].factors != NULL)
+	if (h == NULL || __atomic_sub_fetch(&h->refs, 1, __ATOMIC_ACQ_REL) != 0)
+	{
+		return;
+	}
+	if (h->fs.factors != NULL)
 	{
-		free_matrix(factorizations[factor].factors);
+		free_matrix(h->fs.factors);
 	}
-	if (factorizations[factor].x_permutation != NULL)
+	if (h->fs.x_permutation != NULL)
 	{
-		free_vector(factorizations[factor].x_permutation);
+		free_uvector(h->fs.x_permutation);
 	}
-	if (factorizations[factor].b_permutation != NULL)
+	if (h->fs.b_permutation != NULL)
 	{
-		free_vector(factorizations[factor].b_permutation);
+		free_uvector(h->fs.b_permutation);
 	}
-	factorizations[factor].system=NULL;
+	sparse_factors_free(h->sparse);
+	free(h);
 }
 
-// clean up the factor list
-void free_all_factors(void)
+// memory held by a factorization
+size_t lu_handle_bytes(lu_handle h)
 {
-	unsigned int i;
+	size_t n;
 
-	// free all factors
-	for (i=0; i < i_factorizations; i++)
+	if (h->sparse != NULL)
 	{
-		free_factor(i);
+		return sizeof(*h) + sparse_factors_bytes(h->sparse);
 	}
-	// free the factorization list itself
-	free(factorizations);
-	factorizations=NULL;
+	n = h->fs.factors->n;
+
+	return sizeof(*h) + sizeof(float)*n*h->fs.factors->ld + sizeof(unsigned int)*2*n;
+}
+
+// the factors and permutations of a handle
+struct factored_system * lu_handle_factors(lu_handle h)
+{
+	return &h->fs;
+}
+
+// factor matrix A into lower and upper triangular parts LU
+// with partial pivoting, see lu_factor_pivot()
+int lu_factor(matrix A)
+{
+	return lu_factor_pivot(A, LU_PARTIAL_PIVOTING);
+}
+
+// factor matrix A into lower and upper triangular parts PAQ=LU
+// if a factorization of A has already been done, it is replaced
+// by the new one under the same index, A itself is left untouched
+int lu_factor_pivot(matrix A, int pivoting)
+{
+	lu_handle h,old=NULL;
+	int factor;
+
+	// the work happens outside the lock, solvers using an
+	// old factorization of A keep it until they are done
+	h = lu_handle_factor(A, pivoting);
+
+	pthread_mutex_lock(&factor_lock);
+	factor = index_find(A);
+	if (h == NULL)
+	{
+		// a failed refactorization drops the stale one
+		if (factor >= 0)
+		{
+			old = factor_slots[factor];
+			factor_slots[factor] = NULL;
+			index_remove(A);
+		}
+		factor = -1;
+	}
+	else if (factor >= 0)
+	{
+		old = factor_slots[factor];
+		factor_slots[factor] = h;
+	}
+	else if ((factor = slot_alloc()) >= 0)
+	{
+		if (index_insert(A, factor) == 0)
+		{
+			factor_slots[factor] = h;
+		}
+		else
+		{
+			old = h;
+			factor = -1;
+		}
+	}
+	else
+	{
+		old = h;
+	}
+	pthread_mutex_unlock(&factor_lock);
+
+	lu_handle_release(old);
+
+	// return the factorizations index we just set
+	return factor;
+}
+
+// right-looking blocked LU with partial pivoting, PA=LU in place
+// each panel of LU_BLOCK columns is factored with rank-1 updates,
+// then the block row of U is solved for and the trailing matrix
+// gets a single rank-LU_BLOCK update through the GEMM engine
+// returns 0 on success, 1 if A is singular and -1 if out of memory
+int lu_factor_blocked(matrix LU, uvector bi)
+{
+	unsigned int n=LU->n;
+	unsigned int j,jb,c,r,p;
+	float pivot,l;
+	struct trsm_job job;
+
+	if (LU->flags & MATRIX_TRANSPOSED)
+	{
+		return lu_factor_transposed(LU, NULL, bi, LU_PARTIAL_PIVOTING);
+	}
+
+	for (j=0; j < n; j += LU_BLOCK)
+	{
+		jb = (n - j < LU_BLOCK) ? n - j : LU_BLOCK;
+
+		// factor the panel LU[j..n][j..j+jb]
+		for (c=j; c < j+jb; c++)
+		{
+			// find the largest pivot in this column
+			p = c;
+			pivot = fabsf(LU->A[c][c]);
+			for (r=c+1; r < n; r++)
+			{
+				if (fabsf(LU->A[r][c]) > pivot)
+				{
+					pivot = fabsf(LU->A[r][c]);
+					p = r;
+				}
+			}
+			if (pivot == 0.)
+			{
+				return 1;
+			}
+
+			// swap whole rows so L and the trailing matrix follow
+			if (p != c)
+			{
+				mathlib_kernels->swap(n, LU->A[c], LU->A[p]);
+				ucomponent_swap(bi, c+1, p+1);
+			}
+
+			// multipliers and the rank-1 update inside the panel
+			pivot = LU->A[c][c];
+			for (r=c+1; r < n; r++)
+			{
+				l = LU->A[r][c]/pivot;
+				LU->A[r][c] = l;
+				if (l != 0.)
+				{
+					mathlib_kernels->axpy(j+jb-c-1, -l, LU->A[c]+c+1, LU->A[r]+c+1);
+				}
+			}
+		}
+
+		if (j+jb >= n)
+		{
+			break;
+		}
+
+		// U12 = L11^-1 A12, split over column ranges
+		job.LU = LU;
+		job.j = j;
+		job.jb = jb;
+		job.first = j+jb;
+		job.cols = LU_TRSM_COLS;
+		parallel_for((n - job.first + job.cols - 1)/job.cols, &lu_trsm_task, &job);
+
+		// A22 = A22 - L21 U12
+		if (gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, n-j-jb, n-j-jb, jb,
+				-1., LU->A+j+jb, j, LU->A+j, j+jb, 1., LU->A+j+jb, j+jb) != 0)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// solve the unit lower triangular L11 U12 = A12 for one range of columns
+static void lu_trsm_task(void *arg, unsigned int t)
+{
+	struct trsm_job *job = arg;
+	unsigned int r,c,first,cols;
+	matrix LU = job->LU;
+
+	first = job->first + t*job->cols;
+	cols = (LU->m - first < job->cols) ? LU->m - first : job->cols;
+
+	for (r=job->j+1; r < job->j+job->jb; r++)
+	{
+		for (c=job->j; c < r; c++)
+		{
+			mathlib_kernels->axpy(cols, -LU->A[r][c], LU->A[c]+first, LU->A[r]+first);
+		}
+	}
+}
+
+// LU with total pivoting, PAQ=LU in place
+// every step takes the largest remaining element as the pivot
+// returns 0 on success and 1 if A is singular
+int lu_factor_total(matrix LU, uvector xi, uvector bi)
+{
+	unsigned int n=LU->n;
+	unsigned int c,r,k,p,q;
+	float pivot,l,tmp;
+
+	if (LU->flags & MATRIX_TRANSPOSED)
+	{
+		return lu_factor_transposed(LU, xi, bi, LU_TOTAL_PIVOTING);
+	}
+
+	for (c=0; c < n; c++)
+	{
+		// find the largest element of the trailing square
+		p = c;
+		q = c;
+		pivot = 0.;
+		for (r=c; r < n; r++)
+		{
+			for (k=c; k < n; k++)
+			{
+				if (fabsf(LU->A[r][k]) > pivot)
+				{
+					pivot = fabsf(LU->A[r][k]);
+					p = r;
+					q = k;
+				}
+			}
+		}
+		if (pivot == 0.)
+		{
+			return 1;
+		}
+
+		// move it to the diagonal
+		if (p != c)
+		{
+			mathlib_kernels->swap(n, LU->A[c], LU->A[p]);
+			ucomponent_swap(bi, c+1, p+1);
+		}
+		if (q != c)
+		{
+			for (r=0; r < n; r++)
+			{
+				tmp = LU->A[r][c];
+				LU->A[r][c] = LU->A[r][q];
+				LU->A[r][q] = tmp;
+			}
+			ucomponent_swap(xi, c+1, q+1);
+		}
+
+		// eliminate below the pivot
+		pivot = LU->A[c][c];
+		for (r=c+1; r < n; r++)
+		{
+			l = LU->A[r][c]/pivot;
+			LU->A[r][c] = l;
+			if (l != 0.)
+			{
+				mathlib_kernels->axpy(n-c-1, -l, LU->A[c]+c+1, LU->A[r]+c+1);
+			}
+		}
+	}
+
+	return 0;
+}
+
+// factor a transposed view in ordinary storage and copy the
+// factors back, the elimination runs along rows of storage
+static int lu_factor_transposed(matrix LU, uvector xi, uvector bi, int pivoting)
+{
+	matrix T;
+	int status;
+
+	if ((T = zero_matrix(LU->n, LU->m)) == NULL)
+	{
+		return -1;
+	}
+	matrix_set(T, LU);
+	if (pivoting == LU_TOTAL_PIVOTING)
+	{
+		status = lu_factor_total(T, xi, bi);
+	}
+	else
+	{
+		status = lu_factor_blocked(T, bi);
+	}
+	matrix_set(LU, T);
+	free_matrix(T);
+
+	return status;
+}
+
+// the factorization linear_solve() uses for A, holding a reference
+// for the caller, A is factored now if it hasn't been yet
+static lu_handle solve_handle(matrix A)
+{
+	lu_handle h=NULL;
+	int factor;
+
+	// search for an existing factorization of matrix A
+	// this only compares the pointer! if A has changed
+	// since the last factorization, it must be refactored
+	// by calling lu_factor(A) manually
+	pthread_mutex_lock(&factor_lock);
+	if ((factor = index_find(A)) >= 0)
+	{
+		h = lu_handle_retain(factor_slots[factor]);
+	}
+	pthread_mutex_unlock(&factor_lock);
+
+	// if A has not been factored yet now is the time
+	if (h == NULL && (factor = lu_factor(A)) >= 0)
+	{
+		pthread_mutex_lock(&factor_lock);
+		if ((unsigned int)factor < top_slot && factor_slots[factor] != NULL)
+		{
+			h = lu_handle_retain(factor_slots[factor]);
+		}
+		pthread_mutex_unlock(&factor_lock);
+	}
+	return h;
+}
+
+// solve linear system Ax=b
+void linear_solve(matrix A, vector x, vector b)
+{
+	lu_handle h;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Matrix is not square\n");
+		return;
+	}
+	if ((h = solve_handle(A)) == NULL)
+	{
+		return;
+	}
+
+	// find the solution of LUx=b
+	lu_handle_solve(h,x,b);
+	lu_handle_release(h);
+}
+
+// linear_solve() followed by up to steps of iterative refinement
+// and, if rcond isn't NULL, an estimate of the reciprocal condition
+int linear_solve_refined(matrix A, vector x, vector b, unsigned int steps,
+		float *rcond)
+{
+	lu_handle h;
+	int status;
+
+	if (rcond != NULL)
+	{
+		*rcond = 0.;
+	}
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Matrix is not square\n");
+		return 1;
+	}
+	if ((h = solve_handle(A)) == NULL)
+	{
+		return 1;
+	}
+
+	status = lu_handle_solve(h,x,b);
+	if (status == 0 && steps > 0)
+	{
+		status = lu_handle_refine(h,x,b,steps);
+	}
+	if (status == 0 && rcond != NULL)
+	{
+		*rcond = lu_handle_rcond(h);
+	}
+	lu_handle_release(h);
+	return status;
+}
+
+// rows of the system a handle was factored from
+static unsigned int handle_order(lu_handle h)
+{
+	return (h->sparse != NULL) ? sparse_factors_system(h->sparse)->n
+		: h->fs.factors->n;
+}
+
+// r = b - Ax with the sums accumulated in double, so the
+// corrections solved for from r are accurate to float precision
+static void residual(matrix A, vector x, vector b, vector r)
+{
+	unsigned int i,j;
+	double sum;
+
+	for (i=0; i < A->n; i++)
+	{
+		sum = b->a[i];
+		if (A->flags & MATRIX_TRANSPOSED)
+		{
+			for (j=0; j < A->m; j++)
+			{
+				sum -= (double)A->A[j][i]*x->a[j];
+			}
+		}
+		else
+		{
+			for (j=0; j < A->m; j++)
+			{
+				sum -= (double)A->A[i][j]*x->a[j];
+			}
+		}
+		r->a[i] = sum;
+	}
+}
+
+// x += LU\(b - Ax) until the corrections are at float roundoff or stop
+// shrinking, a correction larger than the last one is not applied
+int lu_handle_refine(lu_handle h, vector x, vector b, unsigned int steps)
+{
+	vector r;
+	unsigned int n=handle_order(h);
+	unsigned int i,k;
+	float norm,size,last=INFINITY;
+
+	if (n != x->n || n != b->n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((r = zero_vector(n)) == NULL)
+	{
+		return 1;
+	}
+
+	for (k=0; k < steps; k++)
+	{
+		if (h->sparse != NULL)
+		{
+			sparse_residual(sparse_factors_system(h->sparse), x->a, b->a, r->a);
+		}
+		else
+		{
+			residual(h->fs.system, x, b, r);
+		}
+		if (lu_handle_solve(h, r, r) != 0)
+		{
+			free_vector(r);
+			return 1;
+		}
+
+		norm = 0.;
+		for (i=0; i < n; i++)
+		{
+			norm = fmaxf(norm, fabsf(r->a[i]));
+		}
+		if (!(norm <= last))
+		{
+			break;
+		}
+		size = 0.;
+		for (i=0; i < n; i++)
+		{
+			x->a[i] += r->a[i];
+			size = fmaxf(size, fabsf(x->a[i]));
+		}
+		if (norm <= FLT_EPSILON*size || norm > 0.5f*last)
+		{
+			break;
+		}
+		last = norm;
+	}
+
+	free_vector(r);
+	return 0;
+}
+
+// solve (LU)^T z = z in place, the transposed factors are read
+// along their rows so each step is an axpy
+static void lu_solve_transposed(struct factored_system *fs, float *z)
+{
+	float **LU = fs->factors->A;
+	unsigned int n=fs->factors->n;
+	unsigned int i;
+
+	// U^T w = z
+	for (i=0; i < n; i++)
+	{
+		z[i] /= LU[i][i];
+		mathlib_kernels->axpy(n-i-1, -z[i], LU[i]+i+1, z+i+1);
+	}
+	// L^T z = w
+	for (i=n; i >= 1; i--)
+	{
+		z[i-1] /= fs->alpha;
+		mathlib_kernels->axpy(i-1, -z[i-1], LU[i-1], z);
+	}
+}
+
+// z = A^-T z, work holds n floats, returns 0 on success
+static int transposed_solve(lu_handle h, float *z, float *work)
+{
+	struct factored_system *fs = &h->fs;
+	unsigned int i,n;
+
+	if (h->sparse != NULL)
+	{
+		return sparse_factors_solve_transposed(h->sparse, z);
+	}
+
+	// z is put in the order of the columns of LU
+	// and comes back in the order of the rows
+	n = fs->factors->n;
+	for (i=0; i < n; i++)
+	{
+		work[i] = z[fs->x_permutation->a[i]];
+	}
+	lu_solve_transposed(fs, work);
+	for (i=0; i < n; i++)
+	{
+		z[fs->b_permutation->a[i]] = work[i];
+	}
+	return 0;
+}
+
+// an estimate of |A^-1|_1 by Hager's method, as refined by Higham in
+// FORTRAN codes for estimating the one-norm of a real or complex
+// matrix, with applications to condition estimation, each step is
+// a solve with A and one with A^T, so the cost is O(n^2)
+static double inverse_norm(lu_handle h, vector v, float *w)
+{
+	unsigned int n=v->n;
+	unsigned int i,k,j=0,last=0;
+	double est=0.,norm,ztx;
+	float big;
+
+	for (i=0; i < n; i++)
+	{
+		v->a[i] = 1.f/n;
+	}
+	for (k=0; k < LU_CONDEST_STEPS; k++)
+	{
+		// v = A^-1 v
+		if (lu_handle_solve(h, v, v) != 0)
+		{
+			return INFINITY;
+		}
+		norm = 0.;
+		for (i=0; i < n; i++)
+		{
+			norm += fabsf(v->a[i]);
+		}
+		if (k > 0 && norm <= est)
+		{
+			break;
+		}
+		est = norm;
+
+		// the gradient z = A^-T sign(v)
+		for (i=0; i < n; i++)
+		{
+			w[i] = (v->a[i] < 0.) ? -1.f : 1.f;
+		}
+		if (transposed_solve(h, w, w+n) != 0)
+		{
+			return INFINITY;
+		}
+
+		// stop once no unit vector looks steeper than this one
+		ztx = 0.;
+		big = 0.;
+		for (i=0; i < n; i++)
+		{
+			ztx += (k == 0) ? w[i]/n : 0.;
+			if (fabsf(w[i]) > big)
+			{
+				big = fabsf(w[i]);
+				j = i;
+			}
+		}
+		if (k > 0)
+		{
+			ztx = w[last];
+		}
+		if (big <= ztx || (k > 0 && j == last))
+		{
+			break;
+		}
+		last = j;
+		memset(v->a, 0, sizeof(*v->a)*n);
+		v->a[j] = 1.;
+	}
+
+	// an alternating vector catches matrices the iteration underestimates
+	for (i=0; i < n; i++)
+	{
+		v->a[i] = ((i & 1) ? -1.f : 1.f)*(1.f + (float)i/((n > 1) ? n-1 : 1));
+	}
+	if (lu_handle_solve(h, v, v) != 0)
+	{
+		return INFINITY;
+	}
+	norm = 0.;
+	for (i=0; i < n; i++)
+	{
+		norm += fabsf(v->a[i]);
+	}
+	return fmax(est, 2*norm/(3*n));
+}
+
+// 1/(|A|_1 |A^-1|_1) from the factors and the system they came from
+// 0 if the estimate can't be made or A is numerically singular
+float lu_handle_rcond(lu_handle h)
+{
+	matrix A = h->fs.system;
+	unsigned int n=handle_order(h);
+	unsigned int i,j;
+	vector v;
+	float *w;
+	double anorm=0.,ainv,*sums;
+
+	if ((v = zero_vector(n)) == NULL)
+	{
+		return 0.;
+	}
+	w = vector_allocate(2*n);
+	sums = calloc(n, sizeof(*sums));
+	if (w == NULL || sums == NULL)
+	{
+		perror("Error allocating memory");
+		free(w);
+		free(sums);
+		free_vector(v);
+		return 0.;
+	}
+
+	// the largest column sum, accumulated along the rows of A
+	if (h->sparse != NULL)
+	{
+		anorm = sparse_norm1(sparse_factors_system(h->sparse));
+	}
+	else
+	{
+		for (i=0; i < A->n; i++)
+		{
+			for (j=0; j < A->m; j++)
+			{
+				sums[j] += fabsf((A->flags & MATRIX_TRANSPOSED) ? A->A[j][i] : A->A[i][j]);
+			}
+		}
+		for (j=0; j < A->m; j++)
+		{
+			anorm = fmax(anorm, sums[j]);
+		}
+	}
+
+	ainv = inverse_norm(h, v, w);
+
+	free(sums);
+	free(w);
+	free_vector(v);
+	if (anorm == 0. || !isfinite(ainv) || ainv == 0.)
+	{
+		return 0.;
+	}
+	return 1./(anorm*ainv);
+}
+
+// det A, sign*exp(logdet) in double so only the result can overflow
+// 0 if A is singular, NaN if the sign can't be found
+float lu_handle_det(lu_handle h)
+{
+	double logdet;
+	int sign;
+
+	logdet = lu_handle_logdet(h, &sign);
+	if (sign == 0)
+	{
+		return isnan(logdet) ? NAN : 0.;
+	}
+	return sign*exp(logdet);
+}
+
+// log|det A| summed from the diagonal of U, which never overflows
+// where the product would, det A = sign*exp(logdet) if sign isn't NULL
+// -INFINITY and a sign of 0 if A is singular
+double lu_handle_logdet(lu_handle h, int *sign)
+{
+	struct factored_system *fs = &h->fs;
+	double logdet;
+	unsigned int i,n;
+	int s;
+	float u;
+
+	if (h->sparse != NULL)
+	{
+		return sparse_factors_logdet(h->sparse, sign);
+	}
+
+	n = fs->factors->n;
+	s = permutation_sign(n, fs->b_permutation->a)
+		*permutation_sign(n, fs->x_permutation->a);
+	if (s == 0)
+	{
+		if (sign != NULL)
+		{
+			*sign = 0;
+		}
+		return NAN;
+	}
+
+	// the diagonal of L is alpha
+	logdet = n*log(fabs(fs->alpha));
+	if (fs->alpha < 0. && n % 2 == 1)
+	{
+		s = -s;
+	}
+	for (i=0; i < n; i++)
+	{
+		u = fs->factors->A[i][i];
+		if (u == 0.)
+		{
+			s = 0;
+			logdet = -INFINITY;
+			break;
+		}
+		if (u < 0.)
+		{
+			s = -s;
+		}
+		logdet += log(fabsf(u));
+	}
+	if (sign != NULL)
+	{
+		*sign = s;
+	}
+	return logdet;
+}
+
+// X = A^-1 = Q U^-1 L^-1 P in place of a copy of the factors, U is
+// inverted first then L from the last block column to the first, as in
+// LAPACK's getri, with the bulk of the work in matrix multiplications
+int lu_handle_inverse(lu_handle h, matrix X)
+{
+	struct factored_system *fs = &h->fs;
+	struct inverse_job job;
+	unsigned int i,c,j,jb,J,Jb,n=handle_order(h);
+	int status;
+	matrix T,W;
+
+	if (X->n != n || X->m != n)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+
+	// the inverse of a sparse matrix is dense anyway
+	if (h->sparse != NULL)
+	{
+		matrix_set_identity(X);
+		return lu_solve_many(h, X, X);
+	}
+
+	if (X->flags & MATRIX_TRANSPOSED)
+	{
+		if ((T = zero_matrix(n, n)) == NULL)
+		{
+			return 1;
+		}
+		if ((status = lu_handle_inverse(h, T)) == 0)
+		{
+			matrix_set(X, T);
+		}
+		free_matrix(T);
+		return status;
+	}
+
+	for (i=0; i < n; i++)
+	{
+		if (fs->factors->A[i][i] == 0.)
+		{
+			fprintf(stderr,"No unique solution\n");
+			return 1;
+		}
+	}
+	if ((W = zero_matrix(n, LU_INVERSE_COLS)) == NULL)
+	{
+		return 1;
+	}
+	matrix_set(X, fs->factors);
+
+	job.X = X->A;
+	job.W = W->A;
+	job.n = n;
+	job.alpha = fs->alpha;
+	job.failed = 0;
+	if (invert_upper(&job) != 0)
+	{
+		free_matrix(W);
+		return 1;
+	}
+
+	// solve X L = U^-1 from the last block column to the first, each
+	// LU_INVERSE_COLS columns of L are applied by one multiplication
+	// and then solved for LU_BLOCK columns at a time
+	for (J=(n-1)/LU_INVERSE_COLS*LU_INVERSE_COLS; ; J -= LU_INVERSE_COLS)
+	{
+		Jb = (n-J < LU_INVERSE_COLS) ? n-J : LU_INVERSE_COLS;
+		// L's block column moves to W leaving U^-1 above it
+		for (i=J+1; i < n; i++)
+		{
+			for (c=J; c < J+Jb && c < i; c++)
+			{
+				W->A[i][c-J] = X->A[i][c];
+				X->A[i][c] = 0.;
+			}
+		}
+		if (J+Jb < n && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, n, Jb,
+					n-J-Jb, -1., X->A, J+Jb, W->A+J+Jb, 0, 1., X->A, J) != 0)
+		{
+			free_matrix(W);
+			return 1;
+		}
+		for (j=J+(Jb-1)/LU_BLOCK*LU_BLOCK; ; j -= LU_BLOCK)
+		{
+			jb = (J+Jb-j < LU_BLOCK) ? J+Jb-j : LU_BLOCK;
+			if (j+jb < J+Jb && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, n, jb,
+						J+Jb-j-jb, -1., X->A, j+jb, W->A+j+jb, j-J, 1., X->A, j) != 0)
+			{
+				free_matrix(W);
+				return 1;
+			}
+			job.j = j;
+			job.jb = jb;
+			job.jw = j-J;
+			parallel_for((n + LU_BLOCK - 1)/LU_BLOCK, &lower_task, &job);
+			if (j == J)
+			{
+				break;
+			}
+		}
+		if (J == 0)
+		{
+			break;
+		}
+	}
+	free_matrix(W);
+
+	return unpermute(fs, X->A, n);
+}
+
+// the sign of a permutation from the lengths of its cycles,
+// 0 if it can't be found
+int permutation_sign(unsigned int n, const unsigned int *p)
+{
+	unsigned char *seen;
+	unsigned int i,j;
+	int s=1;
+
+	if (n == 0)
+	{
+		return 1;
+	}
+	if ((seen = calloc(n, sizeof(*seen))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 0;
+	}
+	for (i=0; i < n; i++)
+	{
+		if (seen[i])
+		{
+			continue;
+		}
+		// a cycle of length l is l-1 transpositions
+		for (j=p[i]; j != i; j=p[j])
+		{
+			seen[j] = 1;
+			s = -s;
+		}
+		seen[i] = 1;
+	}
+	free(seen);
+	return s;
+}
+
+// the upper triangle of X becomes U^-1 a block column at a time,
+// the columns above the diagonal block are U^-1(0:j,0:j) U(0:j,j:j+jb)
+// solved against -U(j:j+jb,j:j+jb) on the thread pool, as in LAPACK's trtri
+// returns 0 on success
+static int invert_upper(struct inverse_job *job)
+{
+	float **X = job->X;
+	unsigned int r,l,c,j,jb;
+	double sum;
+	float ajj;
+
+	for (j=0; j < job->n; j += LU_BLOCK)
+	{
+		jb = (job->n-j < LU_BLOCK) ? job->n-j : LU_BLOCK;
+		if (j > 0)
+		{
+			job->j = j;
+			job->jb = jb;
+			parallel_for((j + LU_BLOCK - 1)/LU_BLOCK, &upper_task, job);
+			if (job->failed)
+			{
+				return 1;
+			}
+			for (r=0; r < j; r++)
+			{
+				memcpy(X[r]+j, job->W[r], sizeof(**X)*jb);
+			}
+		}
+
+		// the diagonal block by columns, from LAPACK's trti2
+		for (c=j; c < j+jb; c++)
+		{
+			X[c][c] = 1./X[c][c];
+			ajj = -X[c][c];
+			// rows above only read the rows below them
+			for (r=j; r < c; r++)
+			{
+				sum = 0.;
+				for (l=r; l < c; l++)
+				{
+					sum += X[r][l]*X[l][c];
+				}
+				X[r][c] = ajj*sum;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// rows t*LU_BLOCK.. of the block column above the diagonal into W
+static void upper_task(void *arg, unsigned int t)
+{
+	struct inverse_job *job = arg;
+	float **X = job->X;
+	float **W = job->W;
+	unsigned int j=job->j,jb=job->jb;
+	unsigned int r,l,r0,r1;
+	float *y;
+
+	r0 = t*LU_BLOCK;
+	r1 = (j-r0 < LU_BLOCK) ? j : r0+LU_BLOCK;
+
+	// the triangle of U^-1 in these rows, then the square to its right
+	for (r=r0; r < r1; r++)
+	{
+		memset(W[r], 0, sizeof(**W)*jb);
+		for (l=r; l < r1; l++)
+		{
+			mathlib_kernels->axpy(jb, X[r][l], X[l]+j, W[r]);
+		}
+	}
+	if (r1 < j && gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, r1-r0, jb, j-r1,
+				1., X+r0, r1, X+r1, j, 1., W+r0, 0) != 0)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	// Y U(j:j+jb,j:j+jb) = -W along each row
+	for (r=r0; r < r1; r++)
+	{
+		y = W[r];
+		for (l=0; l < jb; l++)
+		{
+			y[l] /= X[j+l][j+l];
+			mathlib_kernels->axpy(jb-l-1, -y[l], X[j+l]+j+l+1, y+l+1);
+		}
+		mathlib_kernels->scal(jb, -1., y);
+	}
+}
+
+// rows t*LU_BLOCK.. of X(:,j:j+jb) L(j:j+jb,j:j+jb)^-1, L's diagonal
+// block is in W(j:j+jb,jw:jw+jb)
+static void lower_task(void *arg, unsigned int t)
+{
+	struct inverse_job *job = arg;
+	unsigned int j=job->j,jb=job->jb;
+	unsigned int r,l,r0,r1;
+	float *x;
+
+	r0 = t*LU_BLOCK;
+	r1 = (job->n-r0 < LU_BLOCK) ? job->n : r0+LU_BLOCK;
+	for (r=r0; r < r1; r++)
+	{
+		x = job->X[r]+j;
+		for (l=jb; l >= 1; l--)
+		{
+			x[l-1] /= job->alpha;
+			mathlib_kernels->axpy(l-1, -x[l-1], job->W[j+l-1]+job->jw, x);
+		}
+	}
+}
+
+// (LU)^-1 to A^-1, element (i,k) goes to (x_permutation[i],b_permutation[k])
+static int unpermute(struct factored_system *fs, float **X, unsigned int n)
+{
+	unsigned int *bp = fs->b_permutation->a;
+	unsigned int *xp = fs->x_permutation->a;
+	unsigned int i,k;
+	unsigned char *seen;
+	float *w;
+
+	w = vector_allocate(n);
+	seen = calloc(n, sizeof(*seen));
+	if (w == NULL || seen == NULL)
+	{
+		perror("Error allocating memory");
+		free(w);
+		free(seen);
+		return 1;
+	}
+
+	for (i=0; i < n; i++)
+	{
+		for (k=0; k < n; k++)
+		{
+			w[bp[k]] = X[i][k];
+		}
+		memcpy(X[i], w, sizeof(*w)*n);
+	}
+
+	// the rows follow the cycles of x_permutation, each row swapped
+	// through w into its place
+	for (i=0; i < n; i++)
+	{
+		if (seen[i] || xp[i] == i)
+		{
+			continue;
+		}
+		memcpy(w, X[i], sizeof(*w)*n);
+		for (k=xp[i]; ; k=xp[k])
+		{
+			mathlib_kernels->swap(n, w, X[k]);
+			seen[k] = 1;
+			if (k == i)
+			{
+				break;
+			}
+		}
+	}
+
+	free(w);
+	free(seen);
+	return 0;
+}
+
+// free a factor from the factor list
+void free_factor(int factor)
+{
+	lu_handle h=NULL;
+
+	pthread_mutex_lock(&factor_lock);
+	if (factor >= 0 && (unsigned int)factor < top_slot
+			&& (h = factor_slots[factor]) != NULL)
+	{
+		index_remove(h->fs.system);
+		factor_slots[factor] = NULL;
+	}
+	pthread_mutex_unlock(&factor_lock);
+
+	lu_handle_release(h);
+}
+
+// clean up the factor list
+void free_all_factors(void)
+{
+	unsigned int i;
+	struct factor_index *e,*next;
+
+	pthread_mutex_lock(&factor_lock);
+
+	// free all factors
+	for (i=0; i < top_slot; i++)
+	{
+		lu_handle_release(factor_slots[i]);
+	}
+	// free the factorization list itself
+	free(factor_slots);
+	factor_slots=NULL;
+	n_slots=0;
+	top_slot=0;
+
+	// and its index
+	for (i=0; i < n_buckets; i++)
+	{
+		for (e=index_buckets[i]; e != NULL; e=next)
+		{
+			next = e->next;
+			free(e);
+		}
+	}
+	free(index_buckets);
+	index_buckets=NULL;
+	n_buckets=0;
+	n_indexed=0;
+
+	pthread_mutex_unlock(&factor_lock);
+}
+
+// index of the factorization of A, or -1
+static int index_find(matrix A)
+{
+	struct factor_index *e;
+
+	if (n_buckets == 0)
+	{
+		return -1;
+	}
+	for (e=index_buckets[lu_hash(A) & (n_buckets-1)]; e != NULL; e=e->next)
+	{
+		if (e->A == A)
+		{
+			return e->slot;
+		}
+	}
+	return -1;
+}
+
+// remember that A is factored in slot, returns 0 on success
+// the buckets double whenever there are more entries than buckets
+static int index_insert(matrix A, unsigned int slot)
+{
+	struct factor_index **buckets,*e,*next;
+	unsigned int i,size;
+
+	if (n_indexed >= n_buckets)
+	{
+		size = (n_buckets > 0) ? 2*n_buckets : 16;
+		if ((buckets = calloc(size, sizeof(*buckets))) == NULL)
+		{
+			perror("Error allocating memory");
+			return 1;
+		}
+		for (i=0; i < n_buckets; i++)
+		{
+			for (e=index_buckets[i]; e != NULL; e=next)
+			{
+				next = e->next;
+				e->next = buckets[lu_hash(e->A) & (size-1)];
+				buckets[lu_hash(e->A) & (size-1)] = e;
+			}
+		}
+		free(index_buckets);
+		index_buckets = buckets;
+		n_buckets = size;
+	}
+
+	if ((e = malloc(sizeof(*e))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	e->A = A;
+	e->slot = slot;
+	e->next = index_buckets[lu_hash(A) & (n_buckets-1)];
+	index_buckets[lu_hash(A) & (n_buckets-1)] = e;
+	n_indexed++;
+	return 0;
+}
+
+// forget the factorization of A
+static void index_remove(matrix A)
+{
+	struct factor_index **p,*e;
+
+	if (n_buckets == 0)
+	{
+		return;
+	}
+	for (p=&index_buckets[lu_hash(A) & (n_buckets-1)]; *p != NULL; p=&(*p)->next)
+	{
+		if ((*p)->A == A)
+		{
+			e = *p;
+			*p = e->next;
+			free(e);
+			n_indexed--;
+			return;
+		}
+	}
+}
+
+// find an unused slot in the factorization table, growing it if needed
+static int slot_alloc(void)
+{
+	lu_handle *slots;
+	unsigned int i,size;
+
+	if (top_slot < n_slots)
+	{
+		return top_slot++;
+	}
+
+	// reuse the index of a freed factorization
+	for (i=0; i < top_slot; i++)
+	{
+		if (factor_slots[i] == NULL)
+		{
+			return i;
+		}
+	}
+
+	size = (n_slots > 0) ? 2*n_slots : 16;
+	if ((slots = realloc(factor_slots, sizeof(*slots)*size)) == NULL)
+	{
+		fprintf(stderr,"Couldn't grow factorizations list\n");
+		return -1;
+	}
+	factor_slots = slots;
+	n_slots = size;
+	return top_slot++;
 }
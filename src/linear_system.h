@@ -7,8 +7,20 @@
 
 #include "matrix.h"
 #include "vector.h"
+#include "uvector.h"
 #include "float_cmp.h"
 
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+// pivoting strategies for lu_factor_pivot
+#define LU_PARTIAL_PIVOTING 0 // row interchanges, PA=LU
+#define LU_TOTAL_PIVOTING 1 // row and column interchanges, PAQ=LU
+
+// width of the panels of the blocked factorization
+#define LU_BLOCK 64
+
 // a list of things relevant to an LU factorization Ax=LUx=b
 struct factored_system
 {
@@ -16,18 +28,38 @@ struct factored_system
 	matrix system;
 	// its LU factorization in 1 matrix
 	matrix factors;
-	// pivoting for x
-	vector x_permutation;
-	// pivoting for b
-	vector b_permutation;
+	// pivoting for x, row i of the solution of LU is x[x_permutation[i]]
+	uvector x_permutation;
+	// pivoting for b, row i of LU is row b_permutation[i] of the system
+	uvector b_permutation;
 	// this value is the diagonals of L (usually 1.)
 	float alpha;
 };
 
-// a list of factored systems
-extern struct factored_system *factorizations;
-extern unsigned int n_factorizations; // maximum number of factorizations
-extern unsigned int i_factorizations; // current number of factorizations
+// the factors of a sparse matrix, see sparse_lu.h
+struct sparse_factors;
+
+// an LU factorization shared by everybody solving against it
+// it is never modified once factored, so any number of threads
+// may solve with it at the same time
+struct lu_factorization
+{
+	struct factored_system fs;
+	int pivoting; // LU_PARTIAL_PIVOTING or LU_TOTAL_PIVOTING
+	unsigned int refs; // references held, the last release frees it
+	struct sparse_factors *sparse; // set instead of fs by sparse_lu_factor()
+};
+typedef struct lu_factorization *lu_handle;
+
+// spread matrix pointers over hash buckets
+static inline unsigned long lu_hash(matrix A)
+{
+	unsigned long h = (unsigned long)A;
+
+	h ^= h >> 17;
+	h *= 0x9e3779b1UL;
+	return h ^ (h >> 15);
+}
 
 // directly solve lower triangular system Lx=b
 extern void forward_substitution(matrix L, vector x, vector b);
@@ -37,8 +69,49 @@ extern void backward_substitution(matrix U, vector x, vector b);
 extern void lu_solve(int f, vector x, vector b);
 // generate an LU factorization, return factorizations index
 extern int lu_factor(matrix A);
+// same with a choice of pivoting strategy
+extern int lu_factor_pivot(matrix A, int pivoting);
+// in place factorizations of a square matrix, return 0 on success,
+// 1 if it is singular and -1 if out of memory
+extern int lu_factor_blocked(matrix LU, uvector bi);
+extern int lu_factor_total(matrix LU, uvector xi, uvector bi);
 // general method to solve a linear system Ax=b
 extern void linear_solve(matrix A, vector x, vector b);
+// the same, followed by up to steps of iterative refinement with the
+// residual computed in double, and if rcond isn't NULL an estimate of
+// 1/cond_1(A), a solution has about -log10(rcond) fewer accurate digits
+// than a float, returns 0 on success
+extern int linear_solve_refined(matrix A, vector x, vector b,
+		unsigned int steps, float *rcond);
+
+// factor A into a new handle holding one reference, NULL on failure
+extern lu_handle lu_handle_factor(matrix A, int pivoting);
+// take and drop references, the last release frees the factorization
+extern lu_handle lu_handle_retain(lu_handle h);
+extern void lu_handle_release(lu_handle h);
+// direct solution of LUx=b, returns 0 on success
+extern int lu_handle_solve(lu_handle h, vector x, vector b);
+// solve LUX=B for every column of B at once, X may be B
+extern int lu_solve_many(lu_handle h, matrix B, matrix X);
+// memory held by a factorization
+extern size_t lu_handle_bytes(lu_handle h);
+// the factors and permutations of a handle, factors is NULL
+// for a handle from sparse_lu_factor()
+extern struct factored_system * lu_handle_factors(lu_handle h);
+// refine a solution of Ax=b against the system h was factored from,
+// which must still be unchanged, returns 0 on success
+extern int lu_handle_refine(lu_handle h, vector x, vector b,
+		unsigned int steps);
+// 1/cond_1(A) estimated in O(n^2) from the factors, 0 if A is singular
+extern float lu_handle_rcond(lu_handle h);
+// det A from the factors in O(n), 0 if A is singular, and its log
+// which can't overflow, det A = sign*exp(logdet), sign may be NULL
+extern float lu_handle_det(lu_handle h);
+extern double lu_handle_logdet(lu_handle h, int *sign);
+// A^-1 into the n x n X, returns 0 on success
+extern int lu_handle_inverse(lu_handle h, matrix X);
+// 1 or -1 for an even or odd permutation of 0..n-1, 0 if out of memory
+extern int permutation_sign(unsigned int n, const unsigned int *p);
 // cleanup
 extern void free_factor(int factor);
 extern void free_all_factors(void);
@@ -0,0 +1,335 @@
+/* Cache of LU factorizations
+ * Oct 18 2026 */
+
+#include "lu_cache.h"
+
+// one cached factorization
+struct lu_cache_entry
+{
+	matrix A;
+	unsigned long generation;
+	lu_handle h; // NULL while it is being factored
+	size_t bytes;
+	struct lu_cache_entry *chain; // next in this hash bucket
+	struct lu_cache_entry *newer; // least recently used list
+	struct lu_cache_entry *older;
+};
+
+struct lu_cache
+{
+	pthread_mutex_t lock;
+	pthread_cond_t factored; // signalled when a pending entry resolves
+	size_t budget; // 0 means no limit
+	size_t bytes;
+	// entries hashed on the matrix pointer only, so all
+	// generations of a matrix share a bucket
+	struct lu_cache_entry **buckets;
+	unsigned int n_buckets; // a power of 2
+	unsigned int count;
+	// factored entries, most recently used first
+	struct lu_cache_entry *newest;
+	struct lu_cache_entry *oldest;
+};
+
+lu_cache lu_cache_create(size_t budget);
+lu_handle lu_cache_get(lu_cache c, matrix A, unsigned long generation,
+		int pivoting);
+void lu_cache_invalidate(lu_cache c, matrix A);
+void lu_cache_set_budget(lu_cache c, size_t budget);
+size_t lu_cache_bytes(lu_cache c);
+void lu_cache_destroy(lu_cache c);
+
+// the helpers below are called with the cache locked
+static struct lu_cache_entry * cache_find(lu_cache c, matrix A,
+		unsigned long generation);
+static int cache_insert(lu_cache c, struct lu_cache_entry *e);
+static void cache_unlink(lu_cache c, struct lu_cache_entry *e);
+static void lru_push(lu_cache c, struct lu_cache_entry *e);
+static void lru_remove(lu_cache c, struct lu_cache_entry *e);
+static void cache_drop(lu_cache c, struct lu_cache_entry *e);
+static void cache_evict(lu_cache c, struct lu_cache_entry *keep);
+
+// Set up an empty cache
+lu_cache lu_cache_create(size_t budget)
+{
+	lu_cache c;
+
+	if ((c = calloc(1, sizeof(*c))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	c->n_buckets = 16;
+	if ((c->buckets = calloc(c->n_buckets, sizeof(*c->buckets))) == NULL)
+	{
+		perror("Error allocating memory");
+		free(c);
+		return NULL;
+	}
+	c->budget = budget;
+	pthread_mutex_init(&c->lock, NULL);
+	pthread_cond_init(&c->factored, NULL);
+
+	return c;
+}
+
+// the entry for A at generation, or NULL
+static struct lu_cache_entry * cache_find(lu_cache c, matrix A,
+		unsigned long generation)
+{
+	struct lu_cache_entry *e;
+
+	for (e = c->buckets[lu_hash(A) & (c->n_buckets-1)]; e != NULL; e = e->chain)
+	{
+		if (e->A == A && e->generation == generation)
+		{
+			return e;
+		}
+	}
+	return NULL;
+}
+
+// add an entry to the hash table, doubling it when it fills up
+static int cache_insert(lu_cache c, struct lu_cache_entry *e)
+{
+	struct lu_cache_entry **buckets,*f,*next;
+	unsigned int i,size,b;
+
+	if (c->count >= c->n_buckets)
+	{
+		size = 2*c->n_buckets;
+		if ((buckets = calloc(size, sizeof(*buckets))) == NULL)
+		{
+			perror("Error allocating memory");
+			return 1;
+		}
+		for (i = 0; i < c->n_buckets; i++)
+		{
+			for (f = c->buckets[i]; f != NULL; f = next)
+			{
+				next = f->chain;
+				b = lu_hash(f->A) & (size-1);
+				f->chain = buckets[b];
+				buckets[b] = f;
+			}
+		}
+		free(c->buckets);
+		c->buckets = buckets;
+		c->n_buckets = size;
+	}
+
+	b = lu_hash(e->A) & (c->n_buckets-1);
+	e->chain = c->buckets[b];
+	c->buckets[b] = e;
+	c->count++;
+	return 0;
+}
+
+// take an entry out of the hash table
+static void cache_unlink(lu_cache c, struct lu_cache_entry *e)
+{
+	struct lu_cache_entry **p;
+
+	for (p = &c->buckets[lu_hash(e->A) & (c->n_buckets-1)]; *p != NULL; p = &(*p)->chain)
+	{
+		if (*p == e)
+		{
+			*p = e->chain;
+			c->count--;
+			return;
+		}
+	}
+}
+
+// make e the most recently used entry
+static void lru_push(lu_cache c, struct lu_cache_entry *e)
+{
+	e->newer = NULL;
+	e->older = c->newest;
+	if (c->newest != NULL)
+	{
+		c->newest->newer = e;
+	}
+	c->newest = e;
+	if (c->oldest == NULL)
+	{
+		c->oldest = e;
+	}
+}
+
+// take e out of the least recently used list
+static void lru_remove(lu_cache c, struct lu_cache_entry *e)
+{
+	if (e->newer != NULL)
+	{
+		e->newer->older = e->older;
+	}
+	else
+	{
+		c->newest = e->older;
+	}
+	if (e->older != NULL)
+	{
+		e->older->newer = e->newer;
+	}
+	else
+	{
+		c->oldest = e->newer;
+	}
+	e->newer = NULL;
+	e->older = NULL;
+}
+
+// remove a factored entry, solvers holding its handle keep it alive
+static void cache_drop(lu_cache c, struct lu_cache_entry *e)
+{
+	cache_unlink(c, e);
+	lru_remove(c, e);
+	c->bytes -= e->bytes;
+	lu_handle_release(e->h);
+	free(e);
+}
+
+// evict least recently used entries until the cache fits its budget
+// keep is never evicted, even if it alone is over budget
+static void cache_evict(lu_cache c, struct lu_cache_entry *keep)
+{
+	while (c->budget > 0 && c->bytes > c->budget
+			&& c->oldest != NULL && c->oldest != keep)
+	{
+		cache_drop(c, c->oldest);
+	}
+}
+
+// the factorization of A at this generation
+// concurrent misses on the same key wait for a single factorization
+lu_handle lu_cache_get(lu_cache c, matrix A, unsigned long generation,
+		int pivoting)
+{
+	struct lu_cache_entry *e,*f,*next;
+	lu_handle h;
+	unsigned int b;
+
+	pthread_mutex_lock(&c->lock);
+	while ((e = cache_find(c, A, generation)) != NULL && e->h == NULL)
+	{
+		// somebody else is factoring it
+		pthread_cond_wait(&c->factored, &c->lock);
+	}
+	if (e != NULL)
+	{
+		// hit
+		lru_remove(c, e);
+		lru_push(c, e);
+		h = lu_handle_retain(e->h);
+		pthread_mutex_unlock(&c->lock);
+		return h;
+	}
+
+	// miss, leave a pending entry while we factor without the lock
+	if ((e = calloc(1, sizeof(*e))) == NULL)
+	{
+		perror("Error allocating memory");
+		pthread_mutex_unlock(&c->lock);
+		return NULL;
+	}
+	e->A = A;
+	e->generation = generation;
+	if (cache_insert(c, e) != 0)
+	{
+		free(e);
+		pthread_mutex_unlock(&c->lock);
+		return NULL;
+	}
+	pthread_mutex_unlock(&c->lock);
+
+	h = lu_handle_factor(A, pivoting);
+
+	pthread_mutex_lock(&c->lock);
+	if (h == NULL)
+	{
+		cache_unlink(c, e);
+		free(e);
+		pthread_cond_broadcast(&c->factored);
+		pthread_mutex_unlock(&c->lock);
+		return NULL;
+	}
+
+	e->h = h;
+	e->bytes = lu_handle_bytes(h);
+	c->bytes += e->bytes;
+	lru_push(c, e);
+
+	// other generations of A are stale now
+	b = lu_hash(A) & (c->n_buckets-1);
+	for (f = c->buckets[b]; f != NULL; f = next)
+	{
+		next = f->chain;
+		if (f->A == A && f != e && f->h != NULL)
+		{
+			cache_drop(c, f);
+		}
+	}
+
+	cache_evict(c, e);
+	h = lu_handle_retain(h);
+	pthread_cond_broadcast(&c->factored);
+	pthread_mutex_unlock(&c->lock);
+
+	return h;
+}
+
+// drop every factorization of A
+void lu_cache_invalidate(lu_cache c, matrix A)
+{
+	struct lu_cache_entry *e,*next;
+
+	pthread_mutex_lock(&c->lock);
+	for (e = c->buckets[lu_hash(A) & (c->n_buckets-1)]; e != NULL; e = next)
+	{
+		next = e->chain;
+		if (e->A == A && e->h != NULL)
+		{
+			cache_drop(c, e);
+		}
+	}
+	pthread_mutex_unlock(&c->lock);
+}
+
+// change the budget, evicting as needed
+void lu_cache_set_budget(lu_cache c, size_t budget)
+{
+	pthread_mutex_lock(&c->lock);
+	c->budget = budget;
+	cache_evict(c, NULL);
+	pthread_mutex_unlock(&c->lock);
+}
+
+// memory held by the cached factorizations
+size_t lu_cache_bytes(lu_cache c)
+{
+	size_t bytes;
+
+	pthread_mutex_lock(&c->lock);
+	bytes = c->bytes;
+	pthread_mutex_unlock(&c->lock);
+
+	return bytes;
+}
+
+// release all cached factorizations and the cache itself
+void lu_cache_destroy(lu_cache c)
+{
+	if (c == NULL)
+	{
+		return;
+	}
+	while (c->oldest != NULL)
+	{
+		cache_drop(c, c->oldest);
+	}
+	pthread_cond_destroy(&c->factored);
+	pthread_mutex_destroy(&c->lock);
+	free(c->buckets);
+	free(c);
+}
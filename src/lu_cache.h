@@ -0,0 +1,33 @@
+/* Cache of LU factorizations
+ * Oct 18 2026 */
+
+#ifndef LU_CACHE_H
+#define LU_CACHE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "linear_system.h"
+
+// factorizations keyed by matrix and generation, evicted least
+// recently used first once they take more memory than the budget
+typedef struct lu_cache *lu_cache;
+
+// a budget of 0 bytes means no limit
+extern lu_cache lu_cache_create(size_t budget);
+// the factorization of A at this generation, factored on a miss
+// the handle returned holds a reference for the caller to release
+// bumping the generation after changing A makes the old one stale
+extern lu_handle lu_cache_get(lu_cache c, matrix A, unsigned long generation,
+		int pivoting);
+// drop every factorization of A
+extern void lu_cache_invalidate(lu_cache c, matrix A);
+// change the budget, evicting as needed
+extern void lu_cache_set_budget(lu_cache c, size_t budget);
+// memory held by the cached factorizations
+extern size_t lu_cache_bytes(lu_cache c);
+// release all cached factorizations, nobody may be using the cache
+extern void lu_cache_destroy(lu_cache c);
+
+#endif
@@ -15,6 +15,15 @@
 // floating point comparison
 extern int float_cmp(float a, float b, int n);
 
+// name of the vector kernels picked for this cpu (scalar, sse2, avx2, avx512)
+// set MATHLIB_ISA to one of these to force a narrower instruction set
+extern const char * mathlib_isa(void);
+
+// threads used by the parallel routines, including the calling thread
+// defaults to MATHLIB_NUM_THREADS or the number of online cpus, 0 restores that
+extern void mathlib_set_threads(unsigned int n);
+extern unsigned int mathlib_get_threads(void);
+
 // vector stuff
 // Store dimensions and offsets with a matrix
 typedef struct
@@ -22,13 +31,20 @@ typedef struct
 	unsigned int n; // number of rows (height) of matrix
 	unsigned int offset; // coordinates of sub vector 1 <= x_offset <= n
 	float *a;
+	unsigned int flags;
 } *vector;
 
+// vector flags
+#define VECTOR_MAPPED 1 // a is a read only mapping of a file
+
 // prototypes for vector functions
 extern float * vector_allocate(unsigned int n);
 extern void print_vector(vector vec);
 extern int save_vector(vector vec, const char *filename);
 extern vector load_vector(const char *filename);
+// the vector in a file saved by save_vector(), used in place
+// read only, free_vector() unmaps it
+extern vector map_vector(const char *filename);
 extern vector mult_vector(vector a, vector b);
 extern vector zero_vector(unsigned int n);
 extern vector new_vector(float (*element_function)(int, int),
@@ -36,6 +52,26 @@ extern vector new_vector(float (*element_function)(int, int),
 extern void component_swap(vector vec, unsigned int i, unsigned int j);
 extern void free_vector(vector vec);
 
+// Store dimensions and offsets with a matrix
+typedef struct
+{
+	unsigned int n; // number of rows (height) of matrix
+	unsigned int offset; // coordinates of sub uvector 1 <= x_offset <= n
+	unsigned int* a;
+} *uvector;
+
+// prototypes for uvector functions
+extern unsigned int* uvector_allocate(int n);
+extern void print_uvector(uvector uvec);
+extern int save_uvector(uvector uvec, const char *filename);
+extern uvector load_uvector(const char *filename);
+extern uvector mult_uvector(uvector a, uvector b);
+extern uvector zero_uvector(int n);
+extern uvector new_uvector(unsigned int (*element_function)(int, int),
+		int n, int x);
+extern void ucomponent_swap(uvector uvec, int i, int j);
+extern void free_uvector(uvector uvec);
+
 // vector functions
 // form of function ptr f(t,y)
 typedef float(*func)(float *, int);
@@ -47,10 +83,31 @@ typedef struct
 	func * f; // array of function pointers
 } *vector_function;
 
+// right hand side of dy/dt = f(t,y) computed for all n components
+// at once, so terms shared between components are only done once
+typedef void (*ode_rhs)(double t, const float *y, float *dydt, int n,
+		void *userdata);
+
+// lets a vector_function be used as an ode_rhs
+// with the adapter as its userdata
+struct vecfunc_adapter
+{
+	vector_function vf;
+	float *row; // [t y1 ... yn] handed to the component functions
+};
+
 // prototypes for vector functions
 extern func * vecfunc_allocate(unsigned int n);
 extern vector_function new_vecfunc(unsigned int n, func f);
 extern void free_vecfunc(vector_function vf);
+// dydt = f(t,y) for the row ty = [t y1 ... yn]
+extern void vecfunc_eval(vector_function vf, float *ty, float *dydt);
+// set up an adapter for vf, returns 0 on success
+extern int vecfunc_adapter_init(struct vecfunc_adapter *a, vector_function vf);
+extern void vecfunc_adapter_free(struct vecfunc_adapter *a);
+// the ode_rhs of an adapter
+extern void vecfunc_rhs(double t, const float *y, float *dydt, int n,
+		void *userdata);
 
 // matrix stuff
 // Store dimensions and offsets with a matrix
@@ -60,15 +117,36 @@ typedef struct
 	unsigned int m; // number of columns (width) of matrix
 	unsigned int x_offset; // coordinates of sub matrix 1 <= x_offset <= n
 	unsigned int y_offset; // coordinates of sub matrix 1 <= y_offset <= m
-	float **A;
+	float **A; // row pointers into data
+	float *data; // first element, rows are ld floats apart
+	unsigned int ld; // leading dimension of data
+	unsigned int flags;
 } *matrix;
 
+// op() applied to an operand of matrix_gemm
+#define MATRIX_NOTRANS 0 // op(A) = A
+#define MATRIX_TRANS 1 // op(A) = A^T
+
+// matrix flags
+#define MATRIX_OWNER 1 // data is freed with the matrix, views don't own it
+#define MATRIX_TRANSPOSED 2 // element (i,j) is A[j][i], A has m rows of n
+#define MATRIX_MAPPED 4 // data is a read only mapping of a file
+
+// rows of allocated matrices start on a boundary of this many bytes
+#define MATRIX_ALIGN 64
+
 // prototypes for matrix functions
 extern float ** matrix_allocate(unsigned int n, unsigned int m);
 extern void print_matrix(matrix mat);
 extern int save_matrix(matrix mat, const char *filename);
 extern matrix load_matrix(const char *filename);
+// the matrix in a file saved by save_matrix(), used in place
+// read only, free_matrix() unmaps it
+extern matrix map_matrix(const char *filename);
 extern matrix mult_matrix(matrix A, matrix B);
+// C = alpha*op(A)*op(B) + beta*C, returns 0 on success
+extern int matrix_gemm(int transa, int transb, float alpha, matrix A, matrix B,
+		float beta, matrix C);
 extern void matrix_set(matrix A, matrix B);
 extern void matrix_set_identity(matrix A);
 extern void matrix_product(matrix A, matrix B);
@@ -81,17 +159,226 @@ extern void row_swap(float **A, int row1, int row2);
 extern void row_swap_partial(matrix mat, int row1, int row2, int min_col, int max_col);
 extern void col_swap_partial(matrix mat, int col1, int col2, int min_row, int max_row);
 extern void free_matrix(matrix mat);
+// views share the storage of A, 0 <= i < A->n and 0 <= j < A->m
+// they are released with free_matrix(), which leaves the data alone
+extern matrix matrix_view(matrix A, unsigned int i, unsigned int j,
+		unsigned int n, unsigned int m);
+extern matrix matrix_rows(matrix A, unsigned int i, unsigned int n);
+extern matrix matrix_cols(matrix A, unsigned int j, unsigned int m);
+extern matrix matrix_transpose_view(matrix A);
 
 // numerical root finding
+#define NEWTON_MAXITER 100 // iterations before newton_method gives up
+
 typedef float(*polynomial)(float); 
 
+// the root near x0, NaN if it isn't found in NEWTON_MAXITER steps
+// root_newton() and root_brent() are safer and return a status
 extern float newton_method(float x0, polynomial f, polynomial fprime);
 
+// bracketed root finding
+// status of a root finder
+#define ROOT_OK 0 // converged
+#define ROOT_NO_CONVERGENCE 1 // the iteration limit was reached
+#define ROOT_NO_BRACKET 2 // f(a) and f(b) have the same sign
+#define ROOT_NOT_FINITE 3 // f returned inf or NaN
+#define ROOT_SINGULAR 4 // the Jacobian of a system is singular
+
+#define ROOT_DEFAULT_MAXITER 100 // iterations allowed when 0 is given
+#define ROOT_BATCH 1024 // problems solved together by one task of root_newton_batch
+
+// f(x)
+typedef float (*root_func)(float x, void *userdata);
+// f(x) and f'(x) from one evaluation
+typedef float (*root_fdf)(float x, float *dfdx, void *userdata);
+// f and f' at x[k] for problem index[k], 0 <= k < count
+// called from several threads at once
+typedef void (*root_batch_fdf)(const float *x, float *f, float *dfdx,
+		const unsigned int *index, unsigned int count, void *userdata);
+
+// Newton's method kept inside the bracket [a,b] by bisection, starting
+// at x0 or the midpoint if x0 is outside, converged when |f| <= ftol or
+// the step is below xtol + 4*FLT_EPSILON*|x|, returns a status
+extern int root_newton(root_fdf f, void *userdata, float x0, float a, float b,
+		float xtol, float ftol, unsigned int maxiter, float *root);
+// Brent's method on the bracket [a,b], needs no derivative
+// converged when the bracket is below xtol + 4*FLT_EPSILON*|x|
+extern int root_brent(root_func f, void *userdata, float a, float b,
+		float xtol, unsigned int maxiter, float *root);
+// root_newton for count independent problems at once, problem k has
+// bracket [a[k],b[k]] and starts at x[k], where its root is left
+// status may be NULL, returns 0 if every problem converged
+extern int root_newton_batch(root_batch_fdf f, void *userdata,
+		unsigned int count, const float *a, const float *b, float *x,
+		float xtol, float ftol, unsigned int maxiter, int *status);
+
+
+// Newton's method for nonlinear systems F(x)=0
+// how often the Jacobian is factored
+#define NEWTON_FULL 0 // every iteration
+#define NEWTON_CHORD 1 // once, and again only when convergence stalls
+#define NEWTON_SHAMANSKII 2 // every m iterations, and when convergence stalls
+
+#define NEWTON_RATIO 0.5 // a factorization is replaced when a step reduces |F| by less than this
+#define NEWTON_BACKTRACK 10 // halvings of a step tried along a fresh Newton direction
+#define NEWTON_JAC_COLS 8 // columns of a finite difference Jacobian formed by one task
+
+// F(x) for n equations
+typedef void (*system_func)(const float *x, float *F, int n, void *userdata);
+// the Jacobian J[i][j] = dF_i/dx_j at x, J is n x n
+typedef void (*system_jacobian)(const float *x, matrix J, int n,
+		void *userdata);
+
+// work done by newton_system
+struct newton_stats
+{
+	unsigned long iterations;
+	unsigned long evaluations; // of F, including finite differences
+	unsigned long jacobians;
+	unsigned long factorizations;
+	float residual; // max |F_i| at the returned x
+};
+
+// solve F(x)=0 starting from x, where the solution is left, converged when
+// max |F_i| <= ftol or a full, undamped Newton step has every
+// |dx_i| <= xtol + 4*FLT_EPSILON*|x_i|
+// jac may be NULL for a finite difference Jacobian computed a few
+// columns per thread, in which case F is called from several threads
+// at once, m is the refactoring interval of NEWTON_SHAMANSKII and
+// stats may be NULL, returns ROOT_OK or another root finder status
+extern int newton_system(system_func F, system_jacobian jac, void *userdata,
+		vector x, float ftol, float xtol, unsigned int maxiter, int method,
+		unsigned int m, struct newton_stats *stats);
+
+// streaming output for ODE solvers
+// rows buffered between calls to the sink when no size is given
+#define ODE_STREAM_CHUNK 1024
+// receives a chunk of solution rows [t y1 ... yn], only the first
+// rows->n rows are valid and the matrix is reused after the call
+// returning nonzero stops the integration
+typedef int (*ode_sink)(matrix rows, void *arg);
+typedef struct ode_stream *ode_stream;
+
+// work done by an adaptive solver
+struct ode_stats
+{
+	unsigned long steps; // accepted steps
+	unsigned long rejected; // steps retried with a smaller h
+	unsigned long evaluations; // of the right hand side
+	unsigned long jacobians; // formed by an implicit solver
+	unsigned long factorizations; // of its iteration matrix
+};
+
+// buffer chunk rows of cols floats for sink, keeping every
+// every-th row pushed, chunk 0 is ODE_STREAM_CHUNK and every 0 is 1
+extern ode_stream ode_stream_create(unsigned int cols, unsigned int chunk,
+		unsigned int every, ode_sink sink, void *arg);
+// the same, writing the rows to a file load_matrix() and map_matrix() read
+extern ode_stream ode_stream_open(const char *filename, unsigned int cols,
+		unsigned int chunk, unsigned int every);
+// the same, filling the rows of Y in order
+extern ode_stream ode_stream_into(matrix Y, unsigned int every);
+extern int ode_stream_push(ode_stream s, const float *row);
+extern int ode_stream_flush(ode_stream s);
+extern unsigned long ode_stream_rows(ode_stream s);
+// flush, finish the file if there is one and free the stream
+// a file no rows were kept in is removed
+extern int ode_stream_close(ode_stream s);
+
 // Euler method for ODEs
 extern matrix euler_method(vector_function f, vector y0, float tmin, float tmax, float h);
+// the same rows pushed to out one at a time, returns 0 on success
+extern int euler_method_stream(vector_function f, vector y0, float tmin, float tmax,
+		float h, ode_stream out);
+// the same for a right hand side computed a whole vector at a time
+extern int euler_method_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float h, ode_stream out);
 
 // Runge-Kutta method for ODEs 4th order
 extern matrix runge_kutta4(vector_function f, vector y0, float tmin, float tmax, float h);
+extern int runge_kutta4_stream(vector_function f, vector y0, float tmin, float tmax,
+		float h, ode_stream out);
+extern int runge_kutta4_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float h, ode_stream out);
+
+// Dormand-Prince 5(4) adaptive Runge-Kutta method for ODEs
+// solution rows [t y1 ... yn] at t = tmin, tmin+dt, ... up to tmax
+// interpolated from the adaptive steps, each component is kept within
+// atol + rtol*|y| per step, stats may be NULL
+extern matrix dormand_prince(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, struct ode_stats *stats);
+// the same rows pushed to out, or with dt == 0 one row for
+// every step taken, returns 0 on success
+extern int dormand_prince_stream(vector_function f, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+extern int dormand_prince_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float rtol, float atol, float dt, ode_stream out,
+		struct ode_stats *stats);
+
+// integration of many initial conditions at once
+#define ODE_BATCH_WIDTH 256 // trajectories integrated together by one task
+
+// methods for the batch integrators
+#define ODE_BATCH_EULER 0 // Euler's method
+#define ODE_BATCH_RK4 1 // classical 4th order Runge-Kutta
+
+// right hand side for count trajectories at once, stored structure
+// of arrays, component i of trajectory k is y[i*ld + k] so a loop
+// over k vectorizes, called from several threads at once
+typedef void (*ode_batch_rhs)(double t, const float *y, float *dydt,
+		unsigned int n, unsigned int count, unsigned int ld, void *userdata);
+
+// receives the states of trajectories first ... first+Y->m-1 at t,
+// Y is n x count with trajectory k in column k and is reused after
+// the call, called from several threads at once
+// returning nonzero stops the integration
+typedef int (*ode_batch_sink)(double t, unsigned int first, matrix Y,
+		void *arg);
+
+// integrate every row of Y0 with fixed steps h over the times
+// euler_method() and runge_kutta4() use, the final states go to the
+// rows of Y, which may be Y0, the work is spread over all threads
+// returns 0 on success
+extern int ode_batch(int method, ode_batch_rhs f, void *userdata, matrix Y0,
+		float tmin, float tmax, float h, matrix Y);
+// the same, also handing the states to sink at every every-th step
+// starting with tmin, Y may be NULL if only the sink is wanted
+extern int ode_batch_stream(int method, ode_batch_rhs f, void *userdata,
+		matrix Y0, float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+// the same for a vector_function, sink may be NULL
+extern int ode_batch_vecfunc(int method, vector_function f, matrix Y0,
+		float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+
+// backward differentiation formulas for stiff ODEs
+#define BDF_MAX_ORDER 5 // highest order used, order 1 is backward Euler
+#define BDF_NEWTON_MAXITER 4 // Newton iterations tried before the step is retried
+#define BDF_FACMIN 0.2 // a step shrinks by at most this
+#define BDF_FACMAX 10. // and grows by at most this
+
+// the Jacobian J[i][j] = df_i/dy_j at (t, y), J is n x n
+typedef void (*ode_jacobian)(double t, const float *y, matrix J, int n,
+		void *userdata);
+
+// solution rows [t y1 ... yn] at t = tmin, tmin+dt, ... up to tmax
+// by variable step BDF of order 1 up to order, each component is kept
+// within atol + rtol*|y| per step, rtol is at least 10*FLT_EPSILON,
+// the Jacobian is found by finite differences, stats may be NULL
+extern matrix bdf(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order,
+		struct ode_stats *stats);
+// the same rows pushed to out, or with dt == 0 one row for
+// every step taken, returns 0 on success
+extern int bdf_stream(vector_function f, vector y0, float tmin, float tmax,
+		float rtol, float atol, float dt, unsigned int order, ode_stream out,
+		struct ode_stats *stats);
+// the same for a right hand side computed a whole vector at a time
+// jac may be NULL to use finite differences
+extern int bdf_rhs(ode_rhs f, ode_jacobian jac, void *userdata, vector y0,
+		float tmin, float tmax, float rtol, float atol, float dt,
+		unsigned int order, ode_stream out, struct ode_stats *stats);
 
 // LU factorization of linear systems
 // a list of things relevant to an LU factorization Ax=LUx=b
@@ -101,10 +388,10 @@ struct factored_system
 	matrix system;
 	// its LU factorization in 1 matrix
 	matrix factors;
-	// pivoting for x
-	vector x_permutation;
-	// pivoting for b
-	vector b_permutation;
+	// pivoting for x, row i of the solution of LU is x[x_permutation[i]]
+	uvector x_permutation;
+	// pivoting for b, row i of LU is row b_permutation[i] of the system
+	uvector b_permutation;
 	// this value is the diagonals of L (usually 1.)
 	float alpha;
 };
@@ -115,32 +402,467 @@ extern void forward_substitution(matrix L, vector x, vector b);
 extern void backward_substitution(matrix U, vector x, vector b);
 // direct solution of LUx=b with factorizations index f
 extern void lu_solve(int f, vector x, vector b);
+// pivoting strategies for lu_factor_pivot
+#define LU_PARTIAL_PIVOTING 0 // row interchanges, PA=LU
+#define LU_TOTAL_PIVOTING 1 // row and column interchanges, PAQ=LU
+
 // generate an LU factorization, return factorizations index
 extern int lu_factor(matrix A);
+// same with a choice of pivoting strategy
+extern int lu_factor_pivot(matrix A, int pivoting);
 // general method to solve a linear system Ax=b
 extern void linear_solve(matrix A, vector x, vector b);
+// the same, followed by up to steps of iterative refinement with the
+// residual computed in double, and if rcond isn't NULL an estimate of
+// 1/cond_1(A), a solution has about -log10(rcond) fewer accurate digits
+// than a float, returns 0 on success
+extern int linear_solve_refined(matrix A, vector x, vector b,
+		unsigned int steps, float *rcond);
 // cleanup
 extern void free_factor(int factor);
 extern void free_all_factors(void);
 
-// Store dimensions and offsets with a matrix
+// explicit handles to LU factorizations
+// a handle is immutable once factored, any number of threads may
+// solve with it at the same time, the last release frees it
+typedef struct lu_factorization *lu_handle;
+
+// factor A into a new handle holding one reference, NULL on failure
+extern lu_handle lu_handle_factor(matrix A, int pivoting);
+extern lu_handle lu_handle_retain(lu_handle h);
+extern void lu_handle_release(lu_handle h);
+// direct solution of LUx=b, returns 0 on success
+extern int lu_handle_solve(lu_handle h, vector x, vector b);
+// solve LUX=B for every column of B at once, X may be B
+extern int lu_solve_many(lu_handle h, matrix B, matrix X);
+// memory held by a factorization
+extern size_t lu_handle_bytes(lu_handle h);
+// the factors and permutations of a handle, factors is NULL
+// for a handle from sparse_lu_factor()
+extern struct factored_system * lu_handle_factors(lu_handle h);
+// refine a solution of Ax=b against the system h was factored from,
+// which must still be unchanged, returns 0 on success
+extern int lu_handle_refine(lu_handle h, vector x, vector b,
+		unsigned int steps);
+// 1/cond_1(A) estimated in O(n^2) from the factors, 0 if A is singular
+extern float lu_handle_rcond(lu_handle h);
+// det A from the factors in O(n), 0 if A is singular, and its log
+// which can't overflow, det A = sign*exp(logdet), sign may be NULL
+extern float lu_handle_det(lu_handle h);
+extern double lu_handle_logdet(lu_handle h, int *sign);
+// A^-1 into the n x n X, returns 0 on success
+extern int lu_handle_inverse(lu_handle h, matrix X);
+// 1 or -1 for an even or odd permutation of 0..n-1, 0 if out of memory
+extern int permutation_sign(unsigned int n, const unsigned int *p);
+
+// thread safe cache of factorizations keyed by matrix and generation
+// least recently used entries are evicted once over the memory budget
+typedef struct lu_cache *lu_cache;
+
+// a budget of 0 bytes means no limit
+extern lu_cache lu_cache_create(size_t budget);
+// the factorization of A at this generation, factored on a miss
+// the handle returned holds a reference for the caller to release
+extern lu_handle lu_cache_get(lu_cache c, matrix A, unsigned long generation,
+		int pivoting);
+// drop every factorization of A
+extern void lu_cache_invalidate(lu_cache c, matrix A);
+extern void lu_cache_set_budget(lu_cache c, size_t budget);
+extern size_t lu_cache_bytes(lu_cache c);
+// release all cached factorizations, nobody may be using the cache
+extern void lu_cache_destroy(lu_cache c);
+
+
+// sparse matrices
+#define SPARSE_CSR 0 // compressed rows, ptr has n+1 entries
+#define SPARSE_CSC 1 // compressed columns, ptr has m+1 entries
+#define SPARSE_SPMV_ROWS 4096 // rows of a CSR matrix multiplied by one task of sparse_spmv()
+#define SPARSE_ORDER_NATURAL 0 // as the columns are given
+#define SPARSE_ORDER_AMD 1 // approximate minimum degree of A+A^T
+#define SPARSE_PIVOT_TOL 0.1 // fraction of the largest candidate the diagonal pivot must reach
+
+// only the nonzeros of a matrix, n and m must be below 2^31
 typedef struct
 {
 	unsigned int n; // number of rows (height) of matrix
-	unsigned int offset; // coordinates of sub uvector 1 <= x_offset <= n
-	unsigned int* a;
-} *uvector;
+	unsigned int m; // number of columns (width) of matrix
+	unsigned int nnz; // stored entries
+	unsigned int format; // SPARSE_CSR or SPARSE_CSC
+	unsigned int *ptr; // entries of row (column) i are ptr[i] ... ptr[i+1]-1
+	unsigned int *index; // column (row) of each entry, increasing in a row (column)
+	float *value;
+} *sparse;
 
-// prototypes for uvector functions
-extern unsigned int* uvector_allocate(int n);
-extern void print_uvector(uvector uvec);
-extern int save_uvector(uvector uvec, const char *filename);
-extern uvector load_uvector(const char *filename);
-extern uvector mult_uvector(uvector a, uvector b);
-extern uvector zero_uvector(int n);
-extern uvector new_uvector(unsigned int (*element_function)(int, int),
-		int n, int x);
-extern void ucomponent_swap(uvector uvec, int i, int j);
-extern void free_uvector(uvector uvec);
+// room for nnz entries, ptr is zeroed
+extern sparse sparse_allocate(unsigned int n, unsigned int m, unsigned int nnz,
+		int format);
+// from count triplets (row[k], col[k], value[k]) in any order,
+// duplicates are summed as in finite element assembly
+extern sparse sparse_from_triplets(unsigned int n, unsigned int m,
+		unsigned int count, const unsigned int *row, const unsigned int *col,
+		const float *value, int format);
+// the elements of a dense matrix with |a_ij| > drop
+extern sparse sparse_from_matrix(matrix A, float drop, int format);
+// A in the given format, a copy if it is in that format already
+extern sparse sparse_convert(sparse A, int format);
+extern matrix sparse_to_matrix(sparse A);
+extern void free_sparse(sparse A);
+// memory held by a sparse matrix
+extern size_t sparse_bytes(sparse A);
+// y = alpha*A*x + beta*y, the rows of a CSR matrix are split over the
+// thread pool and each is a gathered dot product, CSC is done serially
+// returns 0 on success
+extern int sparse_spmv(float alpha, sparse A, const float *x, float beta,
+		float *y);
+// r = b - Ax with the sums accumulated in double
+extern void sparse_residual(sparse A, const float *x, const float *b, float *r);
+// |A|_1, the largest column sum
+extern double sparse_norm1(sparse A);
+
+// a fill reducing symmetric ordering of a square matrix, order[k] is the
+// k-th row and column to eliminate, returns 0 on success
+extern int sparse_amd(sparse A, unsigned int *order);
+// factor a square matrix into a handle for lu_handle_solve(),
+// lu_solve_many(), lu_handle_refine() and lu_handle_rcond()
+// A must stay unchanged while the handle is in use, NULL on failure
+extern lu_handle sparse_lu_factor(sparse A, int ordering);
+// the fill of a sparse factorization, entries of L and U
+extern size_t sparse_lu_nnz(lu_handle h);
+
+
+// Krylov solvers
+#define KRYLOV_OK 0 // converged
+#define KRYLOV_NO_CONVERGENCE 1 // the iteration limit was reached
+#define KRYLOV_BREAKDOWN 2 // a denominator vanished, e.g. A isn't SPD for CG
+#define KRYLOV_ERROR 3 // bad arguments, allocation or preconditioner failure
+#define KRYLOV_STAGNATION 4 // restarts stopped reducing |b-Ax|, usually at float roundoff
+
+#define KRYLOV_DEFAULT_MAXITER 1000 // iterations allowed when 0 is given
+#define KRYLOV_RESTART 30 // basis size of GMRES when a restart of 0 is given
+#define KRYLOV_STALL 0.5 // reduction of |b-Ax| each restart after a claimed convergence must make
+#define KRYLOV_OPERATOR_ROWS 64 // rows of a dense matrix multiplied by one task of matrix_operator()
+
+// y = Ax for n unknowns, A needn't be stored at all
+typedef void (*linear_operator)(const float *x, float *y, unsigned int n,
+		void *userdata);
+// z = M^-1 r for a preconditioner M that approximates A
+typedef int (*linear_preconditioner)(const float *r, float *z, unsigned int n,
+		void *userdata);
+
+// a preconditioner and whatever it owns
+typedef struct krylov_preconditioner *preconditioner;
+
+// work done by a Krylov solver
+struct krylov_stats
+{
+	unsigned long iterations;
+	unsigned long products; // of A, including the final residual
+	unsigned long preconditions; // applications of M^-1
+	float residual; // |b-Ax|_2/|b|_2 at the returned x
+	// if history isn't NULL, the relative residual the iteration tracks
+	// is stored after each step, history[0] being that of the first guess
+	float *history;
+	unsigned int history_size; // room in history
+	unsigned int history_count; // entries written
+};
+
+// operators for stored matrices, userdata is the matrix or sparse
+// the rows of a dense matrix are split over the thread pool
+extern void matrix_operator(const float *x, float *y, unsigned int n,
+		void *userdata);
+extern void sparse_operator(const float *x, float *y, unsigned int n,
+		void *userdata);
+
+// M = diag(A)
+extern preconditioner precond_jacobi(matrix A);
+extern preconditioner precond_jacobi_sparse(sparse A);
+// incomplete LU with the sparsity pattern of A, which must have
+// its diagonal stored, A is copied
+extern preconditioner precond_ilu0(sparse A);
+// an existing factorization, e.g. of a nearby or older system,
+// the handle is retained until the preconditioner is freed
+extern preconditioner precond_lu(lu_handle h);
+// the same, for an index returned by lu_factor()
+extern preconditioner precond_lu_index(int f, unsigned int n);
+// any other M^-1, it must return 0 on success
+extern preconditioner precond_custom(linear_preconditioner apply,
+		void *userdata);
+// z = M^-1 r, z = r if M is NULL, returns 0 on success
+extern int precond_apply(preconditioner M, const float *r, float *z,
+		unsigned int n);
+extern void free_preconditioner(preconditioner M);
+
+// solve Ax=b starting from the guess in x, where the solution is left,
+// converged when the true |b-Ax|_2 <= tol*|b|_2, M may be NULL and stats
+// too, maxiter of 0 allows KRYLOV_DEFAULT_MAXITER, returns a status
+// a float solve of an ill conditioned system can't get below about
+// FLT_EPSILON*cond(A), asking for less ends in KRYLOV_STAGNATION
+// conjugate gradients, A and M must be symmetric positive definite
+extern int krylov_cg(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+// GMRES restarted every restart iterations, preconditioned on the
+// right so the residual it tracks is that of the original system
+extern int krylov_gmres(linear_operator A, void *userdata, preconditioner M,
+		vector x, vector b, float tol, unsigned int restart,
+		unsigned int maxiter, struct krylov_stats *stats);
+// stabilized biconjugate gradients, preconditioned on the right
+extern int krylov_bicgstab(linear_operator A, void *userdata,
+		preconditioner M, vector x, vector b, float tol, unsigned int maxiter,
+		struct krylov_stats *stats);
+
+
+// band matrices
+#define BAND_FACTORED 1 // ab holds L and U, pivot the row interchanges
+#define BAND_SINGULAR 2 // band_lu_factor() stopped at a zero pivot
+#define TRIDIAGONAL_BATCH 256 // systems solved together by one task of tridiagonal_solve_batch()
+
+// a square matrix with kl sub and ku super diagonals in the layout of
+// LAPACK's gbtrf, a_ij is ab[kl+ku+i-j + j*ld] for j-ku <= i <= j+kl,
+// the kl rows above are room for the fill of partial pivoting
+typedef struct
+{
+	unsigned int n; // order of matrix
+	unsigned int kl; // sub diagonals
+	unsigned int ku; // super diagonals
+	unsigned int ld; // 2*kl+ku+1, stored elements of a column
+	float *ab; // n columns of ld, column major
+	unsigned int *pivot; // row j was swapped with pivot[j] by band_lu_factor()
+	unsigned int flags;
+} *band;
+
+// a zeroed band matrix
+extern band zero_band(unsigned int n, unsigned int kl, unsigned int ku);
+extern void free_band(band B);
+// a_ij of an unfactored matrix, 0 outside the band
+extern float band_get(band B, unsigned int i, unsigned int j);
+// set a_ij, returns 1 if (i,j) is outside the band
+extern int band_set(band B, unsigned int i, unsigned int j, float a);
+// the band of a dense matrix, elements outside it are ignored
+extern band band_from_matrix(matrix A, unsigned int kl, unsigned int ku);
+extern matrix band_to_matrix(band B);
+// y = alpha*A*x + beta*y for an unfactored matrix, returns 0 on success
+extern int band_gemv(float alpha, band B, const float *x, float beta,
+		float *y);
+// PA=LU in place by partial pivoting in O(n*kl*(kl+ku)) operations
+// returns 0 on success, 1 if A is singular, which band_lu_solve() refuses
+extern int band_lu_factor(band B);
+// direct solution of LUx=Pb, x may be b, returns 0 on success
+extern int band_lu_solve(band B, vector x, vector b);
+
+// the Thomas algorithm for a tridiagonal system with sub diagonal
+// a[1..n-1], diagonal b and super diagonal c[0..n-2] in O(n), x may be d
+// there is no pivoting, so A should be diagonally dominant or SPD
+// returns 0 on success, 1 on a zero pivot
+extern int tridiagonal_solve(unsigned int n, const float *a, const float *b,
+		const float *c, const float *d, float *x);
+// count systems of order n at once, stored structure of arrays with
+// element i of system k at [i*ld + k] so a loop over k vectorizes,
+// the solutions overwrite d and the systems are split over the thread
+// pool, returns 0 on success, 1 if any system hit a zero pivot
+extern int tridiagonal_solve_batch(unsigned int n, unsigned int count,
+		unsigned int ld, const float *a, const float *b, const float *c,
+		float *d);
+
+
+// polynomials
+#define POLY_BATCH 64 // polynomials whose roots are found together by one task
+#define POLY_ROUNDOFF 4 // a root is accepted once |p(z)| is this many roundoffs of p's terms
+
+// c[0] + c[1]*x + ... + c[degree]*x^degree
+typedef struct
+{
+	unsigned int degree;
+	float *c;
+} *poly;
+
+// a polynomial with zero coefficients
+extern poly zero_poly(unsigned int degree);
+extern void free_poly(poly p);
+// p(x) and, if dpdx isn't NULL, p'(x) from one pass of Horner's rule
+extern float poly_eval(poly p, float x, float *dpdx);
+// p and p' at n points at once by the horner kernel
+extern void poly_eval_many(poly p, unsigned int n, const float *x, float *px,
+		float *dpdx);
+// p as a root_func and a root_fdf, userdata is the poly
+extern float poly_func(float x, void *userdata);
+extern float poly_fdf(float x, float *dfdx, void *userdata);
+
+// all degree roots of p, complex ones included, into re and im sorted
+// by real then imaginary part, by the Aberth-Ehrlich iteration in double
+// a root is done when a correction is below tol*|z| or p(z) is at the
+// roundoff of its evaluation, tol of 0 means FLT_EPSILON and maxiter of
+// 0 ROOT_DEFAULT_MAXITER, returns ROOT_OK or another root finder status,
+// ROOT_SINGULAR if the leading coefficient is zero
+extern int poly_roots(poly p, float *re, float *im, float tol,
+		unsigned int maxiter);
+// the same for count polynomials of one degree, the coefficients of
+// polynomial k are c[k*(degree+1) ...] and its roots go to re and im
+// from k*degree, the polynomials are split over the thread pool
+// status may be NULL, returns 0 if every polynomial converged
+extern int poly_roots_batch(unsigned int degree, unsigned int count,
+		const float *c, float *re, float *im, float tol, unsigned int maxiter,
+		int *status);
+
+// eigenvalues
+#define EIGEN_PANEL 32 // columns reduced per panel of the tridiagonalization
+#define EIGEN_UPDATE_COLS 256 // columns of the trailing matrix updated by one gemm_blocked()
+#define EIGEN_LEAF 32 // divide and conquer stops splitting below this order
+#define EIGEN_MAXITER 30 // sweeps of implicit QL allowed per eigenvalue of a tridiagonal matrix
+#define EIGEN_INVERSE_STEPS 3 // steps of inverse iteration for each eigenvector of an index range
+#define EIGEN_CLUSTER 1e-3 // eigenvalues this close relative to |T| have their vectors orthogonalized
+
+// all eigenvalues w[0] <= ... <= w[n-1] of a symmetric A and, if Z isn't
+// NULL, the orthonormal eigenvectors as the columns of the n x n Z
+// only the lower triangle of A is read and A is left alone, A is reduced
+// to tridiagonal form and the vectors come from divide and conquer
+// returns 0 on success
+extern int symmetric_eigen(matrix A, vector w, matrix Z);
+// eigenvalues il to iu of the same sorted list, 0 based and inclusive,
+// into w[0..iu-il] and their vectors into the n x (iu-il+1) Z, by bisection
+// and inverse iteration so the work on the tridiagonal matrix and the
+// back transformation are in proportion to the number of eigenpairs
+extern int symmetric_eigen_range(matrix A, unsigned int il, unsigned int iu,
+		vector w, matrix Z);
+// the same for a symmetric tridiagonal matrix with diagonal d[0..n-1] and
+// off diagonal e[0..n-2], Z may be NULL for the eigenvalues alone
+extern int tridiagonal_eigen(unsigned int n, const float *d, const float *e,
+		float *w, matrix Z);
+
+
+// QR factorization and least squares
+#define QR_NO_PIVOTING 0 // A=QR
+#define QR_COLUMN_PIVOTING 1 // the largest remaining column goes next, AP=QR
+#define QR_PANEL 32 // reflectors per panel, the trailing matrix is updated once per panel
+#define QR_COLUMNS 64 // trailing columns per task of a column pivoted panel
+
+// an immutable QR factorization of an n x m matrix, any number of threads
+// may solve with it at the same time, the last release frees it
+typedef struct qr_factorization *qr_handle;
+
+// factor A into a new handle holding one reference, NULL on failure
+// the rank is the number of diagonal elements of R above
+// max(n,m)*FLT_EPSILON*|R_00|, only meaningful with column pivoting
+extern qr_handle qr_factor(matrix A, int pivoting);
+extern qr_handle qr_retain(qr_handle h);
+extern void qr_release(qr_handle h);
+extern unsigned int qr_rank(qr_handle h);
+// the x of least norm among those minimizing |Ax-b|, returns 0 on success
+extern int qr_solve(qr_handle h, vector x, vector b);
+// the same for every column of the n x k B into the m x k X
+extern int qr_solve_many(qr_handle h, matrix B, matrix X);
+// least squares solution of Ax=b, A is factored with column pivoting
+// the first time it is seen and the factorization is kept for later calls
+// this only compares the pointer! if A changes call free_least_squares(A)
+extern int least_squares_solve(matrix A, vector x, vector b);
+// cleanup
+extern void free_least_squares(matrix A);
+extern void free_all_least_squares(void);
+
+// Cholesky and LDL^T factorizations of symmetric matrices
+#define CHOLESKY_LLT 0 // A=LL^T, A positive definite
+#define CHOLESKY_LDLT 1 // PAP^T=LDL^T, D with 1x1 and 2x2 blocks
+#define CHOLESKY_BLOCK 64 // columns per panel and rows per task of the trailing update
+#define LDLT_ALPHA 0.6403882032022076 // Bunch-Kaufman's (1+sqrt(17))/8
+
+// an immutable factorization holding only the lower triangle, any number
+// of threads may solve with it at the same time, the last release frees it
+typedef struct cholesky_factorization *cholesky_handle;
+
+// factor a positive definite A, only the lower triangle is read
+// returns a handle holding one reference, NULL on failure
+extern cholesky_handle cholesky_factor(matrix A);
+// the same for a symmetric indefinite A with Bunch-Kaufman pivoting
+extern cholesky_handle ldlt_factor(matrix A);
+extern cholesky_handle cholesky_retain(cholesky_handle h);
+extern void cholesky_release(cholesky_handle h);
+// direct solution of Ax=b with the factors, returns 0 on success
+extern int cholesky_solve(cholesky_handle h, vector x, vector b);
+// the same for every column of B at once, X may be B
+extern int cholesky_solve_many(cholesky_handle h, matrix B, matrix X);
+// memory held by a factorization
+extern size_t cholesky_bytes(cholesky_handle h);
+// log|det A| in O(n) from the factors, det A = sign*exp(logdet),
+// sign may be NULL
+extern double cholesky_logdet(cholesky_handle h, int *sign);
+// solve the symmetric Ax=b, A is factored by Cholesky, or LDL^T if it
+// isn't positive definite, the first time it is seen and the factors
+// are kept for later calls
+// this only compares the pointer! if A changes call free_symmetric(A)
+extern int symmetric_solve(matrix A, vector x, vector b);
+// cleanup
+extern void free_symmetric(matrix A);
+extern void free_all_symmetric(void);
+
+// double precision
+#define MIXED_MAXITER 30 // refinement steps allowed by mixed_solve() when 0 is given
+
+// a matrix of double, rows are ld elements apart
+typedef struct
+{
+	unsigned int n; // number of rows (height) of matrix
+	unsigned int m; // number of columns (width) of matrix
+	double **A; // row pointers into data
+	double *data; // first element
+	unsigned int ld; // leading dimension of data
+	unsigned int flags;
+} *dmatrix;
+
+// a vector of double
+typedef struct
+{
+	unsigned int n;
+	double *a;
+} *dvector;
+
+// PA=LU, L has a unit diagonal and is stored below the diagonal of U
+struct dlu_factors
+{
+	dmatrix LU;
+	unsigned int *perm; // row i of LU is row perm[i] of A
+};
+typedef struct dlu_factors *dlu;
+
+// right hand side of dy/dt = f(t,y) for all n components at once
+typedef void (*dode_rhs)(double t, const double *y, double *dydt, int n,
+		void *userdata);
+
+// allocation, matrices are zeroed and their rows aligned like a matrix's
+extern dmatrix dzero_matrix(unsigned int n, unsigned int m);
+extern void dfree_matrix(dmatrix A);
+extern dvector dzero_vector(unsigned int n);
+extern void dfree_vector(dvector v);
+extern void dprint_matrix(dmatrix A);
+extern void dprint_vector(dvector v);
+// copies of single precision matrices and vectors
+extern dmatrix dmatrix_convert(matrix A);
+extern dvector dvector_convert(vector v);
+// v rounded into the single precision vector out, returns 0 on success
+extern int dvector_store(dvector v, vector out);
+// y = alpha*A*x + beta*y with the sums accumulated in double
+extern int dmatrix_gemv(double alpha, dmatrix A, const double *x,
+		double beta, double *y);
+// factor a copy of A by partial pivoting, NULL if A is singular
+extern dlu dlu_factor(dmatrix A);
+// direct solution of LUx=b, x may be b, returns 0 on success
+extern int dlu_solve(dlu f, dvector x, dvector b);
+extern void dlu_free(dlu f);
+// fixed step solutions with rows [t y1 ... yn] as euler_method()
+// and runge_kutta4() give, but with t and y carried in double
+extern dmatrix deuler_method(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+extern dmatrix drunge_kutta4(dode_rhs f, void *userdata,
+		dvector y0, double tmin, double tmax, double h);
+
+// Ax=b to double precision, A is factored in single precision and the
+// solution refined with residuals computed in double, if refinement
+// stalls because A is too ill conditioned for that it falls back to
+// a double precision factorization, returns 0 on success
+extern int mixed_solve(dmatrix A, dvector x, dvector b, unsigned int maxiter);
+// the refinement alone, h is a single precision factorization of A
+// and x holds a starting guess, returns 0 once the residual is at
+// double precision roundoff and 1 if the corrections stalled first
+extern int mixed_refine(lu_handle h, dmatrix A, dvector x, dvector b,
+		unsigned int maxiter);
 
 #endif
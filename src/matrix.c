@@ -3,13 +3,20 @@
  * Sep 22 2010 */
 
 #include "matrix.h"
+#include "gemm.h"
+#include "kernel.h"
+#include "vector.h"
+#include "datafile.h"
 
 // prototypes for matrix functions
 float ** matrix_allocate(int n, int m);
 void print_matrix(matrix mat);
 int save_matrix(matrix mat, const char *filename);
 matrix load_matrix(const char *filename);
+matrix map_matrix(const char *filename);
 matrix mult_matrix(matrix A, matrix B);
+int matrix_gemm(int transa, int transb, float alpha, matrix A, matrix B,
+		float beta, matrix C);
 void matrix_set(matrix A, matrix B);
 void matrix_set_identity(matrix A);
 void matrix_product(matrix A, matrix B);
@@ -22,33 +29,167 @@ void row_swap(float **A, int row1, int row2);
 void row_swap_partial(matrix mat, int row1, int row2, int min_col, int max_col);
 void col_swap_partial(matrix mat, int col1, int col2, int min_row, int max_row);
 void free_matrix(matrix mat);
-
-// Allocate space for an n x m matrix
-float ** matrix_allocate(int n, int m)
+matrix matrix_view(matrix A, unsigned int i, unsigned int j,
+		unsigned int n, unsigned int m);
+matrix matrix_rows(matrix A, unsigned int i, unsigned int n);
+matrix matrix_cols(matrix A, unsigned int j, unsigned int m);
+matrix matrix_transpose_view(matrix A);
+
+// floats per row of an m column matrix, rounded up to MATRIX_ALIGN bytes
+static unsigned int leading_dimension(unsigned int m);
+// aligned zeroed storage for n rows of ld floats
+static float * storage_allocate(unsigned int n, unsigned int ld);
+// row pointers for n rows of ld floats starting at data
+static float ** row_pointers(float *data, unsigned int n, unsigned int ld);
+// rows and columns of the storage of a matrix
+static unsigned int stored_rows(matrix mat);
+static unsigned int stored_cols(matrix mat);
+// element (i,j) of a matrix, wherever it is stored
+static float * element(matrix mat, unsigned int i, unsigned int j);
+// op() of the storage of an operand
+static int stored_trans(matrix mat, int trans);
+// the range of memory the rows of a matrix span
+static void storage_extent(matrix mat, float **lo, float **hi);
+// do the storage of two matrices share any memory
+static int matrix_overlap(matrix A, matrix B);
+// load the format written before the datafile header
+static matrix load_matrix_legacy(FILE *infile, const char *filename);
+
+// the header of an old matrix file is the matrix struct as
+// it was laid out before the storage fields were added
+struct matrix_file_header
 {
-	int i;
+	unsigned int n;
+	unsigned int m;
+	unsigned int x_offset;
+	unsigned int y_offset;
 	float **A;
+};
+
+// floats per row of an m column matrix, rounded up to MATRIX_ALIGN bytes
+static unsigned int leading_dimension(unsigned int m)
+{
+	unsigned int align = MATRIX_ALIGN/sizeof(float);
+
+	return (m + align - 1)/align*align;
+}
+
+// aligned zeroed storage for n rows of ld floats
+static float * storage_allocate(unsigned int n, unsigned int ld)
+{
+	void *data;
+	size_t bytes = sizeof(float)*(size_t)n*ld;
 
-	// Allocate space for rows so we can access A[i]
-	A = calloc(n,sizeof(*A));
-	if(A == NULL)
+	if ((errno = posix_memalign(&data, MATRIX_ALIGN, bytes)) != 0)
 	{
 		perror("Error allocating memory");
 		return NULL;
 	}
+	memset(data, 0, bytes);
+	return data;
+}
+
+// row pointers for n rows of ld floats starting at data
+static float ** row_pointers(float *data, unsigned int n, unsigned int ld)
+{
+	float **A;
+	unsigned int i;
 
-	// Allocate space for the entire matrix
-	A[0] = calloc(n*m,sizeof(*A));
-	if(A[0] == NULL)
+	if ((A = malloc(sizeof(*A)*n)) == NULL)
 	{
 		perror("Error allocating memory");
 		return NULL;
 	}
+	for (i = 0; i < n; i++)
+	{
+		A[i] = data + (size_t)i*ld;
+	}
+	return A;
+}
 
-	// Set up the pointers for the columns
-	for(i = 1; i < n; i++)
+// rows of the storage of a matrix
+static unsigned int stored_rows(matrix mat)
+{
+	return (mat->flags & MATRIX_TRANSPOSED) ? mat->m : mat->n;
+}
+
+// columns of the storage of a matrix
+static unsigned int stored_cols(matrix mat)
+{
+	return (mat->flags & MATRIX_TRANSPOSED) ? mat->n : mat->m;
+}
+
+// element (i,j) of a matrix, wherever it is stored
+static float * element(matrix mat, unsigned int i, unsigned int j)
+{
+	return (mat->flags & MATRIX_TRANSPOSED) ? &mat->A[j][i] : &mat->A[i][j];
+}
+
+// op() of the storage of an operand, a transposed view flips it
+static int stored_trans(matrix mat, int trans)
+{
+	if (mat->flags & MATRIX_TRANSPOSED)
 	{
-		A[i] = A[0] + i*m;
+		return (trans == MATRIX_NOTRANS) ? MATRIX_TRANS : MATRIX_NOTRANS;
+	}
+	return trans;
+}
+
+// the lowest and one past the highest float the rows of a matrix touch,
+// taken over every row pointer since row_swap() and views of swapped
+// matrices leave them in any order
+static void storage_extent(matrix mat, float **lo, float **hi)
+{
+	unsigned int i,rows=stored_rows(mat),cols=stored_cols(mat);
+
+	*lo = *hi = mat->A[0];
+	for (i = 0; i < rows; i++)
+	{
+		if (mat->A[i] < *lo)
+		{
+			*lo = mat->A[i];
+		}
+		if (mat->A[i] + cols > *hi)
+		{
+			*hi = mat->A[i] + cols;
+		}
+	}
+}
+
+// do the storage of two matrices share any memory
+// this compares the ranges their rows span, so rows of one
+// interleaved with rows of the other count as sharing
+static int matrix_overlap(matrix A, matrix B)
+{
+	float *a0,*a1,*b0,*b1;
+
+	if (A == B)
+	{
+		return 1;
+	}
+	storage_extent(A, &a0, &a1);
+	storage_extent(B, &b0, &b1);
+	return a0 < b1 && b0 < a1;
+}
+
+// Allocate space for an n x m matrix
+// the rows are padded so each starts on a MATRIX_ALIGN boundary
+// and A[0] is the start of the block
+float ** matrix_allocate(int n, int m)
+{
+	float **A;
+	float *data;
+	unsigned int ld;
+
+	ld = leading_dimension(m);
+	if ((data = storage_allocate(n, ld)) == NULL)
+	{
+		return NULL;
+	}
+	if ((A = row_pointers(data, n, ld)) == NULL)
+	{
+		free(data);
+		return NULL;
 	}
 	return A;
 }
@@ -62,17 +203,20 @@ void print_matrix(matrix mat)
 	{
 		for (j = 0; j < mat->m; j++)
 		{
-			printf("%.16E\t",mat->A[i][j]);
+			printf("%.16E\t",*element(mat,i,j));
 		}
 		printf("\n");
 	}
 }
 
 // Write a matrix to hard disk
+// the elements are written a row at a time, padded to aligned rows
+// so the file can be mapped with map_matrix()
 int save_matrix(matrix mat, const char *filename)
 {
 	FILE *outfile;
-	unsigned int i,j,b;
+	unsigned int i,j,ld,b;
+	float *row;
 
 	// Attempt to open file for writing
 	if ((outfile = fopen(filename, "w")) == NULL)
@@ -81,106 +225,200 @@ int save_matrix(matrix mat, const char *filename)
 		return 1;
 	}
 
-	// fwrite() may not be portable, but its fast and convenient
-	// Not a problem as long as these files are opened
-	// on the same architecture that created them
-	b = sizeof(*mat)*fwrite(mat,sizeof(*mat),1,outfile);
+	ld = leading_dimension(mat->m);
+	if (datafile_write_header(outfile, DATAFILE_FLOAT32, mat->n, mat->m, ld) != 0)
+	{
+		fclose(outfile);
+		return 1;
+	}
+
+	// our own storage already has the layout of the file
 	for (i = 0; i < mat->n; i++)
 	{
-		for(j = 0; j < mat->m; j++)
+		if (mat->A[i] != mat->data + (size_t)i*ld)
 		{
-			b += sizeof(mat->A)*fwrite(
-					&mat->A[i][j],
-					sizeof(mat->A),
-					1,
-					outfile);
+			break;
 		}
 	}
+	if (i == mat->n && (mat->flags & MATRIX_OWNER)
+			&& !(mat->flags & MATRIX_TRANSPOSED) && mat->ld == ld)
+	{
+		b = fwrite(mat->data, sizeof(*mat->data)*ld, mat->n, outfile);
+	}
+	else
+	{
+		// otherwise each row is gathered into a padded buffer
+		if ((row = vector_allocate(ld)) == NULL)
+		{
+			fclose(outfile);
+			return 1;
+		}
+		for (i = 0, b = 0; i < mat->n; i++)
+		{
+			for (j = 0; j < mat->m; j++)
+			{
+				row[j] = *element(mat,i,j);
+			}
+			b += fwrite(row, sizeof(*row)*ld, 1, outfile);
+		}
+		free(row);
+	}
 
-	// Insert an EOF	
-	fputc(-1,outfile);
-	
-	// Check to make sure all bytes were written
+	// Check to make sure all rows were written
 	// if not, errno should be set
-	if (b != (sizeof(*mat)+(sizeof(mat->A)*mat->n*mat->m)))
+	if (b != mat->n)
 	{
 		perror("Error writing file");
+		fclose(outfile);
 		return 1;
 	}
 
-	fclose(outfile);
-	//printf("Wrote %d bytes to %s\n",b,filename);
+	if (fclose(outfile) != 0)
+	{
+		perror("Error writing file");
+		return 1;
+	}
 	return 0;
 }
 
 // Load a matrix from a file
+// files written before the current format are still understood
 matrix load_matrix(const char *filename)
 {
-	matrix mat,mat_info;
+	matrix mat;
 	FILE *infile;
-	unsigned int i,j,b;
-	struct stat if_stat;
-
-	b = 0;
+	struct datafile_header header;
+	unsigned int i,b;
+	int status,swapped;
 
 	// Attempt to open file for reading
-	if ((infile = fopen(filename, "r+")) == NULL)
+	if ((infile = fopen(filename, "r")) == NULL)
 	{
 		perror("Error opening file");
 		return NULL;
 	}
-	
-	// Read in the dimensions of the old matrix first
-	// and then allocate space for where the rest of it goes
-	if ((mat_info = zero_matrix(1,1)) == NULL) // Only for dimensions
+
+	if ((status = datafile_read_header(infile, filename, &header, &swapped)) != 0)
+	{
+		if (status < 0)
+		{
+			return load_matrix_legacy(infile, filename);
+		}
+		fclose(infile);
+		return NULL;
+	}
+
+	// This is where our matrix will go
+	if ((mat = zero_matrix(header.rows,header.cols)) == NULL)
+	{
+		fclose(infile);
+		return NULL;
+	}
+
+	// read the rows straight into place, in one piece
+	// when the padding of the file matches ours
+	b = 0;
+	if (fseek(infile, header.offset, SEEK_SET) == 0)
+	{
+		if (header.ld == mat->ld)
+		{
+			b = fread(mat->data, sizeof(*mat->data)*mat->ld, mat->n, infile);
+		}
+		else
+		{
+			for (i = 0; i < mat->n; i++)
+			{
+				b += fread(mat->A[i], sizeof(**mat->A)*mat->m, 1, infile);
+				if (fseek(infile, sizeof(**mat->A)*(header.ld - mat->m), SEEK_CUR) != 0)
+				{
+					break;
+				}
+			}
+		}
+	}
+	fclose(infile);
+
+	if (b != mat->n)
 	{
+		perror("Error reading file");
+		free_matrix(mat);
 		return NULL;
 	}
-	b = sizeof(*mat_info)*fread(mat_info,sizeof(*mat_info),1,infile);
+
+	// the file came from a machine of the other byte order
+	if (swapped)
+	{
+		for (i = 0; i < mat->n; i++)
+		{
+			datafile_swap32(mat->A[i], mat->m);
+		}
+	}
+
+	return mat;
+}
+
+// Load a matrix in the format written before the datafile header
+// each element took the space of a pointer after a copy of the struct
+static matrix load_matrix_legacy(FILE *infile, const char *filename)
+{
+	matrix mat;
+	struct matrix_file_header header;
+	union { float f; float *p; } e;
+	unsigned int i,j,b;
+	struct stat if_stat;
+
+	// Read in the dimensions of the old matrix first
+	// and then allocate space for where the rest of it goes
+	b = sizeof(header)*fread(&header,sizeof(header),1,infile);
 
 	// At this point, we should check to make sure the dimensions specified
 	// in the file match the size of the rest of the file. If not, it's very
 	// likely that someone has modified them with intent to corrupt the heap
 	stat(filename,&if_stat);
-	if ((if_stat.st_size - sizeof(*mat_info)-1) !=
-			(sizeof(mat_info->A)*mat_info->n*mat_info->m))
+	if (b != sizeof(header) || (if_stat.st_size - sizeof(header)-1) !=
+			(sizeof(e)*header.n*header.m))
 	{
 		// If we don't catch this here and dimensions are wrong, fread()
 		// will experience errors later trying to read parts of the file
 		// that don't exist
 		fprintf(stderr,"Error: Matrix file has inconsistent dimensions\n");
+		fclose(infile);
 		return NULL;
 	}
 
 	// This is where our matrix will go
-	if ((mat = zero_matrix(mat_info->n,mat_info->m)) == NULL)
+	if ((mat = zero_matrix(header.n,header.m)) == NULL)
 	{
+		fclose(infile);
 		return NULL;
 	}
 
 	// Set offsets
-	mat->x_offset = mat_info->x_offset;
-	mat->y_offset = mat_info->y_offset;
+	mat->x_offset = header.x_offset;
+	mat->y_offset = header.y_offset;
 	
 	// Read in each value of the matrix
 	for (i = 0; i < mat->n; i++)
 	{
 		for(j = 0; j < mat->m; j++)
 		{
-			b += sizeof(mat->A)*fread(
-					&mat->A[i][j],
-					sizeof(mat->A),
+			b += sizeof(e)*fread(
+					&e,
+					sizeof(e),
 					1,
 					infile);
+			mat->A[i][j] = e.f;
 		}
 	}
 	
 	// Check the number of bytes read against the number we expect
 	// if perror() returns "Success" here, it's very likely that someone
 	// has modified the matrix file with intent to corrupt the heap
-	if (b != (sizeof(*mat)+(sizeof(mat->A)*mat->n*mat->m)))
+	if (b != (sizeof(header)+(sizeof(e)*mat->n*mat->m)))
 	{
 		perror("Error reading file");
+		fclose(infile);
+		free_matrix(mat);
 		return NULL;
 	}
 
@@ -189,12 +427,47 @@ matrix load_matrix(const char *filename)
 	return mat;
 }
 
+// Map a matrix file into memory without reading it
+// the matrix is read only and shares pages with the file cache,
+// so mapping a large operator is nearly free until it is used
+matrix map_matrix(const char *filename)
+{
+	matrix mat;
+	struct datafile_header header;
+	float *data;
+
+	if ((data = datafile_map(filename, &header)) == NULL)
+	{
+		return NULL;
+	}
+
+	if ((mat = malloc(sizeof(*mat))) == NULL)
+	{
+		perror("Error allocating memory");
+		datafile_unmap(data, header.bytes);
+		return NULL;
+	}
+	mat->n = header.rows;
+	mat->m = header.cols;
+	mat->x_offset = 1;
+	mat->y_offset = 1;
+	mat->data = data;
+	mat->ld = header.ld;
+	mat->flags = MATRIX_MAPPED;
+	if ((mat->A = row_pointers(data, mat->n, mat->ld)) == NULL)
+	{
+		datafile_unmap(data, header.bytes);
+		free(mat);
+		return NULL;
+	}
+
+	return mat;
+}
+
 // Return matrix C = AB
 matrix mult_matrix(matrix A, matrix B)
 {
 	matrix C;
-	unsigned int i,j,k;
-	float sum;
 
 	// Make sure we can multiply these matrices
 	if(A->m != B->n)
@@ -213,33 +486,98 @@ matrix mult_matrix(matrix A, matrix B)
 	C->x_offset = A->x_offset;
 	C->y_offset = B->y_offset;
 
-	// This is the O(k*n*m) algorithm for matrix multiplication
-	for(i = 0; i < A->n; i++)
+	// cache blocked O(k*n*m) product
+	if (gemm_blocked(stored_trans(A, MATRIX_NOTRANS), stored_trans(B, MATRIX_NOTRANS),
+			A->n, B->m, A->m, 1., A->A, 0, B->A, 0, 0., C->A, 0) != 0)
 	{
-		for(j = 0; j < B->m; j++)
-		{
-			sum = 0.;
-			for(k = 0; k < A->n; k++)
-			{
-				sum += A->A[i][k] * B->A[k][j];
-			}
-			C->A[i][j] = sum;
-		}
+		free_matrix(C);
+		return NULL;
 	}
 
 	return C;
 
 }
 
+// C = alpha*op(A)*op(B) + beta*C
+// any of the matrices may be views, including transposed views
+// returns 0 on success and 1 if the matrices are incompatible
+// or memory runs out
+int matrix_gemm(int transa, int transb, float alpha, matrix A, matrix B,
+		float beta, matrix C)
+{
+	unsigned int n,m,k,kb;
+	int status;
+	matrix T; // result space when C is also an operand
+
+	// dimensions of op(A) and op(B)
+	n = (transa == MATRIX_NOTRANS) ? A->n : A->m;
+	k = (transa == MATRIX_NOTRANS) ? A->m : A->n;
+	kb = (transb == MATRIX_NOTRANS) ? B->n : B->m;
+	m = (transb == MATRIX_NOTRANS) ? B->m : B->n;
+
+	if (k != kb || C->n != n || C->m != m)
+	{
+		fprintf(stderr, "Matrices are dimensionally incompatible.");
+		return 1;
+	}
+
+	// the product is built in place, so an operand that
+	// shares memory with the output is first multiplied
+	// into scratch space
+	if (matrix_overlap(C, A) || matrix_overlap(C, B))
+	{
+		if ((T = zero_matrix(n, m)) == NULL)
+		{
+			return 1;
+		}
+		if (beta != 0.)
+		{
+			matrix_set(T, C);
+		}
+		if ((status = matrix_gemm(transa, transb, alpha, A, B, beta, T)) == 0)
+		{
+			matrix_set(C, T);
+		}
+		free_matrix(T);
+		return status;
+	}
+
+	transa = stored_trans(A, transa);
+	transb = stored_trans(B, transb);
+	if (C->flags & MATRIX_TRANSPOSED)
+	{
+		// C^T = op(B)^T op(A)^T
+		return gemm_blocked(!transb, !transa, m, n, k,
+				alpha, B->A, 0, A->A, 0, beta, C->A, 0);
+	}
+	return gemm_blocked(transa, transb, n, m, k,
+			alpha, A->A, 0, B->A, 0, beta, C->A, 0);
+}
+
 // A = B
 void matrix_set(matrix A, matrix B)
 {
 	unsigned int i,j;
-	for (i = 0; i < A->n; i++)
+
+	// the same layout is copied a row of storage at a time
+	if ((A->flags & MATRIX_TRANSPOSED) == (B->flags & MATRIX_TRANSPOSED))
 	{
-		for (j = 0; j < A->m; j++)
+		for (i = 0; i < stored_rows(A); i++)
 		{
-			A->A[i][j] = B->A[i][j];
+			if (A->A[i] != B->A[i])
+			{
+				memmove(A->A[i], B->A[i], sizeof(**A->A)*stored_cols(A));
+			}
+		}
+		return;
+	}
+
+	// otherwise the storage of A is the transpose of that of B
+	for (i = 0; i < stored_rows(A); i++)
+	{
+		for (j = 0; j < stored_cols(A); j++)
+		{
+			A->A[i][j] = B->A[j][i];
 		}
 	}
 }
@@ -248,9 +586,11 @@ void matrix_set(matrix A, matrix B)
 void matrix_set_identity(matrix A)
 {
 	unsigned int i,j;
-	for (i = 0; i < A->n; i++)
+
+	// the identity is its own transpose
+	for (i = 0; i < stored_rows(A); i++)
 	{
-		for (j = 0; j < A->m; j++)
+		for (j = 0; j < stored_cols(A); j++)
 		{
 			if (i == j) A->A[i][j] = 1.0;
 			else A->A[i][j] = 0.0;
@@ -261,84 +601,42 @@ void matrix_set_identity(matrix A)
 // A = AB
 void matrix_product(matrix A, matrix B)
 {
-	float product[A->n][B->m]; // temporary space for our product
-	float sum;
-	unsigned int i,j,k;
-
-	// check dimension
-	if (A->m != B->n)
+	// check dimension, the product must fit back into A
+	if (A->m != B->n || B->n != B->m)
 	{
 		fprintf(stderr, "Matrices are dimensionally incompatible.");
 		return;
 	}
 
-	// multiply matrices
-	for (i = 0; i < A->n; i++)
-	{
-		for (j = 0; j < B->m; j++)
-		{
-			sum = 0.0;
-			for (k = 0; k < A->n; k++)
-			{
-				sum += A->A[i][k] * B->A[k][j];
-			}
-			product[i][j] = sum;
-		}
-	}
-
-	// set A = product
-	for (i = 0; i < A->n; i++)
-	{
-		for (j = 0; j < B->m; j++)
-		{
-			A->A[i][j] = product[i][j];
-		}
-	}
+	matrix_gemm(MATRIX_NOTRANS, MATRIX_NOTRANS, 1., A, B, 0., A);
 }
 
 // B = AB
 void matrix_product_rev(matrix A, matrix B)
 {
-	float product[A->n][B->m]; // temporary space for our product
-	float sum;
-	unsigned int i,j,k;
-
-	// check dimension
-	if (A->m != B->n)
+	// check dimension, the product must fit back into B
+	if (A->m != B->n || A->n != A->m)
 	{
 		fprintf(stderr, "Matrices are dimensionally incompatible.");
 		return;
 	}
 
-	// multiply matrices
-	for (i = 0; i < A->n; i++)
-	{
-		for (j = 0; j < B->m; j++)
-		{
-			sum = 0.0;
-			for (k = 0; k < A->n; k++)
-			{
-				sum += A->A[i][k] * B->A[k][j];
-			}
-			product[i][j] = sum;
-		}
-	}
-
-	// set A = product
-	for (i = 0; i < A->n; i++)
-	{
-		for (j = 0; j < B->m; j++)
-		{
-			B->A[i][j] = product[i][j];
-		}
-	}
+	matrix_gemm(MATRIX_NOTRANS, MATRIX_NOTRANS, 1., A, B, 0., B);
 }
 
 // Set up a matrix structure
+// the matrix owns one zeroed block of storage with aligned rows
 matrix zero_matrix(unsigned int n, unsigned int m)
 {
 	matrix mat;
 	
+	// Make sure dimensions are >=1
+	if(n < 1 || m < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return NULL;
+	}
+
 	if((mat = malloc(sizeof(*mat))) == NULL)
 	{
 		perror("Error allocating memory");
@@ -348,24 +646,25 @@ matrix zero_matrix(unsigned int n, unsigned int m)
 	// Set offsets
 	mat->x_offset = 1;
 	mat->y_offset = 1;
-
-	// Make sure dimensions are >=1
-	if(n < 1 || m < 1)
-	{
-		fprintf(stderr,"Error: dimensions must be >=1\n");
-		return NULL;
-	}
 	mat->n = n;
 	mat->m = m;
+	mat->ld = leading_dimension(m);
+	mat->flags = MATRIX_OWNER;
 
 	// Allocate space for the actual matrix
-	// errors are identified by matrix_allocate(),
+	// errors are identified by the allocators,
 	// so this is just to clean up
-	if((mat->A = matrix_allocate(n,m)) == NULL)
+	if((mat->data = storage_allocate(n,mat->ld)) == NULL)
 	{
 		free(mat);
 		return NULL;
 	}
+	if((mat->A = row_pointers(mat->data,n,mat->ld)) == NULL)
+	{
+		free(mat->data);
+		free(mat);
+		return NULL;
+	}
 
 	return mat;
 }
@@ -440,14 +739,25 @@ void row_swap(float **A, int row1, int row2)
 void row_swap_partial(matrix mat, int row1, int row2, int min_col, int max_col)
 {
 	float tmp;
-	int i;
-	
-	for(i=min_col; i <= max_col; i++)
+	int j;
+
+	if (max_col < min_col)
 	{
-		tmp = mat->A[row2-1][i-1];
-		mat->A[row2-1][i-1] = mat->A[row1-1][i-1];
-		mat->A[row1-1][i-1] = tmp;
+		return;
 	}
+	// rows of a transposed view are columns of its storage
+	if (mat->flags & MATRIX_TRANSPOSED)
+	{
+		for (j=min_col; j <= max_col; j++)
+		{
+			tmp = mat->A[j-1][row2-1];
+			mat->A[j-1][row2-1] = mat->A[j-1][row1-1];
+			mat->A[j-1][row1-1] = tmp;
+		}
+		return;
+	}
+	mathlib_kernels->swap(max_col-min_col+1, &mat->A[row1-1][min_col-1],
+			&mat->A[row2-1][min_col-1]);
 }
 
 // partial column swap
@@ -456,6 +766,17 @@ void col_swap_partial(matrix mat, int col1, int col2, int min_row, int max_row)
 	float tmp;
 	int i;
 
+	if (max_row < min_row)
+	{
+		return;
+	}
+	// columns of a transposed view are rows of its storage
+	if (mat->flags & MATRIX_TRANSPOSED)
+	{
+		mathlib_kernels->swap(max_row-min_row+1, &mat->A[col1-1][min_row-1],
+				&mat->A[col2-1][min_row-1]);
+		return;
+	}
 	for(i=min_row; i <= max_row; i++)
 	{
 		tmp = mat->A[i-1][col2-1];
@@ -465,18 +786,100 @@ void col_swap_partial(matrix mat, int col1, int col2, int min_row, int max_row)
 }
 
 // Free a matrix and its struct
+// a view only frees its row pointers, the data belongs to its parent
 void free_matrix(matrix mat)
 {
-	if(mat->A != NULL)
+	if(mat == NULL)
 	{
-		free(mat->A[0]);
-		free(mat->A);
-		mat->A = NULL;
+		return;
 	}
-	if(mat != NULL)
+	if(mat->flags & MATRIX_OWNER)
 	{
-		free(mat);
-		mat = NULL;
+		free(mat->data);
+	}
+	if(mat->flags & MATRIX_MAPPED)
+	{
+		datafile_unmap(mat->data, sizeof(*mat->data)*mat->n*mat->ld);
 	}
+	free(mat->A);
+	free(mat);
 }
 
+// the n x m block of A with its top left corner at element (i,j)
+// the view shares storage with A, so writes to either show in both
+// a block of a transposed view is itself a transposed view
+matrix matrix_view(matrix A, unsigned int i, unsigned int j,
+		unsigned int n, unsigned int m)
+{
+	matrix view;
+	unsigned int r,row,col,rows;
+
+	if (n < 1 || m < 1 || i > A->n || n > A->n - i || j > A->m || m > A->m - j)
+	{
+		fprintf(stderr,"Error: view out of bounds\n");
+		return NULL;
+	}
+
+	if ((view = malloc(sizeof(*view))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	view->n = n;
+	view->m = m;
+	view->x_offset = A->x_offset + i;
+	view->y_offset = A->y_offset + j;
+	view->ld = A->ld;
+	view->flags = A->flags & MATRIX_TRANSPOSED;
+
+	// the corner and extent of the block in the storage of A
+	row = (A->flags & MATRIX_TRANSPOSED) ? j : i;
+	col = (A->flags & MATRIX_TRANSPOSED) ? i : j;
+	rows = (A->flags & MATRIX_TRANSPOSED) ? m : n;
+
+	// the rows come from the row pointers of A rather than
+	// from its data, so views of row swapped matrices work
+	if ((view->A = malloc(sizeof(*view->A)*rows)) == NULL)
+	{
+		perror("Error allocating memory");
+		free(view);
+		return NULL;
+	}
+	for (r = 0; r < rows; r++)
+	{
+		view->A[r] = A->A[row+r] + col;
+	}
+	view->data = view->A[0];
+
+	return view;
+}
+
+// rows i through i+n-1 of A
+matrix matrix_rows(matrix A, unsigned int i, unsigned int n)
+{
+	return matrix_view(A, i, 0, n, A->m);
+}
+
+// columns j through j+m-1 of A
+matrix matrix_cols(matrix A, unsigned int j, unsigned int m)
+{
+	return matrix_view(A, 0, j, A->n, m);
+}
+
+// A^T without moving any data
+matrix matrix_transpose_view(matrix A)
+{
+	matrix view;
+
+	if ((view = matrix_view(A, 0, 0, A->n, A->m)) == NULL)
+	{
+		return NULL;
+	}
+	view->n = A->m;
+	view->m = A->n;
+	view->x_offset = A->y_offset;
+	view->y_offset = A->x_offset;
+	view->flags ^= MATRIX_TRANSPOSED;
+
+	return view;
+}
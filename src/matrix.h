@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
 #include <sys/stat.h>
 
 // Store dimensions and offsets with a matrix
@@ -17,15 +18,35 @@ typedef struct
 	unsigned int m; // number of columns (width) of matrix
 	unsigned int x_offset; // coordinates of sub matrix 1 <= x_offset <= n
 	unsigned int y_offset; // coordinates of sub matrix 1 <= y_offset <= m
-	float **A;
+	float **A; // row pointers into data
+	float *data; // first element, rows are ld floats apart
+	unsigned int ld; // leading dimension of data
+	unsigned int flags;
 } *matrix;
 
+// op() applied to an operand of matrix_gemm
+#define MATRIX_NOTRANS 0 // op(A) = A
+#define MATRIX_TRANS 1 // op(A) = A^T
+
+// matrix flags
+#define MATRIX_OWNER 1 // data is freed with the matrix, views don't own it
+#define MATRIX_TRANSPOSED 2 // element (i,j) is A[j][i], A has m rows of n
+#define MATRIX_MAPPED 4 // data is a read only mapping of a file
+
+// rows of allocated matrices start on a boundary of this many bytes
+#define MATRIX_ALIGN 64
+
 // prototypes for matrix functions
 extern float ** matrix_allocate(int n, int m);
 extern void print_matrix(matrix mat);
 extern int save_matrix(matrix mat, const char *filename);
 extern matrix load_matrix(const char *filename);
+// the matrix in a file saved by save_matrix(), used in place
+// read only, free_matrix() unmaps it
+extern matrix map_matrix(const char *filename);
 extern matrix mult_matrix(matrix A, matrix B);
+extern int matrix_gemm(int transa, int transb, float alpha, matrix A, matrix B,
+		float beta, matrix C);
 extern void matrix_set(matrix A, matrix B);
 extern void matrix_set_identity(matrix A);
 extern void matrix_product(matrix A, matrix B);
@@ -38,6 +59,13 @@ extern void row_swap(float **A, int row1, int row2);
 extern void row_swap_partial(matrix mat, int row1, int row2, int min_col, int max_col);
 extern void col_swap_partial(matrix mat, int col1, int col2, int min_row, int max_row);
 extern void free_matrix(matrix mat);
+// views share the storage of A, 0 <= i < A->n and 0 <= j < A->m
+// they are released with free_matrix(), which leaves the data alone
+extern matrix matrix_view(matrix A, unsigned int i, unsigned int j,
+		unsigned int n, unsigned int m);
+extern matrix matrix_rows(matrix A, unsigned int i, unsigned int n);
+extern matrix matrix_cols(matrix A, unsigned int j, unsigned int m);
+extern matrix matrix_transpose_view(matrix A);
 
 #endif
 
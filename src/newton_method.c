@@ -4,16 +4,21 @@ float newton_method(float x0, polynomial f, polynomial fprime);
 
 float newton_method(float x0, polynomial f, polynomial fprime)
 {
-	int i=0;
-	float nextx,lastx;
+	int i;
+	float x,fx;
 
-	lastx=x0;
-	do
+	// f is evaluated once per iteration
+	x = x0;
+	for (i=0; i < NEWTON_MAXITER; i++)
 	{
-		nextx = lastx - (*f)(lastx)/(*fprime)(lastx);
-		lastx = nextx;
-		i++;
-	}while(fabs((*f)(lastx)) > FLT_EPSILON);
+		fx = (*f)(x);
+		if (fabs(fx) <= FLT_EPSILON)
+		{
+			return x;
+		}
+		x = x - fx/(*fprime)(x);
+	}
 
-	return nextx;
+	fprintf(stderr,"Newton's method did not converge from %g\n",x0);
+	return NAN;
 }
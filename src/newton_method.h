@@ -6,11 +6,17 @@
 #ifndef NEWTON_METHOD_H
 #define NEWTON_METHOD_H
 
+#include <stdio.h>
 #include <math.h>
 #include <float.h>
 
+// iterations before newton_method gives up
+#define NEWTON_MAXITER 100
+
 typedef float(*polynomial)(float); 
 
+// the root near x0, NaN if it isn't found in NEWTON_MAXITER steps
+// root_newton() and root_brent() are safer and return a status
 extern float newton_method(float x0, polynomial f, polynomial fprime);
 
 #endif
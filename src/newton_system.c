@@ -0,0 +1,314 @@
+/* Newton's method for nonlinear systems F(x)=0
+ * Oct 18 2026 */
+
+#include "newton_system.h"
+
+// buffers and state of one solve
+struct newton_work
+{
+	system_func F;
+	system_jacobian jac; // NULL for finite differences
+	void *userdata;
+	unsigned int n;
+	float *f; // F at the current point, 3n floats
+	float *ft; // F at the trial point
+	float *xt; // the trial point
+	vector b, dx; // right hand side and solution of J dx = -F
+	matrix J;
+	lu_handle lu; // factors of a recent J
+};
+
+// a finite difference Jacobian, NEWTON_JAC_COLS columns per task
+struct jacobian_job
+{
+	system_func F;
+	void *userdata;
+	unsigned int n;
+	const float *x;
+	const float *f; // F(x)
+	matrix J;
+	int failed;
+};
+
+int newton_system(system_func F, system_jacobian jac, void *userdata,
+		vector x, float ftol, float xtol, unsigned int maxiter, int method,
+		unsigned int m, struct newton_stats *stats);
+
+// max |a_i|, inf if any is not finite
+static float max_norm(unsigned int n, const float *a);
+// the 2-norm
+static double two_norm(unsigned int n, const float *a);
+// the Jacobian at x into w->J, returns 0 on success
+static int jacobian(struct newton_work *w, const float *x, const float *f,
+		struct newton_stats *count);
+// the columns of one task of a finite difference Jacobian
+static void jacobian_task(void *arg, unsigned int t);
+// the iteration itself, returns a status
+static int newton_iterate(struct newton_work *w, vector x, float ftol,
+		float xtol, unsigned int maxiter, int method, unsigned int m,
+		struct newton_stats *count);
+
+// max |a_i|
+static float max_norm(unsigned int n, const float *a)
+{
+	unsigned int i;
+	float norm=0.;
+
+	for (i=0; i < n; i++)
+	{
+		if (!isfinite(a[i]))
+		{
+			return INFINITY;
+		}
+		norm = fmaxf(norm, fabsf(a[i]));
+	}
+	return norm;
+}
+
+// the 2-norm, accumulated in double
+static double two_norm(unsigned int n, const float *a)
+{
+	unsigned int i;
+	double sum=0.;
+
+	for (i=0; i < n; i++)
+	{
+		sum += (double)a[i]*a[i];
+	}
+	return sqrt(sum);
+}
+
+// forward differences of the columns t*NEWTON_JAC_COLS ... of J
+static void jacobian_task(void *arg, unsigned int t)
+{
+	struct jacobian_job *job = arg;
+	unsigned int n=job->n;
+	unsigned int first=t*NEWTON_JAC_COLS;
+	unsigned int last=first+NEWTON_JAC_COLS;
+	unsigned int i,j;
+	float *xj,*fj,delta;
+
+	// each task perturbs its own copy of x
+	if ((xj = vector_allocate(2*n)) == NULL)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	fj = xj+n;
+	memcpy(xj, job->x, sizeof(*xj)*n);
+
+	if (last > n)
+	{
+		last = n;
+	}
+	for (j=first; j < last; j++)
+	{
+		// a step of about sqrt(eps) relative to x_j, or to 1 near 0
+		delta = sqrtf(FLT_EPSILON)*fmaxf(fabsf(job->x[j]), 1.f);
+		xj[j] = job->x[j] + delta;
+		// the step actually taken after rounding
+		delta = xj[j] - job->x[j];
+		(*job->F)(xj, fj, n, job->userdata);
+		for (i=0; i < n; i++)
+		{
+			job->J->A[i][j] = (fj[i] - job->f[i])/delta;
+		}
+		xj[j] = job->x[j];
+	}
+	free(xj);
+}
+
+// the Jacobian at x, by forward differences if jac is NULL
+static int jacobian(struct newton_work *w, const float *x, const float *f,
+		struct newton_stats *count)
+{
+	struct jacobian_job job;
+	unsigned int n=w->n;
+
+	count->jacobians++;
+	if (w->jac != NULL)
+	{
+		(*w->jac)(x, w->J, n, w->userdata);
+		return 0;
+	}
+
+	job.F = w->F;
+	job.userdata = w->userdata;
+	job.n = n;
+	job.x = x;
+	job.f = f;
+	job.J = w->J;
+	job.failed = 0;
+	parallel_for((n + NEWTON_JAC_COLS - 1)/NEWTON_JAC_COLS, &jacobian_task, &job);
+	count->evaluations += n;
+
+	return job.failed;
+}
+
+// allocate the work and iterate
+int newton_system(system_func F, system_jacobian jac, void *userdata,
+		vector x, float ftol, float xtol, unsigned int maxiter, int method,
+		unsigned int m, struct newton_stats *stats)
+{
+	struct newton_work w;
+	int status=ROOT_NO_CONVERGENCE;
+	struct newton_stats count = { 0, 0, 0, 0, INFINITY };
+
+	if (method != NEWTON_FULL && method != NEWTON_CHORD
+			&& method != NEWTON_SHAMANSKII)
+	{
+		fprintf(stderr,"Error: unknown Newton variant %d\n",method);
+		return ROOT_NO_CONVERGENCE;
+	}
+
+	memset(&w, 0, sizeof(w));
+	w.F = F;
+	w.jac = jac;
+	w.userdata = userdata;
+	w.n = x->n;
+	if ((w.f = vector_allocate(3*w.n)) != NULL
+			&& (w.b = zero_vector(w.n)) != NULL
+			&& (w.dx = zero_vector(w.n)) != NULL
+			&& (w.J = zero_matrix(w.n, w.n)) != NULL)
+	{
+		w.ft = w.f + w.n;
+		w.xt = w.ft + w.n;
+		status = newton_iterate(&w, x, ftol, xtol,
+				(maxiter > 0) ? maxiter : ROOT_DEFAULT_MAXITER, method,
+				(method == NEWTON_FULL || m == 0) ? 1 : m, &count);
+	}
+
+	if (stats != NULL)
+	{
+		*stats = count;
+	}
+	lu_handle_release(w.lu);
+	if (w.J != NULL)
+	{
+		free_matrix(w.J);
+	}
+	if (w.dx != NULL)
+	{
+		free_vector(w.dx);
+	}
+	if (w.b != NULL)
+	{
+		free_vector(w.b);
+	}
+	free(w.f);
+	return status;
+}
+
+// Newton's method with the Jacobian factored every iteration, or kept
+// as long as it keeps reducing |F| quickly enough, after Kelley,
+// Solving Nonlinear Equations with Newton's Method
+static int newton_iterate(struct newton_work *w, vector x, float ftol,
+		float xtol, unsigned int maxiter, int method, unsigned int m,
+		struct newton_stats *count)
+{
+	unsigned int n=w->n;
+	unsigned int i,k,age;
+	float *f=w->f,*ft=w->ft,*xt=w->xt;
+	double norm,norm_t=0.,lambda;
+	int status,fresh,refresh,small,decrease=0;
+
+	(*w->F)(x->a, f, n, w->userdata);
+	count->evaluations++;
+	norm = two_norm(n, f);
+	count->residual = max_norm(n, f);
+	if (count->residual <= ftol)
+	{
+		return ROOT_OK;
+	}
+	if (!isfinite(count->residual))
+	{
+		return ROOT_NOT_FINITE;
+	}
+
+	age = 0;
+	refresh = 1;
+	status = ROOT_NO_CONVERGENCE;
+	for (k=0; k < maxiter && status == ROOT_NO_CONVERGENCE; k++)
+	{
+		count->iterations++;
+
+		// a new factorization when the variant calls for one,
+		// or when the old one has stopped paying for itself
+		fresh = 0;
+		if (refresh || method == NEWTON_FULL
+				|| (method == NEWTON_SHAMANSKII && age >= m))
+		{
+			lu_handle_release(w->lu);
+			w->lu = NULL;
+			if (jacobian(w, x->a, f, count) != 0)
+			{
+				return ROOT_NO_CONVERGENCE;
+			}
+			count->factorizations++;
+			if ((w->lu = lu_handle_factor(w->J, LU_PARTIAL_PIVOTING)) == NULL)
+			{
+				return ROOT_SINGULAR;
+			}
+			age = 0;
+			refresh = 0;
+			fresh = 1;
+		}
+
+		// J dx = -F
+		for (i=0; i < n; i++)
+		{
+			w->b->a[i] = -f[i];
+		}
+		if (lu_handle_solve(w->lu, w->dx, w->b) != 0)
+		{
+			return ROOT_NO_CONVERGENCE;
+		}
+
+		// a fresh direction is cut back until |F| decreases,
+		// a stale one that doesn't do it is replaced
+		for (lambda=1.; ; lambda *= 0.5)
+		{
+			for (i=0; i < n; i++)
+			{
+				xt[i] = x->a[i] + lambda*w->dx->a[i];
+			}
+			(*w->F)(xt, ft, n, w->userdata);
+			count->evaluations++;
+			norm_t = two_norm(n, ft);
+			decrease = isfinite(norm_t) && norm_t <= (1. - 1e-4*lambda)*norm;
+			if (decrease || !fresh || lambda < 1./(1 << NEWTON_BACKTRACK))
+			{
+				break;
+			}
+		}
+		if (!decrease)
+		{
+			if (fresh)
+			{
+				return isfinite(norm_t) ? ROOT_NO_CONVERGENCE : ROOT_NOT_FINITE;
+			}
+			refresh = 1;
+			continue;
+		}
+
+		// accept the step, only a full one that was small counts as
+		// convergence, a short backtracked one says nothing about it
+		small = (lambda == 1.);
+		for (i=0; small && i < n; i++)
+		{
+			small = fabsf(w->dx->a[i]) <= xtol + 4*FLT_EPSILON*fabsf(xt[i]);
+		}
+		memcpy(x->a, xt, sizeof(*xt)*n);
+		memcpy(f, ft, sizeof(*ft)*n);
+		refresh = norm_t > NEWTON_RATIO*norm;
+		norm = norm_t;
+		count->residual = max_norm(n, f);
+		age++;
+
+		if (count->residual <= ftol || small)
+		{
+			status = ROOT_OK;
+		}
+	}
+	return status;
+}
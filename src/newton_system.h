@@ -0,0 +1,58 @@
+/* Newton's method for nonlinear systems F(x)=0
+ * Oct 18 2026 */
+
+#ifndef NEWTON_SYSTEM_H
+#define NEWTON_SYSTEM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "linear_system.h"
+#include "root_finding.h"
+#include "thread_pool.h"
+
+// how often the Jacobian is factored
+#define NEWTON_FULL 0 // every iteration
+#define NEWTON_CHORD 1 // once, and again only when convergence stalls
+#define NEWTON_SHAMANSKII 2 // every m iterations, and when convergence stalls
+
+// a factorization is replaced when a step reduces |F| by less than this
+#define NEWTON_RATIO 0.5
+// halvings of a step tried along a fresh Newton direction
+#define NEWTON_BACKTRACK 10
+// columns of a finite difference Jacobian formed by one task
+#define NEWTON_JAC_COLS 8
+
+// F(x) for n equations
+typedef void (*system_func)(const float *x, float *F, int n, void *userdata);
+// the Jacobian J[i][j] = dF_i/dx_j at x, J is n x n
+typedef void (*system_jacobian)(const float *x, matrix J, int n,
+		void *userdata);
+
+// work done by newton_system
+struct newton_stats
+{
+	unsigned long iterations;
+	unsigned long evaluations; // of F, including finite differences
+	unsigned long jacobians;
+	unsigned long factorizations;
+	float residual; // max |F_i| at the returned x
+};
+
+// solve F(x)=0 starting from x, where the solution is left, converged when
+// max |F_i| <= ftol or a full, undamped Newton step has every
+// |dx_i| <= xtol + 4*FLT_EPSILON*|x_i|
+// jac may be NULL for a finite difference Jacobian computed a few
+// columns per thread, in which case F is called from several threads
+// at once, m is the refactoring interval of NEWTON_SHAMANSKII and
+// stats may be NULL, returns ROOT_OK or another root finder status
+extern int newton_system(system_func F, system_jacobian jac, void *userdata,
+		vector x, float ftol, float xtol, unsigned int maxiter, int method,
+		unsigned int m, struct newton_stats *stats);
+
+#endif
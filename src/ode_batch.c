@@ -0,0 +1,299 @@
+/* Integration of many initial conditions at once
+ * Oct 18 2026 */
+
+#include "ode_batch.h"
+
+// one integration split into tasks of ODE_BATCH_WIDTH trajectories
+struct batch_job
+{
+	int method;
+	ode_batch_rhs f;
+	void *userdata;
+	vector_function vf; // set instead of f for ode_batch_vecfunc()
+	matrix Y0;
+	matrix Y;
+	unsigned int n; // equations per trajectory
+	unsigned int steps; // rows euler_method() would give
+	float tmin, h;
+	unsigned int every;
+	ode_batch_sink sink;
+	void *arg;
+	int failed; // set by any task, the others stop at their next step
+};
+
+int ode_batch(int method, ode_batch_rhs f, void *userdata, matrix Y0,
+		float tmin, float tmax, float h, matrix Y);
+int ode_batch_stream(int method, ode_batch_rhs f, void *userdata,
+		matrix Y0, float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+int ode_batch_vecfunc(int method, vector_function f, matrix Y0,
+		float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+
+// check the arguments and run the tasks
+static int batch_run(struct batch_job *job, float tmax);
+// integrate one block of trajectories
+static void batch_task(void *arg, unsigned int t);
+static int batch_integrate(struct batch_job *job, matrix S, matrix view,
+		float *row, unsigned int first);
+// dydt = f(t, y) for count trajectories
+static void batch_eval(struct batch_job *job, float *row, double t,
+		const float *y, float *dydt, unsigned int count, unsigned int ld);
+
+// final states only
+int ode_batch(int method, ode_batch_rhs f, void *userdata, matrix Y0,
+		float tmin, float tmax, float h, matrix Y)
+{
+	return ode_batch_stream(method, f, userdata, Y0, tmin, tmax, h, 1,
+			NULL, NULL, Y);
+}
+
+// final states and every every-th step to sink
+int ode_batch_stream(int method, ode_batch_rhs f, void *userdata,
+		matrix Y0, float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y)
+{
+	struct batch_job job;
+
+	memset(&job, 0, sizeof(job));
+	job.method = method;
+	job.f = f;
+	job.userdata = userdata;
+	job.Y0 = Y0;
+	job.Y = Y;
+	job.n = Y0->m;
+	job.tmin = tmin;
+	job.h = h;
+	job.every = every;
+	job.sink = sink;
+	job.arg = arg;
+
+	return batch_run(&job, tmax);
+}
+
+// the same, the component functions are called one trajectory at a time
+int ode_batch_vecfunc(int method, vector_function f, matrix Y0,
+		float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y)
+{
+	struct batch_job job;
+
+	if (f->n != Y0->m)
+	{
+		fprintf(stderr,"System has inconsistent dimensions\n");
+		return 1;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.method = method;
+	job.vf = f;
+	job.Y0 = Y0;
+	job.Y = Y;
+	job.n = Y0->m;
+	job.tmin = tmin;
+	job.h = h;
+	job.every = every;
+	job.sink = sink;
+	job.arg = arg;
+
+	return batch_run(&job, tmax);
+}
+
+// check the arguments and run the tasks
+static int batch_run(struct batch_job *job, float tmax)
+{
+	unsigned int tasks;
+	int steps=(int)((tmax-job->tmin)/job->h);
+
+	if (job->method != ODE_BATCH_EULER && job->method != ODE_BATCH_RK4)
+	{
+		fprintf(stderr,"Error: unknown integration method %d\n",job->method);
+		return 1;
+	}
+	if (job->Y != NULL && (job->Y->n != job->Y0->n || job->Y->m != job->Y0->m))
+	{
+		fprintf(stderr,"System has inconsistent dimensions\n");
+		return 1;
+	}
+	if (steps < 1)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1\n");
+		return 1;
+	}
+	job->steps = steps;
+	if (job->every == 0)
+	{
+		job->every = 1;
+	}
+
+	tasks = (job->Y0->n + ODE_BATCH_WIDTH - 1)/ODE_BATCH_WIDTH;
+	parallel_for(tasks, &batch_task, job);
+
+	return __atomic_load_n(&job->failed, __ATOMIC_RELAXED);
+}
+
+// dydt = f(t, y) for count trajectories, a vector_function is
+// handed the row [t y1 ... yn] of each trajectory in turn
+static void batch_eval(struct batch_job *job, float *row, double t,
+		const float *y, float *dydt, unsigned int count, unsigned int ld)
+{
+	unsigned int n=job->n;
+	unsigned int i,k;
+
+	if (job->vf == NULL)
+	{
+		(*job->f)(t, y, dydt, n, count, ld, job->userdata);
+		return;
+	}
+
+	row[0] = t;
+	for (k=0; k < count; k++)
+	{
+		for (i=0; i < n; i++)
+		{
+			row[i+1] = y[i*ld+k];
+		}
+		for (i=0; i < n; i++)
+		{
+			dydt[i*ld+k] = (*job->vf->f[i])(row, n+1);
+		}
+	}
+}
+
+// integrate trajectories t*ODE_BATCH_WIDTH ... of the job
+static void batch_task(void *arg, unsigned int t)
+{
+	struct batch_job *job = arg;
+	unsigned int n=job->n;
+	unsigned int first=t*ODE_BATCH_WIDTH;
+	unsigned int count;
+	matrix S=NULL,view=NULL;
+	float *row=NULL;
+
+	count = job->Y0->n - first;
+	if (count > ODE_BATCH_WIDTH)
+	{
+		count = ODE_BATCH_WIDTH;
+	}
+
+	// the state, a stage and four slopes, each n rows of count
+	if ((S = zero_matrix(6*n, count)) == NULL
+			|| (view = matrix_view(S, 0, 0, n, count)) == NULL
+			|| (job->vf != NULL && (row = vector_allocate(n+1)) == NULL)
+			|| batch_integrate(job, S, view, row, first) != 0)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+
+	if (view != NULL)
+	{
+		free_matrix(view);
+	}
+	if (S != NULL)
+	{
+		free_matrix(S);
+	}
+	free(row);
+}
+
+// integrate the trajectories first ... first+view->m-1 in structure
+// of arrays blocks, rows of S are one component of every trajectory
+static int batch_integrate(struct batch_job *job, matrix S, matrix view,
+		float *row, unsigned int first)
+{
+	unsigned int n=job->n;
+	unsigned int count=view->m;
+	unsigned int ld=S->ld;
+	unsigned int i,j,k;
+	float *y,*stage,*k1,*k2,*k3,*k4;
+	float h=job->h;
+	double time;
+
+	y = S->A[0];
+	stage = S->A[n];
+	k1 = S->A[2*n];
+	k2 = S->A[3*n];
+	k3 = S->A[4*n];
+	k4 = S->A[5*n];
+
+	// gather the initial conditions
+	for (k=0; k < count; k++)
+	{
+		for (i=0; i < n; i++)
+		{
+			y[i*ld+k] = (job->Y0->flags & MATRIX_TRANSPOSED)
+				? job->Y0->A[i][first+k] : job->Y0->A[first+k][i];
+		}
+	}
+
+	// the padding at the end of each row is integrated too, it
+	// stays 0 and keeps the loops over whole blocks simple
+	for (j=0; j < job->steps; j++)
+	{
+		// t is computed from j as in the single trajectory solvers
+		time = job->tmin + j*h;
+		if (__atomic_load_n(&job->failed, __ATOMIC_RELAXED))
+		{
+			return 1;
+		}
+		if (job->sink != NULL && j % job->every == 0
+				&& (*job->sink)(time, first, view, job->arg) != 0)
+		{
+			return 1;
+		}
+		if (j == job->steps-1)
+		{
+			break;
+		}
+
+		batch_eval(job, row, time, y, k1, count, ld);
+		if (job->method == ODE_BATCH_EULER)
+		{
+			for (i=0; i < n*ld; i++)
+			{
+				y[i] += h*k1[i];
+			}
+			continue;
+		}
+
+		for (i=0; i < n*ld; i++)
+		{
+			stage[i] = y[i] + h/2*k1[i];
+		}
+		batch_eval(job, row, time+h/2, stage, k2, count, ld);
+		for (i=0; i < n*ld; i++)
+		{
+			stage[i] = y[i] + h/2*k2[i];
+		}
+		batch_eval(job, row, time+h/2, stage, k3, count, ld);
+		for (i=0; i < n*ld; i++)
+		{
+			stage[i] = y[i] + h*k3[i];
+		}
+		batch_eval(job, row, time+h, stage, k4, count, ld);
+		for (i=0; i < n*ld; i++)
+		{
+			y[i] += h/6*(k1[i] + 2*k2[i] + 2*k3[i] + k4[i]);
+		}
+	}
+
+	// scatter the final states
+	if (job->Y != NULL)
+	{
+		for (k=0; k < count; k++)
+		{
+			for (i=0; i < n; i++)
+			{
+				if (job->Y->flags & MATRIX_TRANSPOSED)
+				{
+					job->Y->A[i][first+k] = y[i*ld+k];
+				}
+				else
+				{
+					job->Y->A[first+k][i] = y[i*ld+k];
+				}
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,52 @@
+/* Integration of many initial conditions at once
+ * Oct 18 2026 */
+
+#ifndef ODE_BATCH_H
+#define ODE_BATCH_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "vector_function.h"
+#include "thread_pool.h"
+
+// trajectories integrated together by one task
+#define ODE_BATCH_WIDTH 256
+
+// methods for the batch integrators
+#define ODE_BATCH_EULER 0 // Euler's method
+#define ODE_BATCH_RK4 1 // classical 4th order Runge-Kutta
+
+// right hand side for count trajectories at once, stored structure
+// of arrays, component i of trajectory k is y[i*ld + k] so a loop
+// over k vectorizes, called from several threads at once
+typedef void (*ode_batch_rhs)(double t, const float *y, float *dydt,
+		unsigned int n, unsigned int count, unsigned int ld, void *userdata);
+
+// receives the states of trajectories first ... first+Y->m-1 at t,
+// Y is n x count with trajectory k in column k and is reused after
+// the call, called from several threads at once
+// returning nonzero stops the integration
+typedef int (*ode_batch_sink)(double t, unsigned int first, matrix Y,
+		void *arg);
+
+// integrate every row of Y0 with fixed steps h over the times
+// euler_method() and runge_kutta4() use, the final states go to the
+// rows of Y, which may be Y0, the work is spread over all threads
+// returns 0 on success
+extern int ode_batch(int method, ode_batch_rhs f, void *userdata, matrix Y0,
+		float tmin, float tmax, float h, matrix Y);
+// the same, also handing the states to sink at every every-th step
+// starting with tmin, Y may be NULL if only the sink is wanted
+extern int ode_batch_stream(int method, ode_batch_rhs f, void *userdata,
+		matrix Y0, float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+// the same for a vector_function, sink may be NULL
+extern int ode_batch_vecfunc(int method, vector_function f, matrix Y0,
+		float tmin, float tmax, float h, unsigned int every,
+		ode_batch_sink sink, void *arg, matrix Y);
+
+#endif
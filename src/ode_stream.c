@@ -0,0 +1,249 @@
+/* Streaming output for ODE solvers
+ * Oct 18 2026 */
+
+#include "ode_stream.h"
+
+struct ode_stream
+{
+	matrix buffer; // chunk rows, owned
+	matrix rows; // view of the filled rows handed to the sink
+	unsigned int filled;
+	unsigned int every;
+	unsigned long pushed; // rows pushed, kept or not
+	unsigned long kept; // rows handed on or waiting in the buffer
+	ode_sink sink;
+	void *arg;
+	FILE *file; // set for streams writing a file
+	char *filename; // of file, removed on close if no rows were kept
+	matrix target; // set for streams filling a matrix
+	unsigned int target_row; // next row of target
+	int failed; // a flush failed, later pushes are refused
+};
+
+ode_stream ode_stream_create(unsigned int cols, unsigned int chunk,
+		unsigned int every, ode_sink sink, void *arg);
+ode_stream ode_stream_open(const char *filename, unsigned int cols,
+		unsigned int chunk, unsigned int every);
+ode_stream ode_stream_into(matrix Y, unsigned int every);
+int ode_stream_push(ode_stream s, const float *row);
+int ode_stream_flush(ode_stream s);
+unsigned long ode_stream_rows(ode_stream s);
+int ode_stream_close(ode_stream s);
+
+// sink of the streams made by ode_stream_open()
+static int file_sink(matrix rows, void *arg);
+// sink of the streams made by ode_stream_into()
+static int matrix_sink(matrix rows, void *arg);
+
+// buffer chunk rows of cols floats for sink
+ode_stream ode_stream_create(unsigned int cols, unsigned int chunk,
+		unsigned int every, ode_sink sink, void *arg)
+{
+	ode_stream s;
+
+	if ((s = calloc(1, sizeof(*s))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	if (chunk == 0)
+	{
+		chunk = ODE_STREAM_CHUNK;
+	}
+	if ((s->buffer = zero_matrix(chunk, cols)) == NULL
+			|| (s->rows = matrix_rows(s->buffer, 0, chunk)) == NULL)
+	{
+		if (s->buffer != NULL)
+		{
+			free_matrix(s->buffer);
+		}
+		free(s);
+		return NULL;
+	}
+	s->every = (every > 0) ? every : 1;
+	s->sink = sink;
+	s->arg = arg;
+
+	return s;
+}
+
+// the rows of a buffer are laid out as in a matrix file,
+// so a chunk goes out in a single write
+static int file_sink(matrix rows, void *arg)
+{
+	ode_stream s = arg;
+
+	if (fwrite(rows->data, sizeof(*rows->data)*rows->ld, rows->n, s->file) != rows->n)
+	{
+		perror("Error writing file");
+		return 1;
+	}
+	return 0;
+}
+
+// the same, writing the rows to a file
+// the header is rewritten with the final number of rows on close
+ode_stream ode_stream_open(const char *filename, unsigned int cols,
+		unsigned int chunk, unsigned int every)
+{
+	ode_stream s;
+
+	if ((s = ode_stream_create(cols, chunk, every, &file_sink, NULL)) == NULL)
+	{
+		return NULL;
+	}
+	s->arg = s;
+
+	if ((s->filename = malloc(strlen(filename) + 1)) == NULL)
+	{
+		perror("Error allocating memory");
+		ode_stream_close(s);
+		return NULL;
+	}
+	strcpy(s->filename, filename);
+	if ((s->file = fopen(filename, "w")) == NULL)
+	{
+		perror("Error opening file");
+		ode_stream_close(s);
+		return NULL;
+	}
+	if (datafile_write_header(s->file, DATAFILE_FLOAT32, 0, cols, s->buffer->ld) != 0)
+	{
+		s->failed = 1;
+		ode_stream_close(s);
+		return NULL;
+	}
+
+	return s;
+}
+
+// copy each chunk into the next rows of the target
+static int matrix_sink(matrix rows, void *arg)
+{
+	ode_stream s = arg;
+	unsigned int i;
+
+	if (rows->n > s->target->n - s->target_row)
+	{
+		fprintf(stderr,"Error: more rows than the matrix holds\n");
+		return 1;
+	}
+	for (i = 0; i < rows->n; i++)
+	{
+		memcpy(s->target->A[s->target_row++], rows->A[i],
+				sizeof(**rows->A)*rows->m);
+	}
+	return 0;
+}
+
+// fill the rows of Y in order, the chunks are kept small
+// so they are still in cache when they are copied
+ode_stream ode_stream_into(matrix Y, unsigned int every)
+{
+	ode_stream s;
+
+	if ((s = ode_stream_create(Y->m, ODE_STREAM_INTO_CHUNK, every,
+					&matrix_sink, NULL)) == NULL)
+	{
+		return NULL;
+	}
+	s->arg = s;
+	s->target = Y;
+
+	return s;
+}
+
+// add one row
+int ode_stream_push(ode_stream s, const float *row)
+{
+	if (s->failed)
+	{
+		return 1;
+	}
+	if (s->pushed++ % s->every != 0)
+	{
+		return 0;
+	}
+
+	memcpy(s->buffer->A[s->filled], row, sizeof(*row)*s->buffer->m);
+	s->filled++;
+	s->kept++;
+	if (s->filled == s->buffer->n)
+	{
+		return ode_stream_flush(s);
+	}
+	return 0;
+}
+
+// hand the buffered rows to the sink
+int ode_stream_flush(ode_stream s)
+{
+	if (s->failed)
+	{
+		return 1;
+	}
+	if (s->filled == 0)
+	{
+		return 0;
+	}
+
+	s->rows->n = s->filled;
+	s->filled = 0;
+	if ((*s->sink)(s->rows, s->arg) != 0)
+	{
+		s->failed = 1;
+		return 1;
+	}
+	return 0;
+}
+
+// rows kept so far
+unsigned long ode_stream_rows(ode_stream s)
+{
+	return s->kept;
+}
+
+// flush, finish the file if there is one and free the stream
+int ode_stream_close(ode_stream s)
+{
+	int status;
+
+	if (s == NULL)
+	{
+		return 1;
+	}
+
+	status = ode_stream_flush(s);
+	if (s->file != NULL)
+	{
+		// now the number of rows is known, a file of none can't
+		// be read back as a matrix so it isn't left behind
+		if (status == 0 && s->kept == 0)
+		{
+			fprintf(stderr,"Error: no rows were written to %s\n",s->filename);
+			status = 1;
+		}
+		if (status == 0)
+		{
+			rewind(s->file);
+			status = datafile_write_header(s->file, DATAFILE_FLOAT32,
+					s->kept, s->buffer->m, s->buffer->ld);
+		}
+		if (fclose(s->file) != 0 && status == 0)
+		{
+			perror("Error writing file");
+			status = 1;
+		}
+		if (s->kept == 0 && remove(s->filename) != 0)
+		{
+			perror("Error removing file");
+		}
+	}
+
+	free(s->filename);
+	free_matrix(s->rows);
+	free_matrix(s->buffer);
+	free(s);
+
+	return status;
+}
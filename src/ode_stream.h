@@ -0,0 +1,57 @@
+/* Streaming output for ODE solvers
+ * Oct 18 2026 */
+
+#ifndef ODE_STREAM_H
+#define ODE_STREAM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "datafile.h"
+
+// rows buffered between calls to the sink when no size is given
+#define ODE_STREAM_CHUNK 1024
+// rows buffered by streams that fill a matrix
+#define ODE_STREAM_INTO_CHUNK 32
+
+// receives a chunk of solution rows [t y1 ... yn], only the first
+// rows->n rows are valid and the matrix is reused after the call
+// returning nonzero stops the integration
+typedef int (*ode_sink)(matrix rows, void *arg);
+
+// rows on their way from a solver to a sink or a file
+typedef struct ode_stream *ode_stream;
+
+// work done by an adaptive solver
+struct ode_stats
+{
+	unsigned long steps; // accepted steps
+	unsigned long rejected; // steps retried with a smaller h
+	unsigned long evaluations; // of the right hand side
+	unsigned long jacobians; // formed by an implicit solver
+	unsigned long factorizations; // of its iteration matrix
+};
+
+// buffer chunk rows of cols floats for sink, keeping every
+// every-th row pushed, chunk 0 is ODE_STREAM_CHUNK and every 0 is 1
+extern ode_stream ode_stream_create(unsigned int cols, unsigned int chunk,
+		unsigned int every, ode_sink sink, void *arg);
+// the same, writing the rows to a file load_matrix() and map_matrix() read
+extern ode_stream ode_stream_open(const char *filename, unsigned int cols,
+		unsigned int chunk, unsigned int every);
+// the same, filling the rows of Y in order
+extern ode_stream ode_stream_into(matrix Y, unsigned int every);
+// add one row, returns nonzero if the sink or the write failed
+extern int ode_stream_push(ode_stream s, const float *row);
+// hand the buffered rows to the sink
+extern int ode_stream_flush(ode_stream s);
+// rows kept so far
+extern unsigned long ode_stream_rows(ode_stream s);
+// flush, finish the file if there is one and free the stream
+// returns nonzero if anything failed, a file no rows were kept
+// in is removed
+extern int ode_stream_close(ode_stream s);
+
+#endif
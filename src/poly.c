@@ -0,0 +1,422 @@
+/* Polynomials and their roots
+ * Oct 18 2026 */
+
+#include "poly.h"
+
+// the starting points on a circle are turned by this many radians
+// so those of a real polynomial aren't symmetric about the real axis
+#define ABERTH_ANGLE 0.4
+
+// the roots of POLY_BATCH polynomials at once, the values of one
+// polynomial are POLY_BATCH apart so every loop over them vectorizes
+struct aberth_block
+{
+	unsigned int degree, count;
+	double *a; // monic coefficients, a_j of polynomial k at [j*POLY_BATCH + k]
+	double *zr, *zi; // root i of polynomial k at [i*POLY_BATCH + k]
+	double *cr, *ci; // the corrections of an iteration
+	double *done; // 1 for a root that has converged, else 0
+	int status[POLY_BATCH];
+};
+
+// the polynomials of one task of poly_roots_batch()
+struct poly_job
+{
+	unsigned int degree, count;
+	const float *c;
+	float *re, *im;
+	double tol;
+	unsigned int maxiter;
+	int *status;
+	int failed;
+};
+
+poly zero_poly(unsigned int degree);
+void free_poly(poly p);
+float poly_eval(poly p, float x, float *dpdx);
+void poly_eval_many(poly p, unsigned int n, const float *x, float *px,
+		float *dpdx);
+float poly_func(float x, void *userdata);
+float poly_fdf(float x, float *dfdx, void *userdata);
+int poly_roots(poly p, float *re, float *im, float tol, unsigned int maxiter);
+int poly_roots_batch(unsigned int degree, unsigned int count,
+		const float *c, float *re, float *im, float tol, unsigned int maxiter,
+		int *status);
+
+// the polynomials of one task
+static void poly_task(void *arg, unsigned int t);
+// monic copies of the polynomials and roots spread on circles
+static void aberth_load(struct aberth_block *w, const float *c);
+// one simultaneous Aberth step for every root, returns the roots left
+static unsigned int aberth_step(struct aberth_block *w, double tol,
+		double *tmp);
+// the roots of polynomial k sorted into re and im
+static void aberth_store(struct aberth_block *w, unsigned int k, float *re,
+		float *im);
+
+// a polynomial with zero coefficients
+poly zero_poly(unsigned int degree)
+{
+	poly p;
+
+	if ((p = malloc(sizeof(*p))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	p->degree = degree;
+	if ((p->c = calloc((size_t)degree + 1, sizeof(*p->c))) == NULL)
+	{
+		perror("Error allocating memory");
+		free(p);
+		return NULL;
+	}
+	return p;
+}
+
+void free_poly(poly p)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+	free(p->c);
+	free(p);
+}
+
+// Horner's rule, p' is accumulated from the partial sums of p
+float poly_eval(poly p, float x, float *dpdx)
+{
+	float px,dp;
+
+	kernel_horner(1, p->degree, p->c, &x, &px, &dp);
+	if (dpdx != NULL)
+	{
+		*dpdx = dp;
+	}
+	return px;
+}
+
+// many points through the vector kernel
+void poly_eval_many(poly p, unsigned int n, const float *x, float *px,
+		float *dpdx)
+{
+	mathlib_kernels->horner(n, p->degree, p->c, x, px, dpdx);
+}
+
+float poly_func(float x, void *userdata)
+{
+	return poly_eval(userdata, x, NULL);
+}
+
+float poly_fdf(float x, float *dfdx, void *userdata)
+{
+	return poly_eval(userdata, x, dfdx);
+}
+
+// one polynomial is a batch of one
+int poly_roots(poly p, float *re, float *im, float tol, unsigned int maxiter)
+{
+	int status;
+
+	poly_roots_batch(p->degree, 1, p->c, re, im, tol, maxiter, &status);
+	return status;
+}
+
+// POLY_BATCH polynomials per task
+int poly_roots_batch(unsigned int degree, unsigned int count,
+		const float *c, float *re, float *im, float tol, unsigned int maxiter,
+		int *status)
+{
+	struct poly_job job;
+
+	job.degree = degree;
+	job.count = count;
+	job.c = c;
+	job.re = re;
+	job.im = im;
+	job.tol = (tol > 0.) ? tol : FLT_EPSILON;
+	job.maxiter = (maxiter > 0) ? maxiter : ROOT_DEFAULT_MAXITER;
+	job.status = status;
+	job.failed = 0;
+	parallel_for((count + POLY_BATCH - 1)/POLY_BATCH, &poly_task, &job);
+	return job.failed;
+}
+
+// load, iterate and store one block of polynomials
+static void poly_task(void *arg, unsigned int t)
+{
+	struct poly_job *job = arg;
+	struct aberth_block w;
+	unsigned int first=t*POLY_BATCH;
+	unsigned int d=job->degree;
+	unsigned int it,k;
+	size_t size;
+	double *mem;
+
+	w.degree = d;
+	w.count = (first + POLY_BATCH <= job->count) ? POLY_BATCH
+		: job->count - first;
+
+	// a, then the roots, corrections and done flags, then 8 temporaries
+	size = (size_t)POLY_BATCH*((d+1) + 5*d + 8);
+	if ((mem = malloc(sizeof(*mem)*size)) == NULL)
+	{
+		perror("Error allocating memory");
+		for (k=0; job->status != NULL && k < w.count; k++)
+		{
+			job->status[first + k] = ROOT_NO_CONVERGENCE;
+		}
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	w.a = mem;
+	w.zr = w.a + (size_t)POLY_BATCH*(d+1);
+	w.zi = w.zr + (size_t)POLY_BATCH*d;
+	w.cr = w.zi + (size_t)POLY_BATCH*d;
+	w.ci = w.cr + (size_t)POLY_BATCH*d;
+	w.done = w.ci + (size_t)POLY_BATCH*d;
+
+	aberth_load(&w, job->c + (size_t)first*(d+1));
+	for (it=0; it < job->maxiter; it++)
+	{
+		if (aberth_step(&w, job->tol, w.done + (size_t)POLY_BATCH*d) == 0)
+		{
+			break;
+		}
+	}
+
+	for (k=0; k < w.count; k++)
+	{
+		if (w.status[k] == ROOT_OK && d > 0)
+		{
+			for (it=0; it < d; it++)
+			{
+				if (w.done[it*POLY_BATCH + k] == 0.)
+				{
+					w.status[k] = ROOT_NO_CONVERGENCE;
+				}
+			}
+		}
+		if (w.status[k] != ROOT_OK)
+		{
+			__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		}
+		if (job->status != NULL)
+		{
+			job->status[first + k] = w.status[k];
+		}
+		aberth_store(&w, k, job->re + (size_t)(first + k)*d,
+				job->im + (size_t)(first + k)*d);
+	}
+	free(mem);
+}
+
+// a polynomial that can't be solved is replaced by z^d - 1 so the
+// block stays finite, and its roots are stored as NaN
+static void aberth_load(struct aberth_block *w, const float *c)
+{
+	unsigned int d=w->degree;
+	unsigned int i,j,k;
+	double lead,r,b,angle;
+	const float *ck;
+
+	for (k=0; k < w->count; k++)
+	{
+		ck = c + (size_t)k*(d+1);
+		w->status[k] = ROOT_OK;
+		for (j=0; j <= d; j++)
+		{
+			if (!isfinite(ck[j]))
+			{
+				w->status[k] = ROOT_NOT_FINITE;
+			}
+		}
+		if (w->status[k] == ROOT_OK && ck[d] == 0.)
+		{
+			w->status[k] = ROOT_SINGULAR;
+		}
+
+		lead = (w->status[k] == ROOT_OK) ? ck[d] : 1.;
+		for (j=0; j < d; j++)
+		{
+			w->a[j*POLY_BATCH + k] = (w->status[k] == ROOT_OK) ? ck[j]/lead
+				: (j == 0) ? -1. : 0.;
+		}
+
+		// |a_0|^(1/d) is the geometric mean of the moduli of the roots,
+		// if a_0 is 0 a bound on them is used instead
+		r = 0.;
+		if (d > 0)
+		{
+			r = pow(fabs(w->a[k]), 1./d);
+			for (j=1; j < d && w->a[k] == 0.; j++)
+			{
+				b = pow(fabs(w->a[j*POLY_BATCH + k]), 1./(d - j));
+				r = fmax(r, b);
+			}
+		}
+		if (r == 0. || !isfinite(r))
+		{
+			r = 1.;
+		}
+		for (i=0; i < d; i++)
+		{
+			angle = 2*M_PI*i/d + ABERTH_ANGLE;
+			w->zr[i*POLY_BATCH + k] = r*cos(angle);
+			w->zi[i*POLY_BATCH + k] = r*sin(angle);
+			w->done[i*POLY_BATCH + k] = 0.;
+		}
+		// each leading zero of a_0, a_1, ... is an exact root at 0, which
+		// the iteration could only creep towards
+		for (i=0; i < d && w->a[i*POLY_BATCH + k] == 0.; i++)
+		{
+			w->zr[i*POLY_BATCH + k] = 0.;
+			w->zi[i*POLY_BATCH + k] = 0.;
+			w->done[i*POLY_BATCH + k] = 1.;
+		}
+	}
+	// the slots past count are never read
+	for (k=w->count; k < POLY_BATCH; k++)
+	{
+		w->status[k] = ROOT_OK;
+	}
+}
+
+// z_i -= p(z_i)/(p'(z_i) - p(z_i) sum 1/(z_i - z_j)) for all i at once
+// from the same roots, in complex arithmetic on split real and imaginary
+// parts, tmp holds 8*POLY_BATCH doubles
+static unsigned int aberth_step(struct aberth_block *w, double tol,
+		double *tmp)
+{
+	unsigned int d=w->degree, n=w->count;
+	unsigned int i,j,k,left=0;
+	double *pr=tmp, *pi=pr+POLY_BATCH, *dr=pi+POLY_BATCH, *di=dr+POLY_BATCH;
+	double *e=di+POLY_BATCH, *az=e+POLY_BATCH;
+	double *sr=az+POLY_BATCH, *si=sr+POLY_BATCH;
+	double *zr,*zi,*xr,*xi,*aj;
+	double t,dx,dy,q,nr,ni,cr,ci,bound;
+	double eps=POLY_ROUNDOFF*d*DBL_EPSILON;
+
+	for (i=0; i < d; i++)
+	{
+		zr = w->zr + i*POLY_BATCH;
+		zi = w->zi + i*POLY_BATCH;
+
+		// p and p' by Horner's rule, and e the same sum on |a_j| and |z|
+		// which bounds the rounding error of p
+		for (k=0; k < n; k++)
+		{
+			pr[k] = 1.;
+			pi[k] = 0.;
+			dr[k] = 0.;
+			di[k] = 0.;
+			e[k] = 1.;
+			az[k] = hypot(zr[k], zi[k]);
+		}
+		for (j=d; j-- > 0; )
+		{
+			aj = w->a + j*POLY_BATCH;
+			for (k=0; k < n; k++)
+			{
+				t = dr[k]*zr[k] - di[k]*zi[k] + pr[k];
+				di[k] = dr[k]*zi[k] + di[k]*zr[k] + pi[k];
+				dr[k] = t;
+				t = pr[k]*zr[k] - pi[k]*zi[k] + aj[k];
+				pi[k] = pr[k]*zi[k] + pi[k]*zr[k];
+				pr[k] = t;
+				e[k] = e[k]*az[k] + fabs(aj[k]);
+			}
+		}
+
+		// s = sum over the other roots of 1/(z_i - z_j)
+		for (k=0; k < n; k++)
+		{
+			sr[k] = 0.;
+			si[k] = 0.;
+		}
+		for (j=0; j < d; j++)
+		{
+			if (j == i)
+			{
+				continue;
+			}
+			xr = w->zr + j*POLY_BATCH;
+			xi = w->zi + j*POLY_BATCH;
+			for (k=0; k < n; k++)
+			{
+				dx = zr[k] - xr[k];
+				dy = zi[k] - xi[k];
+				q = dx*dx + dy*dy;
+				sr[k] += dx/q;
+				si[k] -= dy/q;
+			}
+		}
+
+		// the correction p/(p' - p s), none for a root that is done or
+		// whose p is already at roundoff
+		for (k=0; k < n; k++)
+		{
+			nr = dr[k] - (pr[k]*sr[k] - pi[k]*si[k]);
+			ni = di[k] - (pr[k]*si[k] + pi[k]*sr[k]);
+			q = nr*nr + ni*ni;
+			cr = (pr[k]*nr + pi[k]*ni)/q;
+			ci = (pi[k]*nr - pr[k]*ni)/q;
+			if (!(isfinite(cr) && isfinite(ci)))
+			{
+				// two roots met or p' - p s vanished, nudge it
+				cr = tol*(az[k] + 1.);
+				ci = 0.;
+			}
+			bound = eps*e[k];
+			if (w->done[i*POLY_BATCH + k] != 0. || hypot(pr[k], pi[k]) <= bound)
+			{
+				cr = ci = 0.;
+				w->done[i*POLY_BATCH + k] = 1.;
+			}
+			else if (hypot(cr, ci) <= tol*az[k])
+			{
+				w->done[i*POLY_BATCH + k] = 1.;
+			}
+			w->cr[i*POLY_BATCH + k] = cr;
+			w->ci[i*POLY_BATCH + k] = ci;
+		}
+	}
+
+	for (i=0; i < d; i++)
+	{
+		for (k=0; k < n; k++)
+		{
+			w->zr[i*POLY_BATCH + k] -= w->cr[i*POLY_BATCH + k];
+			w->zi[i*POLY_BATCH + k] -= w->ci[i*POLY_BATCH + k];
+			left += (w->done[i*POLY_BATCH + k] == 0.);
+		}
+	}
+	return left;
+}
+
+// insertion sort of the roots of one polynomial as floats
+static void aberth_store(struct aberth_block *w, unsigned int k, float *re,
+		float *im)
+{
+	unsigned int d=w->degree;
+	unsigned int i,j;
+	float r,m;
+
+	for (i=0; i < d; i++)
+	{
+		r = w->zr[i*POLY_BATCH + k];
+		m = w->zi[i*POLY_BATCH + k];
+		if (w->status[k] == ROOT_NOT_FINITE || w->status[k] == ROOT_SINGULAR)
+		{
+			r = m = NAN;
+		}
+		for (j=i; j > 0 && (re[j-1] > r || (re[j-1] == r && im[j-1] > m)); j--)
+		{
+			re[j] = re[j-1];
+			im[j] = im[j-1];
+		}
+		re[j] = r;
+		im[j] = m;
+	}
+}
@@ -0,0 +1,57 @@
+/* Polynomials and their roots
+ * Oct 18 2026 */
+
+#ifndef POLY_H
+#define POLY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "kernel.h"
+#include "thread_pool.h"
+#include "root_finding.h"
+
+// polynomials whose roots are found together by one task
+#define POLY_BATCH 64
+// a root is accepted once |p(z)| is this many roundoffs of p's terms
+#define POLY_ROUNDOFF 4
+
+// c[0] + c[1]*x + ... + c[degree]*x^degree
+typedef struct
+{
+	unsigned int degree;
+	float *c;
+} *poly;
+
+// a polynomial with zero coefficients
+extern poly zero_poly(unsigned int degree);
+extern void free_poly(poly p);
+// p(x) and, if dpdx isn't NULL, p'(x) from one pass of Horner's rule
+extern float poly_eval(poly p, float x, float *dpdx);
+// p and p' at n points at once by the horner kernel
+extern void poly_eval_many(poly p, unsigned int n, const float *x, float *px,
+		float *dpdx);
+// p as a root_func and a root_fdf, userdata is the poly
+extern float poly_func(float x, void *userdata);
+extern float poly_fdf(float x, float *dfdx, void *userdata);
+
+// all degree roots of p, complex ones included, into re and im sorted
+// by real then imaginary part, by the Aberth-Ehrlich iteration in double
+// a root is done when a correction is below tol*|z| or p(z) is at the
+// roundoff of its evaluation, tol of 0 means FLT_EPSILON and maxiter of
+// 0 ROOT_DEFAULT_MAXITER, returns ROOT_OK or another root finder status,
+// ROOT_SINGULAR if the leading coefficient is zero
+extern int poly_roots(poly p, float *re, float *im, float tol,
+		unsigned int maxiter);
+// the same for count polynomials of one degree, the coefficients of
+// polynomial k are c[k*(degree+1) ...] and its roots go to re and im
+// from k*degree, the polynomials are split over the thread pool
+// status may be NULL, returns 0 if every polynomial converged
+extern int poly_roots_batch(unsigned int degree, unsigned int count,
+		const float *c, float *re, float *im, float tol, unsigned int maxiter,
+		int *status);
+
+#endif
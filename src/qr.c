@@ -0,0 +1,775 @@
+/* Householder QR and linear least squares
+ * Oct 18 2026 */
+
+#include "qr.h"
+
+// a reflector of a column pivoted panel applied to its trailing columns
+struct pivot_job
+{
+	float **F, **Fx; // row c of Fx is what the panel owes column c
+	unsigned int n, m, p, k; // reflector k of the panel is in row p
+	float tau;
+	const float *a; // V(p:n,0:k)^T v_p
+	const float *g; // V(p,0:k+1), the panel's part of row p of R
+	double *vn1, *vn2; // partial column norms and the norms they came from
+	unsigned char *stale; // norms lost to cancellation
+	int recompute;
+};
+
+// the handles kept by least_squares_solve()
+struct qr_entry
+{
+	matrix A;
+	qr_handle h;
+	struct qr_entry *next;
+};
+static pthread_mutex_t qr_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct qr_entry *qr_entries;
+
+qr_handle qr_factor(matrix A, int pivoting);
+qr_handle qr_retain(qr_handle h);
+void qr_release(qr_handle h);
+unsigned int qr_rank(qr_handle h);
+int qr_solve(qr_handle h, vector x, vector b);
+int qr_solve_many(qr_handle h, matrix B, matrix X);
+int least_squares_solve(matrix A, vector x, vector b);
+void free_least_squares(matrix A);
+void free_all_least_squares(void);
+
+// the reflector taking (alpha, x[0..n-1]) to (beta, 0), v is left in x
+static float reflector(float *alpha, unsigned int n, float *x);
+// the rows of V^T for reflectors j..j+kb-1, with their ones and zeros
+static void block_vectors(qr_handle h, unsigned int j, unsigned int kb,
+		matrix Vt);
+// T of the block I - V T V^T, from LAPACK's larft, 1 if out of memory
+static int block_triangle(qr_handle h, unsigned int j, unsigned int kb,
+		matrix Vt, matrix S);
+// the factorization without pivoting, a panel at a time
+static int qr_blocked(qr_handle h);
+// the factorization with column pivoting, from LAPACK's laqps
+static int qr_pivoted(qr_handle h);
+static void pivot_task(void *arg, unsigned int t);
+// the rank, then R copied out and reduced to [T11 0]Z if it is deficient
+static int qr_finish(qr_handle h);
+
+qr_handle qr_factor(matrix A, int pivoting)
+{
+	qr_handle h;
+	matrix view;
+	unsigned int kmin,j;
+	int status;
+
+	if (A->n == 0 || A->m == 0)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return NULL;
+	}
+
+	if ((h = calloc(1, sizeof(*h))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	h->n = A->n;
+	h->m = A->m;
+	h->pivoting = pivoting;
+	h->refs = 1;
+	kmin = (A->n < A->m) ? A->n : A->m;
+
+	// the columns of A are the rows of F, so a reflector and
+	// everything it is applied to is contiguous
+	if ((h->F = zero_matrix(A->m, A->n)) == NULL
+			|| (h->T = zero_matrix(kmin, QR_PANEL)) == NULL
+			|| (view = matrix_transpose_view(h->F)) == NULL)
+	{
+		qr_release(h);
+		return NULL;
+	}
+	matrix_set(view, A);
+	free_matrix(view);
+	if ((h->tau = calloc(kmin, sizeof(*h->tau))) == NULL
+			|| (h->perm = malloc(sizeof(*h->perm)*A->m)) == NULL)
+	{
+		perror("Error allocating memory");
+		qr_release(h);
+		return NULL;
+	}
+	for (j=0; j < A->m; j++)
+	{
+		h->perm[j] = j;
+	}
+
+	if (pivoting == QR_COLUMN_PIVOTING)
+	{
+		status = qr_pivoted(h);
+	}
+	else
+	{
+		status = qr_blocked(h);
+	}
+	if (status != 0 || qr_finish(h) != 0)
+	{
+		qr_release(h);
+		return NULL;
+	}
+	return h;
+}
+
+// take another reference to a factorization
+qr_handle qr_retain(qr_handle h)
+{
+	__atomic_add_fetch(&h->refs, 1, __ATOMIC_RELAXED);
+	return h;
+}
+
+// drop a reference, the last one frees the factorization
+void qr_release(qr_handle h)
+{
+	if (h == NULL || __atomic_sub_fetch(&h->refs, 1, __ATOMIC_ACQ_REL) != 0)
+	{
+		return;
+	}
+	free_matrix(h->F);
+	free_matrix(h->T);
+	free_matrix(h->R);
+	free(h->tau);
+	free(h->perm);
+	free(h->tauz);
+	free(h);
+}
+
+unsigned int qr_rank(qr_handle h)
+{
+	return h->rank;
+}
+
+// x = P Z^T [T11^-1 (Q^T b)(0:rank); 0]
+int qr_solve(qr_handle h, vector x, vector b)
+{
+	float **F=h->F->A;
+	float *c,*y,w;
+	unsigned int n=h->n,m=h->m,r=h->rank,l=m-h->rank;
+	unsigned int kmin,k,i;
+
+	if (b->n != n || x->n != m)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	if ((c = malloc(sizeof(*c)*n)) == NULL
+			|| (y = calloc(m, sizeof(*y))) == NULL)
+	{
+		perror("Error allocating memory");
+		free(c);
+		return 1;
+	}
+	memcpy(c, b->a, sizeof(*c)*n);
+	kmin = (n < m) ? n : m;
+
+	// c = Q^T b a reflector at a time
+	for (k=0; k < kmin; k++)
+	{
+		if (h->tau[k] == 0.)
+		{
+			continue;
+		}
+		w = h->tau[k]*(c[k] + mathlib_kernels->dot(n-k-1, F[k]+k+1, c+k+1));
+		c[k] -= w;
+		mathlib_kernels->axpy(n-k-1, -w, F[k]+k+1, c+k+1);
+	}
+
+	// the triangular system in the rows of R
+	for (i=r; i-- > 0; )
+	{
+		y[i] = (c[i] - mathlib_kernels->dot(r-i-1, h->R->A[i]+i+1, y+i+1))
+			/h->R->A[i][i];
+	}
+
+	// back from the coordinates of [T11 0], H_0 first
+	for (i=0; h->tauz != NULL && i < r; i++)
+	{
+		w = h->tauz[i]*(y[i] + mathlib_kernels->dot(l, h->R->A[i]+r, y+r));
+		y[i] -= w;
+		mathlib_kernels->axpy(l, -w, h->R->A[i]+r, y+r);
+	}
+
+	for (i=0; i < m; i++)
+	{
+		x->a[h->perm[i]] = y[i];
+	}
+	free(c);
+	free(y);
+	return 0;
+}
+
+// the same with Q^T applied a block of reflectors at a time
+int qr_solve_many(qr_handle h, matrix B, matrix X)
+{
+	matrix C=NULL,Y=NULL,Xp=NULL,Vt=NULL,M1=NULL,M2=NULL;
+	float *w=NULL;
+	unsigned int n=h->n,m=h->m,r=h->rank,l=m-h->rank,s=B->m;
+	unsigned int kmin,j,kb,i,q;
+
+	if (B->n != n || X->n != m || X->m != s)
+	{
+		fprintf(stderr,"System is dimensionally inconsistent\n");
+		return 1;
+	}
+	kmin = (n < m) ? n : m;
+	if ((C = zero_matrix(n, s)) == NULL
+			|| (Y = zero_matrix(m, s)) == NULL
+			|| (Xp = zero_matrix(m, s)) == NULL
+			|| (Vt = zero_matrix(QR_PANEL, n)) == NULL
+			|| (M1 = zero_matrix(QR_PANEL, s)) == NULL
+			|| (M2 = zero_matrix(QR_PANEL, s)) == NULL
+			|| (w = malloc(sizeof(*w)*s)) == NULL)
+	{
+		if (M2 != NULL)
+		{
+			perror("Error allocating memory");
+		}
+		free_matrix(C);
+		free_matrix(Y);
+		free_matrix(Xp);
+		free_matrix(Vt);
+		free_matrix(M1);
+		free_matrix(M2);
+		return 1;
+	}
+	matrix_set(C, B);
+
+	// C = Q^T B, Q^T = I - V T^T V^T for each block
+	for (j=0; j < kmin; j += QR_PANEL)
+	{
+		kb = (kmin - j < QR_PANEL) ? kmin - j : QR_PANEL;
+		block_vectors(h, j, kb, Vt);
+		if (gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, kb, s, n-j, 1.,
+					Vt->A, 0, C->A + j, 0, 0., M1->A, 0) != 0
+				|| gemm_blocked(MATRIX_TRANS, MATRIX_NOTRANS, kb, s, kb, 1.,
+					h->T->A + j, 0, M1->A, 0, 0., M2->A, 0) != 0
+				|| gemm_blocked(MATRIX_TRANS, MATRIX_NOTRANS, n-j, s, kb, -1.,
+					Vt->A, 0, M2->A, 0, 1., C->A + j, 0) != 0)
+		{
+			free_matrix(C);
+			free_matrix(Y);
+			free_matrix(Xp);
+			free_matrix(Vt);
+			free_matrix(M1);
+			free_matrix(M2);
+			free(w);
+			return 1;
+		}
+	}
+
+	// the triangular system in the rows of R
+	for (i=r; i-- > 0; )
+	{
+		memcpy(Y->A[i], C->A[i], sizeof(**Y->A)*s);
+		for (q=i+1; q < r; q++)
+		{
+			mathlib_kernels->axpy(s, -h->R->A[i][q], Y->A[q], Y->A[i]);
+		}
+		mathlib_kernels->scal(s, 1./h->R->A[i][i], Y->A[i]);
+	}
+
+	// back from the coordinates of [T11 0], H_0 first
+	for (i=0; h->tauz != NULL && i < r; i++)
+	{
+		memcpy(w, Y->A[i], sizeof(*w)*s);
+		for (q=0; q < l; q++)
+		{
+			mathlib_kernels->axpy(s, h->R->A[i][r+q], Y->A[r+q], w);
+		}
+		mathlib_kernels->scal(s, h->tauz[i], w);
+		mathlib_kernels->axpy(s, -1., w, Y->A[i]);
+		for (q=0; q < l; q++)
+		{
+			mathlib_kernels->axpy(s, -h->R->A[i][r+q], w, Y->A[r+q]);
+		}
+	}
+
+	for (i=0; i < m; i++)
+	{
+		memcpy(Xp->A[h->perm[i]], Y->A[i], sizeof(**Y->A)*s);
+	}
+	matrix_set(X, Xp);
+
+	free_matrix(C);
+	free_matrix(Y);
+	free_matrix(Xp);
+	free_matrix(Vt);
+	free_matrix(M1);
+	free_matrix(M2);
+	free(w);
+	return 0;
+}
+
+// solve min |Ax-b| with the kept factorization of A
+int least_squares_solve(matrix A, vector x, vector b)
+{
+	struct qr_entry *e;
+	qr_handle h=NULL,f;
+	int status;
+
+	pthread_mutex_lock(&qr_lock);
+	for (e=qr_entries; e != NULL; e=e->next)
+	{
+		if (e->A == A)
+		{
+			h = qr_retain(e->h);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&qr_lock);
+
+	// if A has not been factored yet now is the time
+	if (h == NULL)
+	{
+		if ((f = qr_factor(A, QR_COLUMN_PIVOTING)) == NULL)
+		{
+			return 1;
+		}
+		if ((e = malloc(sizeof(*e))) == NULL)
+		{
+			perror("Error allocating memory");
+			qr_release(f);
+			return 1;
+		}
+		pthread_mutex_lock(&qr_lock);
+		// another thread may have factored A meanwhile
+		for (e->next=qr_entries; e->next != NULL; e->next=e->next->next)
+		{
+			if (e->next->A == A)
+			{
+				h = qr_retain(e->next->h);
+				break;
+			}
+		}
+		if (h == NULL)
+		{
+			e->A = A;
+			e->h = f;
+			e->next = qr_entries;
+			qr_entries = e;
+			h = qr_retain(f);
+			f = NULL;
+			e = NULL;
+		}
+		pthread_mutex_unlock(&qr_lock);
+		free(e);
+		qr_release(f);
+	}
+
+	status = qr_solve(h, x, b);
+	qr_release(h);
+	return status;
+}
+
+// forget the factorization of A
+void free_least_squares(matrix A)
+{
+	struct qr_entry **p,*e;
+
+	pthread_mutex_lock(&qr_lock);
+	for (p=&qr_entries; *p != NULL; p=&(*p)->next)
+	{
+		if ((*p)->A == A)
+		{
+			e = *p;
+			*p = e->next;
+			qr_release(e->h);
+			free(e);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&qr_lock);
+}
+
+void free_all_least_squares(void)
+{
+	struct qr_entry *e,*next;
+
+	pthread_mutex_lock(&qr_lock);
+	for (e=qr_entries; e != NULL; e=next)
+	{
+		next = e->next;
+		qr_release(e->h);
+		free(e);
+	}
+	qr_entries = NULL;
+	pthread_mutex_unlock(&qr_lock);
+}
+
+static float reflector(float *alpha, unsigned int n, float *x)
+{
+	double xnorm=0.,beta;
+	float scale;
+	unsigned int i;
+
+	for (i=0; i < n; i++)
+	{
+		xnorm += (double)x[i]*x[i];
+	}
+	if (xnorm == 0.)
+	{
+		return 0.;
+	}
+	beta = -copysign(sqrt((double)*alpha*(*alpha) + xnorm), *alpha);
+	scale = 1./(*alpha - beta);
+	mathlib_kernels->scal(n, scale, x);
+	scale = (beta - *alpha)/beta;
+	*alpha = beta;
+	return scale;
+}
+
+static void block_vectors(qr_handle h, unsigned int j, unsigned int kb,
+		matrix Vt)
+{
+	float **F=h->F->A;
+	unsigned int q;
+
+	for (q=0; q < kb; q++)
+	{
+		memset(Vt->A[q], 0, sizeof(**Vt->A)*q);
+		Vt->A[q][q] = 1.;
+		memcpy(Vt->A[q]+q+1, F[j+q]+j+q+1, sizeof(**F)*(h->n-j-q-1));
+	}
+}
+
+static int block_triangle(qr_handle h, unsigned int j, unsigned int kb,
+		matrix Vt, matrix S)
+{
+	float **T=h->T->A + j;
+	unsigned int p,q,l;
+	float sum;
+
+	// T(0:p,p) = -tau_p T(0:p,0:p) V(:,0:p)^T v_p
+	if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, kb, kb, h->n-j, 1.,
+			Vt->A, 0, Vt->A, 0, 0., S->A, 0) != 0)
+	{
+		return 1;
+	}
+	for (p=0; p < kb; p++)
+	{
+		for (q=0; q < p; q++)
+		{
+			sum = 0.;
+			for (l=q; l < p; l++)
+			{
+				sum += T[q][l]*S->A[l][p];
+			}
+			T[q][p] = -h->tau[j+p]*sum;
+		}
+		T[p][p] = h->tau[j+p];
+	}
+	return 0;
+}
+
+// each panel is factored on its own columns, then the columns to its
+// right take (I - V T^T V^T) all at once, which in the rows of F is
+// F2 = F2 - ((F2 V) T) V^T
+static int qr_blocked(qr_handle h)
+{
+	matrix Vt=NULL,S=NULL,W1=NULL,W2=NULL;
+	float **F=h->F->A;
+	unsigned int n=h->n,m=h->m;
+	unsigned int kmin,j,kb,k,p,c,rows;
+	float beta,w;
+	int status=0;
+
+	kmin = (n < m) ? n : m;
+	if ((Vt = zero_matrix(QR_PANEL, n)) == NULL
+			|| (S = zero_matrix(QR_PANEL, QR_PANEL)) == NULL
+			|| (W1 = zero_matrix(m, QR_PANEL)) == NULL
+			|| (W2 = zero_matrix(m, QR_PANEL)) == NULL)
+	{
+		free_matrix(Vt);
+		free_matrix(S);
+		free_matrix(W1);
+		return 1;
+	}
+
+	for (j=0; status == 0 && j < kmin; j += QR_PANEL)
+	{
+		kb = (kmin - j < QR_PANEL) ? kmin - j : QR_PANEL;
+		for (k=0; k < kb; k++)
+		{
+			p = j + k;
+			h->tau[p] = reflector(F[p]+p, n-p-1, F[p]+p+1);
+			if (h->tau[p] == 0.)
+			{
+				continue;
+			}
+			beta = F[p][p];
+			F[p][p] = 1.;
+			for (c=p+1; c < j+kb; c++)
+			{
+				w = h->tau[p]*mathlib_kernels->dot(n-p, F[p]+p, F[c]+p);
+				mathlib_kernels->axpy(n-p, -w, F[p]+p, F[c]+p);
+			}
+			F[p][p] = beta;
+		}
+
+		block_vectors(h, j, kb, Vt);
+		if ((status = block_triangle(h, j, kb, Vt, S)) != 0
+				|| (rows = m - j - kb) == 0)
+		{
+			continue;
+		}
+		if (gemm_blocked(MATRIX_NOTRANS, MATRIX_TRANS, rows, kb, n-j, 1.,
+					F + j + kb, j, Vt->A, 0, 0., W1->A, 0) != 0
+				|| gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, rows, kb, kb, 1.,
+					W1->A, 0, h->T->A + j, 0, 0., W2->A, 0) != 0
+				|| gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, rows, n-j, kb, -1.,
+					W2->A, 0, Vt->A, 0, 1., F + j + kb, j) != 0)
+		{
+			status = 1;
+		}
+	}
+
+	free_matrix(Vt);
+	free_matrix(S);
+	free_matrix(W1);
+	free_matrix(W2);
+	return status;
+}
+
+// the column of largest remaining norm is chosen before each reflector,
+// so the columns to its right are only brought up to date in row p, for
+// the norms, and what they owe the panel is kept in Fx until the panel
+// ends and F2 -= Fx V^T, a panel also ends early once a norm has to be
+// recomputed from its column
+static int qr_pivoted(qr_handle h)
+{
+	struct pivot_job job;
+	matrix Fx=NULL,Vt=NULL,S=NULL;
+	float **F=h->F->A;
+	float a[QR_PANEL],g[QR_PANEL];
+	double *vn1=NULL,*vn2=NULL,dt;
+	unsigned char *stale=NULL;
+	unsigned int n=h->n,m=h->m;
+	unsigned int kmin,j,kb,k,p,c,q,best,ut;
+	float beta;
+	int status=0;
+
+	kmin = (n < m) ? n : m;
+	if ((Fx = zero_matrix(m, QR_PANEL)) == NULL
+			|| (Vt = zero_matrix(QR_PANEL, n)) == NULL
+			|| (S = zero_matrix(QR_PANEL, QR_PANEL)) == NULL
+			|| (vn1 = malloc(sizeof(*vn1)*m)) == NULL
+			|| (vn2 = malloc(sizeof(*vn2)*m)) == NULL
+			|| (stale = calloc(m, sizeof(*stale))) == NULL)
+	{
+		if (S != NULL)
+		{
+			perror("Error allocating memory");
+		}
+		free_matrix(Fx);
+		free_matrix(Vt);
+		free_matrix(S);
+		free(vn1);
+		free(vn2);
+		return 1;
+	}
+	for (c=0; c < m; c++)
+	{
+		vn1[c] = sqrt(mathlib_kernels->dot(n, F[c], F[c]));
+		vn2[c] = vn1[c];
+	}
+
+	job.F = F;
+	job.Fx = Fx->A;
+	job.n = n;
+	job.m = m;
+	job.a = a;
+	job.g = g;
+	job.vn1 = vn1;
+	job.vn2 = vn2;
+	job.stale = stale;
+	for (j=0; status == 0 && j < kmin; j += kb)
+	{
+		job.recompute = 0;
+		for (k=0; k < QR_PANEL && j + k < kmin; )
+		{
+			p = j + k;
+			best = p;
+			for (c=p+1; c < m; c++)
+			{
+				if (vn1[c] > vn1[best])
+				{
+					best = c;
+				}
+			}
+			if (best != p)
+			{
+				row_swap(F, p, best);
+				row_swap(Fx->A, p, best);
+				ut = h->perm[p];
+				h->perm[p] = h->perm[best];
+				h->perm[best] = ut;
+				dt = vn1[p];
+				vn1[p] = vn1[best];
+				vn1[best] = dt;
+				dt = vn2[p];
+				vn2[p] = vn2[best];
+				vn2[best] = dt;
+			}
+
+			// column p brought up to date with the panel
+			for (q=0; q < k; q++)
+			{
+				mathlib_kernels->axpy(n-p, -Fx->A[p][q], F[j+q]+p, F[p]+p);
+			}
+			h->tau[p] = reflector(F[p]+p, n-p-1, F[p]+p+1);
+			beta = F[p][p];
+			F[p][p] = 1.;
+			for (q=0; q < k; q++)
+			{
+				a[q] = mathlib_kernels->dot(n-p, F[j+q]+p, F[p]+p);
+				g[q] = F[j+q][p];
+			}
+			g[k] = 1.;
+
+			job.p = p;
+			job.k = k;
+			job.tau = h->tau[p];
+			if (p + 1 < m)
+			{
+				parallel_for((m - p - 2)/QR_COLUMNS + 1, pivot_task, &job);
+			}
+			F[p][p] = beta;
+			k++;
+			if (job.recompute)
+			{
+				break;
+			}
+		}
+		kb = k;
+
+		if (m > j + kb && n > j + kb)
+		{
+			status = gemm_blocked(MATRIX_NOTRANS, MATRIX_NOTRANS, m-j-kb, n-j-kb,
+					kb, -1., Fx->A + j + kb, 0, F + j, j + kb, 1., F + j + kb, j + kb);
+		}
+		for (c=j+kb; job.recompute && c < m; c++)
+		{
+			if (stale[c])
+			{
+				vn1[c] = sqrt(mathlib_kernels->dot(n-j-kb, F[c]+j+kb, F[c]+j+kb));
+				vn2[c] = vn1[c];
+				stale[c] = 0;
+			}
+		}
+	}
+
+	// T of each block for the solves
+	for (j=0; status == 0 && j < kmin; j += QR_PANEL)
+	{
+		kb = (kmin - j < QR_PANEL) ? kmin - j : QR_PANEL;
+		block_vectors(h, j, kb, Vt);
+		status = block_triangle(h, j, kb, Vt, S);
+	}
+
+	free_matrix(Fx);
+	free_matrix(Vt);
+	free_matrix(S);
+	free(vn1);
+	free(vn2);
+	free(stale);
+	return status;
+}
+
+// columns p+1.. of a task's share: its entry of column k of Fx, its
+// entry in row p of R and its norm without that entry
+static void pivot_task(void *arg, unsigned int t)
+{
+	struct pivot_job *job=arg;
+	float **F=job->F,**Fx=job->Fx;
+	unsigned int n=job->n,p=job->p,k=job->k;
+	unsigned int c,first,last;
+	double temp,temp2;
+
+	first = p + 1 + t*QR_COLUMNS;
+	last = (job->m - first < QR_COLUMNS) ? job->m : first + QR_COLUMNS;
+	for (c=first; c < last; c++)
+	{
+		Fx[c][k] = job->tau*(mathlib_kernels->dot(n-p, F[c]+p, F[p]+p)
+				- mathlib_kernels->dot(k, Fx[c], job->a));
+		F[c][p] -= mathlib_kernels->dot(k+1, Fx[c], job->g);
+
+		if (job->vn1[c] == 0.)
+		{
+			continue;
+		}
+		temp = fabs(F[c][p])/job->vn1[c];
+		temp = 1. - temp*temp;
+		temp = (temp < 0.) ? 0. : temp;
+		temp2 = temp*(job->vn1[c]/job->vn2[c])*(job->vn1[c]/job->vn2[c]);
+		if (temp2 <= sqrt(FLT_EPSILON))
+		{
+			job->stale[c] = 1;
+			__atomic_store_n(&job->recompute, 1, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			job->vn1[c] *= sqrt(temp);
+		}
+	}
+}
+
+static int qr_finish(qr_handle h)
+{
+	float **F=h->F->A,**R;
+	unsigned int n=h->n,m=h->m;
+	unsigned int kmin,r,l,i,k,c;
+	float tol,w;
+
+	kmin = (n < m) ? n : m;
+	tol = ((n > m) ? n : m)*FLT_EPSILON*fabs(F[0][0]);
+	for (r=0; r < kmin && fabs(F[r][r]) > tol; r++);
+	h->rank = r;
+	if (r == 0)
+	{
+		return 0;
+	}
+
+	if ((h->R = zero_matrix(r, m)) == NULL)
+	{
+		return 1;
+	}
+	R = h->R->A;
+	for (i=0; i < r; i++)
+	{
+		for (c=i; c < m; c++)
+		{
+			R[i][c] = F[c][i];
+		}
+	}
+	if (r == m)
+	{
+		return 0;
+	}
+
+	// [R11 R12] Z^T = [T11 0] from the last row up, from LAPACK's latrz
+	if ((h->tauz = malloc(sizeof(*h->tauz)*r)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	l = m - r;
+	for (i=r; i-- > 0; )
+	{
+		h->tauz[i] = reflector(R[i]+i, l, R[i]+r);
+		if (h->tauz[i] == 0.)
+		{
+			continue;
+		}
+		for (k=0; k < i; k++)
+		{
+			w = h->tauz[i]*(R[k][i] + mathlib_kernels->dot(l, R[k]+r, R[i]+r));
+			R[k][i] -= w;
+			mathlib_kernels->axpy(l, -w, R[i]+r, R[k]+r);
+		}
+	}
+	return 0;
+}
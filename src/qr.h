@@ -0,0 +1,67 @@
+/* Householder QR and linear least squares
+ * Oct 18 2026 */
+
+#ifndef QR_H
+#define QR_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+
+#include "matrix.h"
+#include "vector.h"
+#include "gemm.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// pivoting strategies for qr_factor
+#define QR_NO_PIVOTING 0 // A=QR
+#define QR_COLUMN_PIVOTING 1 // the largest remaining column goes next, AP=QR
+// reflectors per panel, the trailing matrix is updated once per panel
+// by matrix multiplication
+#define QR_PANEL 32
+// trailing columns per task of a column pivoted panel
+#define QR_COLUMNS 64
+
+// AP = QR for an n x m A, Q the product of the reflectors
+// H_j = I - tau_j v_j v_j^T where v_j is 1 in row j and zero above
+// a factorization is never modified once made, so any number of threads
+// may solve with it at the same time
+struct qr_factorization
+{
+	unsigned int n, m;
+	unsigned int rank;
+	int pivoting; // QR_NO_PIVOTING or QR_COLUMN_PIVOTING
+	unsigned int refs; // references held, the last release frees it
+	matrix F; // m x n, row j is R(0:j,j) followed by v_j below its 1
+	matrix T; // rows j.. hold T of the block I - V T V^T of reflector j..
+	float *tau;
+	unsigned int *perm; // column j of AP is column perm[j] of A
+	matrix R; // rows 0..rank-1 of R, as [T11 0]Z if rank < m
+	float *tauz; // the reflectors of Z, NULL if rank == m
+};
+typedef struct qr_factorization *qr_handle;
+
+// factor A into a new handle holding one reference, NULL on failure
+// the rank is the number of diagonal elements of R above
+// max(n,m)*FLT_EPSILON*|R_00|, only meaningful with column pivoting
+extern qr_handle qr_factor(matrix A, int pivoting);
+extern qr_handle qr_retain(qr_handle h);
+extern void qr_release(qr_handle h);
+extern unsigned int qr_rank(qr_handle h);
+// the x of least norm among those minimizing |Ax-b|, returns 0 on success
+extern int qr_solve(qr_handle h, vector x, vector b);
+// the same for every column of the n x k B into the m x k X
+extern int qr_solve_many(qr_handle h, matrix B, matrix X);
+// least squares solution of Ax=b, A is factored with column pivoting
+// the first time it is seen and the factorization is kept for later calls
+// this only compares the pointer! if A changes call free_least_squares(A)
+extern int least_squares_solve(matrix A, vector x, vector b);
+// cleanup
+extern void free_least_squares(matrix A);
+extern void free_all_least_squares(void);
+
+#endif
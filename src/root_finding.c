@@ -0,0 +1,367 @@
+/* Bracketed root finding for scalar equations f(x)=0
+ * Oct 18 2026 */
+
+#include "root_finding.h"
+
+// one task of root_newton_batch
+struct root_job
+{
+	root_batch_fdf f;
+	void *userdata;
+	unsigned int count;
+	const float *a, *b;
+	float *x;
+	float xtol, ftol;
+	unsigned int maxiter;
+	int *status;
+	int failed; // some problem didn't converge
+};
+
+int root_newton(root_fdf f, void *userdata, float x0, float a, float b,
+		float xtol, float ftol, unsigned int maxiter, float *root);
+int root_brent(root_func f, void *userdata, float a, float b,
+		float xtol, unsigned int maxiter, float *root);
+int root_newton_batch(root_batch_fdf f, void *userdata,
+		unsigned int count, const float *a, const float *b, float *x,
+		float xtol, float ftol, unsigned int maxiter, int *status);
+
+// set up the bracket from f(a) and f(b)
+static int bracket(float a, float b, float fa, float fb, float *lo, float *hi,
+		float *root);
+// solve the problems of one task
+static void root_task(void *arg, unsigned int t);
+static int root_block(struct root_job *job, unsigned int first, unsigned int n,
+		float *lo, float *hi, float *x, float *fx, float *dfx,
+		unsigned int *index);
+
+// orient the bracket so f(lo) < 0 < f(hi), returns a status
+// or -1 if there is a bracket to search, a root at an end is in root
+static int bracket(float a, float b, float fa, float fb, float *lo, float *hi,
+		float *root)
+{
+	if (!isfinite(fa) || !isfinite(fb))
+	{
+		return ROOT_NOT_FINITE;
+	}
+	if (fa == 0. || fb == 0.)
+	{
+		*root = (fa == 0.) ? a : b;
+		return ROOT_OK;
+	}
+	if ((fa < 0.) == (fb < 0.))
+	{
+		*root = NAN;
+		return ROOT_NO_BRACKET;
+	}
+	*lo = (fa < 0.) ? a : b;
+	*hi = (fa < 0.) ? b : a;
+	return -1;
+}
+
+// Newton's method kept inside the bracket [a,b] by bisection
+int root_newton(root_fdf f, void *userdata, float x0, float a, float b,
+		float xtol, float ftol, unsigned int maxiter, float *root)
+{
+	float lo=0.,hi=0.,x,fx,dfx,fa,fb;
+	unsigned int i;
+	int status;
+
+	if (maxiter == 0)
+	{
+		maxiter = ROOT_DEFAULT_MAXITER;
+	}
+
+	fa = (*f)(a, &dfx, userdata);
+	fb = (*f)(b, &dfx, userdata);
+	if ((status = bracket(a, b, fa, fb, &lo, &hi, root)) >= 0)
+	{
+		return status;
+	}
+
+	x = (x0 > fminf(a, b) && x0 < fmaxf(a, b)) ? x0 : 0.5f*(a + b);
+	for (i=0; i < maxiter; i++)
+	{
+		// f and f' come from the same call
+		fx = (*f)(x, &dfx, userdata);
+		if (!isfinite(fx))
+		{
+			*root = x;
+			return ROOT_NOT_FINITE;
+		}
+		kernel_newton_step(1, &lo, &hi, &x, &fx, &dfx, xtol, ftol);
+		if (dfx != 0.)
+		{
+			*root = x;
+			return ROOT_OK;
+		}
+	}
+
+	*root = x;
+	return ROOT_NO_CONVERGENCE;
+}
+
+// Brent's method, inverse quadratic interpolation or the secant
+// when they stay well inside the bracket, bisection otherwise
+// after Brent, Algorithms for Minimization without Derivatives
+int root_brent(root_func f, void *userdata, float a, float b,
+		float xtol, unsigned int maxiter, float *root)
+{
+	float c,d,e,fa,fb,fc,tol,m,p,q,r,s,lo,hi;
+	unsigned int i;
+	int status;
+
+	if (maxiter == 0)
+	{
+		maxiter = ROOT_DEFAULT_MAXITER;
+	}
+
+	fa = (*f)(a, userdata);
+	fb = (*f)(b, userdata);
+	if ((status = bracket(a, b, fa, fb, &lo, &hi, root)) >= 0)
+	{
+		return status;
+	}
+
+	// b is the best estimate so far, c the other end of the bracket
+	c = a;
+	fc = fa;
+	d = e = b - a;
+	for (i=0; i < maxiter; i++)
+	{
+		if ((fb < 0.) == (fc < 0.))
+		{
+			c = a;
+			fc = fa;
+			d = e = b - a;
+		}
+		if (fabsf(fc) < fabsf(fb))
+		{
+			a = b;
+			b = c;
+			c = a;
+			fa = fb;
+			fb = fc;
+			fc = fa;
+		}
+
+		tol = 0.5f*xtol + 2*FLT_EPSILON*fabsf(b);
+		m = 0.5f*(c - b);
+		if (fabsf(m) <= tol || fb == 0.)
+		{
+			*root = b;
+			return ROOT_OK;
+		}
+
+		if (fabsf(e) >= tol && fabsf(fa) > fabsf(fb))
+		{
+			s = fb/fa;
+			if (a == c)
+			{
+				// secant
+				p = 2*m*s;
+				q = 1 - s;
+			}
+			else
+			{
+				// inverse quadratic interpolation
+				q = fa/fc;
+				r = fb/fc;
+				p = s*(2*m*q*(q - r) - (b - a)*(r - 1));
+				q = (q - 1)*(r - 1)*(s - 1);
+			}
+			if (p > 0.)
+			{
+				q = -q;
+			}
+			else
+			{
+				p = -p;
+			}
+			// accept the step only if it shrinks fast enough
+			if (2*p < fminf(3*m*q - fabsf(tol*q), fabsf(e*q)))
+			{
+				e = d;
+				d = p/q;
+			}
+			else
+			{
+				d = m;
+				e = m;
+			}
+		}
+		else
+		{
+			d = m;
+			e = m;
+		}
+
+		a = b;
+		fa = fb;
+		b += (fabsf(d) > tol) ? d : (m > 0. ? tol : -tol);
+		fb = (*f)(b, userdata);
+		if (!isfinite(fb))
+		{
+			*root = b;
+			return ROOT_NOT_FINITE;
+		}
+	}
+
+	*root = b;
+	return ROOT_NO_CONVERGENCE;
+}
+
+// root_newton for many problems, in tasks of ROOT_BATCH problems
+int root_newton_batch(root_batch_fdf f, void *userdata,
+		unsigned int count, const float *a, const float *b, float *x,
+		float xtol, float ftol, unsigned int maxiter, int *status)
+{
+	struct root_job job;
+
+	job.f = f;
+	job.userdata = userdata;
+	job.count = count;
+	job.a = a;
+	job.b = b;
+	job.x = x;
+	job.xtol = xtol;
+	job.ftol = ftol;
+	job.maxiter = (maxiter > 0) ? maxiter : ROOT_DEFAULT_MAXITER;
+	job.status = status;
+	job.failed = 0;
+
+	parallel_for((count + ROOT_BATCH - 1)/ROOT_BATCH, &root_task, &job);
+
+	return job.failed;
+}
+
+// solve problems t*ROOT_BATCH ... of the job
+static void root_task(void *arg, unsigned int t)
+{
+	struct root_job *job = arg;
+	unsigned int first=t*ROOT_BATCH;
+	unsigned int n,k;
+	unsigned int *index;
+	float *work;
+
+	n = job->count - first;
+	if (n > ROOT_BATCH)
+	{
+		n = ROOT_BATCH;
+	}
+
+	work = vector_allocate(5*n);
+	index = malloc(sizeof(*index)*n);
+	if (work == NULL || index == NULL)
+	{
+		if (index == NULL)
+		{
+			perror("Error allocating memory");
+		}
+		for (k=0; k < n && job->status != NULL; k++)
+		{
+			job->status[first+k] = ROOT_NO_CONVERGENCE;
+		}
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+	else if (root_block(job, first, n, work, work+n, work+2*n, work+3*n,
+				work+4*n, index) != 0)
+	{
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+
+	free(work);
+	free(index);
+}
+
+// the problems still iterating are kept packed at the front of the
+// arrays, so f is evaluated on contiguous x and the Newton steps
+// run over contiguous lanes, returns nonzero if any problem failed
+static int root_block(struct root_job *job, unsigned int first, unsigned int n,
+		float *lo, float *hi, float *x, float *fx, float *dfx,
+		unsigned int *index)
+{
+	unsigned int active,i,k;
+	int status,failed=0;
+	float root=0.;
+
+	// f at both ends of every bracket, f(a) is kept in lo for now
+	for (k=0; k < n; k++)
+	{
+		index[k] = first+k;
+		x[k] = job->a[first+k];
+	}
+	(*job->f)(x, fx, dfx, index, n, job->userdata);
+	memcpy(lo, fx, sizeof(*fx)*n);
+	for (k=0; k < n; k++)
+	{
+		x[k] = job->b[first+k];
+	}
+	(*job->f)(x, fx, dfx, index, n, job->userdata);
+
+	// problems settled by their brackets drop out at once
+	active = 0;
+	for (k=0; k < n; k++)
+	{
+		i = first+k;
+		status = bracket(job->a[i], job->b[i], lo[k], fx[k], &lo[active],
+				&hi[active], &root);
+		if (status >= 0)
+		{
+			job->x[i] = root;
+			failed |= (status != ROOT_OK);
+			if (job->status != NULL)
+			{
+				job->status[i] = status;
+			}
+			continue;
+		}
+		x[active] = (job->x[i] > fminf(job->a[i], job->b[i])
+				&& job->x[i] < fmaxf(job->a[i], job->b[i]))
+			? job->x[i] : 0.5f*(job->a[i] + job->b[i]);
+		index[active++] = i;
+	}
+
+	for (i=0; i < job->maxiter && active > 0; i++)
+	{
+		(*job->f)(x, fx, dfx, index, active, job->userdata);
+
+		// the steps in SIMD lanes, a flag for each lane is left in dfx
+		mathlib_kernels->newton_step(active, lo, hi, x, fx, dfx, job->xtol, job->ftol);
+
+		// retire the finished lanes, the last active lane takes their place
+		for (k=0; k < active; )
+		{
+			if (dfx[k] == 0. && isfinite(fx[k]))
+			{
+				k++;
+				continue;
+			}
+			status = isfinite(fx[k]) ? ROOT_OK : ROOT_NOT_FINITE;
+			job->x[index[k]] = x[k];
+			failed |= (status != ROOT_OK);
+			if (job->status != NULL)
+			{
+				job->status[index[k]] = status;
+			}
+			active--;
+			lo[k] = lo[active];
+			hi[k] = hi[active];
+			x[k] = x[active];
+			fx[k] = fx[active];
+			dfx[k] = dfx[active];
+			index[k] = index[active];
+		}
+	}
+
+	// out of iterations
+	for (k=0; k < active; k++)
+	{
+		job->x[index[k]] = x[k];
+		if (job->status != NULL)
+		{
+			job->status[index[k]] = ROOT_NO_CONVERGENCE;
+		}
+		failed = 1;
+	}
+	return failed;
+}
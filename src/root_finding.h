@@ -0,0 +1,54 @@
+/* Bracketed root finding for scalar equations f(x)=0
+ * Oct 18 2026 */
+
+#ifndef ROOT_FINDING_H
+#define ROOT_FINDING_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "vector.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// status of a root finder
+#define ROOT_OK 0 // converged
+#define ROOT_NO_CONVERGENCE 1 // the iteration limit was reached
+#define ROOT_NO_BRACKET 2 // f(a) and f(b) have the same sign
+#define ROOT_NOT_FINITE 3 // f returned inf or NaN
+#define ROOT_SINGULAR 4 // the Jacobian of a system is singular
+
+// iterations allowed when 0 is given
+#define ROOT_DEFAULT_MAXITER 100
+// problems solved together by one task of root_newton_batch
+#define ROOT_BATCH 1024
+
+// f(x)
+typedef float (*root_func)(float x, void *userdata);
+// f(x) and f'(x) from one evaluation
+typedef float (*root_fdf)(float x, float *dfdx, void *userdata);
+// f and f' at x[k] for problem index[k], 0 <= k < count
+// called from several threads at once
+typedef void (*root_batch_fdf)(const float *x, float *f, float *dfdx,
+		const unsigned int *index, unsigned int count, void *userdata);
+
+// Newton's method kept inside the bracket [a,b] by bisection, starting
+// at x0 or the midpoint if x0 is outside, converged when |f| <= ftol or
+// the step is below xtol + 4*FLT_EPSILON*|x|, returns a status
+extern int root_newton(root_fdf f, void *userdata, float x0, float a, float b,
+		float xtol, float ftol, unsigned int maxiter, float *root);
+// Brent's method on the bracket [a,b], needs no derivative
+// converged when the bracket is below xtol + 4*FLT_EPSILON*|x|
+extern int root_brent(root_func f, void *userdata, float a, float b,
+		float xtol, unsigned int maxiter, float *root);
+// root_newton for count independent problems at once, problem k has
+// bracket [a[k],b[k]] and starts at x[k], where its root is left
+// status may be NULL, returns 0 if every problem converged
+extern int root_newton_batch(root_batch_fdf f, void *userdata,
+		unsigned int count, const float *a, const float *b, float *x,
+		float xtol, float ftol, unsigned int maxiter, int *status);
+
+#endif
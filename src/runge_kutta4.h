@@ -9,7 +9,14 @@
 #include "matrix.h"
 #include "vector.h"
 #include "vector_function.h"
+#include "ode_stream.h"
 
 extern matrix runge_kutta4(vector_function f, vector y0, float tmin, float tmax, float h);
+// the same rows pushed to out one at a time, returns 0 on success
+extern int runge_kutta4_stream(vector_function f, vector y0, float tmin, float tmax,
+		float h, ode_stream out);
+// the same for a right hand side computed a whole vector at a time
+extern int runge_kutta4_rhs(ode_rhs f, void *userdata, vector y0, float tmin,
+		float tmax, float h, ode_stream out);
 
 #endif
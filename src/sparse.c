@@ -0,0 +1,465 @@
+/* Compressed sparse matrices
+ * Oct 18 2026 */
+
+#include "sparse.h"
+
+// y = alpha*A*x + beta*y split over ranges of rows
+struct spmv_job
+{
+	float alpha, beta;
+	sparse A;
+	const float *x;
+	float *y;
+};
+
+sparse sparse_allocate(unsigned int n, unsigned int m, unsigned int nnz,
+		int format);
+sparse sparse_from_triplets(unsigned int n, unsigned int m,
+		unsigned int count, const unsigned int *row, const unsigned int *col,
+		const float *value, int format);
+sparse sparse_from_matrix(matrix A, float drop, int format);
+sparse sparse_convert(sparse A, int format);
+matrix sparse_to_matrix(sparse A);
+void free_sparse(sparse A);
+size_t sparse_bytes(sparse A);
+int sparse_spmv(float alpha, sparse A, const float *x, float beta, float *y);
+void sparse_residual(sparse A, const float *x, const float *b, float *r);
+double sparse_norm1(sparse A);
+
+// rows (columns) of a CSR (CSC) matrix and the length of their index
+static unsigned int major_dim(sparse A);
+static unsigned int minor_dim(sparse A);
+// the rows of one task of sparse_spmv()
+static void spmv_task(void *arg, unsigned int t);
+
+// rows of a CSR matrix, columns of a CSC one
+static unsigned int major_dim(sparse A)
+{
+	return (A->format == SPARSE_CSC) ? A->m : A->n;
+}
+
+// the other dimension
+static unsigned int minor_dim(sparse A)
+{
+	return (A->format == SPARSE_CSC) ? A->n : A->m;
+}
+
+// an empty matrix with room for nnz entries
+sparse sparse_allocate(unsigned int n, unsigned int m, unsigned int nnz,
+		int format)
+{
+	sparse A;
+
+	if (n < 1 || m < 1 || n > INT_MAX || m > INT_MAX)
+	{
+		fprintf(stderr,"Error: dimensions must be >=1 and below 2^31\n");
+		return NULL;
+	}
+	if (format != SPARSE_CSR && format != SPARSE_CSC)
+	{
+		fprintf(stderr,"Error: unknown sparse format %d\n",format);
+		return NULL;
+	}
+	if ((A = calloc(1, sizeof(*A))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	A->n = n;
+	A->m = m;
+	A->format = format;
+	// at least one entry so an empty matrix still has arrays
+	A->ptr = calloc((size_t)major_dim(A)+1, sizeof(*A->ptr));
+	A->index = malloc(sizeof(*A->index)*(nnz > 0 ? nnz : 1));
+	A->value = malloc(sizeof(*A->value)*(nnz > 0 ? nnz : 1));
+	if (A->ptr == NULL || A->index == NULL || A->value == NULL)
+	{
+		perror("Error allocating memory");
+		free_sparse(A);
+		return NULL;
+	}
+	return A;
+}
+
+// two stable counting sorts, by the minor index and then the major one,
+// leave the entries of every row (column) in order, then duplicates merge
+sparse sparse_from_triplets(unsigned int n, unsigned int m,
+		unsigned int count, const unsigned int *row, const unsigned int *col,
+		const float *value, int format)
+{
+	sparse A;
+	const unsigned int *major,*minor;
+	unsigned int *start,*order;
+	unsigned int i,k,p,q,end,nmajor,nminor;
+
+	if ((A = sparse_allocate(n, m, count, format)) == NULL)
+	{
+		return NULL;
+	}
+	major = (format == SPARSE_CSC) ? col : row;
+	minor = (format == SPARSE_CSC) ? row : col;
+	nmajor = major_dim(A);
+	nminor = minor_dim(A);
+
+	for (k=0; k < count; k++)
+	{
+		if (row[k] >= n || col[k] >= m)
+		{
+			fprintf(stderr,"Entry (%u,%u) is outside the matrix\n",row[k],col[k]);
+			free_sparse(A);
+			return NULL;
+		}
+	}
+
+	start = calloc((size_t)nminor+1, sizeof(*start));
+	order = malloc(sizeof(*order)*(count > 0 ? count : 1));
+	if (start == NULL || order == NULL)
+	{
+		perror("Error allocating memory");
+		free(start);
+		free(order);
+		free_sparse(A);
+		return NULL;
+	}
+
+	// by the minor index
+	for (k=0; k < count; k++)
+	{
+		start[minor[k]+1]++;
+	}
+	for (i=0; i < nminor; i++)
+	{
+		start[i+1] += start[i];
+	}
+	for (k=0; k < count; k++)
+	{
+		order[start[minor[k]]++] = k;
+	}
+
+	// then by the major index, which keeps the minor order
+	for (k=0; k < count; k++)
+	{
+		A->ptr[major[k]+1]++;
+	}
+	for (i=0; i < nmajor; i++)
+	{
+		A->ptr[i+1] += A->ptr[i];
+	}
+	memcpy(start, A->ptr, sizeof(*start)*nmajor);
+	for (p=0; p < count; p++)
+	{
+		k = order[p];
+		q = start[major[k]]++;
+		A->index[q] = minor[k];
+		A->value[q] = value[k];
+	}
+	free(order);
+	free(start);
+
+	// sum the duplicates, compacting each row (column) to the front
+	q = 0;
+	for (i=0; i < nmajor; i++)
+	{
+		p = A->ptr[i];
+		end = A->ptr[i+1];
+		A->ptr[i] = q;
+		for (; p < end; p++)
+		{
+			if (q > A->ptr[i] && A->index[q-1] == A->index[p])
+			{
+				A->value[q-1] += A->value[p];
+				continue;
+			}
+			A->index[q] = A->index[p];
+			A->value[q++] = A->value[p];
+		}
+	}
+	A->ptr[nmajor] = q;
+	A->nnz = q;
+	return A;
+}
+
+// the elements of a dense matrix or view with |a_ij| > drop
+sparse sparse_from_matrix(matrix A, float drop, int format)
+{
+	sparse S,T;
+	unsigned int i,j,nnz=0;
+	float a;
+
+	for (i=0; i < A->n; i++)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			a = (A->flags & MATRIX_TRANSPOSED) ? A->A[j][i] : A->A[i][j];
+			nnz += (fabsf(a) > drop);
+		}
+	}
+	if ((S = sparse_allocate(A->n, A->m, nnz, SPARSE_CSR)) == NULL)
+	{
+		return NULL;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			a = (A->flags & MATRIX_TRANSPOSED) ? A->A[j][i] : A->A[i][j];
+			if (fabsf(a) > drop)
+			{
+				S->index[S->nnz] = j;
+				S->value[S->nnz++] = a;
+			}
+		}
+		S->ptr[i+1] = S->nnz;
+	}
+	if (format == SPARSE_CSR)
+	{
+		return S;
+	}
+	T = sparse_convert(S, format);
+	free_sparse(S);
+	return T;
+}
+
+// A in the given format, the rows of one become the columns of the
+// other by a counting sort, which leaves each in increasing order
+sparse sparse_convert(sparse A, int format)
+{
+	sparse B;
+	unsigned int *start;
+	unsigned int i,p,q,nmajor,nminor;
+
+	if ((B = sparse_allocate(A->n, A->m, A->nnz, format)) == NULL)
+	{
+		return NULL;
+	}
+	B->nnz = A->nnz;
+	if (B->format == A->format)
+	{
+		memcpy(B->ptr, A->ptr, sizeof(*B->ptr)*((size_t)major_dim(A)+1));
+		memcpy(B->index, A->index, sizeof(*B->index)*A->nnz);
+		memcpy(B->value, A->value, sizeof(*B->value)*A->nnz);
+		return B;
+	}
+
+	nmajor = major_dim(A);
+	nminor = minor_dim(A);
+	if ((start = malloc(sizeof(*start)*nminor)) == NULL)
+	{
+		perror("Error allocating memory");
+		free_sparse(B);
+		return NULL;
+	}
+	for (p=0; p < A->nnz; p++)
+	{
+		B->ptr[A->index[p]+1]++;
+	}
+	for (i=0; i < nminor; i++)
+	{
+		B->ptr[i+1] += B->ptr[i];
+	}
+	memcpy(start, B->ptr, sizeof(*start)*nminor);
+	for (i=0; i < nmajor; i++)
+	{
+		for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+		{
+			q = start[A->index[p]]++;
+			B->index[q] = i;
+			B->value[q] = A->value[p];
+		}
+	}
+	free(start);
+	return B;
+}
+
+// a dense copy
+matrix sparse_to_matrix(sparse A)
+{
+	matrix D;
+	unsigned int i,p;
+
+	if ((D = zero_matrix(A->n, A->m)) == NULL)
+	{
+		return NULL;
+	}
+	for (i=0; i < major_dim(A); i++)
+	{
+		for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+		{
+			if (A->format == SPARSE_CSC)
+			{
+				D->A[A->index[p]][i] = A->value[p];
+			}
+			else
+			{
+				D->A[i][A->index[p]] = A->value[p];
+			}
+		}
+	}
+	return D;
+}
+
+void free_sparse(sparse A)
+{
+	if (A == NULL)
+	{
+		return;
+	}
+	free(A->ptr);
+	free(A->index);
+	free(A->value);
+	free(A);
+}
+
+// memory held by a sparse matrix
+size_t sparse_bytes(sparse A)
+{
+	return sizeof(*A) + sizeof(*A->ptr)*((size_t)major_dim(A)+1)
+		+ (sizeof(*A->index) + sizeof(*A->value))*(size_t)A->nnz;
+}
+
+// y = alpha*A*x + beta*y
+int sparse_spmv(float alpha, sparse A, const float *x, float beta, float *y)
+{
+	struct spmv_job job;
+	unsigned int i,j,p;
+
+	if (A->format == SPARSE_CSR)
+	{
+		job.alpha = alpha;
+		job.beta = beta;
+		job.A = A;
+		job.x = x;
+		job.y = y;
+		parallel_for((A->n + SPARSE_SPMV_ROWS - 1)/SPARSE_SPMV_ROWS,
+				&spmv_task, &job);
+		return 0;
+	}
+
+	// the columns of a CSC matrix scatter into y
+	for (i=0; i < A->n; i++)
+	{
+		y[i] = (beta == 0.) ? 0. : beta*y[i];
+	}
+	for (j=0; j < A->m; j++)
+	{
+		for (p=A->ptr[j]; p < A->ptr[j+1]; p++)
+		{
+			y[A->index[p]] += alpha*A->value[p]*x[j];
+		}
+	}
+	return 0;
+}
+
+// rows t*SPARSE_SPMV_ROWS ... of y = alpha*A*x + beta*y
+static void spmv_task(void *arg, unsigned int t)
+{
+	struct spmv_job *job = arg;
+	sparse A = job->A;
+	unsigned int first=t*SPARSE_SPMV_ROWS;
+	unsigned int last=first+SPARSE_SPMV_ROWS;
+	unsigned int i;
+	float sum;
+
+	if (last > A->n)
+	{
+		last = A->n;
+	}
+	for (i=first; i < last; i++)
+	{
+		sum = mathlib_kernels->gather_dot(A->ptr[i+1] - A->ptr[i], A->value + A->ptr[i],
+				A->index + A->ptr[i], job->x);
+		// y isn't read when beta is 0, so it may start out as anything
+		job->y[i] = (job->beta == 0.) ? job->alpha*sum
+			: job->alpha*sum + job->beta*job->y[i];
+	}
+}
+
+// r = b - Ax in double
+void sparse_residual(sparse A, const float *x, const float *b, float *r)
+{
+	double *sum;
+	unsigned int i,j,p;
+	double s;
+
+	if (A->format == SPARSE_CSR)
+	{
+		for (i=0; i < A->n; i++)
+		{
+			s = b[i];
+			for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+			{
+				s -= (double)A->value[p]*x[A->index[p]];
+			}
+			r[i] = s;
+		}
+		return;
+	}
+
+	// the sums of a CSC matrix need a row of doubles
+	if ((sum = malloc(sizeof(*sum)*A->n)) == NULL)
+	{
+		perror("Error allocating memory");
+		sparse_spmv(-1., A, x, 0., r);
+		for (i=0; i < A->n; i++)
+		{
+			r[i] += b[i];
+		}
+		return;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		sum[i] = b[i];
+	}
+	for (j=0; j < A->m; j++)
+	{
+		for (p=A->ptr[j]; p < A->ptr[j+1]; p++)
+		{
+			sum[A->index[p]] -= (double)A->value[p]*x[j];
+		}
+	}
+	for (i=0; i < A->n; i++)
+	{
+		r[i] = sum[i];
+	}
+	free(sum);
+}
+
+// the largest column sum
+double sparse_norm1(sparse A)
+{
+	double *sum,s,norm=0.;
+	unsigned int i,j,p;
+
+	if (A->format == SPARSE_CSC)
+	{
+		for (j=0; j < A->m; j++)
+		{
+			s = 0.;
+			for (p=A->ptr[j]; p < A->ptr[j+1]; p++)
+			{
+				s += fabsf(A->value[p]);
+			}
+			norm = fmax(norm, s);
+		}
+		return norm;
+	}
+
+	if ((sum = calloc(A->m, sizeof(*sum))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NAN;
+	}
+	for (i=0; i < A->n; i++)
+	{
+		for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+		{
+			sum[A->index[p]] += fabsf(A->value[p]);
+		}
+	}
+	for (j=0; j < A->m; j++)
+	{
+		norm = fmax(norm, sum[j]);
+	}
+	free(sum);
+	return norm;
+}
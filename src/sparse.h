@@ -0,0 +1,62 @@
+/* Compressed sparse matrices
+ * Oct 18 2026 */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "matrix.h"
+#include "kernel.h"
+#include "thread_pool.h"
+
+// storage of a sparse matrix
+#define SPARSE_CSR 0 // compressed rows, ptr has n+1 entries
+#define SPARSE_CSC 1 // compressed columns, ptr has m+1 entries
+
+// rows of a CSR matrix multiplied by one task of sparse_spmv()
+#define SPARSE_SPMV_ROWS 4096
+
+// only the nonzeros of a matrix, n and m must be below 2^31
+typedef struct
+{
+	unsigned int n; // number of rows (height) of matrix
+	unsigned int m; // number of columns (width) of matrix
+	unsigned int nnz; // stored entries
+	unsigned int format; // SPARSE_CSR or SPARSE_CSC
+	unsigned int *ptr; // entries of row (column) i are ptr[i] ... ptr[i+1]-1
+	unsigned int *index; // column (row) of each entry, increasing in a row (column)
+	float *value;
+} *sparse;
+
+// room for nnz entries, ptr is zeroed
+extern sparse sparse_allocate(unsigned int n, unsigned int m, unsigned int nnz,
+		int format);
+// from count triplets (row[k], col[k], value[k]) in any order,
+// duplicates are summed as in finite element assembly
+extern sparse sparse_from_triplets(unsigned int n, unsigned int m,
+		unsigned int count, const unsigned int *row, const unsigned int *col,
+		const float *value, int format);
+// the elements of a dense matrix with |a_ij| > drop
+extern sparse sparse_from_matrix(matrix A, float drop, int format);
+// A in the given format, a copy if it is in that format already
+extern sparse sparse_convert(sparse A, int format);
+extern matrix sparse_to_matrix(sparse A);
+extern void free_sparse(sparse A);
+// memory held by a sparse matrix
+extern size_t sparse_bytes(sparse A);
+// y = alpha*A*x + beta*y, the rows of a CSR matrix are split over the
+// thread pool and each is a gathered dot product, CSC is done serially
+// returns 0 on success
+extern int sparse_spmv(float alpha, sparse A, const float *x, float beta,
+		float *y);
+// r = b - Ax with the sums accumulated in double
+extern void sparse_residual(sparse A, const float *x, const float *b, float *r);
+// |A|_1, the largest column sum
+extern double sparse_norm1(sparse A);
+
+#endif
@@ -0,0 +1,876 @@
+/* Sparse LU factorization
+ * Oct 18 2026 */
+
+#include "sparse_lu.h"
+
+// an index that isn't one
+#define SPARSE_NONE UINT_MAX
+
+// what a node of the quotient graph currently stands for
+#define AMD_VARIABLE 0 // not eliminated yet
+#define AMD_ELEMENT 1 // eliminated, standing for the clique it left behind
+#define AMD_ABSORBED 2 // an element contained in a newer one
+
+// PAQ=LU, L and U are stored by columns
+struct sparse_factors
+{
+	sparse A; // the system, for refinement and condition estimates
+	unsigned int n;
+	sparse L; // unit lower triangle, the diagonal first in each column
+	sparse U; // upper triangle, the diagonal last in each column
+	unsigned int *pinv; // row i of A is row pinv[i] of LU
+	unsigned int *q; // column k of LU is column q[k] of A
+};
+
+// a growing list of nodes
+struct amd_list
+{
+	unsigned int *a;
+	unsigned int len;
+	unsigned int cap;
+};
+
+// the quotient graph of a minimum degree ordering, elements are
+// named after the variable whose elimination made them
+struct amd_graph
+{
+	unsigned int n;
+	// the variables and elements next to a variable,
+	// or the variables of an element
+	struct amd_list *adj;
+	unsigned char *status;
+	unsigned int *degree; // approximate external degree of a variable
+	unsigned int *head, *next, *prev; // variables by degree
+	unsigned int mindeg; // no variable has a smaller degree
+	unsigned int *mark; // step at which a variable joined the new element
+	unsigned int *wstep; // step at which w of an element was set
+	unsigned int *w; // variables of an element outside the new one
+};
+
+int sparse_amd(sparse A, unsigned int *order);
+lu_handle sparse_lu_factor(sparse A, int ordering);
+size_t sparse_lu_nnz(lu_handle h);
+int sparse_factors_solve(struct sparse_factors *f, const float *b, float *x);
+int sparse_factors_solve_transposed(struct sparse_factors *f, float *z);
+double sparse_factors_logdet(struct sparse_factors *f, int *sign);
+sparse sparse_factors_system(struct sparse_factors *f);
+size_t sparse_factors_bytes(struct sparse_factors *f);
+void sparse_factors_free(struct sparse_factors *f);
+
+// append v, returns 0 on success
+static int amd_push(struct amd_list *l, unsigned int v);
+// the pattern of A+A^T without its diagonal
+static int amd_build(struct amd_graph *g, sparse A);
+// move variables in and out of the degree lists
+static void degree_insert(struct amd_graph *g, unsigned int i, unsigned int d);
+static void degree_remove(struct amd_graph *g, unsigned int i);
+// eliminate variable p as step k
+static int amd_eliminate(struct amd_graph *g, unsigned int p, unsigned int k);
+static void amd_free(struct amd_graph *g);
+// left looking factorization of the columns of C in the order q,
+// L and U have room for cap entries to start with
+static int factor(struct sparse_factors *f, sparse C, unsigned int cap);
+// the rows reached from column col of C through L, in topological order
+static unsigned int reach(struct sparse_factors *f, sparse C, unsigned int col,
+		unsigned int *xi, unsigned int *mark, unsigned int tag);
+// make room for need more entries in S
+static int grow(sparse S, unsigned int *cap, unsigned int need);
+
+// append v, doubling the list when it is full
+static int amd_push(struct amd_list *l, unsigned int v)
+{
+	unsigned int *a;
+	unsigned int cap;
+
+	if (l->len == l->cap)
+	{
+		cap = (l->cap > 0) ? 2*l->cap : 4;
+		if ((a = realloc(l->a, sizeof(*a)*cap)) == NULL)
+		{
+			perror("Error allocating memory");
+			return 1;
+		}
+		l->a = a;
+		l->cap = cap;
+	}
+	l->a[l->len++] = v;
+	return 0;
+}
+
+// every off diagonal entry a_ij makes i and j neighbours
+static int amd_build(struct amd_graph *g, sparse A)
+{
+	unsigned int *count;
+	unsigned int i,j,p,q,len;
+
+	if ((count = calloc(g->n, sizeof(*count))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	for (i=0; i < g->n; i++)
+	{
+		for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+		{
+			if ((j = A->index[p]) != i)
+			{
+				count[i]++;
+				count[j]++;
+			}
+		}
+	}
+	for (i=0; i < g->n; i++)
+	{
+		if (count[i] > 0 && (g->adj[i].a = malloc(sizeof(unsigned int)*count[i])) == NULL)
+		{
+			perror("Error allocating memory");
+			free(count);
+			return 1;
+		}
+		g->adj[i].cap = count[i];
+	}
+	free(count);
+
+	for (i=0; i < g->n; i++)
+	{
+		for (p=A->ptr[i]; p < A->ptr[i+1]; p++)
+		{
+			if ((j = A->index[p]) != i)
+			{
+				g->adj[i].a[g->adj[i].len++] = j;
+				g->adj[j].a[g->adj[j].len++] = i;
+			}
+		}
+	}
+
+	// a_ij and a_ji both give the edge, keep it once
+	for (i=0; i < g->n; i++)
+	{
+		len = 0;
+		for (q=0; q < g->adj[i].len; q++)
+		{
+			j = g->adj[i].a[q];
+			if (g->mark[j] != i+1)
+			{
+				g->mark[j] = i+1;
+				g->adj[i].a[len++] = j;
+			}
+		}
+		g->adj[i].len = len;
+	}
+	memset(g->mark, 0, sizeof(*g->mark)*g->n);
+	return 0;
+}
+
+// put i on the list of degree d
+static void degree_insert(struct amd_graph *g, unsigned int i, unsigned int d)
+{
+	g->degree[i] = d;
+	g->prev[i] = SPARSE_NONE;
+	g->next[i] = g->head[d];
+	if (g->head[d] != SPARSE_NONE)
+	{
+		g->prev[g->head[d]] = i;
+	}
+	g->head[d] = i;
+	if (d < g->mindeg)
+	{
+		g->mindeg = d;
+	}
+}
+
+// take i off its degree list
+static void degree_remove(struct amd_graph *g, unsigned int i)
+{
+	if (g->prev[i] != SPARSE_NONE)
+	{
+		g->next[g->prev[i]] = g->next[i];
+	}
+	else
+	{
+		g->head[g->degree[i]] = g->next[i];
+	}
+	if (g->next[i] != SPARSE_NONE)
+	{
+		g->prev[g->next[i]] = g->prev[i];
+	}
+}
+
+// p becomes an element whose variables are its neighbours and those of
+// the elements next to it, which it absorbs, the degrees of its variables
+// are then bounded by the approximate degree of Amestoy, Davis and Duff,
+// An approximate minimum degree ordering algorithm
+static int amd_eliminate(struct amd_graph *g, unsigned int p, unsigned int k)
+{
+	struct amd_list lp = { NULL, 0, 0 };
+	struct amd_list *l;
+	unsigned int i,j,e,q,r,len,tag=k+1;
+	unsigned long d;
+
+	// the variables of the new element
+	g->mark[p] = tag;
+	g->status[p] = AMD_ELEMENT;
+	l = &g->adj[p];
+	for (q=0; q < l->len; q++)
+	{
+		j = l->a[q];
+		if (g->status[j] == AMD_VARIABLE)
+		{
+			if (g->mark[j] != tag)
+			{
+				g->mark[j] = tag;
+				if (amd_push(&lp, j) != 0)
+				{
+					free(lp.a);
+					return 1;
+				}
+			}
+			continue;
+		}
+		if (g->status[j] != AMD_ELEMENT || j == p)
+		{
+			continue;
+		}
+		for (r=0; r < g->adj[j].len; r++)
+		{
+			i = g->adj[j].a[r];
+			if (g->status[i] == AMD_VARIABLE && g->mark[i] != tag)
+			{
+				g->mark[i] = tag;
+				if (amd_push(&lp, i) != 0)
+				{
+					free(lp.a);
+					return 1;
+				}
+			}
+		}
+		g->status[j] = AMD_ABSORBED;
+		free(g->adj[j].a);
+		memset(&g->adj[j], 0, sizeof(g->adj[j]));
+	}
+	free(l->a);
+	*l = lp;
+
+	// w[e] = |L_e \ L_p| for the other elements next to L_p,
+	// each variable of L_p in L_e takes one off |L_e|
+	for (q=0; q < lp.len; q++)
+	{
+		i = lp.a[q];
+		for (r=0; r < g->adj[i].len; r++)
+		{
+			e = g->adj[i].a[r];
+			if (g->status[e] != AMD_ELEMENT || e == p)
+			{
+				continue;
+			}
+			if (g->wstep[e] != tag)
+			{
+				// drop the variables eliminated since e was made
+				len = 0;
+				for (j=0; j < g->adj[e].len; j++)
+				{
+					if (g->status[g->adj[e].a[j]] == AMD_VARIABLE)
+					{
+						g->adj[e].a[len++] = g->adj[e].a[j];
+					}
+				}
+				g->adj[e].len = len;
+				g->wstep[e] = tag;
+				g->w[e] = len;
+			}
+			if (g->w[e] > 0)
+			{
+				g->w[e]--;
+			}
+		}
+	}
+
+	// the variables of L_p lose the neighbours p now stands for
+	for (q=0; q < lp.len; q++)
+	{
+		i = lp.a[q];
+		l = &g->adj[i];
+		degree_remove(g, i);
+		d = lp.len - 1;
+		len = 0;
+		for (r=0; r < l->len; r++)
+		{
+			j = l->a[r];
+			if (j == p)
+			{
+				continue;
+			}
+			if (g->status[j] == AMD_VARIABLE)
+			{
+				if (g->mark[j] == tag)
+				{
+					continue;
+				}
+				d++;
+			}
+			else if (g->status[j] == AMD_ELEMENT)
+			{
+				// an element inside L_p is absorbed by it
+				if (g->w[j] == 0)
+				{
+					g->status[j] = AMD_ABSORBED;
+					free(g->adj[j].a);
+					memset(&g->adj[j], 0, sizeof(g->adj[j]));
+					continue;
+				}
+				d += g->w[j];
+			}
+			else
+			{
+				continue;
+			}
+			l->a[len++] = j;
+		}
+		l->len = len;
+		if (amd_push(l, p) != 0)
+		{
+			return 1;
+		}
+		degree_insert(g, i, (d < g->n-k-1) ? d : g->n-k-1);
+	}
+	return 0;
+}
+
+static void amd_free(struct amd_graph *g)
+{
+	unsigned int i;
+
+	if (g->adj != NULL)
+	{
+		for (i=0; i < g->n; i++)
+		{
+			free(g->adj[i].a);
+		}
+	}
+	free(g->adj);
+	free(g->status);
+	free(g->degree);
+	free(g->head);
+	free(g->next);
+	free(g->prev);
+	free(g->mark);
+	free(g->wstep);
+	free(g->w);
+}
+
+// repeatedly eliminate a variable of least approximate degree
+int sparse_amd(sparse A, unsigned int *order)
+{
+	struct amd_graph g;
+	unsigned int i,k,p,n=A->n;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Matrix is not square\n");
+		return 1;
+	}
+
+	memset(&g, 0, sizeof(g));
+	g.n = n;
+	g.adj = calloc(n, sizeof(*g.adj));
+	g.status = calloc(n, sizeof(*g.status));
+	g.degree = malloc(sizeof(*g.degree)*n);
+	g.head = malloc(sizeof(*g.head)*(n+1));
+	g.next = malloc(sizeof(*g.next)*n);
+	g.prev = malloc(sizeof(*g.prev)*n);
+	g.mark = calloc(n, sizeof(*g.mark));
+	g.wstep = calloc(n, sizeof(*g.wstep));
+	g.w = calloc(n, sizeof(*g.w));
+	if (g.adj == NULL || g.status == NULL || g.degree == NULL || g.head == NULL
+			|| g.next == NULL || g.prev == NULL || g.mark == NULL
+			|| g.wstep == NULL || g.w == NULL)
+	{
+		perror("Error allocating memory");
+		amd_free(&g);
+		return 1;
+	}
+	if (amd_build(&g, A) != 0)
+	{
+		amd_free(&g);
+		return 1;
+	}
+
+	for (i=0; i <= n; i++)
+	{
+		g.head[i] = SPARSE_NONE;
+	}
+	g.mindeg = n;
+	for (i=0; i < n; i++)
+	{
+		degree_insert(&g, i, g.adj[i].len);
+	}
+
+	for (k=0; k < n; k++)
+	{
+		while (g.head[g.mindeg] == SPARSE_NONE)
+		{
+			g.mindeg++;
+		}
+		p = g.head[g.mindeg];
+		degree_remove(&g, p);
+		order[k] = p;
+		if (amd_eliminate(&g, p, k) != 0)
+		{
+			amd_free(&g);
+			return 1;
+		}
+	}
+
+	amd_free(&g);
+	return 0;
+}
+
+// make room for need more entries after the nnz in use
+static int grow(sparse S, unsigned int *cap, unsigned int need)
+{
+	unsigned int *index;
+	float *value;
+	size_t size;
+
+	if (S->nnz + need <= *cap)
+	{
+		return 0;
+	}
+	size = 2*(size_t)*cap + need;
+	if (size > UINT_MAX)
+	{
+		size = UINT_MAX;
+	}
+	if (size < (size_t)S->nnz + need)
+	{
+		fprintf(stderr,"Error: the factors have too many entries\n");
+		return 1;
+	}
+	if ((index = realloc(S->index, sizeof(*index)*size)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	S->index = index;
+	if ((value = realloc(S->value, sizeof(*value)*size)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	S->value = value;
+	*cap = size;
+	return 0;
+}
+
+// a depth first search from the entries of column col through the
+// columns of L, rows not yet pivoted have no column and end a path
+// the rows are left in xi[top] ... xi[n-1], xi[n] ... is the stack
+static unsigned int reach(struct sparse_factors *f, sparse C, unsigned int col,
+		unsigned int *xi, unsigned int *mark, unsigned int tag)
+{
+	sparse L = f->L;
+	unsigned int *pstack = xi + f->n;
+	unsigned int n=f->n;
+	unsigned int top=n;
+	unsigned int p,q,i,j,J,end;
+	int head,done;
+
+	for (p=C->ptr[col]; p < C->ptr[col+1]; p++)
+	{
+		if (mark[C->index[p]] == tag)
+		{
+			continue;
+		}
+
+		// the stack grows up from xi[0] while the output grows down
+		// from xi[n-1], together they never hold more than n rows
+		head = 0;
+		xi[0] = C->index[p];
+		while (head >= 0)
+		{
+			j = xi[head];
+			J = f->pinv[j];
+			if (mark[j] != tag)
+			{
+				mark[j] = tag;
+				pstack[head] = (J == SPARSE_NONE) ? 0 : L->ptr[J] + 1;
+			}
+			done = 1;
+			end = (J == SPARSE_NONE) ? 0 : L->ptr[J+1];
+			for (q=pstack[head]; q < end; q++)
+			{
+				i = L->index[q];
+				if (mark[i] == tag)
+				{
+					continue;
+				}
+				pstack[head] = q + 1;
+				xi[++head] = i;
+				done = 0;
+				break;
+			}
+			if (done)
+			{
+				head--;
+				xi[--top] = j;
+			}
+		}
+	}
+	return top;
+}
+
+// Gilbert and Peierls' left looking LU, each column is a sparse
+// triangular solve with the columns of L found so far, then the
+// pivot is chosen from the rows it leaves, as in Davis' cs_lu
+static int factor(struct sparse_factors *f, sparse C, unsigned int cap)
+{
+	sparse L = f->L;
+	sparse U = f->U;
+	unsigned int n=f->n;
+	unsigned int lcap=cap,ucap=cap;
+	unsigned int *xi,*mark;
+	unsigned int i,j,J,k,p,px,top,col,ipiv;
+	float *x,a,t,pivot;
+
+	x = calloc(n, sizeof(*x));
+	xi = malloc(sizeof(*xi)*2*n);
+	mark = calloc(n, sizeof(*mark));
+	if (x == NULL || xi == NULL || mark == NULL)
+	{
+		perror("Error allocating memory");
+		free(x);
+		free(xi);
+		free(mark);
+		return 1;
+	}
+	L->nnz = U->nnz = 0;
+	for (i=0; i < n; i++)
+	{
+		f->pinv[i] = SPARSE_NONE;
+	}
+
+	for (k=0; k < n; k++)
+	{
+		L->ptr[k] = L->nnz;
+		U->ptr[k] = U->nnz;
+		if (grow(L, &lcap, n-k) != 0 || grow(U, &ucap, k+1) != 0)
+		{
+			break;
+		}
+
+		// x = L \ A(:,col) over the rows the solve can reach
+		col = f->q[k];
+		top = reach(f, C, col, xi, mark, k+1);
+		for (px=top; px < n; px++)
+		{
+			x[xi[px]] = 0.;
+		}
+		for (p=C->ptr[col]; p < C->ptr[col+1]; p++)
+		{
+			x[C->index[p]] = C->value[p];
+		}
+		for (px=top; px < n; px++)
+		{
+			j = xi[px];
+			if ((J = f->pinv[j]) == SPARSE_NONE)
+			{
+				continue;
+			}
+			for (p=L->ptr[J]+1; p < L->ptr[J+1]; p++)
+			{
+				x[L->index[p]] -= L->value[p]*x[j];
+			}
+		}
+
+		// pivoted rows go to U, the largest of the rest is the pivot
+		ipiv = SPARSE_NONE;
+		a = -1.;
+		for (px=top; px < n; px++)
+		{
+			i = xi[px];
+			if (f->pinv[i] == SPARSE_NONE)
+			{
+				if ((t = fabsf(x[i])) > a)
+				{
+					a = t;
+					ipiv = i;
+				}
+			}
+			else
+			{
+				U->index[U->nnz] = f->pinv[i];
+				U->value[U->nnz++] = x[i];
+			}
+		}
+		if (ipiv == SPARSE_NONE || !(a > 0.) || !isfinite(a))
+		{
+			break;
+		}
+		// unless it is much smaller, the diagonal keeps the fill the
+		// ordering planned for
+		if (f->pinv[col] == SPARSE_NONE && fabsf(x[col]) >= SPARSE_PIVOT_TOL*a)
+		{
+			ipiv = col;
+		}
+
+		pivot = x[ipiv];
+		U->index[U->nnz] = k;
+		U->value[U->nnz++] = pivot;
+		f->pinv[ipiv] = k;
+		L->index[L->nnz] = ipiv;
+		L->value[L->nnz++] = 1.;
+		for (px=top; px < n; px++)
+		{
+			i = xi[px];
+			if (f->pinv[i] == SPARSE_NONE)
+			{
+				L->index[L->nnz] = i;
+				L->value[L->nnz++] = x[i]/pivot;
+			}
+		}
+	}
+
+	free(x);
+	free(xi);
+	free(mark);
+	if (k < n)
+	{
+		return 1;
+	}
+
+	// the rows of L become pivot order
+	L->ptr[n] = L->nnz;
+	U->ptr[n] = U->nnz;
+	for (p=0; p < L->nnz; p++)
+	{
+		L->index[p] = f->pinv[L->index[p]];
+	}
+	return 0;
+}
+
+// order the columns, factor and wrap the factors in a handle
+lu_handle sparse_lu_factor(sparse A, int ordering)
+{
+	struct sparse_factors *f;
+	lu_handle h;
+	sparse C;
+	unsigned int k,n=A->n;
+	int status;
+
+	if (A->n != A->m)
+	{
+		fprintf(stderr,"Matrix is not square\n");
+		return NULL;
+	}
+	if ((f = calloc(1, sizeof(*f))) == NULL)
+	{
+		perror("Error allocating memory");
+		return NULL;
+	}
+	f->A = A;
+	f->n = n;
+	f->pinv = malloc(sizeof(*f->pinv)*n);
+	f->q = malloc(sizeof(*f->q)*n);
+	if (f->pinv == NULL || f->q == NULL)
+	{
+		perror("Error allocating memory");
+		sparse_factors_free(f);
+		return NULL;
+	}
+	// a guess at the fill, the factors grow as needed
+	if ((f->L = sparse_allocate(n, n, 2*A->nnz + n, SPARSE_CSC)) == NULL
+			|| (f->U = sparse_allocate(n, n, 2*A->nnz + n, SPARSE_CSC)) == NULL)
+	{
+		sparse_factors_free(f);
+		return NULL;
+	}
+
+	if (ordering == SPARSE_ORDER_AMD)
+	{
+		if (sparse_amd(A, f->q) != 0)
+		{
+			sparse_factors_free(f);
+			return NULL;
+		}
+	}
+	else
+	{
+		for (k=0; k < n; k++)
+		{
+			f->q[k] = k;
+		}
+	}
+
+	// the columns of A are walked one at a time
+	C = (A->format == SPARSE_CSC) ? A : sparse_convert(A, SPARSE_CSC);
+	if (C == NULL)
+	{
+		sparse_factors_free(f);
+		return NULL;
+	}
+	status = factor(f, C, 2*A->nnz + n);
+	if (C != A)
+	{
+		free_sparse(C);
+	}
+	if (status != 0)
+	{
+		fprintf(stderr,"No unique solution\n");
+		sparse_factors_free(f);
+		return NULL;
+	}
+
+	if ((h = calloc(1, sizeof(*h))) == NULL)
+	{
+		perror("Error allocating memory");
+		sparse_factors_free(f);
+		return NULL;
+	}
+	h->pivoting = LU_PARTIAL_PIVOTING;
+	h->refs = 1;
+	h->fs.alpha = 1.;
+	h->sparse = f;
+	return h;
+}
+
+// entries of L and U
+size_t sparse_lu_nnz(lu_handle h)
+{
+	if (h->sparse == NULL)
+	{
+		return 0;
+	}
+	return (size_t)h->sparse->L->nnz + h->sparse->U->nnz;
+}
+
+// x = Q U^-1 L^-1 P b
+int sparse_factors_solve(struct sparse_factors *f, const float *b, float *x)
+{
+	sparse L = f->L;
+	sparse U = f->U;
+	unsigned int n=f->n;
+	unsigned int i,j,p;
+	float *w;
+
+	if ((w = malloc(sizeof(*w)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	for (i=0; i < n; i++)
+	{
+		w[f->pinv[i]] = b[i];
+	}
+	for (j=0; j < n; j++)
+	{
+		for (p=L->ptr[j]+1; p < L->ptr[j+1]; p++)
+		{
+			w[L->index[p]] -= L->value[p]*w[j];
+		}
+	}
+	for (j=n; j >= 1; j--)
+	{
+		w[j-1] /= U->value[U->ptr[j]-1];
+		for (p=U->ptr[j-1]; p < U->ptr[j]-1; p++)
+		{
+			w[U->index[p]] -= U->value[p]*w[j-1];
+		}
+	}
+	for (i=0; i < n; i++)
+	{
+		x[f->q[i]] = w[i];
+	}
+	free(w);
+	return 0;
+}
+
+// z = P^T L^-T U^-T Q^T z, the transposed factors are read
+// down their columns so each step is a gathered dot product
+int sparse_factors_solve_transposed(struct sparse_factors *f, float *z)
+{
+	sparse L = f->L;
+	sparse U = f->U;
+	unsigned int n=f->n;
+	unsigned int i,j,p,d;
+	float *w;
+
+	if ((w = malloc(sizeof(*w)*n)) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	for (j=0; j < n; j++)
+	{
+		w[j] = z[f->q[j]];
+	}
+	for (j=0; j < n; j++)
+	{
+		d = U->ptr[j+1]-1;
+		w[j] = (w[j] - mathlib_kernels->gather_dot(d - U->ptr[j], U->value + U->ptr[j],
+					U->index + U->ptr[j], w))/U->value[d];
+	}
+	for (j=n; j >= 1; j--)
+	{
+		p = L->ptr[j-1]+1;
+		w[j-1] -= mathlib_kernels->gather_dot(L->ptr[j] - p, L->value + p,
+				L->index + p, w);
+	}
+	for (i=0; i < n; i++)
+	{
+		z[i] = w[f->pinv[i]];
+	}
+	free(w);
+	return 0;
+}
+
+// log|det A| from the diagonal of U, the last entry of each column
+double sparse_factors_logdet(struct sparse_factors *f, int *sign)
+{
+	sparse U = f->U;
+	double logdet=0.;
+	unsigned int k;
+	int s;
+	float u;
+
+	s = permutation_sign(f->n, f->pinv)*permutation_sign(f->n, f->q);
+	for (k=0; s != 0 && k < f->n; k++)
+	{
+		u = U->value[U->ptr[k+1]-1];
+		if (u < 0.)
+		{
+			s = -s;
+		}
+		logdet += log(fabsf(u));
+	}
+	if (sign != NULL)
+	{
+		*sign = s;
+	}
+	return (s == 0) ? NAN : logdet;
+}
+
+// the system the factors came from
+sparse sparse_factors_system(struct sparse_factors *f)
+{
+	return f->A;
+}
+
+// memory held by the factors
+size_t sparse_factors_bytes(struct sparse_factors *f)
+{
+	return sizeof(*f) + sparse_bytes(f->L) + sparse_bytes(f->U)
+		+ 2*sizeof(*f->pinv)*(size_t)f->n;
+}
+
+void sparse_factors_free(struct sparse_factors *f)
+{
+	if (f == NULL)
+	{
+		return;
+	}
+	free_sparse(f->L);
+	free_sparse(f->U);
+	free(f->pinv);
+	free(f->q);
+	free(f);
+}
@@ -0,0 +1,48 @@
+/* Sparse LU factorization
+ * Oct 18 2026 */
+
+#ifndef SPARSE_LU_H
+#define SPARSE_LU_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sparse.h"
+#include "linear_system.h"
+
+// column orderings for sparse_lu_factor
+#define SPARSE_ORDER_NATURAL 0 // as the columns are given
+#define SPARSE_ORDER_AMD 1 // approximate minimum degree of A+A^T
+
+// the diagonal of the ordered matrix is kept as the pivot while it is
+// at least this fraction of the largest candidate in its column
+#define SPARSE_PIVOT_TOL 0.1
+
+// the factors PAQ=LU behind a sparse lu_handle
+struct sparse_factors;
+
+// a fill reducing symmetric ordering of a square matrix, order[k] is the
+// k-th row and column to eliminate, returns 0 on success
+extern int sparse_amd(sparse A, unsigned int *order);
+// factor a square matrix into a handle for lu_handle_solve(),
+// lu_solve_many(), lu_handle_refine() and lu_handle_rcond()
+// A must stay unchanged while the handle is in use, NULL on failure
+extern lu_handle sparse_lu_factor(sparse A, int ordering);
+// the fill of a sparse factorization, entries of L and U
+extern size_t sparse_lu_nnz(lu_handle h);
+
+// used by the lu_handle routines
+// x = A^-1 b, x may be b, returns 0 on success
+extern int sparse_factors_solve(struct sparse_factors *f, const float *b,
+		float *x);
+// z = A^-T z, returns 0 on success
+extern int sparse_factors_solve_transposed(struct sparse_factors *f, float *z);
+// log|det A| and its sign as for lu_handle_logdet()
+extern double sparse_factors_logdet(struct sparse_factors *f, int *sign);
+extern sparse sparse_factors_system(struct sparse_factors *f);
+extern size_t sparse_factors_bytes(struct sparse_factors *f);
+extern void sparse_factors_free(struct sparse_factors *f);
+
+#endif
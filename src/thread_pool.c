@@ -0,0 +1,257 @@
+/* Persistent worker threads
+ * Oct 18 2026 */
+
+#include "thread_pool.h"
+
+// held by the thread running a parallel loop, or resizing the pool
+static pthread_mutex_t pool_owner = PTHREAD_MUTEX_INITIALIZER;
+// protects everything below
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+
+static pthread_t *workers;
+static unsigned int n_workers; // worker threads currently running
+// pool size including the caller, 0 until decided, read atomically
+// so asking for it never waits for a running loop
+static unsigned int n_threads;
+static unsigned long generation; // incremented for every parallel loop
+static unsigned int busy; // workers that haven't finished the current loop
+static int stopping; // tells the workers to exit
+
+// the current parallel loop
+static pool_task job_task;
+static void *job_arg;
+static unsigned int job_n;
+static unsigned int job_next; // next task index, taken atomically
+
+// set on threads that are executing tasks
+static __thread int in_pool;
+
+void parallel_for(unsigned int n_tasks, pool_task task, void *arg);
+void mathlib_set_threads(unsigned int n);
+unsigned int mathlib_get_threads(void);
+
+static unsigned int default_threads(void);
+static unsigned int pool_size(void);
+static void run_tasks(void);
+static void * worker_main(void *arg);
+static void start_workers(void);
+static void stop_workers(void);
+static void pool_destructor(void) __attribute__((destructor));
+
+// MATHLIB_NUM_THREADS if set, otherwise one thread per online cpu
+static unsigned int default_threads(void)
+{
+	const char *env;
+	long n;
+
+	if ((env = getenv("MATHLIB_NUM_THREADS")) != NULL && atoi(env) > 0)
+	{
+		return (unsigned int)atoi(env);
+	}
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (unsigned int)n : 1;
+}
+
+// n_threads, decided the first time anybody asks
+static unsigned int pool_size(void)
+{
+	unsigned int n,unset=0;
+
+	if ((n = __atomic_load_n(&n_threads, __ATOMIC_RELAXED)) == 0)
+	{
+		n = default_threads();
+		// somebody else may have decided first
+		if (!__atomic_compare_exchange_n(&n_threads, &unset, n, 0,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			n = unset;
+		}
+	}
+	return n;
+}
+
+// take tasks of the current loop until there are none left
+static void run_tasks(void)
+{
+	unsigned int i;
+
+	while ((i = __atomic_fetch_add(&job_next, 1, __ATOMIC_RELAXED)) < job_n)
+	{
+		(*job_task)(job_arg, i);
+	}
+}
+
+// workers sleep until the generation changes, then help with the loop
+// arg is the generation current when the worker was started
+static void * worker_main(void *arg)
+{
+	unsigned long seen = (unsigned long)arg;
+
+	in_pool = 1;
+
+	pthread_mutex_lock(&pool_lock);
+	for (;;)
+	{
+		while (generation == seen && !stopping)
+		{
+			pthread_cond_wait(&pool_wake, &pool_lock);
+		}
+		if (stopping)
+		{
+			break;
+		}
+		seen = generation;
+		pthread_mutex_unlock(&pool_lock);
+
+		run_tasks();
+
+		pthread_mutex_lock(&pool_lock);
+		if (--busy == 0)
+		{
+			pthread_cond_signal(&pool_done);
+		}
+	}
+	pthread_mutex_unlock(&pool_lock);
+
+	return NULL;
+}
+
+// start n_threads-1 workers, called with pool_owner held
+static void start_workers(void)
+{
+	unsigned int i,n=pool_size();
+
+	if ((workers = malloc(sizeof(*workers)*(n-1))) == NULL)
+	{
+		perror("Error allocating memory");
+		return;
+	}
+
+	for (i = 0; i < n-1; i++)
+	{
+		if (pthread_create(&workers[i], NULL, &worker_main,
+					(void *)generation) != 0)
+		{
+			// keep going with the workers we have
+			perror("Error starting worker thread");
+			break;
+		}
+	}
+	n_workers = i;
+}
+
+// join all workers, called with pool_owner held
+static void stop_workers(void)
+{
+	unsigned int i;
+
+	if (n_workers == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool_lock);
+	stopping = 1;
+	pthread_cond_broadcast(&pool_wake);
+	pthread_mutex_unlock(&pool_lock);
+
+	for (i = 0; i < n_workers; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+	workers = NULL;
+	n_workers = 0;
+	stopping = 0;
+}
+
+// don't leave threads behind when the library is unloaded
+static void pool_destructor(void)
+{
+	if (pthread_mutex_trylock(&pool_owner) == 0)
+	{
+		stop_workers();
+		pthread_mutex_unlock(&pool_owner);
+	}
+}
+
+// run task(arg, i) for 0 <= i < n_tasks
+void parallel_for(unsigned int n_tasks, pool_task task, void *arg)
+{
+	unsigned int i;
+
+	// nested loops and loops issued while another thread
+	// owns the pool run serially on this thread
+	if (n_tasks < 2 || in_pool || pthread_mutex_trylock(&pool_owner) != 0)
+	{
+		for (i = 0; i < n_tasks; i++)
+		{
+			(*task)(arg, i);
+		}
+		return;
+	}
+
+	// the pool is created the first time it can be used
+	if (n_workers == 0 && pool_size() > 1)
+	{
+		start_workers();
+	}
+	if (n_workers == 0)
+	{
+		pthread_mutex_unlock(&pool_owner);
+		for (i = 0; i < n_tasks; i++)
+		{
+			(*task)(arg, i);
+		}
+		return;
+	}
+
+	// publish the loop and wake everybody up
+	pthread_mutex_lock(&pool_lock);
+	job_task = task;
+	job_arg = arg;
+	job_n = n_tasks;
+	job_next = 0;
+	busy = n_workers;
+	generation++;
+	pthread_cond_broadcast(&pool_wake);
+	pthread_mutex_unlock(&pool_lock);
+
+	in_pool = 1;
+	run_tasks();
+	in_pool = 0;
+
+	// wait for the workers still running a task
+	pthread_mutex_lock(&pool_lock);
+	while (busy > 0)
+	{
+		pthread_cond_wait(&pool_done, &pool_lock);
+	}
+	pthread_mutex_unlock(&pool_lock);
+
+	pthread_mutex_unlock(&pool_owner);
+}
+
+// resize the pool, n == 0 restores the default
+// the new workers are started by the next parallel loop
+void mathlib_set_threads(unsigned int n)
+{
+	pthread_mutex_lock(&pool_owner);
+	stop_workers();
+	__atomic_store_n(&n_threads, (n > 0) ? n : default_threads(),
+			__ATOMIC_RELAXED);
+	pthread_mutex_unlock(&pool_owner);
+}
+
+// number of threads parallel loops will use, never waits for the pool
+unsigned int mathlib_get_threads(void)
+{
+	// loops issued from inside a task run serially
+	if (in_pool)
+	{
+		return 1;
+	}
+	return pool_size();
+}
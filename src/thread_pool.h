@@ -0,0 +1,27 @@
+/* Persistent worker threads
+ * Oct 18 2026 */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// one unit of work of a parallel loop, i is the task index
+typedef void (*pool_task)(void *arg, unsigned int i);
+
+// run task(arg, i) for 0 <= i < n_tasks on the library's worker threads
+// and return once every task is done, the calling thread works too
+// a parallel_for issued from inside a task, or while another thread
+// owns the pool, simply runs its tasks on the calling thread
+extern void parallel_for(unsigned int n_tasks, pool_task task, void *arg);
+
+// number of threads parallel_for uses, including the caller, 1 inside a task
+// defaults to MATHLIB_NUM_THREADS or else the number of online cpus
+// the workers are started the first time they are needed
+extern void mathlib_set_threads(unsigned int n);
+extern unsigned int mathlib_get_threads(void);
+
+#endif
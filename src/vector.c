@@ -3,12 +3,14 @@
  * Nov 7 2010 */
 
 #include "vector.h"
+#include "datafile.h"
 
 // prototypes for vector functions
 float* vector_allocate(int n);
 void print_vector(vector vec);
 int save_vector(vector vec, const char *filename);
 vector load_vector(const char *filename);
+vector map_vector(const char *filename);
 vector mult_vector(vector a, vector b);
 vector zero_vector(int n);
 vector new_vector(float (*element_function)(int, int),
@@ -16,6 +18,18 @@ vector new_vector(float (*element_function)(int, int),
 void component_swap(vector vec, int i, int j);
 void free_vector(vector vec);
 
+// load the format written before the datafile header
+static vector load_vector_legacy(FILE *infile, const char *filename);
+
+// the header of an old vector file is the vector struct as
+// it was laid out before the flags were added
+struct vector_file_header
+{
+	unsigned int n;
+	unsigned int offset;
+	float *a;
+};
+
 // allocate space for an n dimensional vector
 float* vector_allocate(int n)
 {
@@ -45,10 +59,10 @@ void print_vector(vector vec)
 }
 
 // Write a vector to hard disk
+// as a single column so the file can be mapped with map_vector()
 int save_vector(vector vec, const char *filename)
 {
 	FILE *outfile;
-	unsigned int i,b;
 
 	// attempt to open file for writing
 	if ((outfile = fopen(filename, "w")) == NULL)
@@ -57,82 +71,125 @@ int save_vector(vector vec, const char *filename)
 		return 1;
 	}
 
-	// fwrite() may not be portable, but its fast and convenient
-	// Not a problem as long as these files are opened
-	// on the same architecture that created them
-	b = sizeof(*vec)*fwrite(vec,sizeof(*vec),1,outfile);
-	for (i = 0; i < vec->n; i++)
+	if (datafile_write_header(outfile, DATAFILE_FLOAT32, vec->n, 1, 1) != 0)
 	{
-		b += sizeof(*vec->a) * fwrite(&vec->a[i], sizeof(*vec->a), 1, outfile);
+		fclose(outfile);
+		return 1;
 	}
 
-	// Insert an EOF	
-	fputc(-1,outfile);
-	
-	// check to make sure all bytes were written
+	// check to make sure all elements were written
 	// if not, errno should be set
-	if (b != (sizeof(*vec) + (sizeof(*vec->a) * vec->n)))
+	if (fwrite(vec->a, sizeof(*vec->a), vec->n, outfile) != vec->n)
 	{
 		perror("Error writing file");
+		fclose(outfile);
 		return 1;
 	}
 
-	fclose(outfile);
-	//printf("Wrote %d bytes to %s\n",b,filename);
+	if (fclose(outfile) != 0)
+	{
+		perror("Error writing file");
+		return 1;
+	}
 	return 0;
 }
 
 // Load a vector from a file
+// files written before the current format are still understood
 vector load_vector(const char *filename)
 {
-	vector vec,vec_info;
+	vector vec;
 	FILE *infile;
-	unsigned int i,b;
-	struct stat if_stat;
-
-	b = 0;
+	struct datafile_header header;
+	int status,swapped;
 
 	// attempt to open file for reading
-	if ((infile = fopen(filename, "r+")) == NULL)
+	if ((infile = fopen(filename, "r")) == NULL)
 	{
 		perror("Error opening file");
 		return NULL;
 	}
-	
-	// Read in the dimensions of the old vector first
-	// and then allocate space for where the rest of it goes
-	if ((vec_info = calloc(1, sizeof(*vec_info))) == NULL)
+
+	if ((status = datafile_read_header(infile, filename, &header, &swapped)) != 0)
 	{
+		if (status < 0)
+		{
+			return load_vector_legacy(infile, filename);
+		}
+		fclose(infile);
+		return NULL;
+	}
+	if (header.cols != 1 || header.ld != 1)
+	{
+		fprintf(stderr,"Error: %s is not a vector\n",filename);
+		fclose(infile);
+		return NULL;
+	}
+
+	// This is where our vector will go
+	if ((vec = zero_vector(header.rows)) == NULL)
+	{
+		fclose(infile);
 		return NULL;
 	}
-	b = sizeof(*vec_info)*fread(vec_info,sizeof(*vec_info),1,infile);
+
+	// check the number of elements read against the number we expect
+	if (fseek(infile, header.offset, SEEK_SET) != 0
+			|| fread(vec->a, sizeof(*vec->a), vec->n, infile) != vec->n)
+	{
+		perror("Error reading file");
+		fclose(infile);
+		free_vector(vec);
+		return NULL;
+	}
+	fclose(infile);
+
+	// the file came from a machine of the other byte order
+	if (swapped)
+	{
+		datafile_swap32(vec->a, vec->n);
+	}
+
+	return vec;
+}
+
+// Load a vector in the format written before the datafile header
+static vector load_vector_legacy(FILE *infile, const char *filename)
+{
+	vector vec;
+	struct vector_file_header vec_info;
+	unsigned int i,b;
+	struct stat if_stat;
+
+	// Read in the dimensions of the old vector first
+	// and then allocate space for where the rest of it goes
+	b = sizeof(vec_info)*fread(&vec_info,sizeof(vec_info),1,infile);
 
 	// at this point, we should check to make sure the dimensions specified
-	// in the file vecch the size of the rest of the file. If not, it's very
+	// in the file match the size of the rest of the file. If not, it's very
 	// likely that someone has modified them with intent to corrupt the heap
 	stat(filename,&if_stat);
-	if ((if_stat.st_size - sizeof(*vec_info)-1) !=
-			(sizeof(*vec_info->a)*vec_info->n))
+	if (b != sizeof(vec_info) || (if_stat.st_size - sizeof(vec_info)-1) !=
+			(sizeof(*vec->a)*vec_info.n))
 	{
 		// If we don't catch this here and dimensions are wrong, fread()
 		// will experience errors later trying to read parts of the file
 		// that don't exist
 		fprintf(stderr,"Error: Vector file has inconsistent dimensions\n");
+		fclose(infile);
 		return NULL;
 	}
 
 	// This is where our vector will go
-	if ((vec = zero_vector(vec_info->n)) == NULL)
+	if ((vec = zero_vector(vec_info.n)) == NULL)
 	{
+		fclose(infile);
 		return NULL;
 	}
 
 	// Set offsets
-	vec->offset = vec_info->offset;
+	vec->offset = vec_info.offset;
 
-	// free our temporary vector
-	free(vec_info);
-	
 	// Read in each value of the vector
 	for (i = 0; i < vec->n; i++)
 	{
@@ -140,9 +197,10 @@ vector load_vector(const char *filename)
 	}
 	
 	// check the number of bytes read against the number we expect
-	if (b != (sizeof(*vec)+(sizeof(*vec->a)*vec->n)))
+	if (b != (sizeof(vec_info)+(sizeof(*vec->a)*vec->n)))
 	{
 		perror("Error reading file");
+		fclose(infile);
 		free_vector(vec);
 		return NULL;
 	}
@@ -152,6 +210,39 @@ vector load_vector(const char *filename)
 	return vec;
 }
 
+// Map a vector file into memory without reading it
+// the vector is read only, free_vector() unmaps it
+vector map_vector(const char *filename)
+{
+	vector vec;
+	struct datafile_header header;
+	float *a;
+
+	if ((a = datafile_map(filename, &header)) == NULL)
+	{
+		return NULL;
+	}
+	if (header.cols != 1 || header.ld != 1)
+	{
+		fprintf(stderr,"Error: %s is not a vector\n",filename);
+		datafile_unmap(a, header.bytes);
+		return NULL;
+	}
+
+	if ((vec = malloc(sizeof(*vec))) == NULL)
+	{
+		perror("Error allocating memory");
+		datafile_unmap(a, header.bytes);
+		return NULL;
+	}
+	vec->n = header.rows;
+	vec->offset = 1;
+	vec->a = a;
+	vec->flags = VECTOR_MAPPED;
+
+	return vec;
+}
+
 // Set up a vector structure
 vector zero_vector(int n)
 {
@@ -165,6 +256,7 @@ vector zero_vector(int n)
 
 	// Set offsets
 	vec->offset = 1;
+	vec->flags = 0;
 
 	// Make sure dimensions are >=1
 	if (n < 1)
@@ -231,7 +323,11 @@ void free_vector(vector vec)
 {
 	if(vec != NULL)
 	{
-		if (vec->a != NULL)
+		if (vec->flags & VECTOR_MAPPED)
+		{
+			datafile_unmap(vec->a, sizeof(*vec->a)*vec->n);
+		}
+		else if (vec->a != NULL)
 		{
 			free(vec->a);
 			vec->a = NULL;
@@ -16,13 +16,20 @@ typedef struct
 	unsigned int n; // number of rows (height) of matrix
 	unsigned int offset; // coordinates of sub vector 1 <= offset <= n
 	float *a;
+	unsigned int flags;
 } *vector;
 
+// vector flags
+#define VECTOR_MAPPED 1 // a is a read only mapping of a file
+
 // prototypes for vector functions
 extern float * vector_allocate(int n);
 extern void print_vector(vector vec);
 extern int save_vector(vector vec, const char *filename);
 extern vector load_vector(const char *filename);
+// the vector in a file saved by save_vector(), used in place
+// read only, free_vector() unmaps it
+extern vector map_vector(const char *filename);
 extern vector mult_vector(vector a, vector b);
 extern vector zero_vector(int n);
 extern vector new_vector(float (*element_function)(int, int),
@@ -8,6 +8,10 @@
 func * vecfunc_allocate(int n);
 vector_function new_vecfunc(int n, func f);
 void free_vecfunc(vector_function vf);
+void vecfunc_eval(vector_function vf, float *ty, float *dydt);
+int vecfunc_adapter_init(struct vecfunc_adapter *a, vector_function vf);
+void vecfunc_adapter_free(struct vecfunc_adapter *a);
+void vecfunc_rhs(double t, const float *y, float *dydt, int n, void *userdata);
 
 // allocate space for an n dimensional vector function
 func * vecfunc_allocate(int n)
@@ -68,3 +72,43 @@ void free_vecfunc(vector_function vf)
 	free(vf->f);
 	free(vf);
 }
+
+// dydt = f(t,y) for the row ty = [t y1 ... yn]
+void vecfunc_eval(vector_function vf, float *ty, float *dydt)
+{
+	unsigned int j;
+
+	for(j = 0; j < vf->n; j++)
+	{
+		dydt[j] = (*vf->f[j])(ty, vf->n+1);
+	}
+}
+
+// set up an adapter for vf
+int vecfunc_adapter_init(struct vecfunc_adapter *a, vector_function vf)
+{
+	a->vf = vf;
+	if((a->row = calloc(vf->n+1, sizeof(*a->row))) == NULL)
+	{
+		perror("Error allocating memory");
+		return 1;
+	}
+	return 0;
+}
+
+void vecfunc_adapter_free(struct vecfunc_adapter *a)
+{
+	free(a->row);
+	a->row = NULL;
+}
+
+// the ode_rhs of an adapter, each component function
+// sees the row [t y1 ... yn] like it always has
+void vecfunc_rhs(double t, const float *y, float *dydt, int n, void *userdata)
+{
+	struct vecfunc_adapter *a = userdata;
+
+	a->row[0] = t;
+	memcpy(a->row+1, y, sizeof(*y)*n);
+	vecfunc_eval(a->vf, a->row, dydt);
+}
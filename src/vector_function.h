@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <sys/stat.h>
 
@@ -20,9 +21,30 @@ typedef struct
 	func * f; // array of function pointers
 } *vector_function;
 
+// right hand side of dy/dt = f(t,y) computed for all n components
+// at once, so terms shared between components are only done once
+typedef void (*ode_rhs)(double t, const float *y, float *dydt, int n,
+		void *userdata);
+
+// lets a vector_function be used as an ode_rhs
+// with the adapter as its userdata
+struct vecfunc_adapter
+{
+	vector_function vf;
+	float *row; // [t y1 ... yn] handed to the component functions
+};
+
 // prototypes for vector functions
 extern func * vecfunc_allocate(int n);
 extern vector_function new_vecfunc(int n, func f);
 extern void free_vecfunc(vector_function vf);
+// dydt = f(t,y) for the row ty = [t y1 ... yn]
+extern void vecfunc_eval(vector_function vf, float *ty, float *dydt);
+// set up an adapter for vf, returns 0 on success
+extern int vecfunc_adapter_init(struct vecfunc_adapter *a, vector_function vf);
+extern void vecfunc_adapter_free(struct vecfunc_adapter *a);
+// the ode_rhs of an adapter
+extern void vecfunc_rhs(double t, const float *y, float *dydt, int n,
+		void *userdata);
 
 #endif